@@ -0,0 +1,1029 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Downloader benchmarks against the in-process stand-in server.
+ * Each scenario prints one record, either as a JSON object per line or as
+ * CSV, so results can be collected and compared across builds.
+ * Scenarios exercising a feature also check that it behaves: a failed check
+ * is printed and makes the exit status non-zero.
+ */
+
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "fludownloader.h"
+#include "flubenchserver.h"
+
+#include <fluc/threads/fluc_lock_profile.h>
+
+/* Shared by all the tasks of a scenario */
+typedef struct _BenchSync
+{
+  GMutex lock;
+  GCond cond;
+  guint pending;
+  guint ok;
+  guint failed;
+  guint64 bytes;
+  GArray *startup; /* gint64, us from submission to first byte */
+} BenchSync;
+
+typedef struct _BenchTask
+{
+  BenchSync *sync;
+  gint64 submitted;
+  gint64 first_byte;
+  gboolean to_file; /* No data callbacks, bytes are counted when done */
+  gboolean upload;  /* Bytes sent are counted when done */
+  guint64 upload_size;
+  guint64 uploaded;              /* By _read_cb */
+  struct _BenchResumer *resumer; /* Resumes the uploads _read_cb pauses */
+} BenchTask;
+
+/* Thread resuming the uploads paused by _read_cb, as an application thread
+ * producing the data would */
+typedef struct _BenchResumer
+{
+  GMutex lock;
+  GCond cond;
+  GThread *thread;
+  FluDownloaderTask *task; /* To be resumed */
+  gboolean stop;
+} BenchResumer;
+
+typedef struct _BenchResult
+{
+  const gchar *scenario;
+  guint tasks;
+  guint sessions;
+  gint64 wall_time;  /* us */
+  gint64 cpu_time;   /* us, process minus server */
+  BenchSync *sync;
+  FluBenchServerStats server;
+} BenchResult;
+
+static gint opt_tasks = 32;
+static gint opt_sessions = 8;
+static gint64 opt_size = 8 * 1024 * 1024;
+static gint opt_latency = 20;
+static gint64 opt_bandwidth = 0;
+static gboolean opt_chunked = FALSE;
+static gboolean opt_no_keep_alive = FALSE;
+static gdouble opt_error_rate = 0.0;
+static gint opt_polling = 0;
+static gchar *opt_format = NULL;
+static gchar **opt_scenarios = NULL;
+
+static guint failed_checks = 0;
+
+static GOptionEntry entries[] = {
+  { "tasks", 't', 0, G_OPTION_ARG_INT, &opt_tasks, "Tasks per scenario",
+      "N" },
+  { "sessions", 's', 0, G_OPTION_ARG_INT, &opt_sessions,
+      "Downloader contexts for the sessions scenario", "N" },
+  { "size", 'z', 0, G_OPTION_ARG_INT64, &opt_size,
+      "Resource size for the throughput scenarios", "BYTES" },
+  { "latency", 'l', 0, G_OPTION_ARG_INT, &opt_latency,
+      "Server latency for the startup and pipelining scenarios", "MS" },
+  { "bandwidth", 'b', 0, G_OPTION_ARG_INT64, &opt_bandwidth,
+      "Per-connection bandwidth cap, and upload send speed, 0 for none",
+      "BYTES/S" },
+  { "chunked", 'c', 0, G_OPTION_ARG_NONE, &opt_chunked,
+      "Use chunked transfer encoding", NULL },
+  { "no-keep-alive", 'k', 0, G_OPTION_ARG_NONE, &opt_no_keep_alive,
+      "Close the connection after each response", NULL },
+  { "error-rate", 'e', 0, G_OPTION_ARG_DOUBLE, &opt_error_rate,
+      "Probability of dropping a response half-way", "P" },
+  { "polling", 'p', 0, G_OPTION_ARG_INT, &opt_polling,
+      "Downloader polling period, 0 to use select()", "US" },
+  { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format,
+      "Output format: json (default) or csv", "FORMAT" },
+  { "scenario", 0, 0, G_OPTION_ARG_STRING_ARRAY, &opt_scenarios,
+      "Scenario to run, can be repeated (default: all)", "NAME" },
+  { NULL }
+};
+
+/*****************************************************************************
+ * Downloader callbacks
+ *****************************************************************************/
+
+static gboolean
+_data_cb (
+    void *buffer, size_t size, gpointer user_data, FluDownloaderTask *task)
+{
+  BenchTask *bt = (BenchTask *) user_data;
+  BenchSync *sync = bt->sync;
+
+  g_mutex_lock (&sync->lock);
+  if (!bt->first_byte)
+    bt->first_byte = g_get_monotonic_time ();
+  sync->bytes += size;
+  g_mutex_unlock (&sync->lock);
+
+  return TRUE;
+}
+
+static void
+_task_finished (BenchTask *bt, FluDownloaderTaskOutcome outcome,
+    size_t downloaded_size)
+{
+  BenchSync *sync = bt->sync;
+
+  g_mutex_lock (&sync->lock);
+  if (bt->to_file || bt->upload)
+    sync->bytes += downloaded_size;
+  if (outcome == FLUDOWNLOADER_TASK_OK)
+    sync->ok++;
+  else
+    sync->failed++;
+  if (bt->first_byte) {
+    gint64 startup = bt->first_byte - bt->submitted;
+    g_array_append_val (sync->startup, startup);
+  }
+  sync->pending--;
+  g_cond_broadcast (&sync->cond);
+  g_mutex_unlock (&sync->lock);
+
+  g_free (bt);
+}
+
+static void
+_done_cb (FluDownloaderTaskOutcome outcome, int http_status_code,
+    size_t downloaded_size, gpointer user_data, FluDownloaderTask *task,
+    gboolean *cancel_remaining_downloads)
+{
+  BenchTask *bt = (BenchTask *) user_data;
+
+  if (bt->upload)
+    downloaded_size = fludownloader_task_get_uploaded_size (task);
+  _task_finished (bt, outcome, downloaded_size);
+}
+
+/* Bytes of the resources, and of the bodies the server expects, are
+ * (N & 0xFF). Large enough for any chunk at any offset. */
+static guint8 pattern[64 * 1024 + 256];
+
+/* Produces the body of an upload. Half-way, it pauses the transfer and has
+ * the resumer thread resume it, waiting for it to do so: this takes the
+ * downloader lock from that thread while the callback runs. */
+static gssize
+_read_cb (
+    void *buffer, size_t size, gpointer user_data, FluDownloaderTask *task)
+{
+  BenchTask *bt = (BenchTask *) user_data;
+  BenchResumer *resumer = bt->resumer;
+  gsize len, done = 0;
+
+  if (bt->uploaded == bt->upload_size)
+    return 0;
+
+  if (resumer && bt->uploaded >= bt->upload_size / 2) {
+    bt->resumer = NULL;
+    g_mutex_lock (&resumer->lock);
+    resumer->task = task;
+    g_cond_broadcast (&resumer->cond);
+    while (resumer->task)
+      g_cond_wait (&resumer->cond, &resumer->lock);
+    g_mutex_unlock (&resumer->lock);
+    return FLUDOWNLOADER_UPLOAD_PAUSE;
+  }
+
+  len = MIN (size, bt->upload_size - bt->uploaded);
+  while (done < len) {
+    gsize chunk = MIN (len - done, sizeof (pattern) - 256);
+
+    memcpy ((guint8 *) buffer + done,
+        pattern + ((bt->uploaded + done) & 0xFF), chunk);
+    done += chunk;
+  }
+  bt->uploaded += len;
+  return len;
+}
+
+static gpointer
+_resumer_function (BenchResumer *resumer)
+{
+  g_mutex_lock (&resumer->lock);
+  while (!resumer->stop) {
+    if (resumer->task) {
+      fludownloader_task_resume_upload (resumer->task);
+      resumer->task = NULL;
+      g_cond_broadcast (&resumer->cond);
+    }
+    g_cond_wait (&resumer->cond, &resumer->lock);
+  }
+  g_mutex_unlock (&resumer->lock);
+  return NULL;
+}
+
+static gboolean
+_batch_done_cb (const FluDownloaderTaskCompletion *completions,
+    guint n_completions, gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i < n_completions; i++)
+    _task_finished ((BenchTask *) completions[i].user_data,
+        completions[i].outcome, completions[i].downloaded_size);
+  return FALSE;
+}
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+static void
+_check (gboolean ok, const gchar *scenario, const gchar *what)
+{
+  if (ok)
+    return;
+  g_printerr ("%s: %s\n", scenario, what);
+  failed_checks++;
+}
+
+static BenchSync *
+_sync_new (void)
+{
+  BenchSync *sync = g_new0 (BenchSync, 1);
+
+  g_mutex_init (&sync->lock);
+  g_cond_init (&sync->cond);
+  sync->startup = g_array_new (FALSE, FALSE, sizeof (gint64));
+  return sync;
+}
+
+static void
+_sync_free (BenchSync *sync)
+{
+  g_array_free (sync->startup, TRUE);
+  g_cond_clear (&sync->cond);
+  g_mutex_clear (&sync->lock);
+  g_free (sync);
+}
+
+/* Block until 'count' tasks are pending at most */
+static void
+_sync_wait (BenchSync *sync, guint count)
+{
+  g_mutex_lock (&sync->lock);
+  while (sync->pending > count)
+    g_cond_wait (&sync->cond, &sync->lock);
+  g_mutex_unlock (&sync->lock);
+}
+
+static FluDownloaderTask *
+_submit (FluDownloader *dl, BenchSync *sync, const gchar *url)
+{
+  BenchTask *bt = g_new0 (BenchTask, 1);
+  FluDownloaderTask *task;
+
+  bt->sync = sync;
+  bt->submitted = g_get_monotonic_time ();
+  g_mutex_lock (&sync->lock);
+  sync->pending++;
+  g_mutex_unlock (&sync->lock);
+
+  task = fludownloader_new_task (dl, url, NULL, bt, TRUE);
+  if (!task) {
+    g_mutex_lock (&sync->lock);
+    sync->pending--;
+    sync->failed++;
+    g_mutex_unlock (&sync->lock);
+    g_free (bt);
+  }
+  return task;
+}
+
+static FluDownloaderTask *
+_submit_file (
+    FluDownloader *dl, BenchSync *sync, const gchar *url, const gchar *path)
+{
+  BenchTask *bt = g_new0 (BenchTask, 1);
+  FluDownloaderTask *task;
+
+  bt->sync = sync;
+  bt->submitted = g_get_monotonic_time ();
+  bt->to_file = TRUE;
+  g_mutex_lock (&sync->lock);
+  sync->pending++;
+  g_mutex_unlock (&sync->lock);
+
+  task = fludownloader_new_file_task (dl, url, path, bt, TRUE);
+  if (!task) {
+    g_mutex_lock (&sync->lock);
+    sync->pending--;
+    sync->failed++;
+    g_mutex_unlock (&sync->lock);
+    g_free (bt);
+  }
+  return task;
+}
+
+/* An upload of 'size' bytes, produced by _read_cb if 'resumer' is set or
+ * pushed in buffers otherwise */
+static FluDownloaderTask *
+_submit_upload (FluDownloader *dl, BenchSync *sync, const gchar *url,
+    guint64 size, BenchResumer *resumer)
+{
+  BenchTask *bt = g_new0 (BenchTask, 1);
+  FluDownloaderTask *task;
+  guint64 offset;
+
+  bt->sync = sync;
+  bt->submitted = g_get_monotonic_time ();
+  bt->upload = TRUE;
+  bt->upload_size = size;
+  bt->resumer = resumer;
+  g_mutex_lock (&sync->lock);
+  sync->pending++;
+  g_mutex_unlock (&sync->lock);
+
+  task = fludownloader_new_upload_task (
+      dl, url, "PUT", resumer ? _read_cb : NULL, bt, TRUE);
+  if (!task) {
+    g_mutex_lock (&sync->lock);
+    sync->pending--;
+    sync->failed++;
+    g_mutex_unlock (&sync->lock);
+    g_free (bt);
+    return NULL;
+  }
+
+  if (!resumer) {
+    for (offset = 0; offset < size; offset += sizeof (pattern) - 256) {
+      gsize chunk = MIN (size - offset, sizeof (pattern) - 256);
+      fludownloader_task_push_buffer (
+          task, g_bytes_new_static (pattern + (offset & 0xFF), chunk));
+    }
+    fludownloader_task_end_upload (task);
+  }
+  return task;
+}
+
+static FluDownloader *
+_downloader_new (void)
+{
+  FluDownloader *dl = fludownloader_new (_data_cb, _done_cb);
+
+  if (dl)
+    fludownloader_set_polling_period (dl, opt_polling);
+  return dl;
+}
+
+static gint64
+_process_cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+             G_USEC_PER_SEC +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static FluBenchServer *
+_server_new (guint latency)
+{
+  FluBenchServerConfig config;
+
+  flu_bench_server_config_init (&config);
+  config.latency = latency;
+  config.bandwidth = opt_bandwidth;
+  config.chunked = opt_chunked;
+  config.keep_alive = !opt_no_keep_alive;
+  config.error_rate = opt_error_rate;
+  return flu_bench_server_new (&config);
+}
+
+static gint
+_compare_gint64 (gconstpointer a, gconstpointer b)
+{
+  gint64 va = *(const gint64 *) a, vb = *(const gint64 *) b;
+
+  return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+static gint64
+_percentile (GArray *values, guint percent)
+{
+  if (!values->len)
+    return 0;
+  return g_array_index (values, gint64, (values->len - 1) * percent / 100);
+}
+
+static void
+_print_result (BenchResult *r)
+{
+  static gboolean header_printed = FALSE;
+  gdouble seconds = r->wall_time / (gdouble) G_USEC_PER_SEC;
+  gdouble mb = r->sync->bytes / (1024.0 * 1024.0);
+  gdouble mbps = seconds > 0 ? mb / seconds : 0;
+  gdouble cpu_per_mb = mb > 0 ? r->cpu_time / 1000.0 / mb : 0;
+  gint64 avg = 0;
+  guint i;
+
+  for (i = 0; i < r->sync->startup->len; i++)
+    avg += g_array_index (r->sync->startup, gint64, i);
+  if (r->sync->startup->len)
+    avg /= r->sync->startup->len;
+  g_array_sort (r->sync->startup, _compare_gint64);
+
+  if (!g_strcmp0 (opt_format, "csv")) {
+    if (!header_printed) {
+      g_printf ("scenario,tasks,sessions,ok,failed,bytes,seconds,mb_per_s,"
+                "startup_avg_us,startup_p50_us,startup_p99_us,cpu_ms,"
+                "cpu_ms_per_mb,connections,requests,errors_injected\n");
+      header_printed = TRUE;
+    }
+    g_printf ("%s,%u,%u,%u,%u,%" G_GUINT64_FORMAT ",%.6f,%.3f,%" G_GINT64_FORMAT
+              ",%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT ",%.3f,%.3f,%"
+              G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT
+              "\n",
+        r->scenario, r->tasks, r->sessions, r->sync->ok, r->sync->failed,
+        r->sync->bytes, seconds, mbps, avg, _percentile (r->sync->startup, 50),
+        _percentile (r->sync->startup, 99), r->cpu_time / 1000.0, cpu_per_mb,
+        r->server.connections, r->server.requests, r->server.errors_injected);
+  } else {
+    g_printf ("{\"scenario\":\"%s\",\"tasks\":%u,\"sessions\":%u,\"ok\":%u,"
+              "\"failed\":%u,\"bytes\":%" G_GUINT64_FORMAT
+              ",\"seconds\":%.6f,\"mb_per_s\":%.3f,\"startup_avg_us\":%"
+              G_GINT64_FORMAT ",\"startup_p50_us\":%" G_GINT64_FORMAT
+              ",\"startup_p99_us\":%" G_GINT64_FORMAT
+              ",\"cpu_ms\":%.3f,\"cpu_ms_per_mb\":%.3f,\"connections\":%"
+              G_GUINT64_FORMAT ",\"requests\":%" G_GUINT64_FORMAT
+              ",\"errors_injected\":%" G_GUINT64_FORMAT "}\n",
+        r->scenario, r->tasks, r->sessions, r->sync->ok, r->sync->failed,
+        r->sync->bytes, seconds, mbps, avg, _percentile (r->sync->startup, 50),
+        _percentile (r->sync->startup, 99), r->cpu_time / 1000.0, cpu_per_mb,
+        r->server.connections, r->server.requests, r->server.errors_injected);
+  }
+}
+
+/* Common prologue and epilogue of all scenarios */
+static void
+_result_begin (BenchResult *r, const gchar *scenario)
+{
+  memset (r, 0, sizeof (BenchResult));
+  r->scenario = scenario;
+  r->sessions = 1;
+  r->sync = _sync_new ();
+  r->cpu_time = _process_cpu_time ();
+  r->wall_time = g_get_monotonic_time ();
+}
+
+static void
+_result_end (BenchResult *r, FluBenchServer *server)
+{
+  r->wall_time = g_get_monotonic_time () - r->wall_time;
+  r->cpu_time = _process_cpu_time () - r->cpu_time;
+  flu_bench_server_get_stats (server, &r->server);
+  r->cpu_time -= r->server.cpu_time;
+  _print_result (r);
+  _sync_free (r->sync);
+}
+
+/*****************************************************************************
+ * Scenarios
+ *****************************************************************************/
+
+/* Large resources back to back on one context: raw throughput */
+static void
+_scenario_throughput (const gchar *name, gsize chunk)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  BenchResult r;
+  gchar *url, *query = NULL;
+  gint i;
+
+  if (chunk)
+    query = g_strdup_printf ("chunk=%" G_GSIZE_FORMAT, chunk);
+  url = flu_bench_server_get_url (server, opt_size, query);
+
+  _result_begin (&r, name);
+  r.tasks = opt_tasks;
+  for (i = 0; i < opt_tasks; i++)
+    _submit (dl, r.sync, url);
+  _sync_wait (r.sync, 0);
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+  g_free (query);
+}
+
+/* Small resources one at a time: time from submission to first byte */
+static void
+_scenario_startup (void)
+{
+  FluBenchServer *server = _server_new (opt_latency);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, 1024, NULL);
+  BenchResult r;
+  gint i;
+
+  _result_begin (&r, "startup");
+  r.tasks = opt_tasks;
+  for (i = 0; i < opt_tasks; i++) {
+    _submit (dl, r.sync, url);
+    _sync_wait (r.sync, 0);
+  }
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Small resources queued at once on a high latency server: shows how much
+ * of the latency the scheduler manages to overlap */
+static void
+_scenario_pipelining (void)
+{
+  FluBenchServer *server = _server_new (opt_latency);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, 64 * 1024, NULL);
+  BenchResult r;
+  gint i;
+
+  _result_begin (&r, "pipelining");
+  r.tasks = opt_tasks;
+  fludownloader_lock (dl);
+  for (i = 0; i < opt_tasks; i++)
+    _submit (dl, r.sync, url);
+  fludownloader_unlock (dl);
+  _sync_wait (r.sync, 0);
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Same as pipelining, but submitting and completing in batches */
+static void
+_scenario_batch (void)
+{
+  FluBenchServer *server = _server_new (opt_latency);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, 64 * 1024, NULL);
+  FluDownloaderTaskRequest *requests;
+  BenchResult r;
+  gint i;
+
+  fludownloader_set_batch_done_callback (dl, _batch_done_cb, NULL);
+  requests = g_new0 (FluDownloaderTaskRequest, opt_tasks);
+
+  _result_begin (&r, "batch");
+  r.tasks = opt_tasks;
+  g_mutex_lock (&r.sync->lock);
+  r.sync->pending = opt_tasks;
+  g_mutex_unlock (&r.sync->lock);
+  for (i = 0; i < opt_tasks; i++) {
+    BenchTask *bt = g_new0 (BenchTask, 1);
+    bt->sync = r.sync;
+    bt->submitted = g_get_monotonic_time ();
+    requests[i].url = url;
+    requests[i].user_data = bt;
+  }
+  fludownloader_new_tasks (dl, requests, opt_tasks, NULL, TRUE);
+  _sync_wait (r.sync, 0);
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (requests);
+  g_free (url);
+}
+
+/* Many contexts downloading concurrently, the total size is kept constant */
+static void
+_scenario_sessions (void)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader **dls = g_new0 (FluDownloader *, opt_sessions);
+  gchar *url = flu_bench_server_get_url (
+      server, MAX (1, opt_size / opt_sessions), NULL);
+  BenchResult r;
+  gint i, j;
+
+  for (i = 0; i < opt_sessions; i++)
+    dls[i] = _downloader_new ();
+
+  _result_begin (&r, "sessions");
+  r.tasks = opt_tasks * opt_sessions;
+  r.sessions = opt_sessions;
+  for (j = 0; j < opt_tasks; j++)
+    for (i = 0; i < opt_sessions; i++)
+      _submit (dls[i], r.sync, url);
+  _sync_wait (r.sync, 0);
+  _result_end (&r, server);
+
+  for (i = 0; i < opt_sessions; i++)
+    fludownloader_destroy (dls[i]);
+  g_free (dls);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Queue a batch, wait for data to flow and abort everything, repeatedly.
+ * The bandwidth cap keeps the transfers alive until they are aborted. */
+static void
+_scenario_abort (void)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (
+      server, opt_size, "bandwidth=1048576");
+  BenchResult r;
+  gint i, j;
+
+  _result_begin (&r, "abort");
+  r.tasks = opt_tasks * 8;
+  for (i = 0; i < opt_tasks; i++) {
+    guint64 bytes;
+
+    g_mutex_lock (&r.sync->lock);
+    bytes = r.sync->bytes;
+    g_mutex_unlock (&r.sync->lock);
+
+    fludownloader_lock (dl);
+    for (j = 0; j < 8; j++)
+      _submit (dl, r.sync, url);
+    fludownloader_unlock (dl);
+
+    /* Let the first transfer start */
+    g_mutex_lock (&r.sync->lock);
+    while (r.sync->bytes == bytes && r.sync->pending)
+      g_cond_wait_until (&r.sync->cond, &r.sync->lock,
+          g_get_monotonic_time () + 10 * G_TIME_SPAN_MILLISECOND);
+    g_mutex_unlock (&r.sync->lock);
+
+    fludownloader_abort_all_tasks (dl, TRUE);
+    _sync_wait (r.sync, 0);
+  }
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Like throughput, but writing into files instead of the data callback */
+static void
+_scenario_file (void)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, opt_size, NULL);
+  gchar *path;
+  BenchResult r;
+  gint i;
+
+  path = g_build_filename (g_get_tmp_dir (), "dlbench.out", NULL);
+
+  _result_begin (&r, "file");
+  r.tasks = opt_tasks;
+  for (i = 0; i < opt_tasks; i++) {
+    _submit_file (dl, r.sync, url, path);
+    _sync_wait (r.sync, 0);
+  }
+  _result_end (&r, server);
+
+  g_unlink (path);
+  g_free (path);
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Offset up to which the sidecar of 'path' says the data is on disk, 0 if
+ * there is none */
+static guint64
+_sidecar_done (const gchar *path)
+{
+  gchar *sidecar = g_strconcat (path, ".fludl", NULL);
+  gchar *contents = NULL;
+  const gchar *done;
+  guint64 offset = 0;
+
+  if (g_file_get_contents (sidecar, &contents, NULL, NULL)) {
+    done = strstr (contents, "done=0-");
+    if (done)
+      offset = g_ascii_strtoull (done + 7, NULL, 10);
+  }
+  g_free (contents);
+  g_free (sidecar);
+  return offset;
+}
+
+/* Whether the file holds the synthetic resource of 'size' bytes */
+static gboolean
+_file_matches (const gchar *path, guint64 size)
+{
+  gchar *contents = NULL;
+  gsize len = 0, i;
+  gboolean ok;
+
+  if (!g_file_get_contents (path, &contents, &len, NULL))
+    return FALSE;
+  ok = len == size;
+  for (i = 0; ok && i < len; i++)
+    ok = (guint8) contents[i] == (i & 0xFF);
+  g_free (contents);
+  return ok;
+}
+
+/* A file download interrupted half-way and started again with the same URL
+ * and path: the second run has to ask only for what the sidecar says is
+ * missing, and the result has to be the whole resource. The bandwidth cap
+ * makes the interruption land in the middle of the transfer. */
+static void
+_scenario_resume (void)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  guint64 bandwidth = MAX (opt_size * 4, 1024 * 1024);
+  gchar *query = g_strdup_printf ("bandwidth=%" G_GUINT64_FORMAT, bandwidth);
+  gchar *url = flu_bench_server_get_url (server, opt_size, query);
+  gchar *path = g_build_filename (g_get_tmp_dir (), "dlbench.resume", NULL);
+  gchar *sidecar = g_strconcat (path, ".fludl", NULL);
+  FluBenchServerStats before;
+  GStatBuf st;
+  guint64 done, resent;
+  BenchResult r;
+
+  g_unlink (path);
+  g_unlink (sidecar);
+
+  _result_begin (&r, "resume");
+  r.tasks = 2;
+  _submit_file (dl, r.sync, url, path);
+  g_usleep (opt_size * G_USEC_PER_SEC / bandwidth / 2);
+  fludownloader_abort_all_tasks (dl, TRUE);
+  _sync_wait (r.sync, 0);
+
+  done = _sidecar_done (path);
+  _check (done > 0 && done < (guint64) opt_size, r.scenario,
+      "the interrupted download left no usable sidecar");
+#ifdef HAVE_FALLOCATE
+  _check (g_stat (path, &st) == 0 && st.st_size == opt_size, r.scenario,
+      "the file was not preallocated");
+#endif
+
+  flu_bench_server_get_stats (server, &before);
+  _submit_file (dl, r.sync, url, path);
+  _sync_wait (r.sync, 0);
+  _check (r.sync->ok == 1, r.scenario, "the resumed download failed");
+  _result_end (&r, server);
+
+  /* The sidecar offset is rounded down to the write alignment */
+  resent = r.server.bytes_sent - before.bytes_sent;
+  _check (resent >= opt_size - done && resent <= opt_size - done + 4096,
+      r.scenario, "the download did not resume from the sidecar offset");
+  _check (_file_matches (path, opt_size), r.scenario,
+      "the resumed file differs from the resource");
+  _check (g_stat (sidecar, &st) != 0, r.scenario,
+      "the sidecar was not removed");
+
+  g_unlink (path);
+  g_unlink (sidecar);
+  g_free (sidecar);
+  g_free (path);
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+  g_free (query);
+}
+
+/* A context with a memory budget whose data callback keeps every buffer:
+ * the transfer has to stop once the budget is used up, and go on as the
+ * memory is given back. Also checks that nothing is accounted without a
+ * budget. */
+static void
+_scenario_memory (void)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  FluDownloader *unbudgeted = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, opt_size, NULL);
+  gsize budget = MAX (opt_size / 8, 64 * 1024);
+  /* The budget is checked before each write callback, which can be up to
+   * CURL_MAX_WRITE_SIZE (16KB) and go over it */
+  gsize slack = 64 * 1024;
+  gsize usage, peak = 0;
+  guint64 bytes = 0, last = 0;
+  gint64 deadline;
+  BenchResult r;
+  gint stalled = 0;
+
+  fludownloader_memory_acquire (unbudgeted, 4096);
+  _check (fludownloader_get_memory_usage (unbudgeted) == 0 &&
+              fludownloader_get_memory_usage (NULL) == 0,
+      "memory", "memory was accounted without a budget");
+  fludownloader_memory_release (unbudgeted, 4096);
+
+  fludownloader_set_memory_budget (dl, budget);
+
+  _result_begin (&r, "memory");
+  r.tasks = 1;
+  _submit (dl, r.sync, url);
+
+  /* Wait until the transfer starts and stops for lack of memory */
+  deadline = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  while (stalled < 5 && g_get_monotonic_time () < deadline) {
+    g_usleep (20 * G_TIME_SPAN_MILLISECOND);
+    g_mutex_lock (&r.sync->lock);
+    bytes = r.sync->bytes;
+    g_mutex_unlock (&r.sync->lock);
+    stalled = bytes && bytes == last ? stalled + 1 : 0;
+    last = bytes;
+  }
+  usage = fludownloader_get_memory_usage (dl);
+  _check (bytes < (guint64) opt_size && usage >= budget &&
+              usage <= budget + slack,
+      r.scenario, "the transfer did not pause at the budget");
+  _check (fludownloader_get_memory_usage (NULL) == usage, r.scenario,
+      "the process-wide usage differs from the context one");
+
+  /* Give the memory back as the application would, the transfer resumes */
+  g_mutex_lock (&r.sync->lock);
+  while (r.sync->pending) {
+    g_mutex_unlock (&r.sync->lock);
+    usage = fludownloader_get_memory_usage (dl);
+    peak = MAX (peak, usage);
+    fludownloader_memory_release (dl, usage);
+    g_mutex_lock (&r.sync->lock);
+    g_cond_wait_until (&r.sync->cond, &r.sync->lock,
+        g_get_monotonic_time () + 2 * G_TIME_SPAN_MILLISECOND);
+  }
+  _check (r.sync->ok == 1 && r.sync->bytes == (guint64) opt_size,
+      r.scenario, "the transfer did not resume after releasing memory");
+  g_mutex_unlock (&r.sync->lock);
+  _check (peak <= budget + slack, r.scenario, "the budget was exceeded");
+  _result_end (&r, server);
+
+  fludownloader_destroy (dl);
+  fludownloader_destroy (unbudgeted);
+  _check (fludownloader_get_memory_usage (NULL) == 0, "memory",
+      "the destroyed context left process-wide usage behind");
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+/* Uploads one after the other, as uploads are never pipelined, with pushed
+ * buffers or with a read callback. The server checks every body. */
+static void
+_scenario_upload (const gchar *name, gboolean read_cb)
+{
+  FluBenchServer *server = _server_new (0);
+  FluDownloader *dl = _downloader_new ();
+  gchar *url = flu_bench_server_get_url (server, 0, NULL);
+  BenchResumer resumer;
+  BenchResult r;
+  gint i;
+
+  memset (&resumer, 0, sizeof (resumer));
+  g_mutex_init (&resumer.lock);
+  g_cond_init (&resumer.cond);
+  resumer.thread = g_thread_new (
+      "dlbenchresumer", (GThreadFunc) _resumer_function, &resumer);
+  if (opt_bandwidth)
+    fludownloader_set_max_send_speed (dl, opt_bandwidth);
+
+  _result_begin (&r, name);
+  r.tasks = opt_tasks;
+  for (i = 0; i < opt_tasks; i++)
+    _submit_upload (dl, r.sync, url, opt_size, read_cb ? &resumer : NULL);
+  _sync_wait (r.sync, 0);
+  _check (r.sync->ok == (guint) opt_tasks &&
+              r.sync->bytes == (guint64) opt_size * opt_tasks,
+      r.scenario, "uploads failed");
+  _result_end (&r, server);
+  _check (r.server.bytes_received == (guint64) opt_size * opt_tasks,
+      r.scenario, "the server did not receive every body");
+
+  g_mutex_lock (&resumer.lock);
+  resumer.stop = TRUE;
+  g_cond_broadcast (&resumer.cond);
+  g_mutex_unlock (&resumer.lock);
+  g_thread_join (resumer.thread);
+  g_cond_clear (&resumer.cond);
+  g_mutex_clear (&resumer.lock);
+
+  fludownloader_destroy (dl);
+  flu_bench_server_free (server);
+  g_free (url);
+}
+
+static void
+_scenario_upload_buffers (void)
+{
+  _scenario_upload ("upload", FALSE);
+}
+
+static void
+_scenario_upload_callback (void)
+{
+  _scenario_upload ("upload-callback", TRUE);
+}
+
+typedef struct _BenchScenario
+{
+  const gchar *name;
+  void (*run) (void);
+} BenchScenario;
+
+static void
+_scenario_throughput_default (void)
+{
+  _scenario_throughput ("throughput", 0);
+}
+
+/* Tiny server writes, so the cost per callback dominates the CPU usage */
+static void
+_scenario_cpu (void)
+{
+  _scenario_throughput ("cpu", 1024);
+}
+
+static const BenchScenario scenarios[] = {
+  { "throughput", _scenario_throughput_default },
+  { "startup", _scenario_startup },
+  { "pipelining", _scenario_pipelining },
+  { "batch", _scenario_batch },
+  { "sessions", _scenario_sessions },
+  { "abort", _scenario_abort },
+  { "cpu", _scenario_cpu },
+  { "file", _scenario_file },
+  { "resume", _scenario_resume },
+  { "memory", _scenario_memory },
+  { "upload", _scenario_upload_buffers },
+  { "upload-callback", _scenario_upload_callback },
+  { NULL, NULL }
+};
+
+static gboolean
+_scenario_selected (const gchar *name)
+{
+  gchar **it;
+
+  if (!opt_scenarios)
+    return TRUE;
+  for (it = opt_scenarios; *it; it++)
+    if (!strcmp (*it, name))
+      return TRUE;
+  return FALSE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  const BenchScenario *s;
+  gchar *report;
+  gsize i;
+
+  ctx = g_option_context_new ("- downloader benchmarks");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    g_error_free (err);
+    g_option_context_free (ctx);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_tasks < 1 || opt_sessions < 1 || opt_size < 1) {
+    g_printerr ("tasks, sessions and size must be positive\n");
+    return -1;
+  }
+
+  for (i = 0; i < sizeof (pattern); i++)
+    pattern[i] = i & 0xFF;
+
+  fludownloader_init ();
+  for (s = scenarios; s->name; s++) {
+    if (_scenario_selected (s->name))
+      s->run ();
+  }
+  fludownloader_shutdown ();
+
+  /* Only available in lock_profiling builds */
+  report = fluc_lock_profile_report ();
+  if (report) {
+    g_printerr ("%s", report);
+    g_free (report);
+  }
+  fluc_lock_profile_dispose ();
+
+  g_strfreev (opt_scenarios);
+  g_free (opt_format);
+
+  return failed_checks ? 1 : 0;
+}
@@ -0,0 +1,635 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Minimal HTTP/1.1 server used to benchmark the downloader without depending
+ * on the network. Resources are synthetic: "/<size>" returns <size> bytes in
+ * which byte N is (N & 0xFF), so ranges can be verified by the client.
+ * Each connection is served from its own thread, requests on a connection
+ * are answered in order, which is enough for keep-alive and pipelining.
+ * Request bodies are read and checked against the same pattern, so uploads
+ * can be verified too.
+ */
+
+#include "flubenchserver.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define ACCEPT_POLL_TIMEOUT 100 /* ms */
+#define REQUEST_MAX_SIZE 8192
+#define DEFAULT_CHUNK_SIZE (16 * 1024)
+
+typedef struct _FluBenchConnection
+{
+  FluBenchServer *server;
+  GThread *thread;
+  int fd;
+  gboolean done;
+} FluBenchConnection;
+
+struct _FluBenchServer
+{
+  FluBenchServerConfig config;
+  int listen_fd;
+  guint16 port;
+  GThread *accept_thread;
+  gboolean stopping;
+
+  GMutex lock;
+  GList *connections;
+  FluBenchServerStats stats;
+};
+
+/* Parameters of a single response, taken from the config and then overridden
+ * by the query string */
+typedef struct _FluBenchRequest
+{
+  gboolean head;
+  gboolean keep_alive;
+  guint64 size;
+  guint64 range_start;
+  guint64 range_end; /* inclusive */
+  gboolean has_range;
+  guint latency;
+  guint64 bandwidth;
+  gsize chunk_size;
+  gboolean chunked;
+  guint status;
+  gint64 drop; /* -1 to never drop */
+  guint64 body_length; /* From Content-Length */
+  gboolean body_chunked;
+  guint64 received; /* Body bytes read */
+  gboolean body_ok; /* The body followed the pattern */
+} FluBenchRequest;
+
+static gboolean
+_send_all (int fd, const void *data, gsize len)
+{
+  const guint8 *ptr = data;
+
+  while (len > 0) {
+    ssize_t ret = send (fd, ptr, len, MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    ptr += ret;
+    len -= ret;
+  }
+  return TRUE;
+}
+
+static void
+_parse_query (FluBenchRequest *req, const gchar *query)
+{
+  gchar **params, **it;
+
+  params = g_strsplit (query, "&", -1);
+  for (it = params; *it; it++) {
+    gchar *value = strchr (*it, '=');
+    if (!value)
+      continue;
+    *value++ = '\0';
+
+    if (!strcmp (*it, "latency"))
+      req->latency = atoi (value);
+    else if (!strcmp (*it, "bandwidth"))
+      req->bandwidth = g_ascii_strtoull (value, NULL, 10);
+    else if (!strcmp (*it, "chunk"))
+      req->chunk_size = MAX (1, g_ascii_strtoull (value, NULL, 10));
+    else if (!strcmp (*it, "chunked"))
+      req->chunked = atoi (value) != 0;
+    else if (!strcmp (*it, "status"))
+      req->status = atoi (value);
+    else if (!strcmp (*it, "drop"))
+      req->drop = g_ascii_strtoll (value, NULL, 10);
+  }
+  g_strfreev (params);
+}
+
+/* Parse the request head (everything before the empty line).
+ * Returns FALSE for requests we cannot answer. */
+static gboolean
+_parse_request (FluBenchServer *server, FluBenchRequest *req, gchar *head)
+{
+  gchar **lines, **it;
+  gchar method[16], path[1024], version[16];
+  gchar *query;
+
+  memset (req, 0, sizeof (FluBenchRequest));
+  req->latency = server->config.latency;
+  req->bandwidth = server->config.bandwidth;
+  req->chunk_size = server->config.chunk_size;
+  req->chunked = server->config.chunked;
+  req->keep_alive = server->config.keep_alive;
+  req->status = 200;
+  req->drop = -1;
+  req->body_ok = TRUE;
+
+  lines = g_strsplit (head, "\r\n", -1);
+  if (!lines[0] || sscanf (lines[0], "%15s %1023s %15s", method, path,
+                       version) != 3) {
+    g_strfreev (lines);
+    return FALSE;
+  }
+
+  req->head = !strcmp (method, "HEAD");
+  if (strcmp (version, "HTTP/1.1"))
+    req->keep_alive = FALSE;
+
+  query = strchr (path, '?');
+  if (query) {
+    *query++ = '\0';
+    _parse_query (req, query);
+    /* Bodies are sent from a pattern buffer sized for the configured chunk */
+    req->chunk_size = MIN (req->chunk_size, server->config.chunk_size);
+  }
+  req->size = g_ascii_strtoull (path + 1, NULL, 10);
+
+  for (it = lines + 1; *it; it++) {
+    guint64 start, end;
+
+    if (!g_ascii_strncasecmp (*it, "Connection:", 11)) {
+      if (strstr (*it + 11, "close"))
+        req->keep_alive = FALSE;
+    } else if (!g_ascii_strncasecmp (*it, "Content-Length:", 15)) {
+      req->body_length = g_ascii_strtoull (*it + 15, NULL, 10);
+    } else if (!g_ascii_strncasecmp (*it, "Transfer-Encoding:", 18)) {
+      if (strstr (*it + 18, "chunked"))
+        req->body_chunked = TRUE;
+    } else if (!g_ascii_strncasecmp (*it, "Range:", 6)) {
+      int n = sscanf (*it + 6,
+          " bytes=%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT, &start, &end);
+      if (n >= 1 && start < req->size) {
+        req->has_range = TRUE;
+        req->range_start = start;
+        req->range_end = (n == 2 && end < req->size) ? end : req->size - 1;
+      }
+    }
+  }
+  g_strfreev (lines);
+
+  return TRUE;
+}
+
+/* Read more of the connection into the request buffer, which must not be
+ * full. Returns FALSE if the connection was closed. */
+static gboolean
+_recv_more (FluBenchConnection *conn, gchar *buffer, gsize *filled)
+{
+  for (;;) {
+    ssize_t ret =
+        recv (conn->fd, buffer + *filled, REQUEST_MAX_SIZE - *filled, 0);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return FALSE;
+    *filled += ret;
+    return TRUE;
+  }
+}
+
+/* Drop 'len' bytes from the start of the request buffer */
+static void
+_consume (gchar *buffer, gsize *filled, gsize len)
+{
+  memmove (buffer, buffer + len, *filled - len);
+  *filled -= len;
+}
+
+/* Read 'len' bytes of body, checking them against the pattern */
+static gboolean
+_receive_data (FluBenchConnection *conn, FluBenchRequest *req, gchar *buffer,
+    gsize *filled, guint64 len)
+{
+  while (len > 0) {
+    gsize chunk, i;
+
+    if (!*filled && !_recv_more (conn, buffer, filled))
+      return FALSE;
+    chunk = MIN (len, *filled);
+    for (i = 0; i < chunk && req->body_ok; i++)
+      req->body_ok = (guint8) buffer[i] == ((req->received + i) & 0xFF);
+    req->received += chunk;
+    len -= chunk;
+    _consume (buffer, filled, chunk);
+  }
+  return TRUE;
+}
+
+/* Read 'len' bytes which must be the given ones, as the CRLF after a chunk */
+static gboolean
+_receive_literal (FluBenchConnection *conn, gchar *buffer, gsize *filled,
+    const gchar *literal)
+{
+  gsize len = strlen (literal);
+
+  while (*filled < len) {
+    if (!_recv_more (conn, buffer, filled))
+      return FALSE;
+  }
+  if (memcmp (buffer, literal, len))
+    return FALSE;
+  _consume (buffer, filled, len);
+  return TRUE;
+}
+
+/* Read the body of the request, if any, which follows the head in the
+ * buffer. Returns FALSE if it is malformed or the connection was closed. */
+static gboolean
+_receive_body (FluBenchConnection *conn, FluBenchRequest *req, gchar *buffer,
+    gsize *filled)
+{
+  if (!req->body_chunked)
+    return _receive_data (conn, req, buffer, filled, req->body_length);
+
+  for (;;) {
+    gchar *end;
+    guint64 size;
+
+    /* Chunk size line, extensions are not expected */
+    while (!(end = g_strstr_len (buffer, *filled, "\r\n"))) {
+      if (*filled == REQUEST_MAX_SIZE ||
+          !_recv_more (conn, buffer, filled))
+        return FALSE;
+    }
+    size = g_ascii_strtoull (buffer, NULL, 16);
+    _consume (buffer, filled, end - buffer + 2);
+
+    /* No trailers are expected either */
+    if (!size)
+      return _receive_literal (conn, buffer, filled, "\r\n");
+    if (!_receive_data (conn, req, buffer, filled, size) ||
+        !_receive_literal (conn, buffer, filled, "\r\n"))
+      return FALSE;
+  }
+}
+
+/* Sleep as needed so that 'sent' bytes since 'start' do not exceed the
+ * configured bandwidth */
+static void
+_throttle (FluBenchRequest *req, gint64 start, guint64 sent)
+{
+  gint64 target, elapsed;
+
+  if (!req->bandwidth)
+    return;
+
+  target = (gint64) (sent * G_USEC_PER_SEC / req->bandwidth);
+  elapsed = g_get_monotonic_time () - start;
+  if (target > elapsed)
+    g_usleep (target - elapsed);
+}
+
+/* CPU time consumed by the calling thread, in us */
+static gint64
+_thread_cpu_time (void)
+{
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) < 0)
+    return 0;
+  return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+/* Send one response. Returns FALSE if the connection has to be closed. */
+static gboolean
+_serve_request (FluBenchConnection *conn, FluBenchRequest *req, GRand *rand,
+    guint8 *pattern)
+{
+  FluBenchServer *server = conn->server;
+  GString *header;
+  guint64 offset, length, sent = 0;
+  gint64 start, cpu_start;
+  gboolean ok = TRUE;
+  gboolean injected = FALSE;
+
+  cpu_start = _thread_cpu_time ();
+
+  /* Before answering, so the client sees it once it has the response */
+  g_mutex_lock (&server->lock);
+  server->stats.bytes_received += req->received;
+  g_mutex_unlock (&server->lock);
+
+  if (server->config.error_rate > 0.0 &&
+      g_rand_double (rand) < server->config.error_rate) {
+    injected = TRUE;
+    if (server->config.error_status)
+      req->status = server->config.error_status;
+    else
+      req->drop = req->size / 2;
+  }
+  if (!req->body_ok)
+    req->status = 400;
+
+  if (req->latency)
+    g_usleep (req->latency * 1000);
+
+  header = g_string_new (NULL);
+  if (req->status != 200) {
+    g_string_append_printf (header,
+        "HTTP/1.1 %u %s\r\n"
+        "Content-Length: 0\r\n",
+        req->status, req->body_ok ? "Injected error" : "Unexpected body");
+    length = 0;
+    offset = 0;
+  } else if (req->has_range) {
+    offset = req->range_start;
+    length = req->range_end - req->range_start + 1;
+    g_string_append_printf (header,
+        "HTTP/1.1 206 Partial Content\r\n"
+        "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
+        "/%" G_GUINT64_FORMAT "\r\n",
+        req->range_start, req->range_end, req->size);
+  } else {
+    offset = 0;
+    length = req->size;
+    g_string_append (header, "HTTP/1.1 200 OK\r\n");
+  }
+  if (req->status == 200) {
+    if (req->chunked)
+      g_string_append (header, "Transfer-Encoding: chunked\r\n");
+    else
+      g_string_append_printf (
+          header, "Content-Length: %" G_GUINT64_FORMAT "\r\n", length);
+  }
+  g_string_append_printf (header, "Connection: %s\r\n\r\n",
+      req->keep_alive ? "keep-alive" : "close");
+
+  ok = _send_all (conn->fd, header->str, header->len);
+  g_string_free (header, TRUE);
+  if (req->head || req->status != 200)
+    goto beach;
+
+  start = g_get_monotonic_time ();
+  while (ok && sent < length) {
+    gsize chunk = MIN (req->chunk_size, length - sent);
+    const guint8 *data = pattern + ((offset + sent) & 0xFF);
+
+    if (req->drop >= 0 && sent + chunk > (guint64) req->drop) {
+      chunk = req->drop - sent;
+      _send_all (conn->fd, data, chunk);
+      sent += chunk;
+      ok = FALSE;
+      break;
+    }
+
+    if (req->chunked) {
+      gchar prefix[24];
+      g_snprintf (prefix, sizeof (prefix), "%" G_GSIZE_MODIFIER "x\r\n", chunk);
+      ok = _send_all (conn->fd, prefix, strlen (prefix)) &&
+           _send_all (conn->fd, data, chunk) &&
+           _send_all (conn->fd, "\r\n", 2);
+    } else {
+      ok = _send_all (conn->fd, data, chunk);
+    }
+    sent += chunk;
+    _throttle (req, start, sent);
+  }
+  if (ok && req->chunked)
+    ok = _send_all (conn->fd, "0\r\n\r\n", 5);
+
+beach:
+  g_mutex_lock (&server->lock);
+  server->stats.requests++;
+  server->stats.bytes_sent += sent;
+  server->stats.cpu_time += _thread_cpu_time () - cpu_start;
+  if (injected)
+    server->stats.errors_injected++;
+  g_mutex_unlock (&server->lock);
+
+  return ok && req->keep_alive;
+}
+
+static gpointer
+_connection_function (FluBenchConnection *conn)
+{
+  FluBenchServer *server = conn->server;
+  gchar buffer[REQUEST_MAX_SIZE + 1];
+  gsize filled = 0;
+  guint8 *pattern;
+  GRand *rand;
+  gsize i;
+
+  /* Byte N of every resource is N & 0xFF, so any chunk can be sent straight
+   * from this buffer at the right offset */
+  pattern = g_malloc (server->config.chunk_size + 256);
+  for (i = 0; i < server->config.chunk_size + 256; i++)
+    pattern[i] = i & 0xFF;
+  rand = g_rand_new_with_seed (conn->fd);
+
+  for (;;) {
+    FluBenchRequest req;
+    gchar *end;
+    gsize head_len;
+    ssize_t ret;
+
+    buffer[filled] = '\0';
+    end = strstr (buffer, "\r\n\r\n");
+    if (!end) {
+      if (filled == REQUEST_MAX_SIZE)
+        break;
+      ret = recv (conn->fd, buffer + filled, REQUEST_MAX_SIZE - filled, 0);
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret <= 0)
+        break;
+      filled += ret;
+      continue;
+    }
+
+    *end = '\0';
+    head_len = end - buffer + 4;
+    if (!_parse_request (server, &req, buffer))
+      break;
+    /* Keep the body and any pipelined request that arrived with this one */
+    _consume (buffer, &filled, head_len);
+    if (!_receive_body (conn, &req, buffer, &filled))
+      break;
+
+    if (!_serve_request (conn, &req, rand, pattern))
+      break;
+  }
+
+  shutdown (conn->fd, SHUT_RDWR);
+  g_rand_free (rand);
+  g_free (pattern);
+
+  g_mutex_lock (&server->lock);
+  conn->done = TRUE;
+  g_mutex_unlock (&server->lock);
+
+  return NULL;
+}
+
+/* Join the threads of closed connections. Call with the lock taken. */
+static void
+_reap_connections (FluBenchServer *server, gboolean all)
+{
+  GList *link = server->connections;
+
+  while (link) {
+    GList *next = link->next;
+    FluBenchConnection *conn = link->data;
+
+    if (conn->done || all) {
+      server->connections = g_list_delete_link (server->connections, link);
+      g_mutex_unlock (&server->lock);
+      g_thread_join (conn->thread);
+      g_mutex_lock (&server->lock);
+      close (conn->fd);
+      g_free (conn);
+    }
+    link = next;
+  }
+}
+
+static gpointer
+_accept_function (FluBenchServer *server)
+{
+  struct pollfd pfd;
+
+  pfd.fd = server->listen_fd;
+  pfd.events = POLLIN;
+
+  while (!g_atomic_int_get (&server->stopping)) {
+    FluBenchConnection *conn;
+    int fd, one = 1;
+
+    g_mutex_lock (&server->lock);
+    _reap_connections (server, FALSE);
+    g_mutex_unlock (&server->lock);
+
+    if (poll (&pfd, 1, ACCEPT_POLL_TIMEOUT) <= 0)
+      continue;
+    fd = accept (server->listen_fd, NULL, NULL);
+    if (fd < 0)
+      continue;
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+
+    conn = g_new0 (FluBenchConnection, 1);
+    conn->server = server;
+    conn->fd = fd;
+
+    g_mutex_lock (&server->lock);
+    server->stats.connections++;
+    server->connections = g_list_prepend (server->connections, conn);
+    conn->thread = g_thread_new (
+        "flubenchconn", (GThreadFunc) _connection_function, conn);
+    g_mutex_unlock (&server->lock);
+  }
+
+  return NULL;
+}
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+void
+flu_bench_server_config_init (FluBenchServerConfig *config)
+{
+  memset (config, 0, sizeof (FluBenchServerConfig));
+  config->chunk_size = DEFAULT_CHUNK_SIZE;
+  config->keep_alive = TRUE;
+}
+
+FluBenchServer *
+flu_bench_server_new (const FluBenchServerConfig *config)
+{
+  FluBenchServer *server;
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof (addr);
+  int one = 1;
+
+  server = g_new0 (FluBenchServer, 1);
+  if (config)
+    server->config = *config;
+  else
+    flu_bench_server_config_init (&server->config);
+  if (!server->config.chunk_size)
+    server->config.chunk_size = DEFAULT_CHUNK_SIZE;
+
+  server->listen_fd = socket (AF_INET, SOCK_STREAM, 0);
+  if (server->listen_fd < 0)
+    goto error;
+  setsockopt (server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if (bind (server->listen_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (server->listen_fd, 1024) < 0 ||
+      getsockname (
+          server->listen_fd, (struct sockaddr *) &addr, &addr_len) < 0)
+    goto error;
+  server->port = ntohs (addr.sin_port);
+
+  g_mutex_init (&server->lock);
+  server->accept_thread = g_thread_new (
+      "flubenchserver", (GThreadFunc) _accept_function, server);
+
+  return server;
+
+error:
+  if (server->listen_fd >= 0)
+    close (server->listen_fd);
+  g_free (server);
+  return NULL;
+}
+
+void
+flu_bench_server_free (FluBenchServer *server)
+{
+  GList *link;
+
+  if (server == NULL)
+    return;
+
+  g_atomic_int_set (&server->stopping, TRUE);
+  g_thread_join (server->accept_thread);
+  close (server->listen_fd);
+
+  /* Unblock every connection thread, then wait for all of them */
+  g_mutex_lock (&server->lock);
+  for (link = server->connections; link; link = link->next)
+    shutdown (((FluBenchConnection *) link->data)->fd, SHUT_RDWR);
+  _reap_connections (server, TRUE);
+  g_mutex_unlock (&server->lock);
+
+  g_mutex_clear (&server->lock);
+  g_free (server);
+}
+
+guint16
+flu_bench_server_get_port (FluBenchServer *server)
+{
+  return server->port;
+}
+
+gchar *
+flu_bench_server_get_url (
+    FluBenchServer *server, guint64 size, const gchar *query)
+{
+  return g_strdup_printf ("http://127.0.0.1:%u/%" G_GUINT64_FORMAT "%s%s",
+      server->port, size, query ? "?" : "", query ? query : "");
+}
+
+void
+flu_bench_server_get_stats (FluBenchServer *server, FluBenchServerStats *stats)
+{
+  g_mutex_lock (&server->lock);
+  *stats = server->stats;
+  g_mutex_unlock (&server->lock);
+}
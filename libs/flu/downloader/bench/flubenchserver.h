@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef _FLUBENCHSERVER_H
+#define _FLUBENCHSERVER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FluBenchServer FluBenchServer;
+
+/* Behaviour of the stand-in server. Every field can also be overridden per
+ * request through the query string, see flu_bench_server_get_url(). */
+typedef struct _FluBenchServerConfig
+{
+  /* Delay before the response headers are sent, in ms */
+  guint latency;
+  /* Per-connection bandwidth cap in bytes per second, 0 for unlimited */
+  guint64 bandwidth;
+  /* Size of each write() on the socket */
+  gsize chunk_size;
+  /* Use "Transfer-Encoding: chunked" instead of Content-Length */
+  gboolean chunked;
+  /* Honour HTTP/1.1 persistent connections (and pipelined requests) */
+  gboolean keep_alive;
+  /* Probability [0, 1] of injecting an error into a response */
+  gdouble error_rate;
+  /* Status code used for injected errors. 0 means that the connection is
+   * dropped half-way through the body instead. */
+  guint error_status;
+} FluBenchServerConfig;
+
+/* Counters accumulated since the server was started */
+typedef struct _FluBenchServerStats
+{
+  guint64 connections;
+  guint64 requests;
+  guint64 errors_injected;
+  guint64 bytes_sent;
+  /* Request bodies (PUT, POST) received, without the chunked framing */
+  guint64 bytes_received;
+  /* CPU time spent by the server threads answering requests, in us. Lets
+   * benchmarks subtract the server share from the process CPU usage. */
+  gint64 cpu_time;
+} FluBenchServerStats;
+
+/* Fill a config with the defaults: no latency, no bandwidth cap, 16KB
+ * writes, Content-Length bodies, keep-alive and no errors. */
+void flu_bench_server_config_init (FluBenchServerConfig *config);
+
+/* Start a server listening on 127.0.0.1 on an ephemeral port. Connections
+ * are served from their own thread until flu_bench_server_free(). */
+FluBenchServer *flu_bench_server_new (const FluBenchServerConfig *config);
+
+/* Stop the server, close all connections and free it */
+void flu_bench_server_free (FluBenchServer *server);
+
+/* Port the server is listening on */
+guint16 flu_bench_server_get_port (FluBenchServer *server);
+
+/* Build the URL of a resource of 'size' bytes. 'query' is appended as is and
+ * can be NULL, or contain any of latency=, bandwidth=, chunk= (no larger
+ * than the configured one), chunked=, status= and drop= (bytes after which
+ * the connection is closed).
+ * Requests can carry a body (PUT, POST), with Content-Length or chunked. It
+ * must follow the same pattern as the resources, or the response is a 400.
+ * Free with g_free. */
+gchar *flu_bench_server_get_url (
+    FluBenchServer *server, guint64 size, const gchar *query);
+
+/* Copy the current counters */
+void flu_bench_server_get_stats (
+    FluBenchServer *server, FluBenchServerStats *stats);
+
+G_END_DECLS
+
+#endif /* _FLUBENCHSERVER_H */
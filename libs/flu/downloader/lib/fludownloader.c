@@ -21,6 +21,7 @@
  */
 
 #include "fludownloader.h"
+#include "fludownloaderfile.h"
 
 #include <gst/gst.h>
 #include <glib/gstdio.h> /* g_stat */
@@ -32,6 +33,7 @@
 #define DATE_MAX_LENGTH 48
 #define DEFAULT_CONNECT_TIMEOUT (20 * 1000 * 1000) /* us, 20s */
 #define DEFAULT_RECEIVE_TIMEOUT (3 * 1000 * 1000)  /* us, 3s */
+#define TIMER_RESOLUTION (10 * 1000)                /* us, 10ms */
 
 /*****************************************************************************
  * Private functions and structs
@@ -43,6 +45,11 @@ static GStaticMutex _init_lock = G_STATIC_MUTEX_INIT;
 #endif
 static gint _init_count = 0;
 
+/* Process-wide memory accounting, see fludownloader_set_memory_budget() */
+static GMutex _memory_lock;
+static gsize _memory_usage = 0;
+static gsize _memory_budget = 0;
+
 /* Takes care of a session, which might include multiple tasks */
 struct _FluDownloader
 {
@@ -54,11 +61,23 @@ struct _FluDownloader
   /* API stuff */
   FluDownloaderDataCallback data_cb;
   FluDownloaderDoneCallback done_cb;
+  FluDownloaderBatchDoneCallback batch_done_cb;
+  gpointer batch_done_data;
+  GArray *completions;       /* FluDownloaderTaskCompletion, not delivered */
+  GArray *completions_spare; /* Swapped with the above when delivering */
+  gboolean flushing;         /* completions_spare is being delivered */
 
   /* CURL stuff */
   CURLM *handle; /* CURL multi handler */
   GList *queued_tasks;
 
+  /* Timeouts. Armed tasks are refreshed once per loop iteration if they
+   * had any activity, instead of reading the clock on every callback.
+   * The wheel is not thread safe, every call on it is made with the lock
+   * taken. The active list is only touched from the downloader thread. */
+  FlucTimerWheel *timers;
+  FluDownloaderTask *active_tasks;
+
   /* CPU control stuff */
   gboolean use_polling; /* Do not use select() */
   gint polling_period;  /* uSeconds to wait between curl checks */
@@ -71,8 +90,11 @@ struct _FluDownloader
   gchar
       *proxy; /* String containing the proxy server used optionally by cURL */
 
-  /* bandwidth meter */
+  /* bandwidth meters */
   FlucBwMeter *bwmeter;
+  FlucBwMeter *write_bwmeter; /* Upload tasks */
+  curl_off_t max_send_speed;  /* Bytes per second for uploads, 0 unlimited */
+  guint upload_paused_tasks;  /* Running uploads waiting for the app */
 
   gboolean running;
   gboolean paused;
@@ -80,6 +102,12 @@ struct _FluDownloader
   gboolean discarding;
   guint32 discard;
   guint32 discarded;
+
+  /* Memory accounting, protected by _memory_lock */
+  gsize memory_budget; /* 0 means no accounting */
+  gsize memory_usage;
+  guint memory_paused_tasks; /* Running tasks paused for memory */
+  guint memory_resume_pass;  /* Count of _memory_resume_tasks() calls */
 };
 
 /* Takes care of one task (file) */
@@ -92,6 +120,20 @@ struct _FluDownloaderTask
   gboolean abort;     /* Signal the write callback to return error */
   gboolean running;   /* Has it already been passed to libCurl? */
   gboolean is_file;   /* URL starts with file:// */
+  gboolean memory_paused;  /* Paused by the memory budget */
+  guint memory_resume_pass; /* Last pass which tried to resume it */
+  FluDownloaderFile *file; /* Destination file, NULL to use data_cb */
+
+  /* Upload control */
+  gboolean upload;                   /* The request has a body */
+  FluDownloaderReadCallback read_cb; /* NULL to send the pushed buffers */
+  GQueue upload_buffers;             /* GBytes not fully sent yet */
+  gsize upload_buffer_offset;        /* Bytes of the head already sent */
+  gboolean upload_eos;               /* No more buffers will be pushed */
+  gboolean upload_paused;            /* Waiting for the application */
+  gboolean upload_ready;             /* Resume requested by the app */
+  size_t uploaded_size;              /* Amount of body bytes sent */
+  struct curl_slist *headers;
 
   /* Download control */
   size_t total_size;           /* File size reported by HTTP headers */
@@ -103,7 +145,10 @@ struct _FluDownloaderTask
 
   /* timeouts control */
   gint64 idle_timeout;
-  gint64 last_event_time;
+  FlucTimer timeout;
+  gboolean timed_out;
+  gboolean active;                /* In the context active list */
+  FluDownloaderTask *next_active; /* Next in the context active list */
 
   /* CURL stuff */
   CURL *handle; /* CURL easy handler */
@@ -121,11 +166,181 @@ struct _FluDownloaderTask
 static void _task_done (FluDownloaderTask *task, CURLcode result);
 static void _process_curl_messages (FluDownloader *context);
 
+/* Whether the context must stop receiving data because of its memory
+ * budget or the process-wide one. Call with _memory_lock taken. */
+static gboolean
+_memory_exhausted_unlocked (FluDownloader *context)
+{
+  if (!context->memory_budget)
+    return FALSE;
+
+  return context->memory_usage >= context->memory_budget ||
+         (_memory_budget && _memory_usage >= _memory_budget);
+}
+
+/* Add (or remove, for negative values) memory to the usage of the context,
+ * if any, and to the process-wide usage. Nothing is accounted without a
+ * budget, for the context or, with no context, the process-wide one. */
+static void
+_memory_account (FluDownloader *context, gssize size)
+{
+  g_mutex_lock (&_memory_lock);
+  if (context ? !context->memory_budget : !_memory_budget) {
+    g_mutex_unlock (&_memory_lock);
+    return;
+  }
+  if (size < 0) {
+    gsize released = -size;
+    if (context)
+      context->memory_usage -= MIN (released, context->memory_usage);
+    _memory_usage -= MIN (released, _memory_usage);
+  } else {
+    if (context)
+      context->memory_usage += size;
+    _memory_usage += size;
+  }
+  g_mutex_unlock (&_memory_lock);
+}
+
+/* Remove the usage of the context from the process-wide usage.
+ * Call with _memory_lock taken. */
+static void
+_memory_forget_unlocked (FluDownloader *context)
+{
+  _memory_usage -= MIN (context->memory_usage, _memory_usage);
+  context->memory_usage = 0;
+}
+
+/* Record activity on a running task, which postpones its timeout.
+ * Only call from the downloader thread. */
+static void
+_task_touch (FluDownloaderTask *task)
+{
+  FluDownloader *context = task->context;
+
+  if (task->active)
+    return;
+  task->active = TRUE;
+  task->next_active = context->active_tasks;
+  context->active_tasks = task;
+}
+
+/* Restart the idle timeout of the tasks which had activity since the last
+ * call. Call with the lock taken. */
+static void
+_refresh_timeouts (FluDownloader *context, gint64 now)
+{
+  while (context->active_tasks) {
+    FluDownloaderTask *task = context->active_tasks;
+
+    context->active_tasks = task->next_active;
+    task->active = FALSE;
+    task->next_active = NULL;
+    fluc_timer_wheel_arm (
+        context->timers, &task->timeout, now + task->idle_timeout);
+  }
+}
+
+/* The task had no activity for idle_timeout. The progress function will
+ * abort it. */
+static void
+_timeout_expired (FlucTimer *timer, FluDownloaderTask *task)
+{
+  FluDownloader *context = task->context;
+
+  /* Waiting on purpose, not idle */
+  if (task->memory_paused || task->upload_paused) {
+    fluc_timer_wheel_arm (context->timers, timer,
+        fluc_timer_wheel_get_time (context->timers) + task->idle_timeout);
+    return;
+  }
+  task->timed_out = TRUE;
+}
+
+/* Apply the pause state of both directions of a running transfer */
+static void
+_task_update_pause (FluDownloaderTask *task)
+{
+  int mask = (task->memory_paused ? CURLPAUSE_RECV : 0) |
+             (task->upload_paused ? CURLPAUSE_SEND : 0);
+
+  curl_easy_pause (task->handle, mask);
+}
+
+/* Restart the transfers paused for memory, once there is room again or if
+ * they have been aborted. One at a time, since restarting a transfer runs
+ * the callbacks, which can pause it again or finish other tasks. Each task
+ * is tried once per pass, a task paused again waits for the next one.
+ * Only call from the downloader thread, with the lock taken. */
+static void
+_memory_resume_tasks (FluDownloader *context)
+{
+  guint pass = ++context->memory_resume_pass;
+
+  while (context->memory_paused_tasks > 0) {
+    FluDownloaderTask *task = NULL;
+    gboolean exhausted;
+    GList *link;
+
+    g_mutex_lock (&_memory_lock);
+    exhausted = _memory_exhausted_unlocked (context);
+    g_mutex_unlock (&_memory_lock);
+
+    for (link = context->queued_tasks; link; link = link->next) {
+      FluDownloaderTask *t = (FluDownloaderTask *) link->data;
+      if (t->memory_paused && t->memory_resume_pass != pass &&
+          (!exhausted || t->abort)) {
+        task = t;
+        break;
+      }
+    }
+    if (!task)
+      break;
+
+    task->memory_resume_pass = pass;
+    task->memory_paused = FALSE;
+    context->memory_paused_tasks--;
+    _task_touch (task);
+    _task_update_pause (task);
+  }
+}
+
+/* Restart the uploads that were waiting for the application, like
+ * _memory_resume_tasks() does.
+ * Only call from the downloader thread, with the lock taken. */
+static void
+_upload_resume_tasks (FluDownloader *context)
+{
+  while (context->upload_paused_tasks > 0) {
+    FluDownloaderTask *task = NULL;
+    GList *link;
+
+    for (link = context->queued_tasks; link; link = link->next) {
+      FluDownloaderTask *t = (FluDownloaderTask *) link->data;
+      if (t->upload_paused &&
+          (t->upload_ready || t->upload_eos || t->abort ||
+              !g_queue_is_empty (&t->upload_buffers))) {
+        task = t;
+        break;
+      }
+    }
+    if (!task)
+      break;
+
+    task->upload_paused = FALSE;
+    context->upload_paused_tasks--;
+    _task_touch (task);
+    _task_update_pause (task);
+  }
+}
+
 /* Removes a task. Transfer will NOT be interrupted if it had already started.
- * Call with the lock taken. */
+ * Takes the lock, as the downloader thread also finishes tasks while other
+ * threads schedule new ones. */
 static void
 _remove_task (FluDownloader *context, FluDownloaderTask *task)
 {
+  fluc_rec_mutex_lock (&context->lock);
   if (task->running) {
     /* If the task has already been submitted to libCurl, remove it.
      * If libCurl has already issued the GET, it will close the connection
@@ -136,6 +351,26 @@ _remove_task (FluDownloader *context, FluDownloaderTask *task)
   }
   curl_easy_cleanup (task->handle);
   context->queued_tasks = g_list_remove (context->queued_tasks, task);
+  fluc_timer_wheel_cancel (context->timers, &task->timeout);
+  if (task->active) {
+    FluDownloaderTask **link = &context->active_tasks;
+    while (*link != task)
+      link = &(*link)->next_active;
+    *link = task->next_active;
+  }
+  if (task->memory_paused)
+    context->memory_paused_tasks--;
+  if (task->upload_paused)
+    context->upload_paused_tasks--;
+  fluc_rec_mutex_unlock (&context->lock);
+
+  g_queue_clear_full (&task->upload_buffers, (GDestroyNotify) g_bytes_unref);
+  if (task->headers)
+    curl_slist_free_all (task->headers);
+
+  /* Still open if the task never finished, keep it resumable */
+  if (task->file)
+    fludownloader_file_close (task->file, FALSE);
 
   if (task->header_lines)
     g_list_free_full (task->header_lines, g_free);
@@ -273,10 +508,31 @@ _task_done (FluDownloaderTask *task, CURLcode result)
     task->outcome = outcome;
   }
 
+  if (task->file) {
+    gboolean complete = task->outcome == FLUDOWNLOADER_TASK_OK;
+    if (!fludownloader_file_close (task->file, complete) && complete)
+      task->outcome = FLUDOWNLOADER_TASK_FILE_WRITE_ERROR;
+    task->file = NULL;
+  }
+
   fluc_bwmeter_update (task->context->bwmeter);
   fluc_bwmeter_end (task->context->bwmeter);
+  if (task->upload && task->running) {
+    fluc_bwmeter_update (task->context->write_bwmeter);
+    fluc_bwmeter_end (task->context->write_bwmeter);
+  }
   task->finished = TRUE;
-  if (context->done_cb) {
+  if (context->batch_done_cb) {
+    FluDownloaderTaskCompletion completion;
+
+    completion.outcome = task->outcome;
+    completion.http_status_code = task->http_status;
+    completion.downloaded_size = task->downloaded_size;
+    completion.user_data = task->user_data;
+    fluc_rec_mutex_lock (&context->lock);
+    g_array_append_val (context->completions, completion);
+    fluc_rec_mutex_unlock (&context->lock);
+  } else if (context->done_cb) {
     gboolean cancel_remaining_downloads = FALSE;
     context->done_cb (task->outcome, task->http_status, task->downloaded_size,
         task->user_data, task, &cancel_remaining_downloads);
@@ -286,6 +542,40 @@ _task_done (FluDownloaderTask *task, CURLcode result)
   _remove_task (context, task);
 }
 
+/* Deliver the completions accumulated since the last call through a single
+ * batch_done_cb call. Call with the lock taken. It is released around the
+ * callback, as it is around done_cb, so the application can call back into
+ * the downloader from other threads while handling the batch. */
+static void
+_flush_completions (FluDownloader *context)
+{
+  GArray *completions = context->completions;
+  FluDownloaderBatchDoneCallback batch_done_cb = context->batch_done_cb;
+  gpointer batch_done_data = context->batch_done_data;
+  gboolean cancel;
+
+  /* While a batch is being delivered, new completions wait for the next
+   * call instead of reusing the array the callback is reading */
+  if (!batch_done_cb || !completions->len || context->flushing)
+    return;
+
+  /* Tasks finished from within the callback go to the other array */
+  context->completions = context->completions_spare;
+  context->completions_spare = completions;
+  context->flushing = TRUE;
+
+  fluc_rec_mutex_unlock (&context->lock);
+  cancel = batch_done_cb (
+      &g_array_index (completions, FluDownloaderTaskCompletion, 0),
+      completions->len, batch_done_data);
+  fluc_rec_mutex_lock (&context->lock);
+
+  if (cancel)
+    _abort_all_tasks_unlocked (context, FALSE);
+  g_array_set_size (completions, 0);
+  context->flushing = FALSE;
+}
+
 /* Gets called by libCurl when idle */
 static int
 _progress_function (
@@ -298,16 +588,97 @@ _progress_function (
     if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
       task->outcome = FLUDOWNLOADER_TASK_ABORTED;
     ret = -1;
-  } else {
-    gint64 now = g_get_monotonic_time ();
-    if (now - task->last_event_time > task->idle_timeout) {
+  } else if (task->timed_out) {
+    if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
+      task->outcome = (task->http_status >= 200 && task->http_status <= 299)
+                          ? FLUDOWNLOADER_TASK_RECV_ERROR
+                          : FLUDOWNLOADER_TASK_COULD_NOT_CONNECT;
+    ret = -1;
+  }
+  return ret;
+}
+
+/* Copy as much as possible of the pushed buffers. Call with the lock taken */
+static size_t
+_read_buffers (FluDownloaderTask *task, guint8 *buffer, size_t max_size)
+{
+  size_t size = 0;
+
+  while (size < max_size && !g_queue_is_empty (&task->upload_buffers)) {
+    GBytes *head = (GBytes *) g_queue_peek_head (&task->upload_buffers);
+    gsize head_size;
+    const guint8 *data = g_bytes_get_data (head, &head_size);
+    gsize copied;
+
+    copied = MIN (head_size - task->upload_buffer_offset, max_size - size);
+    memcpy (buffer + size, data + task->upload_buffer_offset, copied);
+    size += copied;
+    task->upload_buffer_offset += copied;
+    if (task->upload_buffer_offset >= head_size) {
+      g_queue_pop_head (&task->upload_buffers);
+      g_bytes_unref (head);
+      task->upload_buffer_offset = 0;
+    }
+  }
+
+  return size;
+}
+
+/* Gets called by libCurl when it needs more data to upload */
+static size_t
+_read_function (
+    char *buffer, size_t size, size_t nitems, FluDownloaderTask *task)
+{
+  FluDownloader *context = task->context;
+  size_t max_size = size * nitems;
+  size_t ret;
+
+  fluc_rec_mutex_lock (&context->lock);
+  if (task->abort) {
+    if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
+      task->outcome = FLUDOWNLOADER_TASK_ABORTED;
+    ret = CURL_READFUNC_ABORT;
+    goto beach;
+  }
+
+  task->upload_ready = FALSE;
+  if (task->read_cb) {
+    gssize read;
+
+    /* Not under the lock, as done_cb, since the application will likely
+     * need it from other threads to produce the data */
+    fluc_rec_mutex_unlock (&context->lock);
+    read = task->read_cb (buffer, max_size, task->user_data, task);
+    fluc_rec_mutex_lock (&context->lock);
+    if (read == FLUDOWNLOADER_UPLOAD_PAUSE) {
+      ret = CURL_READFUNC_PAUSE;
+    } else if (read < 0) {
       if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
-        task->outcome = (task->http_status >= 200 && task->http_status <= 299)
-                            ? FLUDOWNLOADER_TASK_RECV_ERROR
-                            : FLUDOWNLOADER_TASK_COULD_NOT_CONNECT;
-      ret = -1;
+        task->outcome = FLUDOWNLOADER_TASK_ABORTED;
+      ret = CURL_READFUNC_ABORT;
+    } else {
+      ret = MIN ((size_t) read, max_size);
     }
+  } else {
+    ret = _read_buffers (task, (guint8 *) buffer, max_size);
+    /* Returning 0 ends the body, only do it once told so */
+    if (!ret && !task->upload_eos)
+      ret = CURL_READFUNC_PAUSE;
+  }
+
+  if (ret == CURL_READFUNC_PAUSE) {
+    /* Resumed from the downloader thread, even if the callback itself
+     * already asked for it */
+    task->upload_paused = TRUE;
+    context->upload_paused_tasks++;
+  } else if (ret != CURL_READFUNC_ABORT && ret > 0) {
+    task->uploaded_size += ret;
+    _task_touch (task);
+    fluc_bwmeter_data (context->write_bwmeter, ret);
   }
+
+beach:
+  fluc_rec_mutex_unlock (&context->lock);
   return ret;
 }
 
@@ -322,6 +693,14 @@ _write_function (
   if (!total_size)
     goto beach;
 
+  /* Fail the transfer instead of pausing it again for memory, so an aborted
+   * task resumed by _memory_resume_tasks() finishes */
+  if (task->abort) {
+    if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
+      task->outcome = FLUDOWNLOADER_TASK_ABORTED;
+    return 0;
+  }
+
   /* Do not pass data if https status is not OK.
    * We may be streaming the data, and we must not
    * stream error bodies. */
@@ -337,6 +716,25 @@ _write_function (
   }
 
   context = task->context;
+
+  /* Data handed to the application counts against the memory budget.
+   * When there is no room, libcurl keeps this data until the transfer is
+   * resumed by the downloader thread. */
+  if (context->memory_budget && !task->file) {
+    g_mutex_lock (&_memory_lock);
+    if (_memory_exhausted_unlocked (context)) {
+      g_mutex_unlock (&_memory_lock);
+      fluc_rec_mutex_lock (&context->lock);
+      task->memory_paused = TRUE;
+      context->memory_paused_tasks++;
+      fluc_rec_mutex_unlock (&context->lock);
+      return CURL_WRITEFUNC_PAUSE;
+    }
+    context->memory_usage += total_size;
+    _memory_usage += total_size;
+    g_mutex_unlock (&_memory_lock);
+  }
+
   fluc_rec_mutex_lock (&context->lock);
   task->downloaded_size += total_size;
 
@@ -355,21 +753,29 @@ _write_function (
   }
 
   FluDownloaderDataCallback cb = task->context->data_cb;
-  if (cb) {
+  if (task->file) {
+    if (!fludownloader_file_write (task->file, buffer, total_size)) {
+      if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
+        task->outcome = FLUDOWNLOADER_TASK_FILE_WRITE_ERROR;
+      total_size = -1;
+    }
+  } else if (cb) {
     if (!cb (buffer, total_size, task->user_data, task)) {
       if (task->outcome == FLUDOWNLOADER_TASK_PENDING)
         task->outcome = FLUDOWNLOADER_TASK_ABORTED;
+      /* The application did not keep the data */
+      if (context->memory_budget)
+        _memory_account (context, -(gssize) total_size);
       total_size = -1;
     }
   }
 
 beach:
-  /* Currently the data callback may block, so we have to update the last
-   * event time AFTER the callback to prevent a receive timeout because the
-   * callback blocking.
-   * The progress and data callbacks can never nest, we don't need to be locked
-   */
-  task->last_event_time = g_get_monotonic_time ();
+  /* Currently the data callback may block, so the timeout must restart
+   * AFTER the callback to prevent a receive timeout because the callback
+   * blocking. It does, since it is restarted once curl_multi_perform()
+   * returns. */
+  _task_touch (task);
   return total_size;
 }
 
@@ -383,13 +789,15 @@ _header_function (
 
   fluc_rec_mutex_lock (&task->context->lock);
 
-  task->last_event_time = g_get_monotonic_time ();
+  _task_touch (task);
   if (sscanf (line, "HTTP/%*s %d", &http_status) == 1) {
     task->http_status = http_status;
     task->http_status_ok = http_status >= 200 && http_status <= 299;
     task->http_status_error = http_status >= 400;
     if (task->http_status_ok) {
       task->idle_timeout = task->context->receive_timeout;
+      if (task->file)
+        fludownloader_file_start (task->file, http_status == 206);
     }
   } else {
     /* This is another header line */
@@ -400,6 +808,8 @@ _header_function (
       if (sscanf (line, "Content-Length:%" G_GSIZE_FORMAT, &size) == 1) {
         /* Context length parsed ok */
         task->total_size = size;
+        if (task->file)
+          fludownloader_file_set_length (task->file, size);
       }
     }
   }
@@ -461,7 +871,8 @@ _schedule_tasks (FluDownloader *context)
     if (next_task_link) {
       next_task = (FluDownloaderTask *) next_task_link->data;
       /* Check if it is already running */
-      if (next_task->running || next_task->is_file || first_task->is_file) {
+      if (next_task->running || next_task->is_file || first_task->is_file ||
+          next_task->upload || first_task->upload) {
         /* Nothing to do then */
         next_task = NULL;
       } else {
@@ -476,10 +887,13 @@ _schedule_tasks (FluDownloader *context)
   }
 
   if (next_task) {
-    next_task->last_event_time = g_get_monotonic_time ();
+    fluc_timer_wheel_arm (context->timers, &next_task->timeout,
+        g_get_monotonic_time () + next_task->idle_timeout);
     next_task->running = TRUE;
     curl_multi_add_handle (context->handle, next_task->handle);
     fluc_bwmeter_start (context->bwmeter);
+    if (next_task->upload)
+      fluc_bwmeter_start (context->write_bwmeter);
   }
 }
 
@@ -493,6 +907,7 @@ _thread_function (FluDownloader *context)
   fd_set rfds, wfds, efds;
   int max_fd;
   int num_queued_tasks;
+  gint64 now;
 
   fluc_rec_mutex_lock (&context->lock);
   while (!context->shutdown) {
@@ -511,7 +926,7 @@ _thread_function (FluDownloader *context)
       tv.tv_sec = 0;
       tv.tv_usec = TIMEOUT;
       fluc_rec_mutex_unlock (&context->lock);
-      select (max_fd + 1, &rfds, NULL, NULL, &tv);
+      select (max_fd + 1, &rfds, &wfds, NULL, &tv);
     } else {
       /* max_fd should never be 0, but better be safe than sorry. */
       fluc_rec_mutex_unlock (&context->lock);
@@ -525,7 +940,13 @@ _thread_function (FluDownloader *context)
 
     /* See if any queued task can be started */
     fluc_rec_mutex_lock (&context->lock);
+    now = g_get_monotonic_time ();
+    _refresh_timeouts (context, now);
+    fluc_timer_wheel_advance (context->timers, now);
+    _memory_resume_tasks (context);
+    _upload_resume_tasks (context);
     _schedule_tasks (context);
+    _flush_completions (context);
   }
   fluc_rec_mutex_unlock (&context->lock);
   return NULL;
@@ -592,10 +1013,13 @@ fludownloader_new (
 
   fluc_bwmeters_init ();
   context->bwmeter = fluc_bwmeters_get_read ();
+  context->write_bwmeter = fluc_bwmeters_get_write ();
   context->paused = FALSE;
   context->discarding = FALSE;
   context->discard = 32 * 1024;
   fluc_barrier_init (&context->paused_barrier, TRUE);
+  context->timers =
+      fluc_timer_wheel_new (TIMER_RESOLUTION, g_get_monotonic_time ());
 
   context->handle = curl_multi_init ();
   if (!context->handle)
@@ -616,6 +1040,7 @@ fludownloader_new (
   return context;
 
 error:
+  fluc_timer_wheel_free (context->timers);
   g_free (context);
   return NULL;
 }
@@ -634,6 +1059,12 @@ fludownloader_destroy (FluDownloader *context)
   /* Wait for thread to finish */
   g_thread_join (context->thread);
 
+  /* Deliver what the thread did not get to */
+  fluc_rec_mutex_lock (&context->lock);
+  if (context->batch_done_cb)
+    _flush_completions (context);
+  fluc_rec_mutex_unlock (&context->lock);
+
   /* Abort and free all tasks */
   link = context->queued_tasks;
   while (link) {
@@ -642,6 +1073,13 @@ fludownloader_destroy (FluDownloader *context)
     link = next;
   }
 
+  fluc_timer_wheel_free (context->timers);
+
+  /* Whatever the application did not release is gone with the context */
+  g_mutex_lock (&_memory_lock);
+  _memory_forget_unlocked (context);
+  g_mutex_unlock (&_memory_lock);
+
   fluc_barrier_clear (&context->paused_barrier);
   fluc_bwmeters_dispose ();
   fluc_rec_mutex_clear (&context->lock);
@@ -655,6 +1093,11 @@ fludownloader_destroy (FluDownloader *context)
   if (context->proxy)
     g_free (context->proxy);
 
+  if (context->completions) {
+    g_array_free (context->completions, TRUE);
+    g_array_free (context->completions_spare, TRUE);
+  }
+
   /* FIXME: This will crash libcurl if no easy handles have ever been added */
   curl_multi_cleanup (context->handle);
   g_free (context);
@@ -672,22 +1115,20 @@ fludownloader_task_set_cookies (FluDownloaderTask *task, gchar **cookies)
   }
 }
 
-FluDownloaderTask *
-fludownloader_new_task (FluDownloader *context, const gchar *url,
-    const gchar *range, gpointer user_data, gboolean locked)
+/* Create a task, ready to be queued */
+static FluDownloaderTask *
+_task_new (FluDownloader *context, const gchar *url, const gchar *range,
+    gpointer user_data)
 {
   FluDownloaderTask *task;
 
-  if (context == NULL || url == NULL)
-    return NULL;
-
   task = g_new0 (FluDownloaderTask, 1);
   task->outcome = FLUDOWNLOADER_TASK_PENDING;
   task->user_data = user_data;
   task->context = context;
   task->http_status_ok = TRUE;
   task->idle_timeout = context->connect_timeout;
-  task->last_event_time = g_get_monotonic_time ();
+  fluc_timer_init (&task->timeout, (FlucTimerFunc) _timeout_expired, task);
   task->is_file = g_str_has_prefix (url, "file://");
   memset (task->date, '\0', DATE_MAX_LENGTH);
   if (task->is_file) {
@@ -758,16 +1199,191 @@ fludownloader_new_task (FluDownloader *context, const gchar *url,
   if (context->proxy)
     curl_easy_setopt (task->handle, CURLOPT_PROXY, context->proxy);
 
+  return task;
+}
+
+static void
+_task_enqueue (
+    FluDownloader *context, FluDownloaderTask *task, gboolean locked)
+{
   if (locked)
     fluc_rec_mutex_lock (&context->lock);
   context->queued_tasks = g_list_append (context->queued_tasks, task);
   _schedule_tasks (context);
   if (locked)
     fluc_rec_mutex_unlock (&context->lock);
+}
+
+FluDownloaderTask *
+fludownloader_new_task (FluDownloader *context, const gchar *url,
+    const gchar *range, gpointer user_data, gboolean locked)
+{
+  FluDownloaderTask *task;
+
+  if (context == NULL || url == NULL)
+    return NULL;
+
+  task = _task_new (context, url, range, user_data);
+  _task_enqueue (context, task, locked);
 
   return task;
 }
 
+guint
+fludownloader_new_tasks (FluDownloader *context,
+    const FluDownloaderTaskRequest *requests, guint n_requests,
+    FluDownloaderTask **tasks, gboolean locked)
+{
+  GList *batch = NULL;
+  guint i, count = 0;
+
+  if (context == NULL || requests == NULL)
+    return 0;
+
+  /* Set up all the curl handles before taking the lock. Walk backwards so
+   * the batch can be built by prepending. */
+  for (i = n_requests; i > 0; i--) {
+    const FluDownloaderTaskRequest *request = &requests[i - 1];
+    FluDownloaderTask *task = NULL;
+
+    if (request->url) {
+      task = _task_new (
+          context, request->url, request->range, request->user_data);
+      batch = g_list_prepend (batch, task);
+      count++;
+    }
+    if (tasks)
+      tasks[i - 1] = task;
+  }
+
+  if (locked)
+    fluc_rec_mutex_lock (&context->lock);
+  context->queued_tasks = g_list_concat (context->queued_tasks, batch);
+  _schedule_tasks (context);
+  if (locked)
+    fluc_rec_mutex_unlock (&context->lock);
+
+  return count;
+}
+
+FluDownloaderTask *
+fludownloader_new_file_task (FluDownloader *context, const gchar *url,
+    const gchar *path, gpointer user_data, gboolean locked)
+{
+  FluDownloaderTask *task;
+  FluDownloaderFile *file;
+  guint64 offset;
+  gchar *range = NULL;
+
+  if (context == NULL || url == NULL || path == NULL)
+    return NULL;
+
+  file = fludownloader_file_open (path, url);
+  if (!file)
+    return NULL;
+
+  offset = fludownloader_file_get_resume_offset (file);
+  if (offset)
+    range = g_strdup_printf ("%" G_GUINT64_FORMAT "-", offset);
+
+  task = _task_new (context, url, range, user_data);
+  task->file = file;
+  /* Offsets must refer to the stored bytes, do not let the server encode */
+  curl_easy_setopt (task->handle, CURLOPT_ACCEPT_ENCODING, NULL);
+  g_free (range);
+
+  _task_enqueue (context, task, locked);
+
+  return task;
+}
+
+FluDownloaderTask *
+fludownloader_new_upload_task (FluDownloader *context, const gchar *url,
+    const gchar *method, FluDownloaderReadCallback read_cb,
+    gpointer user_data, gboolean locked)
+{
+  FluDownloaderTask *task;
+
+  if (context == NULL || url == NULL)
+    return NULL;
+
+  task = _task_new (context, url, NULL, user_data);
+  task->upload = TRUE;
+  task->read_cb = read_cb;
+  g_queue_init (&task->upload_buffers);
+
+  /* No size set, so libcurl sends the body with chunked encoding */
+  curl_easy_setopt (task->handle, CURLOPT_UPLOAD, 1L);
+  curl_easy_setopt (task->handle, CURLOPT_READFUNCTION,
+      (curl_read_callback) _read_function);
+  curl_easy_setopt (task->handle, CURLOPT_READDATA, task);
+  if (method && strcmp (method, "PUT") != 0)
+    curl_easy_setopt (task->handle, CURLOPT_CUSTOMREQUEST, method);
+  /* Do not wait for a "100 Continue" before sending the body */
+  task->headers = curl_slist_append (NULL, "Expect:");
+  curl_easy_setopt (task->handle, CURLOPT_HTTPHEADER, task->headers);
+  if (context->max_send_speed)
+    curl_easy_setopt (
+        task->handle, CURLOPT_MAX_SEND_SPEED_LARGE, context->max_send_speed);
+
+  _task_enqueue (context, task, locked);
+
+  return task;
+}
+
+void
+fludownloader_task_push_buffer (FluDownloaderTask *task, GBytes *buffer)
+{
+  FluDownloader *context = task->context;
+
+  fluc_rec_mutex_lock (&context->lock);
+  if (task->read_cb || task->upload_eos) {
+    g_warning ("Buffer pushed to a task which does not take buffers");
+    g_bytes_unref (buffer);
+  } else {
+    g_queue_push_tail (&task->upload_buffers, buffer);
+  }
+  fluc_rec_mutex_unlock (&context->lock);
+}
+
+void
+fludownloader_task_end_upload (FluDownloaderTask *task)
+{
+  FluDownloader *context = task->context;
+
+  fluc_rec_mutex_lock (&context->lock);
+  task->upload_eos = TRUE;
+  fluc_rec_mutex_unlock (&context->lock);
+}
+
+void
+fludownloader_task_resume_upload (FluDownloaderTask *task)
+{
+  FluDownloader *context = task->context;
+
+  fluc_rec_mutex_lock (&context->lock);
+  task->upload_ready = TRUE;
+  fluc_rec_mutex_unlock (&context->lock);
+}
+
+void
+fludownloader_set_batch_done_callback (FluDownloader *context,
+    FluDownloaderBatchDoneCallback batch_done_cb, gpointer user_data)
+{
+  fluc_rec_mutex_lock (&context->lock);
+  if (!context->completions) {
+    context->completions =
+        g_array_new (FALSE, FALSE, sizeof (FluDownloaderTaskCompletion));
+    context->completions_spare =
+        g_array_new (FALSE, FALSE, sizeof (FluDownloaderTaskCompletion));
+  }
+  /* Do not lose what was batched for the previous callback */
+  _flush_completions (context);
+  context->batch_done_cb = batch_done_cb;
+  context->batch_done_data = user_data;
+  fluc_rec_mutex_unlock (&context->lock);
+}
+
 void
 fludownloader_abort_task (FluDownloaderTask *task)
 {
@@ -841,6 +1457,12 @@ fludownloader_task_get_length (FluDownloaderTask *task)
   return task->total_size;
 }
 
+size_t
+fludownloader_task_get_uploaded_size (FluDownloaderTask *task)
+{
+  return task->uploaded_size;
+}
+
 const gchar *
 fludownloader_task_get_date (FluDownloaderTask *task)
 {
@@ -949,6 +1571,8 @@ fludownloader_get_outcome_string (FluDownloaderTaskOutcome outcome)
       return "Could not resolve host";
     case FLUDOWNLOADER_TASK_SSL_ERROR:
       return "SSL error";
+    case FLUDOWNLOADER_TASK_FILE_WRITE_ERROR:
+      return "File write error";
     default:
       return "<Unknown>";
   }
@@ -1036,6 +1660,55 @@ fludownloader_set_proxy (FluDownloader *context, const gchar *proxy)
   context->proxy = g_strdup (proxy);
 }
 
+void
+fludownloader_set_max_send_speed (
+    FluDownloader *context, guint64 bytes_per_second)
+{
+  context->max_send_speed = (curl_off_t) bytes_per_second;
+}
+
+void
+fludownloader_set_memory_budget (FluDownloader *context, gsize budget)
+{
+  g_mutex_lock (&_memory_lock);
+  context->memory_budget = budget;
+  if (!budget)
+    _memory_forget_unlocked (context);
+  g_mutex_unlock (&_memory_lock);
+}
+
+void
+fludownloader_set_global_memory_budget (gsize budget)
+{
+  g_mutex_lock (&_memory_lock);
+  _memory_budget = budget;
+  g_mutex_unlock (&_memory_lock);
+}
+
+void
+fludownloader_memory_acquire (FluDownloader *context, gsize size)
+{
+  _memory_account (context, size);
+}
+
+void
+fludownloader_memory_release (FluDownloader *context, gsize size)
+{
+  _memory_account (context, -(gssize) size);
+}
+
+gsize
+fludownloader_get_memory_usage (FluDownloader *context)
+{
+  gsize ret;
+
+  g_mutex_lock (&_memory_lock);
+  ret = context ? context->memory_usage : _memory_usage;
+  g_mutex_unlock (&_memory_lock);
+
+  return ret;
+}
+
 gint
 fludownloader_get_tasks_count (FluDownloader *context)
 {
@@ -43,6 +43,8 @@ typedef enum _FluDownloaderTaskOutcome
   FLUDOWNLOADER_TASK_COULD_NOT_RESOLVE_HOST,
   /* SSL related errors */
   FLUDOWNLOADER_TASK_SSL_ERROR,
+  /* The destination file of a file task could not be written */
+  FLUDOWNLOADER_TASK_FILE_WRITE_ERROR,
   /* LAST: No Task */
   FLUDOWNLOADER_TASK_NO_TASK,
 } FluDownloaderTaskOutcome;
@@ -85,11 +87,47 @@ typedef enum _FluDownloaderTaskSSLStatus
 typedef gboolean (*FluDownloaderDataCallback) (
     void *buffer, size_t size, gpointer user_data, FluDownloaderTask *task);
 
+/* Read callback for upload tasks. Copy up to 'size' bytes of the request body
+ * into 'buffer' and return how many were copied, 0 when the body is complete
+ * or -1 to cancel the task. Return FLUDOWNLOADER_UPLOAD_PAUSE when no data is
+ * available yet, and call fludownloader_task_resume_upload() once there is.
+ * It is called from the downloader thread, without the lock held. */
+typedef gssize (*FluDownloaderReadCallback) (
+    void *buffer, size_t size, gpointer user_data, FluDownloaderTask *task);
+
+#define FLUDOWNLOADER_UPLOAD_PAUSE ((gssize) -2)
+
 /* Done callback. Called when a download finishes. */
 typedef void (*FluDownloaderDoneCallback) (FluDownloaderTaskOutcome outcome,
     int http_status_code, size_t downloaded_size, gpointer user_data,
     FluDownloaderTask *task, gboolean *cancel_remaining_downloads);
 
+/* Description of a task for fludownloader_new_tasks(). 'range' follows the
+ * same rules as in fludownloader_new_task(). */
+typedef struct _FluDownloaderTaskRequest
+{
+  const gchar *url;
+  const gchar *range;
+  gpointer user_data;
+} FluDownloaderTaskRequest;
+
+/* Result of a finished task, as delivered to FluDownloaderBatchDoneCallback.
+ * The task itself has already been released. */
+typedef struct _FluDownloaderTaskCompletion
+{
+  FluDownloaderTaskOutcome outcome;
+  int http_status_code;
+  size_t downloaded_size;
+  gpointer user_data;
+} FluDownloaderTaskCompletion;
+
+/* Batched done callback. Receives all the tasks finished since the previous
+ * call, in completion order. Return TRUE to cancel the remaining downloads,
+ * like cancel_remaining_downloads does in FluDownloaderDoneCallback. */
+typedef gboolean (*FluDownloaderBatchDoneCallback) (
+    const FluDownloaderTaskCompletion *completions, guint n_completions,
+    gpointer user_data);
+
 /* Initialize the library */
 void fludownloader_init ();
 
@@ -110,6 +148,51 @@ void fludownloader_destroy (FluDownloader *context);
 FluDownloaderTask *fludownloader_new_task (FluDownloader *context,
     const gchar *url, const gchar *range, gpointer user_data, gboolean locked);
 
+/* Add several tasks at once. They are queued atomically, in order, taking
+ * the lock and running the scheduler only once; the curl handles are set up
+ * before the lock is taken. If 'tasks' is not NULL it receives the task of
+ * each request (NULL for requests without URL).
+ * Returns the number of queued tasks. */
+guint fludownloader_new_tasks (FluDownloader *context,
+    const FluDownloaderTaskRequest *requests, guint n_requests,
+    FluDownloaderTask **tasks, gboolean locked);
+
+/* Add a URL to be downloaded straight into the file at 'path', instead of
+ * going through the data callback, which is not called for this task.
+ * The file is preallocated when the server reports the Content-Length and
+ * written from a worker thread. Progress is kept in "<path>.fludl" so that,
+ * if the process dies or the task does not finish, adding the same URL and
+ * path again resumes the download from where it stopped. The sidecar is
+ * removed once the download completes.
+ * Returns NULL if the file cannot be opened. */
+FluDownloaderTask *fludownloader_new_file_task (FluDownloader *context,
+    const gchar *url, const gchar *path, gpointer user_data, gboolean locked);
+
+/* Add a streaming upload of 'url' using 'method' ("PUT" if NULL, or "POST").
+ * The body is sent with chunked transfer encoding as it is produced, either
+ * by 'read_cb' or, if it is NULL, from the buffers given to
+ * fludownloader_task_push_buffer(). Uploads share the queue, connections and
+ * thread of the downloads, but are never pipelined. The response body goes
+ * through the data callback and the completion is reported as usual.
+ * Outgoing traffic is accounted in fluc_bwmeters_get_write(). */
+FluDownloaderTask *fludownloader_new_upload_task (FluDownloader *context,
+    const gchar *url, const gchar *method, FluDownloaderReadCallback read_cb,
+    gpointer user_data, gboolean locked);
+
+/* Queue a buffer to be sent by an upload task without read callback. Takes
+ * ownership of the buffer. */
+void fludownloader_task_push_buffer (FluDownloaderTask *task, GBytes *buffer);
+
+/* Tell an upload task without read callback that no more buffers will be
+ * pushed, so the body is completed once the queued ones are sent */
+void fludownloader_task_end_upload (FluDownloaderTask *task);
+
+/* Tell an upload task which read callback returned
+ * FLUDOWNLOADER_UPLOAD_PAUSE that there is data again. Paused uploads are
+ * resumed from the downloader thread, within one polling period, and are
+ * not subject to the receive timeout meanwhile. */
+void fludownloader_task_resume_upload (FluDownloaderTask *task);
+
 /* Abort download task or remove it from queue if it has not started yet.
  * Tasks are automatically removed when they finish, so there is no need
  * to call this unless premature termination is desired. */
@@ -120,6 +203,16 @@ void fludownloader_abort_task (FluDownloaderTask *task);
 void fludownloader_abort_all_tasks (
     FluDownloader *context, gboolean including_current);
 
+/* Deliver completions in batches instead of one done_cb call per task.
+ * Once set, done_cb is no longer called. The batches are delivered from
+ * the downloader thread, once per iteration of its event loop, so tasks
+ * aborted from other threads are reported up to one polling period later.
+ * batch_done_cb is called without the lock held, so other threads can use
+ * the downloader meanwhile.
+ * Pass NULL to go back to done_cb. */
+void fludownloader_set_batch_done_callback (FluDownloader *context,
+    FluDownloaderBatchDoneCallback batch_done_cb, gpointer user_data);
+
 /* Lock the library. This allows making multiple library calls in an atomic
  * fashion (as long as they do not try to get the lock) */
 void fludownloader_lock (FluDownloader *context);
@@ -141,6 +234,9 @@ const gchar *fludownloader_task_get_url (FluDownloaderTask *task);
  * report it. Works for file:// transfers too. */
 size_t fludownloader_task_get_length (FluDownloaderTask *task);
 
+/* Retrieve the amount of request body sent by an upload task */
+size_t fludownloader_task_get_uploaded_size (FluDownloaderTask *task);
+
 /* Retrieve pointer to string containing "Date" field value from
  * HTTP header, if there is no such field in the header, returns NULL.. */
 const gchar *fludownloader_task_get_date (FluDownloaderTask *task);
@@ -196,6 +292,39 @@ void fludownloader_set_user_agent (
 /* Set downloader proxy */
 void fludownloader_set_proxy (FluDownloader *context, const gchar *proxy);
 
+/* Cap the send rate of upload tasks, in bytes per second, 0 for no limit.
+ * Only tasks added after the call are affected. */
+void fludownloader_set_max_send_speed (
+    FluDownloader *context, guint64 bytes_per_second);
+
+/* Memory budgets.
+ * Setting a budget on a context turns on accounting for it: every buffer
+ * passed to its data callback counts as in use until the application gives
+ * it back with fludownloader_memory_release(). While the usage of the
+ * context reaches its budget, or the process-wide usage reaches the global
+ * budget, its transfers are paused, and they are resumed (within one polling
+ * period) once enough memory has been released. Pass 0 to turn accounting
+ * off, which also forgets the usage of the context, G_MAXSIZE to account
+ * without a per-context limit. */
+void fludownloader_set_memory_budget (FluDownloader *context, gsize budget);
+
+/* Process-wide budget, shared by all the contexts with accounting on.
+ * 0 (the default) means no limit. */
+void fludownloader_set_global_memory_budget (gsize budget);
+
+/* Account memory held outside the data callback (helper buffers,
+ * read-ahead, ...) on a context or, with a NULL context, only process-wide.
+ * Ignored if the context has no budget, or with a NULL context if there is
+ * no global budget. */
+void fludownloader_memory_acquire (FluDownloader *context, gsize size);
+
+/* Give back memory accounted by the data callback or by
+ * fludownloader_memory_acquire() */
+void fludownloader_memory_release (FluDownloader *context, gsize size);
+
+/* Current memory usage of a context, or process-wide for NULL */
+gsize fludownloader_get_memory_usage (FluDownloader *context);
+
 /* Get tasks count. It includes the active task. */
 gint fludownloader_get_tasks_count (FluDownloader *context);
 
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* fallocate */
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fludownloaderfile.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FILE_BUFFER_SIZE (1024 * 1024) /* Size of each write */
+#define FILE_BUFFER_COUNT 4            /* Buffers in flight */
+#define FILE_BUFFER_ALIGN 4096         /* Memory and file offset alignment */
+#define FILE_SYNC_INTERVAL (32 * 1024 * 1024) /* Bytes between checkpoints */
+#define SIDECAR_SUFFIX ".fludl"
+
+typedef struct _FluDownloaderFileBuffer
+{
+  guint8 *data;
+  gsize size;
+  guint64 offset;
+} FluDownloaderFileBuffer;
+
+struct _FluDownloaderFile
+{
+  gchar *path;
+  gchar *sidecar_path;
+  gchar *url;
+  int fd;
+
+  guint64 resume_offset; /* Where this run started writing */
+  guint64 offset;        /* File offset of the buffer being filled */
+
+  /* Set by the caller thread, read by the worker for the sidecar */
+  GMutex lock;
+  guint64 total_size; /* 0 if unknown */
+
+  /* Owned by the caller thread */
+  FluDownloaderFileBuffer *current;
+  gboolean received; /* Data was written in this run */
+
+  /* Worker thread and its queues. A buffer with no data stops the worker. */
+  GThread *thread;
+  GAsyncQueue *full_buffers;
+  GAsyncQueue *free_buffers;
+  FluDownloaderFileBuffer buffers[FILE_BUFFER_COUNT];
+  FluDownloaderFileBuffer stop;
+
+  /* Owned by the worker thread */
+  guint64 committed; /* Bytes known to be on disk, from 0 */
+  guint64 synced;    /* 'committed' at the last checkpoint */
+  gint error;        /* Accessed atomically */
+};
+
+/* Write the sidecar atomically. Only call once 'committed' bytes are synced */
+static void
+_save_sidecar (FluDownloaderFile *file, guint64 committed)
+{
+  gchar *contents;
+  guint64 total_size;
+
+  g_mutex_lock (&file->lock);
+  total_size = file->total_size;
+  g_mutex_unlock (&file->lock);
+
+  contents = g_strdup_printf ("url=%s\nsize=%" G_GUINT64_FORMAT
+                              "\ndone=0-%" G_GUINT64_FORMAT "\n",
+      file->url, total_size, committed);
+  if (!g_file_set_contents (file->sidecar_path, contents, -1, NULL))
+    g_warning ("Could not write %s", file->sidecar_path);
+  g_free (contents);
+}
+
+/* Read the sidecar left by a previous run, if any, and return the offset
+ * from which the download can be resumed */
+static guint64
+_load_sidecar (FluDownloaderFile *file)
+{
+  gchar *contents = NULL;
+  gchar **lines, **it;
+  gboolean same_url = FALSE;
+  guint64 size = 0, done = 0;
+  GStatBuf s;
+
+  if (!g_file_get_contents (file->sidecar_path, &contents, NULL, NULL))
+    return 0;
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (it = lines; *it; it++) {
+    guint64 start, end;
+
+    if (g_str_has_prefix (*it, "url="))
+      same_url = !strcmp (*it + 4, file->url);
+    else if (sscanf (*it, "size=%" G_GUINT64_FORMAT, &size) == 1)
+      continue;
+    else if (sscanf (*it, "done=%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+                 &start, &end) == 2 &&
+             start == 0)
+      done = end;
+  }
+  g_strfreev (lines);
+  g_free (contents);
+
+  /* Never trust the sidecar beyond what the file actually holds, nor one
+   * whose final size does not fit the file, which was preallocated to it
+   * at most */
+  if (!same_url || g_stat (file->path, &s) != 0 || (guint64) s.st_size < done)
+    return 0;
+  if (size && (done > size || (guint64) s.st_size > size))
+    return 0;
+  file->total_size = size;
+
+  /* Keep writes aligned, a few bytes will be downloaded again */
+  return done - done % FILE_BUFFER_ALIGN;
+}
+
+static gpointer
+_worker_function (FluDownloaderFile *file)
+{
+  FluDownloaderFileBuffer *buffer;
+
+  while ((buffer = g_async_queue_pop (file->full_buffers)) != &file->stop) {
+    guint8 *ptr = buffer->data;
+    gsize left = buffer->size;
+    guint64 offset = buffer->offset;
+
+    while (left > 0 && !g_atomic_int_get (&file->error)) {
+      ssize_t ret = pwrite (file->fd, ptr, left, offset);
+      if (ret < 0) {
+        if (errno == EINTR)
+          continue;
+        g_warning ("Write to %s failed: %s", file->path, strerror (errno));
+        g_atomic_int_set (&file->error, TRUE);
+        break;
+      }
+      ptr += ret;
+      left -= ret;
+      offset += ret;
+    }
+
+    if (!g_atomic_int_get (&file->error)) {
+      file->committed = buffer->offset + buffer->size;
+      if (file->committed - file->synced >= FILE_SYNC_INTERVAL &&
+          fdatasync (file->fd) == 0) {
+        file->synced = file->committed;
+        _save_sidecar (file, file->synced);
+      }
+    }
+
+    buffer->size = 0;
+    g_async_queue_push (file->free_buffers, buffer);
+  }
+
+  return NULL;
+}
+
+/* Hand the buffer being filled over to the worker */
+static void
+_push_current (FluDownloaderFile *file)
+{
+  FluDownloaderFileBuffer *buffer = file->current;
+
+  if (!buffer)
+    return;
+  buffer->offset = file->offset;
+  file->offset += buffer->size;
+  file->current = NULL;
+  g_async_queue_push (file->full_buffers, buffer);
+}
+
+/*****************************************************************************
+ * Private API
+ *****************************************************************************/
+
+FluDownloaderFile *
+fludownloader_file_open (const gchar *path, const gchar *url)
+{
+  FluDownloaderFile *file;
+  int flags = O_WRONLY | O_CREAT;
+  gint i;
+
+  file = g_new0 (FluDownloaderFile, 1);
+  file->path = g_strdup (path);
+  file->sidecar_path = g_strconcat (path, SIDECAR_SUFFIX, NULL);
+  file->url = g_strdup (url);
+  g_mutex_init (&file->lock);
+
+  file->resume_offset = _load_sidecar (file);
+  if (!file->resume_offset)
+    flags |= O_TRUNC;
+  file->fd = g_open (path, flags, 0644);
+  if (file->fd < 0) {
+    g_warning ("Could not open %s: %s", path, strerror (errno));
+    g_mutex_clear (&file->lock);
+    g_free (file->path);
+    g_free (file->sidecar_path);
+    g_free (file->url);
+    g_free (file);
+    return NULL;
+  }
+
+  file->offset = file->resume_offset;
+  file->committed = file->synced = file->resume_offset;
+
+  file->full_buffers = g_async_queue_new ();
+  file->free_buffers = g_async_queue_new ();
+  for (i = 0; i < FILE_BUFFER_COUNT; i++) {
+    void *data = NULL;
+    if (posix_memalign (&data, FILE_BUFFER_ALIGN, FILE_BUFFER_SIZE) != 0)
+      g_error ("Out of memory");
+    file->buffers[i].data = data;
+    g_async_queue_push (file->free_buffers, &file->buffers[i]);
+  }
+
+  file->thread = g_thread_new (
+      "fludownloaderfile", (GThreadFunc) _worker_function, file);
+
+  return file;
+}
+
+guint64
+fludownloader_file_get_resume_offset (FluDownloaderFile *file)
+{
+  return file->resume_offset;
+}
+
+void
+fludownloader_file_start (FluDownloaderFile *file, gboolean partial)
+{
+  if (partial || !file->resume_offset)
+    return;
+
+  /* The server ignored our range: start over. Nothing has been queued yet,
+   * so the worker is idle. */
+  file->resume_offset = 0;
+  g_mutex_lock (&file->lock);
+  file->total_size = 0;
+  g_mutex_unlock (&file->lock);
+  file->offset = 0;
+  file->committed = file->synced = 0;
+  if (ftruncate (file->fd, 0) != 0)
+    g_atomic_int_set (&file->error, TRUE);
+}
+
+void
+fludownloader_file_set_length (FluDownloaderFile *file, guint64 length)
+{
+  g_mutex_lock (&file->lock);
+  file->total_size = file->resume_offset + length;
+  g_mutex_unlock (&file->lock);
+#ifdef HAVE_FALLOCATE
+  /* Not fatal, the writes will extend the file as needed. No fallback to
+   * posix_fallocate(), which may write the whole file with zeros. */
+  if (length)
+    fallocate (file->fd, 0, file->resume_offset, length);
+#endif
+}
+
+gboolean
+fludownloader_file_write (
+    FluDownloaderFile *file, const void *data, gsize size)
+{
+  const guint8 *ptr = data;
+
+  if (size)
+    file->received = TRUE;
+
+  while (size > 0) {
+    gsize chunk;
+
+    if (g_atomic_int_get (&file->error))
+      return FALSE;
+
+    if (!file->current)
+      file->current = g_async_queue_pop (file->free_buffers);
+
+    chunk = MIN (size, FILE_BUFFER_SIZE - file->current->size);
+    memcpy (file->current->data + file->current->size, ptr, chunk);
+    file->current->size += chunk;
+    ptr += chunk;
+    size -= chunk;
+
+    if (file->current->size == FILE_BUFFER_SIZE)
+      _push_current (file);
+  }
+
+  return !g_atomic_int_get (&file->error);
+}
+
+gboolean
+fludownloader_file_close (FluDownloaderFile *file, gboolean complete)
+{
+  gboolean ok;
+  gint i;
+
+  _push_current (file);
+  g_async_queue_push (file->full_buffers, &file->stop);
+  g_thread_join (file->thread);
+
+  ok = !g_atomic_int_get (&file->error);
+  if (ok && complete) {
+    /* Drop any preallocated space the server did not fill */
+    if (ftruncate (file->fd, file->committed) != 0 ||
+        fdatasync (file->fd) != 0) {
+      ok = FALSE;
+    } else {
+      g_unlink (file->sidecar_path);
+    }
+  } else {
+    if (file->committed > file->synced && fdatasync (file->fd) == 0)
+      file->synced = file->committed;
+    /* Only describe data which was actually received. A task which got
+     * nothing leaves the sidecar of a resumed download as it was. */
+    if (file->received && file->synced)
+      _save_sidecar (file, file->synced);
+    else if (!file->resume_offset)
+      g_unlink (file->sidecar_path);
+  }
+  close (file->fd);
+
+  for (i = 0; i < FILE_BUFFER_COUNT; i++)
+    free (file->buffers[i].data);
+  g_async_queue_unref (file->full_buffers);
+  g_async_queue_unref (file->free_buffers);
+  g_mutex_clear (&file->lock);
+  g_free (file->path);
+  g_free (file->sidecar_path);
+  g_free (file->url);
+  g_free (file);
+
+  return ok;
+}
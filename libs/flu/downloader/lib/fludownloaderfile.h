@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef _FLUDOWNLOADERFILE_H
+#define _FLUDOWNLOADERFILE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Writes the body of a download task into a file from a worker thread, using
+ * large aligned writes. Progress is recorded in a sidecar file ("<path>.fludl")
+ * which is only updated after the data it describes has reached the disk, so
+ * an interrupted download can be resumed after a process restart.
+ * This is private to the downloader, see fludownloader_new_file_task(). */
+typedef struct _FluDownloaderFile FluDownloaderFile;
+
+/* Open 'path' for writing 'url'. If the sidecar says a previous download of
+ * the same URL was interrupted, the existing data is kept and
+ * fludownloader_file_get_resume_offset() tells where to continue.
+ * Returns NULL if the file cannot be opened. */
+FluDownloaderFile *fludownloader_file_open (
+    const gchar *path, const gchar *url);
+
+/* Offset from which the transfer has to be requested, 0 for a new download */
+guint64 fludownloader_file_get_resume_offset (FluDownloaderFile *file);
+
+/* Call when the response status is known. A full (non partial) response
+ * discards whatever a previous run had written. */
+void fludownloader_file_start (FluDownloaderFile *file, gboolean partial);
+
+/* Call with the Content-Length of the response, preallocates the file */
+void fludownloader_file_set_length (FluDownloaderFile *file, guint64 length);
+
+/* Queue data for writing. Blocks if the worker thread is too far behind.
+ * Returns FALSE if a previous write failed. */
+gboolean fludownloader_file_write (
+    FluDownloaderFile *file, const void *data, gsize size);
+
+/* Flush pending data, stop the worker and close the file. If 'complete' the
+ * file is trimmed to its final size and the sidecar removed, otherwise the
+ * sidecar is kept so the download can be resumed.
+ * Returns FALSE if any write failed. */
+gboolean fludownloader_file_close (FluDownloaderFile *file, gboolean complete);
+
+G_END_DECLS
+
+#endif /* _FLUDOWNLOADERFILE_H */
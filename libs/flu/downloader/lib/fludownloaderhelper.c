@@ -24,6 +24,8 @@ fludownloader_helper_data_cb (void *buffer, size_t size,
     FluDownloaderHelper *downloader, FluDownloaderTask *task)
 {
 
+  /* Counts against the global budget, if any, until the download ends */
+  fludownloader_memory_acquire (NULL, size);
   downloader->data =
       (guint8 *) g_realloc (downloader->data, downloader->size + size);
   memcpy (downloader->data + downloader->size, buffer, size);
@@ -39,6 +41,8 @@ fludownloader_helper_done_cb (FluDownloaderTaskOutcome outcome,
     gboolean *cancel_remaining_downloads)
 {
   g_mutex_lock (downloader->done_mutex);
+  /* The data is either freed or handed to the caller */
+  fludownloader_memory_release (NULL, downloader->size);
   if (outcome != FLUDOWNLOADER_TASK_OK) {
     g_free (downloader->data);
     downloader->size = 0;
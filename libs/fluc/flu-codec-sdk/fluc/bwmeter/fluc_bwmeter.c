@@ -28,6 +28,7 @@ fluc_bwmeters_init ()
   fluc_rec_mutex_lock (&ctx_lock);
   if (!ctx_init_count++) {
     ctx.read = fluc_bwmeter_sock_new ();
+    ctx.write = fluc_bwmeter_sock_new ();
   }
   fluc_rec_mutex_unlock (&ctx_lock);
 }
@@ -39,6 +40,8 @@ fluc_bwmeters_dispose ()
   if (!--ctx_init_count) {
     ctx.read->delete (ctx.read);
     ctx.read = NULL;
+    ctx.write->delete (ctx.write);
+    ctx.write = NULL;
   }
   fluc_rec_mutex_unlock (&ctx_lock);
 }
@@ -49,6 +52,12 @@ fluc_bwmeters_get_read ()
   return ctx.read;
 }
 
+FlucBwMeter *
+fluc_bwmeters_get_write ()
+{
+  return ctx.write;
+}
+
 void
 fluc_bwmeter_lock (FlucBwMeter *meter)
 {
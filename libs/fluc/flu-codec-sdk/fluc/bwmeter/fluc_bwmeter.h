@@ -22,9 +22,8 @@ typedef struct
 
 /**
  * Opaque structure representing a bwmeter.
- * Currently we only need a read meter, but this API is designed to easily
- * add a write meter if needed.
- * Each is a singleton, as a meter accounts for global traffic.
+ * There is a read meter for incoming traffic and a write meter for outgoing
+ * traffic. Each is a singleton, as a meter accounts for global traffic.
  */
 typedef struct _FlucBwMeter FlucBwMeter;
 
@@ -32,6 +31,7 @@ FLUC_EXPORT void fluc_bwmeters_init ();
 FLUC_EXPORT void fluc_bwmeters_dispose ();
 
 FLUC_EXPORT FlucBwMeter *fluc_bwmeters_get_read ();
+FLUC_EXPORT FlucBwMeter *fluc_bwmeters_get_write ();
 
 FLUC_EXPORT void fluc_bwmeter_lock (FlucBwMeter *meter);
 FLUC_EXPORT void fluc_bwmeter_unlock (FlucBwMeter *meter);
@@ -45,6 +45,7 @@ struct _FlucBwMeter
 typedef struct
 {
   FlucBwMeter *read;
+  FlucBwMeter *write;
 } FlucBwMeters;
 
 G_END_DECLS
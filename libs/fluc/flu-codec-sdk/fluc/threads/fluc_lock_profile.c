@@ -0,0 +1,404 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fluc_lock_profile.h"
+
+#if FLUC_LOCK_PROFILING
+
+#include <gst/gst.h>
+#include <time.h>
+
+GST_DEBUG_CATEGORY_STATIC (fluc_lock_profile_debug);
+#define GST_CAT_DEFAULT fluc_lock_profile_debug
+
+typedef struct
+{
+  const gchar *site;
+  guint64 acquisitions;
+  guint64 contended;
+  gint64 wait_time;
+} FlucLockProfileSite;
+
+/* Counters are updated by the holder of the profiled lock, under 'stats' so
+ * that the report can read them at any time */
+struct _FlucLockProfile
+{
+  const gchar *kind;
+  gconstpointer lock;
+  FlucLockProfile **owner; /* Field of the lock pointing to us */
+  gboolean retired;        /* Totals of the cleared locks of this kind */
+
+  GMutex stats;
+  guint64 acquisitions;
+  guint64 contended;
+  gint64 wait_time;
+  gint64 wait_max;
+  gint64 hold_time;
+  gint64 hold_max;
+  guint64 cond_waits;
+  gint64 cond_wait_time;
+  GHashTable *sites; /* site string -> FlucLockProfileSite */
+
+  /* Only touched by the holder */
+  guint depth; /* Recursive acquisitions */
+  gint64 hold_start;
+};
+
+/* Profiles of the live locks, and the totals of the cleared ones by kind,
+ * so the report does not grow with every short-lived lock */
+static GMutex registry_lock;
+static GHashTable *registry;
+static GHashTable *retired;
+
+static FlucLockProfile *
+_new (const gchar *kind, gconstpointer lock)
+{
+  FlucLockProfile *p;
+
+  p = g_new0 (FlucLockProfile, 1);
+  p->kind = kind;
+  p->lock = lock;
+  g_mutex_init (&p->stats);
+  p->sites = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+  return p;
+}
+
+static void
+_free (FlucLockProfile *profile)
+{
+  g_hash_table_unref (profile->sites);
+  g_mutex_clear (&profile->stats);
+  g_free (profile);
+}
+
+/* Add the counters of 'from' to 'to', with both stats locks taken */
+static void
+_merge_unlocked (FlucLockProfile *to, FlucLockProfile *from)
+{
+  GHashTableIter iter;
+  FlucLockProfileSite *s, *total;
+
+  to->acquisitions += from->acquisitions;
+  to->contended += from->contended;
+  to->wait_time += from->wait_time;
+  to->wait_max = MAX (to->wait_max, from->wait_max);
+  to->hold_time += from->hold_time;
+  to->hold_max = MAX (to->hold_max, from->hold_max);
+  to->cond_waits += from->cond_waits;
+  to->cond_wait_time += from->cond_wait_time;
+
+  g_hash_table_iter_init (&iter, from->sites);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &s)) {
+    total = g_hash_table_lookup (to->sites, s->site);
+    if (!total) {
+      total = g_new0 (FlucLockProfileSite, 1);
+      total->site = s->site;
+      g_hash_table_insert (to->sites, (gpointer) s->site, total);
+    }
+    total->acquisitions += s->acquisitions;
+    total->contended += s->contended;
+    total->wait_time += s->wait_time;
+  }
+}
+
+static void
+_reset_unlocked (FlucLockProfile *profile)
+{
+  profile->acquisitions = profile->contended = 0;
+  profile->wait_time = profile->wait_max = 0;
+  profile->hold_time = profile->hold_max = 0;
+  profile->cond_waits = 0;
+  profile->cond_wait_time = 0;
+  g_hash_table_remove_all (profile->sites);
+}
+
+static gint
+_compare_wait (gconstpointer a, gconstpointer b)
+{
+  const FlucLockProfile *pa = *(const FlucLockProfile **) a;
+  const FlucLockProfile *pb = *(const FlucLockProfile **) b;
+  return pa->wait_time < pb->wait_time ? 1
+                                       : (pa->wait_time > pb->wait_time ? -1 : 0);
+}
+
+gint64
+fluc_lock_profile_now (void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
+
+FlucLockProfile *
+fluc_lock_profile_get (
+    FlucLockProfile **profile, const gchar *kind, gconstpointer lock)
+{
+  FlucLockProfile *p = g_atomic_pointer_get (profile);
+
+  if (G_LIKELY (p))
+    return p;
+
+  p = _new (kind, lock);
+  p->owner = profile;
+
+  if (!g_atomic_pointer_compare_and_exchange (profile, NULL, p)) {
+    /* Somebody else created it first */
+    _free (p);
+    return g_atomic_pointer_get (profile);
+  }
+
+  g_mutex_lock (&registry_lock);
+  if (!registry) {
+    registry = g_hash_table_new (g_direct_hash, g_direct_equal);
+    retired = g_hash_table_new_full (
+        g_str_hash, g_str_equal, NULL, (GDestroyNotify) _free);
+  }
+  g_hash_table_add (registry, p);
+  g_mutex_unlock (&registry_lock);
+
+  return p;
+}
+
+void
+fluc_lock_profile_retire (FlucLockProfile *profile)
+{
+  FlucLockProfile *total;
+
+  /* Short-lived locks must show in the report too, as part of the totals
+   * of their kind */
+  g_mutex_lock (&registry_lock);
+  g_hash_table_remove (registry, profile);
+  total = g_hash_table_lookup (retired, profile->kind);
+  if (!total) {
+    total = _new (profile->kind, NULL);
+    total->retired = TRUE;
+    g_hash_table_insert (retired, (gpointer) profile->kind, total);
+  }
+  g_mutex_lock (&profile->stats);
+  g_mutex_lock (&total->stats);
+  _merge_unlocked (total, profile);
+  g_mutex_unlock (&total->stats);
+  g_mutex_unlock (&profile->stats);
+  g_mutex_unlock (&registry_lock);
+
+  _free (profile);
+}
+
+void
+fluc_lock_profile_acquired (
+    FlucLockProfile *profile, const gchar *site, gint64 wait)
+{
+  FlucLockProfileSite *s;
+
+  if (!profile->depth++)
+    profile->hold_start = fluc_lock_profile_now ();
+
+  if (!site)
+    site = "unknown";
+
+  g_mutex_lock (&profile->stats);
+  profile->acquisitions++;
+  profile->wait_time += wait;
+  profile->wait_max = MAX (profile->wait_max, wait);
+  if (wait)
+    profile->contended++;
+
+  s = g_hash_table_lookup (profile->sites, site);
+  if (!s) {
+    s = g_new0 (FlucLockProfileSite, 1);
+    s->site = site;
+    g_hash_table_insert (profile->sites, (gpointer) site, s);
+  }
+  s->acquisitions++;
+  s->wait_time += wait;
+  if (wait)
+    s->contended++;
+  g_mutex_unlock (&profile->stats);
+}
+
+void
+fluc_lock_profile_releasing (FlucLockProfile *profile)
+{
+  gint64 hold;
+
+  if (!profile->depth || --profile->depth)
+    return;
+
+  hold = fluc_lock_profile_now () - profile->hold_start;
+  g_mutex_lock (&profile->stats);
+  profile->hold_time += hold;
+  profile->hold_max = MAX (profile->hold_max, hold);
+  g_mutex_unlock (&profile->stats);
+}
+
+void
+fluc_lock_profile_cond_waited (FlucLockProfile *profile, gint64 time)
+{
+  /* The wait released the lock, holding starts again */
+  profile->depth = 1;
+  profile->hold_start = fluc_lock_profile_now ();
+
+  g_mutex_lock (&profile->stats);
+  profile->cond_waits++;
+  profile->cond_wait_time += time;
+  g_mutex_unlock (&profile->stats);
+}
+
+gchar *
+fluc_lock_profile_report (void)
+{
+  GString *report;
+  GPtrArray *profiles;
+  guint i;
+
+  /* Held all along, so no profile is retired while it is printed */
+  g_mutex_lock (&registry_lock);
+  profiles = g_ptr_array_new ();
+  if (registry) {
+    GHashTableIter iter;
+    FlucLockProfile *p;
+
+    g_hash_table_iter_init (&iter, registry);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &p, NULL))
+      g_ptr_array_add (profiles, p);
+    g_hash_table_iter_init (&iter, retired);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &p))
+      g_ptr_array_add (profiles, p);
+  }
+
+  g_ptr_array_sort (profiles, _compare_wait);
+
+  report = g_string_new (
+      "kind address acquisitions contended wait_ns wait_max_ns hold_ns "
+      "hold_max_ns cond_waits cond_wait_ns\n");
+  for (i = 0; i < profiles->len; i++) {
+    FlucLockProfile *p = g_ptr_array_index (profiles, i);
+    GHashTableIter iter;
+    FlucLockProfileSite *s;
+
+    g_mutex_lock (&p->stats);
+    if (!p->acquisitions) {
+      g_mutex_unlock (&p->stats);
+      continue;
+    }
+    if (p->retired)
+      g_string_append_printf (report, "%s cleared", p->kind);
+    else
+      g_string_append_printf (report, "%s %p", p->kind, p->lock);
+    g_string_append_printf (report,
+        " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GINT64_FORMAT
+        " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT
+        " %" G_GUINT64_FORMAT " %" G_GINT64_FORMAT "\n",
+        p->acquisitions, p->contended, p->wait_time, p->wait_max,
+        p->hold_time, p->hold_max, p->cond_waits, p->cond_wait_time);
+    g_hash_table_iter_init (&iter, p->sites);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &s)) {
+      g_string_append_printf (report,
+          "  at %s %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+          " %" G_GINT64_FORMAT "\n",
+          s->site, s->acquisitions, s->contended, s->wait_time);
+    }
+    g_mutex_unlock (&p->stats);
+  }
+  g_mutex_unlock (&registry_lock);
+  g_ptr_array_free (profiles, TRUE);
+
+  return g_string_free (report, FALSE);
+}
+
+void
+fluc_lock_profile_dump (void)
+{
+  gchar *report, **lines, **it;
+
+  GST_DEBUG_CATEGORY_INIT (fluc_lock_profile_debug, "fluclockprofile", 0,
+      "fluc lock contention profile");
+
+  report = fluc_lock_profile_report ();
+  lines = g_strsplit (report, "\n", -1);
+  for (it = lines; *it; it++) {
+    if (**it)
+      GST_INFO ("%s", *it);
+  }
+  g_strfreev (lines);
+  g_free (report);
+}
+
+void
+fluc_lock_profile_reset (void)
+{
+  GHashTableIter iter;
+  FlucLockProfile *p;
+
+  g_mutex_lock (&registry_lock);
+  if (registry) {
+    g_hash_table_iter_init (&iter, registry);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &p, NULL)) {
+      g_mutex_lock (&p->stats);
+      _reset_unlocked (p);
+      g_mutex_unlock (&p->stats);
+    }
+    /* Nothing worth keeping in the totals once cleared */
+    g_hash_table_remove_all (retired);
+  }
+  g_mutex_unlock (&registry_lock);
+}
+
+void
+fluc_lock_profile_dispose (void)
+{
+  GHashTableIter iter;
+  FlucLockProfile *p;
+
+  g_mutex_lock (&registry_lock);
+  if (registry) {
+    /* Locks used again start a new profile */
+    g_hash_table_iter_init (&iter, registry);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &p, NULL)) {
+      g_atomic_pointer_set (p->owner, NULL);
+      _free (p);
+    }
+    g_hash_table_unref (registry);
+    g_hash_table_unref (retired);
+    registry = retired = NULL;
+  }
+  g_mutex_unlock (&registry_lock);
+}
+
+#else /* FLUC_LOCK_PROFILING */
+
+gchar *
+fluc_lock_profile_report (void)
+{
+  return NULL;
+}
+
+void
+fluc_lock_profile_dump (void)
+{
+}
+
+void
+fluc_lock_profile_reset (void)
+{
+}
+
+void
+fluc_lock_profile_dispose (void)
+{
+}
+
+#endif /* FLUC_LOCK_PROFILING */
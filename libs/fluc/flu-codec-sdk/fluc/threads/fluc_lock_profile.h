@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _FLUC_LOCK_PROFILE_H_
+#define _FLUC_LOCK_PROFILE_H_
+
+#include <fluc/fluc_config.h>
+#include <fluc/fluc_export.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Lock contention profiling.
+ * When built with the lock_profiling meson option, every FlucMutex,
+ * FlucRecMutex and FlucMonitor records how many times it is acquired, how
+ * long threads wait to get it, how long it is held and from which call
+ * sites, and how long its holders spend in fluc_monitor_wait*().
+ * Otherwise the report functions do nothing, so they can be called
+ * unconditionally.
+ */
+
+/**
+ * Text report of all the locks used so far, most waited for first. The
+ * locks already cleared are added up in one line per kind.
+ * Returns NULL if profiling is not built in. Free with g_free().
+ */
+FLUC_EXPORT gchar *fluc_lock_profile_report (void);
+
+/**
+ * Log the report to the "fluclockprofile" GStreamer debug category, at
+ * INFO level, one line per lock and call site.
+ */
+FLUC_EXPORT void fluc_lock_profile_dump (void);
+
+/**
+ * Clear the counters of all the locks.
+ */
+FLUC_EXPORT void fluc_lock_profile_reset (void);
+
+/**
+ * Free all the profiles, at shutdown. Must not be called while other
+ * threads use profiled locks; locks used afterwards start from scratch.
+ */
+FLUC_EXPORT void fluc_lock_profile_dispose (void);
+
+#if FLUC_LOCK_PROFILING
+typedef struct _FlucLockProfile FlucLockProfile;
+
+/* Instrumentation hooks, used by the lock implementations.
+ * 'profile' points to the field of the lock, which is created on first use
+ * so statically allocated locks are profiled too. */
+FlucLockProfile *fluc_lock_profile_get (
+    FlucLockProfile **profile, const gchar *kind, gconstpointer lock);
+void fluc_lock_profile_retire (FlucLockProfile *profile);
+/* Call with the lock taken, 'wait' in ns, NULL site if unknown */
+void fluc_lock_profile_acquired (
+    FlucLockProfile *profile, const gchar *site, gint64 wait);
+/* Call with the lock still taken */
+void fluc_lock_profile_releasing (FlucLockProfile *profile);
+/* Time spent in a condition wait, in ns, called once the lock is back */
+void fluc_lock_profile_cond_waited (FlucLockProfile *profile, gint64 time);
+gint64 fluc_lock_profile_now (void);
+#endif
+
+G_END_DECLS
+#endif /* _FLUC_LOCK_PROFILE_H_ */
@@ -9,31 +9,83 @@
 #include "config.h"
 #endif
 
+/* Define the plain functions, not the call site recording macros */
+#define FLUC_LOCK_PROFILE_NO_SITES
 #include "fluc_monitor.h"
 
+#if FLUC_LOCK_PROFILING
+/* The lock is released while waiting, which ends the current hold */
+static gint64
+_wait_begin (FlucMonitor *thiz)
+{
+  fluc_lock_profile_releasing (thiz->profile);
+  return fluc_lock_profile_now ();
+}
+
+static void
+_wait_end (FlucMonitor *thiz, gint64 start)
+{
+  fluc_lock_profile_cond_waited (
+      thiz->profile, fluc_lock_profile_now () - start);
+}
+#endif
+
 void
 fluc_monitor_init (FlucMonitor *thiz)
 {
   g_mutex_init (&thiz->mutex);
   g_cond_init (&thiz->cond);
+#if FLUC_LOCK_PROFILING
+  thiz->profile = NULL;
+#endif
 }
 
 void
 fluc_monitor_clear (FlucMonitor *thiz)
 {
+#if FLUC_LOCK_PROFILING
+  if (thiz->profile) {
+    fluc_lock_profile_retire (thiz->profile);
+    thiz->profile = NULL;
+  }
+#endif
   g_mutex_clear (&thiz->mutex);
   g_cond_clear (&thiz->cond);
 }
 
+#if FLUC_LOCK_PROFILING
+void
+fluc_monitor_lock_at (FlucMonitor *thiz, const gchar *site) ACQUIRE (thiz)
+{
+  FlucLockProfile *profile =
+      fluc_lock_profile_get (&thiz->profile, "monitor", thiz);
+  gint64 wait = 0;
+
+  if (!g_mutex_trylock (&thiz->mutex)) {
+    gint64 start = fluc_lock_profile_now ();
+    g_mutex_lock (&thiz->mutex);
+    wait = MAX (fluc_lock_profile_now () - start, 1);
+  }
+  fluc_lock_profile_acquired (profile, site, wait);
+}
+#endif
+
 void
 fluc_monitor_lock (FlucMonitor *thiz) ACQUIRE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_monitor_lock_at (thiz, NULL);
+#else
   g_mutex_lock (&thiz->mutex);
+#endif
 }
 
 void
 fluc_monitor_unlock (FlucMonitor *thiz) RELEASE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_lock_profile_releasing (thiz->profile);
+#endif
   g_mutex_unlock (&thiz->mutex);
 }
 
@@ -52,18 +104,30 @@ fluc_monitor_signal_one (FlucMonitor *thiz) REQUIRES (thiz)
 void
 fluc_monitor_wait (FlucMonitor *thiz) REQUIRES (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  gint64 start = _wait_begin (thiz);
+  g_cond_wait (&thiz->cond, &thiz->mutex);
+  _wait_end (thiz, start);
+#else
   g_cond_wait (&thiz->cond, &thiz->mutex);
+#endif
 }
 
 gboolean
 fluc_monitor_wait_until (FlucMonitor *thiz, gint64 time) REQUIRES (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  gint64 start = _wait_begin (thiz);
+  gboolean ret = g_cond_wait_until (&thiz->cond, &thiz->mutex, time);
+  _wait_end (thiz, start);
+  return ret;
+#else
   return g_cond_wait_until (&thiz->cond, &thiz->mutex, time);
+#endif
 }
 
 gboolean
 fluc_monitor_wait_for (FlucMonitor *thiz, gint64 time) REQUIRES (thiz)
 {
-  return g_cond_wait_until (
-      &thiz->cond, &thiz->mutex, g_get_monotonic_time () + time);
+  return fluc_monitor_wait_until (thiz, g_get_monotonic_time () + time);
 }
@@ -16,6 +16,9 @@ typedef struct CAPABILITY ("mutex")
 {
   GMutex mutex;
   GCond cond;
+#if FLUC_LOCK_PROFILING
+  FlucLockProfile *profile;
+#endif
 } FlucMonitor;
 
 FLUC_EXPORT void fluc_monitor_init (FlucMonitor *thiz);
@@ -41,5 +44,14 @@ FLUC_EXPORT gboolean fluc_monitor_wait_until (FlucMonitor *thiz, gint64 time)
 FLUC_EXPORT gboolean fluc_monitor_wait_for (FlucMonitor *thiz, gint64 time)
     REQUIRES (thiz);
 
+#if FLUC_LOCK_PROFILING
+FLUC_EXPORT void fluc_monitor_lock_at (FlucMonitor *thiz, const gchar *site)
+    ACQUIRE (thiz);
+
+#ifndef FLUC_LOCK_PROFILE_NO_SITES
+#define fluc_monitor_lock(thiz) fluc_monitor_lock_at (thiz, G_STRLOC)
+#endif
+#endif
+
 G_END_DECLS
 #endif /* _FLUC_MONITOR_H_ */
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fluc_mpsc_queue.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* Each cell carries a sequence number telling whether it is free for the
+ * push at position 'pos' (sequence == pos) or holds the item for the pop at
+ * 'pos' (sequence == pos + 1). Producers claim positions with a CAS on
+ * 'enqueue_pos'; the single consumer needs no atomic read-modify-write. */
+typedef struct
+{
+  gint sequence;
+  gpointer item;
+} FlucMpscQueueCell;
+
+struct _FlucMpscQueue
+{
+  FlucMpscQueueCell *cells;
+  guint mask;
+  gint closed;
+  gint waiters;
+  FlucMonitor monitor;
+
+  /* Keep each side on its own cache line */
+  gchar pad0[CACHE_LINE_SIZE];
+  gint enqueue_pos; /* Claimed by the producers */
+  gchar pad1[CACHE_LINE_SIZE - sizeof (gint)];
+  guint dequeue_pos; /* Only used by the consumer */
+  gchar pad2[CACHE_LINE_SIZE - sizeof (guint)];
+};
+
+static void
+_wake_up (FlucMpscQueue *queue)
+{
+  if (g_atomic_int_get (&queue->waiters)) {
+    fluc_monitor_lock (&queue->monitor);
+    fluc_monitor_signal_all (&queue->monitor);
+    fluc_monitor_unlock (&queue->monitor);
+  }
+}
+
+static gboolean
+_can_push (FlucMpscQueue *queue)
+{
+  guint pos = g_atomic_int_get (&queue->enqueue_pos);
+  FlucMpscQueueCell *cell = &queue->cells[pos & queue->mask];
+  return (gint) ((guint) g_atomic_int_get (&cell->sequence) - pos) >= 0;
+}
+
+static gboolean
+_can_pop (FlucMpscQueue *queue)
+{
+  guint pos = queue->dequeue_pos;
+  FlucMpscQueueCell *cell = &queue->cells[pos & queue->mask];
+  return (gint) ((guint) g_atomic_int_get (&cell->sequence) - (pos + 1)) >= 0;
+}
+
+static gboolean
+_ready (FlucMpscQueue *queue, gboolean producer)
+{
+  if (g_atomic_int_get (&queue->closed))
+    return TRUE;
+  return producer ? _can_push (queue) : _can_pop (queue);
+}
+
+/* Wait until the given side can make progress. FALSE on timeout. */
+static gboolean
+_wait (FlucMpscQueue *queue, gboolean producer, gint64 end_time)
+{
+  gboolean ready;
+
+  fluc_monitor_lock (&queue->monitor);
+  g_atomic_int_inc (&queue->waiters);
+  while (!(ready = _ready (queue, producer))) {
+    if (end_time < 0)
+      fluc_monitor_wait (&queue->monitor);
+    else if (!fluc_monitor_wait_until (&queue->monitor, end_time))
+      break;
+  }
+  g_atomic_int_add (&queue->waiters, -1);
+  fluc_monitor_unlock (&queue->monitor);
+
+  return ready || _ready (queue, producer);
+}
+
+/*********************************************************************
+ * public functions
+ ********************************************************************/
+
+FlucMpscQueue *
+fluc_mpsc_queue_new (guint capacity)
+{
+  FlucMpscQueue *queue;
+  guint i;
+
+  g_return_val_if_fail (capacity > 0 && capacity <= G_MAXINT / 2 + 1, NULL);
+
+  queue = g_new0 (FlucMpscQueue, 1);
+  /* With a single cell, a full queue and a free cell share the sequence */
+  capacity = MAX (capacity, 2);
+  capacity = 1U << g_bit_storage (capacity - 1);
+  queue->cells = g_new (FlucMpscQueueCell, capacity);
+  for (i = 0; i < capacity; i++) {
+    queue->cells[i].sequence = i;
+    queue->cells[i].item = NULL;
+  }
+  queue->mask = capacity - 1;
+  fluc_monitor_init (&queue->monitor);
+
+  return queue;
+}
+
+void
+fluc_mpsc_queue_free (FlucMpscQueue *queue)
+{
+  fluc_monitor_clear (&queue->monitor);
+  g_free (queue->cells);
+  g_free (queue);
+}
+
+guint
+fluc_mpsc_queue_get_capacity (FlucMpscQueue *queue)
+{
+  return queue->mask + 1;
+}
+
+gboolean
+fluc_mpsc_queue_push (FlucMpscQueue *queue, gpointer item)
+{
+  FlucMpscQueueCell *cell;
+  guint pos;
+
+  g_return_val_if_fail (item != NULL, FALSE);
+
+  if (g_atomic_int_get (&queue->closed))
+    return FALSE;
+
+  pos = g_atomic_int_get (&queue->enqueue_pos);
+  for (;;) {
+    gint diff;
+
+    cell = &queue->cells[pos & queue->mask];
+    diff = (gint) ((guint) g_atomic_int_get (&cell->sequence) - pos);
+    if (diff == 0) {
+      if (g_atomic_int_compare_and_exchange (
+              &queue->enqueue_pos, (gint) pos, (gint) (pos + 1)))
+        break;
+    } else if (diff < 0) {
+      /* The consumer has not freed this cell yet: full */
+      return FALSE;
+    }
+    /* Another producer got this position */
+    pos = g_atomic_int_get (&queue->enqueue_pos);
+  }
+
+  cell->item = item;
+  g_atomic_int_set (&cell->sequence, pos + 1);
+  _wake_up (queue);
+
+  return TRUE;
+}
+
+gpointer
+fluc_mpsc_queue_pop (FlucMpscQueue *queue)
+{
+  FlucMpscQueueCell *cell;
+  gpointer item;
+  guint pos = queue->dequeue_pos;
+
+  if (!_can_pop (queue))
+    return NULL;
+
+  cell = &queue->cells[pos & queue->mask];
+  item = cell->item;
+  queue->dequeue_pos = pos + 1;
+  /* Free the cell for the push one lap later */
+  g_atomic_int_set (&cell->sequence, pos + queue->mask + 1);
+  _wake_up (queue);
+
+  return item;
+}
+
+void
+fluc_mpsc_queue_close (FlucMpscQueue *queue)
+{
+  g_atomic_int_set (&queue->closed, TRUE);
+  _wake_up (queue);
+}
+
+gboolean
+fluc_mpsc_queue_is_closed (FlucMpscQueue *queue)
+{
+  return g_atomic_int_get (&queue->closed);
+}
+
+gboolean
+fluc_mpsc_queue_push_wait (
+    FlucMpscQueue *queue, gpointer item, gint64 end_time)
+{
+  while (!fluc_mpsc_queue_push (queue, item)) {
+    if (fluc_mpsc_queue_is_closed (queue) || !_wait (queue, TRUE, end_time))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+gpointer
+fluc_mpsc_queue_pop_wait (FlucMpscQueue *queue, gint64 end_time)
+{
+  gpointer item;
+
+  /* Once closed, _wait() returns at once and the last pop drains it */
+  while (!(item = fluc_mpsc_queue_pop (queue))) {
+    if (fluc_mpsc_queue_is_closed (queue) || !_wait (queue, FALSE, end_time))
+      break;
+  }
+  if (!item)
+    item = fluc_mpsc_queue_pop (queue);
+
+  return item;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _FLUC_MPSC_QUEUE_H_
+#define _FLUC_MPSC_QUEUE_H_
+
+#include <fluc/threads/fluc_monitor.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Bounded lock-free queue of pointers for any number of producer threads
+ * and one consumer thread. Items are delivered in the order in which the
+ * producers claimed their slot, so the items of each producer keep their
+ * order. A producer stalled between claiming its slot and publishing the
+ * item holds back the consumer, even if later items are already published.
+ * NULL cannot be queued.
+ */
+typedef struct _FlucMpscQueue FlucMpscQueue;
+
+/**
+ * Capacity is rounded up to a power of 2, and is at least 2.
+ */
+FLUC_EXPORT FlucMpscQueue *fluc_mpsc_queue_new (guint capacity);
+
+/**
+ * Items still queued are not freed.
+ */
+FLUC_EXPORT void fluc_mpsc_queue_free (FlucMpscQueue *queue);
+
+FLUC_EXPORT guint fluc_mpsc_queue_get_capacity (FlucMpscQueue *queue);
+
+/**
+ * Producer side. Returns FALSE if the queue is full or closed.
+ */
+FLUC_EXPORT gboolean fluc_mpsc_queue_push (FlucMpscQueue *queue, gpointer item);
+
+/**
+ * Consumer side. Returns NULL if the queue is empty.
+ */
+FLUC_EXPORT gpointer fluc_mpsc_queue_pop (FlucMpscQueue *queue);
+
+/**
+ * No more items will be pushed. Wakes up any waiting thread, the consumer
+ * can still pop what was queued.
+ */
+FLUC_EXPORT void fluc_mpsc_queue_close (FlucMpscQueue *queue);
+FLUC_EXPORT gboolean fluc_mpsc_queue_is_closed (FlucMpscQueue *queue);
+
+/**
+ * Blocking helpers. Times are monotonic, in μs, -1 to wait forever.
+ * push_wait waits for room and returns FALSE on timeout or close.
+ * pop_wait waits for an item and returns NULL on timeout or once closed and
+ * drained.
+ */
+FLUC_EXPORT gboolean fluc_mpsc_queue_push_wait (
+    FlucMpscQueue *queue, gpointer item, gint64 end_time);
+FLUC_EXPORT gpointer fluc_mpsc_queue_pop_wait (
+    FlucMpscQueue *queue, gint64 end_time);
+
+G_END_DECLS
+#endif /* _FLUC_MPSC_QUEUE_H_ */
@@ -9,64 +9,169 @@
 #include "config.h"
 #endif
 
+/* Define the plain functions, not the call site recording macros */
+#define FLUC_LOCK_PROFILE_NO_SITES
 #include "fluc_mutex.h"
 
+#if FLUC_LOCK_PROFILING
+#define PROFILE(thiz, kind) fluc_lock_profile_get (&(thiz)->profile, kind, thiz)
+
+/* Wait time of a lock() that could not be a trylock(), at least 1ns so it
+ * counts as contended */
+#define TIMED_LOCK(lock_func, lock, wait)                                     \
+  do {                                                                        \
+    gint64 _start = fluc_lock_profile_now ();                                 \
+    lock_func (lock);                                                         \
+    wait = MAX (fluc_lock_profile_now () - _start, 1);                        \
+  } while (0)
+#endif
+
 void
 fluc_mutex_init (FlucMutex *thiz)
 {
   g_mutex_init (&thiz->lock);
+#if FLUC_LOCK_PROFILING
+  thiz->profile = NULL;
+#endif
 }
 
 void
 fluc_mutex_clear (FlucMutex *thiz)
 {
+#if FLUC_LOCK_PROFILING
+  if (thiz->profile) {
+    fluc_lock_profile_retire (thiz->profile);
+    thiz->profile = NULL;
+  }
+#endif
   g_mutex_clear (&thiz->lock);
 }
 
+#if FLUC_LOCK_PROFILING
+void
+fluc_mutex_lock_at (FlucMutex *thiz, const gchar *site) ACQUIRE (thiz)
+{
+  FlucLockProfile *profile = PROFILE (thiz, "mutex");
+  gint64 wait = 0;
+
+  if (!g_mutex_trylock (&thiz->lock))
+    TIMED_LOCK (g_mutex_lock, &thiz->lock, wait);
+  fluc_lock_profile_acquired (profile, site, wait);
+}
+
+gboolean
+fluc_mutex_trylock_at (FlucMutex *thiz, const gchar *site)
+    TRY_ACQUIRE (TRUE, thiz)
+{
+  FlucLockProfile *profile = PROFILE (thiz, "mutex");
+
+  if (!g_mutex_trylock (&thiz->lock))
+    return FALSE;
+  fluc_lock_profile_acquired (profile, site, 0);
+  return TRUE;
+}
+#endif
+
 void
 fluc_mutex_lock (FlucMutex *thiz) ACQUIRE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_mutex_lock_at (thiz, NULL);
+#else
   g_mutex_lock (&thiz->lock);
+#endif
 }
 
 void
 fluc_mutex_unlock (FlucMutex *thiz) RELEASE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_lock_profile_releasing (thiz->profile);
+#endif
   g_mutex_unlock (&thiz->lock);
 }
 
 gboolean
 fluc_mutex_trylock (FlucMutex *thiz) TRY_ACQUIRE (TRUE, thiz)
 {
+#if FLUC_LOCK_PROFILING
+  return fluc_mutex_trylock_at (thiz, NULL);
+#else
   return g_mutex_trylock (&thiz->lock);
+#endif
 }
 
 void
 fluc_rec_mutex_init (FlucRecMutex *thiz)
 {
   g_rec_mutex_init (&thiz->lock);
+#if FLUC_LOCK_PROFILING
+  thiz->profile = NULL;
+#endif
 }
 
 void
 fluc_rec_mutex_clear (FlucRecMutex *thiz)
 {
+#if FLUC_LOCK_PROFILING
+  if (thiz->profile) {
+    fluc_lock_profile_retire (thiz->profile);
+    thiz->profile = NULL;
+  }
+#endif
   g_rec_mutex_clear (&thiz->lock);
 }
 
+#if FLUC_LOCK_PROFILING
+void
+fluc_rec_mutex_lock_at (FlucRecMutex *thiz, const gchar *site) ACQUIRE (thiz)
+{
+  FlucLockProfile *profile = PROFILE (thiz, "rec_mutex");
+  gint64 wait = 0;
+
+  if (!g_rec_mutex_trylock (&thiz->lock))
+    TIMED_LOCK (g_rec_mutex_lock, &thiz->lock, wait);
+  fluc_lock_profile_acquired (profile, site, wait);
+}
+
+gboolean
+fluc_rec_mutex_trylock_at (FlucRecMutex *thiz, const gchar *site)
+    TRY_ACQUIRE (TRUE, thiz)
+{
+  FlucLockProfile *profile = PROFILE (thiz, "rec_mutex");
+
+  if (!g_rec_mutex_trylock (&thiz->lock))
+    return FALSE;
+  fluc_lock_profile_acquired (profile, site, 0);
+  return TRUE;
+}
+#endif
+
 void
 fluc_rec_mutex_lock (FlucRecMutex *thiz) ACQUIRE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_rec_mutex_lock_at (thiz, NULL);
+#else
   g_rec_mutex_lock (&thiz->lock);
+#endif
 }
 
 void
 fluc_rec_mutex_unlock (FlucRecMutex *thiz) RELEASE (thiz)
 {
+#if FLUC_LOCK_PROFILING
+  fluc_lock_profile_releasing (thiz->profile);
+#endif
   g_rec_mutex_unlock (&thiz->lock);
 }
 
 gboolean
 fluc_rec_mutex_trylock (FlucRecMutex *thiz) TRY_ACQUIRE (TRUE, thiz)
 {
+#if FLUC_LOCK_PROFILING
+  return fluc_rec_mutex_trylock_at (thiz, NULL);
+#else
   return g_rec_mutex_trylock (&thiz->lock);
+#endif
 }
@@ -9,6 +9,7 @@
 #define _FLUC_MUTEX_H_
 
 #include <fluc/fluc_export.h>
+#include <fluc/threads/fluc_lock_profile.h>
 #include <glib.h>
 
 G_BEGIN_DECLS
@@ -26,6 +27,7 @@ G_BEGIN_DECLS
 #endif
 
 #define CAPABILITY(x) FLUC_THREADS_ANNOTATION (capability (x))
+#define GUARDED_BY(x) FLUC_THREADS_ANNOTATION (guarded_by (x))
 #define REQUIRES(...)                                                         \
   FLUC_THREADS_ANNOTATION (requires_capability (__VA_ARGS__))
 #define ACQUIRE(...) FLUC_THREADS_ANNOTATION (acquire_capability (__VA_ARGS__))
@@ -43,6 +45,9 @@ G_BEGIN_DECLS
 typedef struct CAPABILITY ("mutex")
 {
   GMutex lock;
+#if FLUC_LOCK_PROFILING
+  FlucLockProfile *profile;
+#endif
 } FlucMutex;
 
 FLUC_EXPORT void fluc_mutex_init (FlucMutex *thiz);
@@ -59,6 +64,9 @@ FLUC_EXPORT gboolean fluc_mutex_trylock (FlucMutex *thiz)
 typedef struct CAPABILITY ("mutex")
 {
   GRecMutex lock;
+#if FLUC_LOCK_PROFILING
+  FlucLockProfile *profile;
+#endif
 } FlucRecMutex;
 
 FLUC_EXPORT void fluc_rec_mutex_init (FlucRecMutex *thiz);
@@ -69,5 +77,26 @@ FLUC_EXPORT void fluc_rec_mutex_unlock (FlucRecMutex *thiz) RELEASE (thiz);
 FLUC_EXPORT gboolean fluc_rec_mutex_trylock (FlucRecMutex *thiz)
     TRY_ACQUIRE (TRUE, thiz);
 
+/**
+ * With lock profiling, acquisitions record their call site.
+ */
+#if FLUC_LOCK_PROFILING
+FLUC_EXPORT void fluc_mutex_lock_at (FlucMutex *thiz, const gchar *site)
+    ACQUIRE (thiz);
+FLUC_EXPORT gboolean fluc_mutex_trylock_at (
+    FlucMutex *thiz, const gchar *site) TRY_ACQUIRE (TRUE, thiz);
+FLUC_EXPORT void fluc_rec_mutex_lock_at (FlucRecMutex *thiz, const gchar *site)
+    ACQUIRE (thiz);
+FLUC_EXPORT gboolean fluc_rec_mutex_trylock_at (
+    FlucRecMutex *thiz, const gchar *site) TRY_ACQUIRE (TRUE, thiz);
+
+#ifndef FLUC_LOCK_PROFILE_NO_SITES
+#define fluc_mutex_lock(thiz) fluc_mutex_lock_at (thiz, G_STRLOC)
+#define fluc_mutex_trylock(thiz) fluc_mutex_trylock_at (thiz, G_STRLOC)
+#define fluc_rec_mutex_lock(thiz) fluc_rec_mutex_lock_at (thiz, G_STRLOC)
+#define fluc_rec_mutex_trylock(thiz) fluc_rec_mutex_trylock_at (thiz, G_STRLOC)
+#endif
+#endif
+
 G_END_DECLS
 #endif /* _FLUC_MUTEX_H_ */
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fluc_spsc_ring.h"
+
+#include <string.h>
+
+#define CACHE_LINE_SIZE 64
+
+/* head and tail are free running counters, the offset in the buffer is
+ * counter & mask. They are only written by their own side and published with
+ * the full barrier of g_atomic_int_set(), which also orders the waiters check
+ * in _wake_up() after it. */
+struct _FlucSpscRing
+{
+  guint8 *data;
+  guint mask;
+  gint closed;
+  gint waiters;
+  FlucMonitor monitor;
+
+  /* Keep each side on its own cache line */
+  gchar pad0[CACHE_LINE_SIZE];
+  gint head; /* Next byte to read, written by the consumer */
+  gchar pad1[CACHE_LINE_SIZE - sizeof (gint)];
+  gint tail; /* Next byte to write, written by the producer */
+  gchar pad2[CACHE_LINE_SIZE - sizeof (gint)];
+};
+
+static void
+_wake_up (FlucSpscRing *ring)
+{
+  if (g_atomic_int_get (&ring->waiters)) {
+    fluc_monitor_lock (&ring->monitor);
+    fluc_monitor_signal_all (&ring->monitor);
+    fluc_monitor_unlock (&ring->monitor);
+  }
+}
+
+static gboolean
+_ready (FlucSpscRing *ring, gboolean writer)
+{
+  if (g_atomic_int_get (&ring->closed))
+    return TRUE;
+  return writer ? fluc_spsc_ring_get_writable (ring) > 0
+                : fluc_spsc_ring_get_readable (ring) > 0;
+}
+
+/* Wait until the given side can make progress. FALSE on timeout. */
+static gboolean
+_wait (FlucSpscRing *ring, gboolean writer, gint64 end_time)
+{
+  gboolean ready;
+
+  fluc_monitor_lock (&ring->monitor);
+  g_atomic_int_inc (&ring->waiters);
+  while (!(ready = _ready (ring, writer))) {
+    if (end_time < 0)
+      fluc_monitor_wait (&ring->monitor);
+    else if (!fluc_monitor_wait_until (&ring->monitor, end_time))
+      break;
+  }
+  g_atomic_int_add (&ring->waiters, -1);
+  fluc_monitor_unlock (&ring->monitor);
+
+  return ready || _ready (ring, writer);
+}
+
+/*********************************************************************
+ * public functions
+ ********************************************************************/
+
+FlucSpscRing *
+fluc_spsc_ring_new (gsize capacity)
+{
+  FlucSpscRing *ring;
+
+  g_return_val_if_fail (capacity > 0 && capacity <= G_MAXINT / 2 + 1, NULL);
+
+  ring = g_new0 (FlucSpscRing, 1);
+  if (capacity > 1)
+    capacity = (gsize) 1 << g_bit_storage (capacity - 1);
+  ring->data = g_malloc (capacity);
+  ring->mask = capacity - 1;
+  fluc_monitor_init (&ring->monitor);
+
+  return ring;
+}
+
+void
+fluc_spsc_ring_free (FlucSpscRing *ring)
+{
+  fluc_monitor_clear (&ring->monitor);
+  g_free (ring->data);
+  g_free (ring);
+}
+
+gsize
+fluc_spsc_ring_get_capacity (FlucSpscRing *ring)
+{
+  return (gsize) ring->mask + 1;
+}
+
+gsize
+fluc_spsc_ring_get_readable (FlucSpscRing *ring)
+{
+  guint tail = g_atomic_int_get (&ring->tail);
+  guint head = g_atomic_int_get (&ring->head);
+  return tail - head;
+}
+
+gsize
+fluc_spsc_ring_get_writable (FlucSpscRing *ring)
+{
+  return fluc_spsc_ring_get_capacity (ring) -
+         fluc_spsc_ring_get_readable (ring);
+}
+
+gsize
+fluc_spsc_ring_write (FlucSpscRing *ring, const void *data, gsize size)
+{
+  guint tail = ring->tail;
+  guint offset = tail & ring->mask;
+  gsize first;
+
+  if (fluc_spsc_ring_is_closed (ring))
+    return 0;
+
+  size = MIN (size, fluc_spsc_ring_get_writable (ring));
+  if (!size)
+    return 0;
+
+  first = MIN (size, ring->mask + 1 - offset);
+  memcpy (ring->data + offset, data, first);
+  memcpy (ring->data, (const guint8 *) data + first, size - first);
+
+  g_atomic_int_set (&ring->tail, tail + size);
+  _wake_up (ring);
+
+  return size;
+}
+
+gsize
+fluc_spsc_ring_read (FlucSpscRing *ring, void *data, gsize size)
+{
+  guint head = ring->head;
+  guint offset = head & ring->mask;
+  gsize first;
+
+  size = MIN (size, fluc_spsc_ring_get_readable (ring));
+  if (!size)
+    return 0;
+
+  first = MIN (size, ring->mask + 1 - offset);
+  memcpy (data, ring->data + offset, first);
+  memcpy ((guint8 *) data + first, ring->data, size - first);
+
+  g_atomic_int_set (&ring->head, head + size);
+  _wake_up (ring);
+
+  return size;
+}
+
+void
+fluc_spsc_ring_close (FlucSpscRing *ring)
+{
+  g_atomic_int_set (&ring->closed, TRUE);
+  _wake_up (ring);
+}
+
+gboolean
+fluc_spsc_ring_is_closed (FlucSpscRing *ring)
+{
+  return g_atomic_int_get (&ring->closed);
+}
+
+gsize
+fluc_spsc_ring_write_wait (
+    FlucSpscRing *ring, const void *data, gsize size, gint64 end_time)
+{
+  gsize written = 0;
+
+  for (;;) {
+    written += fluc_spsc_ring_write (
+        ring, (const guint8 *) data + written, size - written);
+    if (written == size || fluc_spsc_ring_is_closed (ring) ||
+        !_wait (ring, TRUE, end_time))
+      break;
+  }
+
+  return written;
+}
+
+gsize
+fluc_spsc_ring_read_wait (
+    FlucSpscRing *ring, void *data, gsize size, gint64 end_time)
+{
+  gsize read = fluc_spsc_ring_read (ring, data, size);
+
+  /* Once closed, _wait() returns at once and the last read drains it */
+  if (!read && size && _wait (ring, FALSE, end_time))
+    read = fluc_spsc_ring_read (ring, data, size);
+
+  return read;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _FLUC_SPSC_RING_H_
+#define _FLUC_SPSC_RING_H_
+
+#include <fluc/threads/fluc_monitor.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Bounded lock-free byte ring for one producer thread and one consumer
+ * thread. Reads and writes never take a lock; the monitor is only used by
+ * the blocking helpers, and only touched by the other side when somebody is
+ * actually waiting.
+ */
+typedef struct _FlucSpscRing FlucSpscRing;
+
+/**
+ * Capacity is rounded up to a power of 2.
+ */
+FLUC_EXPORT FlucSpscRing *fluc_spsc_ring_new (gsize capacity);
+FLUC_EXPORT void fluc_spsc_ring_free (FlucSpscRing *ring);
+
+FLUC_EXPORT gsize fluc_spsc_ring_get_capacity (FlucSpscRing *ring);
+FLUC_EXPORT gsize fluc_spsc_ring_get_readable (FlucSpscRing *ring);
+FLUC_EXPORT gsize fluc_spsc_ring_get_writable (FlucSpscRing *ring);
+
+/**
+ * Producer side. Copy as much of data as fits and return the amount copied,
+ * 0 once closed.
+ */
+FLUC_EXPORT gsize fluc_spsc_ring_write (
+    FlucSpscRing *ring, const void *data, gsize size);
+
+/**
+ * Consumer side. Copy up to size bytes and return the amount copied.
+ */
+FLUC_EXPORT gsize fluc_spsc_ring_read (
+    FlucSpscRing *ring, void *data, gsize size);
+
+/**
+ * No more data will be written. Wakes up any waiting thread.
+ */
+FLUC_EXPORT void fluc_spsc_ring_close (FlucSpscRing *ring);
+FLUC_EXPORT gboolean fluc_spsc_ring_is_closed (FlucSpscRing *ring);
+
+/**
+ * Blocking helpers. Times are monotonic, in μs, -1 to wait forever.
+ * write_wait returns once all the data is written, or on timeout or close,
+ * with the amount written. read_wait waits until there is some data and
+ * returns what could be read, 0 on timeout or once closed and drained.
+ */
+FLUC_EXPORT gsize fluc_spsc_ring_write_wait (
+    FlucSpscRing *ring, const void *data, gsize size, gint64 end_time);
+FLUC_EXPORT gsize fluc_spsc_ring_read_wait (
+    FlucSpscRing *ring, void *data, gsize size, gint64 end_time);
+
+G_END_DECLS
+#endif /* _FLUC_SPSC_RING_H_ */
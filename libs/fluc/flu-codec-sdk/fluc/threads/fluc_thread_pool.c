@@ -0,0 +1,350 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fluc_thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* How often a joining thread with nothing to run looks for new tasks, in μs */
+#define JOIN_POLL_TIME 1000
+
+typedef struct
+{
+  FlucThreadPoolFunc func;
+  gpointer data;
+  FlucTaskGroup *group;
+} FlucThreadPoolTask;
+
+typedef struct
+{
+  FlucThreadPool *pool;
+  GThread *thread;
+  guint index;
+  FlucMutex lock;
+  /* The owner works on the tail, thieves take from the head */
+  GQueue deque GUARDED_BY (lock);
+} FlucThreadPoolWorker;
+
+struct _FlucThreadPool
+{
+  FlucThreadPoolWorker *workers;
+  guint n_workers;
+  gboolean pin_cpus;
+  gint pending; /* Tasks in the deques, atomic */
+  gint next;    /* Deque for the next push from outside, atomic */
+  FlucMonitor idle;
+  guint sleeping GUARDED_BY (idle);
+  gboolean shutdown GUARDED_BY (idle);
+};
+
+/* Worker running on the current thread, if any */
+static GPrivate current_worker;
+
+/* Shared pool singleton */
+static FlucMutex shared_lock;
+static gint32 shared_init_count = 0;
+static FlucThreadPool *shared_pool;
+
+static FlucThreadPoolWorker *
+_get_current_worker (FlucThreadPool *pool)
+{
+  FlucThreadPoolWorker *worker = g_private_get (&current_worker);
+  return worker && worker->pool == pool ? worker : NULL;
+}
+
+static FlucThreadPoolTask *
+_pop (FlucThreadPoolWorker *worker, gboolean steal)
+{
+  FlucThreadPoolTask *task;
+
+  fluc_mutex_lock (&worker->lock);
+  task = steal ? g_queue_pop_head (&worker->deque)
+               : g_queue_pop_tail (&worker->deque);
+  fluc_mutex_unlock (&worker->lock);
+
+  return task;
+}
+
+/* Take a task from our own deque or, if empty, from another worker */
+static FlucThreadPoolTask *
+_find_task (FlucThreadPool *pool, FlucThreadPoolWorker *self)
+{
+  FlucThreadPoolTask *task = NULL;
+  guint start, i;
+
+  if (g_atomic_int_get (&pool->pending) <= 0)
+    return NULL;
+
+  if (self)
+    task = _pop (self, FALSE);
+
+  start = self ? self->index + 1 : 0;
+  for (i = 0; !task && i < pool->n_workers; i++) {
+    FlucThreadPoolWorker *victim = &pool->workers[(start + i) % pool->n_workers];
+    if (victim != self)
+      task = _pop (victim, TRUE);
+  }
+
+  if (task)
+    g_atomic_int_add (&pool->pending, -1);
+
+  return task;
+}
+
+static void
+_run_task (FlucThreadPoolTask *task)
+{
+  FlucTaskGroup *group = task->group;
+
+  task->func (task->data);
+  g_free (task);
+
+  if (group) {
+    fluc_monitor_lock (&group->monitor);
+    if (!--group->outstanding)
+      fluc_monitor_signal_all (&group->monitor);
+    fluc_monitor_unlock (&group->monitor);
+  }
+}
+
+static void
+_pin_to_cpu (guint cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+
+  CPU_ZERO (&set);
+  CPU_SET (cpu % CPU_SETSIZE, &set);
+  /* Not fatal, the worker just runs wherever the scheduler puts it */
+  pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+#endif
+}
+
+static gpointer
+_worker_function (FlucThreadPoolWorker *worker)
+{
+  FlucThreadPool *pool = worker->pool;
+
+  g_private_set (&current_worker, worker);
+  if (pool->pin_cpus)
+    _pin_to_cpu (worker->index % g_get_num_processors ());
+
+  for (;;) {
+    FlucThreadPoolTask *task = _find_task (pool, worker);
+    gboolean done = FALSE;
+
+    if (task) {
+      _run_task (task);
+      continue;
+    }
+
+    /* Checking 'pending' with the monitor taken ensures the push that makes
+     * it non zero will see us sleeping and wake us up */
+    fluc_monitor_lock (&pool->idle);
+    if (g_atomic_int_get (&pool->pending) <= 0) {
+      if (pool->shutdown) {
+        done = TRUE;
+      } else {
+        pool->sleeping++;
+        fluc_monitor_wait (&pool->idle);
+        pool->sleeping--;
+      }
+    }
+    fluc_monitor_unlock (&pool->idle);
+
+    if (done)
+      break;
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * public functions
+ ********************************************************************/
+
+FlucThreadPool *
+fluc_thread_pool_new (guint n_workers, gboolean pin_cpus)
+{
+  FlucThreadPool *pool;
+  guint i;
+
+  if (!n_workers)
+    n_workers = g_get_num_processors ();
+
+  pool = g_new0 (FlucThreadPool, 1);
+  pool->n_workers = n_workers;
+  pool->pin_cpus = pin_cpus;
+  fluc_monitor_init (&pool->idle);
+
+  pool->workers = g_new0 (FlucThreadPoolWorker, n_workers);
+  for (i = 0; i < n_workers; i++) {
+    FlucThreadPoolWorker *worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->index = i;
+    fluc_mutex_init (&worker->lock);
+    g_queue_init (&worker->deque);
+  }
+
+  /* Only start them once all the deques can be stolen from */
+  for (i = 0; i < n_workers; i++) {
+    pool->workers[i].thread = g_thread_new ("flucpool",
+        (GThreadFunc) _worker_function, &pool->workers[i]);
+  }
+
+  return pool;
+}
+
+void
+fluc_thread_pool_free (FlucThreadPool *pool)
+{
+  guint i;
+
+  fluc_monitor_lock (&pool->idle);
+  pool->shutdown = TRUE;
+  fluc_monitor_signal_all (&pool->idle);
+  fluc_monitor_unlock (&pool->idle);
+
+  for (i = 0; i < pool->n_workers; i++)
+    g_thread_join (pool->workers[i].thread);
+
+  for (i = 0; i < pool->n_workers; i++)
+    fluc_mutex_clear (&pool->workers[i].lock);
+  fluc_monitor_clear (&pool->idle);
+  g_free (pool->workers);
+  g_free (pool);
+}
+
+guint
+fluc_thread_pool_get_n_workers (FlucThreadPool *pool)
+{
+  return pool->n_workers;
+}
+
+void
+fluc_thread_pool_push (FlucThreadPool *pool, FlucThreadPoolFunc func,
+    gpointer data, FlucTaskGroup *group)
+{
+  FlucThreadPoolWorker *worker;
+  FlucThreadPoolTask *task;
+
+  task = g_new (FlucThreadPoolTask, 1);
+  task->func = func;
+  task->data = data;
+  task->group = group;
+
+  if (group) {
+    fluc_monitor_lock (&group->monitor);
+    group->outstanding++;
+    fluc_monitor_unlock (&group->monitor);
+  }
+
+  worker = _get_current_worker (pool);
+  if (!worker) {
+    guint next = (guint) g_atomic_int_add (&pool->next, 1);
+    worker = &pool->workers[next % pool->n_workers];
+  }
+
+  fluc_mutex_lock (&worker->lock);
+  g_queue_push_tail (&worker->deque, task);
+  fluc_mutex_unlock (&worker->lock);
+  g_atomic_int_inc (&pool->pending);
+
+  fluc_monitor_lock (&pool->idle);
+  if (pool->sleeping)
+    fluc_monitor_signal_one (&pool->idle);
+  fluc_monitor_unlock (&pool->idle);
+}
+
+void
+fluc_thread_pools_init ()
+{
+  fluc_mutex_lock (&shared_lock);
+  if (!shared_init_count++) {
+    shared_pool = fluc_thread_pool_new (0, FALSE);
+  }
+  fluc_mutex_unlock (&shared_lock);
+}
+
+void
+fluc_thread_pools_dispose ()
+{
+  fluc_mutex_lock (&shared_lock);
+  if (!--shared_init_count) {
+    fluc_thread_pool_free (shared_pool);
+    shared_pool = NULL;
+  }
+  fluc_mutex_unlock (&shared_lock);
+}
+
+FlucThreadPool *
+fluc_thread_pools_get_shared ()
+{
+  return shared_pool;
+}
+
+FlucTaskGroup *
+fluc_task_group_new (FlucThreadPool *pool)
+{
+  FlucTaskGroup *group;
+
+  group = g_new0 (FlucTaskGroup, 1);
+  group->pool = pool;
+  fluc_monitor_init (&group->monitor);
+
+  return group;
+}
+
+void
+fluc_task_group_free (FlucTaskGroup *group)
+{
+  fluc_monitor_clear (&group->monitor);
+  g_free (group);
+}
+
+void
+fluc_task_group_wait (FlucTaskGroup *group) EXCLUDES (&group->monitor)
+{
+  fluc_monitor_lock (&group->monitor);
+  while (group->outstanding)
+    fluc_monitor_wait (&group->monitor);
+  fluc_monitor_unlock (&group->monitor);
+}
+
+void
+fluc_task_group_join (FlucTaskGroup *group) EXCLUDES (&group->monitor)
+{
+  FlucThreadPool *pool = group->pool;
+  FlucThreadPoolWorker *self = _get_current_worker (pool);
+
+  fluc_monitor_lock (&group->monitor);
+  while (group->outstanding) {
+    FlucThreadPoolTask *task;
+
+    fluc_monitor_unlock (&group->monitor);
+    task = _find_task (pool, self);
+    if (task)
+      _run_task (task);
+    fluc_monitor_lock (&group->monitor);
+
+    /* The rest are running elsewhere, but they may still queue more work */
+    if (!task && group->outstanding)
+      fluc_monitor_wait_for (&group->monitor, JOIN_POLL_TIME);
+  }
+  fluc_monitor_unlock (&group->monitor);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _FLUC_THREAD_POOL_H_
+#define _FLUC_THREAD_POOL_H_
+
+#include <fluc/threads/fluc_monitor.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Pool of worker threads for CPU bound work.
+ * Each worker has its own queue of tasks. Tasks pushed from a worker go to
+ * its own queue and are run newest first, which keeps related data in the
+ * caches; tasks pushed from other threads are spread among the workers. An
+ * idle worker steals the oldest tasks from the others.
+ */
+typedef struct _FlucThreadPool FlucThreadPool;
+
+/**
+ * Set of tasks which can be waited for together.
+ * Only public for the thread safety annotations, do not access its fields.
+ */
+typedef struct _FlucTaskGroup FlucTaskGroup;
+
+struct _FlucTaskGroup
+{
+  FlucThreadPool *pool;
+  FlucMonitor monitor;
+  guint outstanding GUARDED_BY (monitor);
+};
+
+typedef void (*FlucThreadPoolFunc) (gpointer data);
+
+/**
+ * Create a pool with n_workers threads, or one per CPU if 0.
+ * If pin_cpus is TRUE, each worker is bound to a CPU (only on Linux).
+ */
+FLUC_EXPORT FlucThreadPool *fluc_thread_pool_new (
+    guint n_workers, gboolean pin_cpus);
+
+/**
+ * Run all the pending tasks, then stop the workers and free the pool.
+ * Must not be called from one of its workers.
+ */
+FLUC_EXPORT void fluc_thread_pool_free (FlucThreadPool *pool);
+
+FLUC_EXPORT guint fluc_thread_pool_get_n_workers (FlucThreadPool *pool);
+
+/**
+ * Queue func (data) to be run by a worker. If group is not NULL, the task
+ * is added to it.
+ */
+FLUC_EXPORT void fluc_thread_pool_push (FlucThreadPool *pool,
+    FlucThreadPoolFunc func, gpointer data, FlucTaskGroup *group);
+
+/**
+ * Process-wide pool, with one worker per CPU, so components share the cores
+ * instead of each spawning its own threads.
+ * Call fluc_thread_pools_init() before using it and fluc_thread_pools_dispose()
+ * when done.
+ */
+FLUC_EXPORT void fluc_thread_pools_init ();
+FLUC_EXPORT void fluc_thread_pools_dispose ();
+FLUC_EXPORT FlucThreadPool *fluc_thread_pools_get_shared ();
+
+FLUC_EXPORT FlucTaskGroup *fluc_task_group_new (FlucThreadPool *pool);
+
+/**
+ * The group must have no pending tasks, see fluc_task_group_wait().
+ */
+FLUC_EXPORT void fluc_task_group_free (FlucTaskGroup *group);
+
+/**
+ * Block until all the tasks of the group have run.
+ */
+FLUC_EXPORT void fluc_task_group_wait (FlucTaskGroup *group)
+    EXCLUDES (&group->monitor);
+
+/**
+ * Like fluc_task_group_wait(), but the calling thread runs queued tasks of
+ * the pool meanwhile. This is the one to use from inside a task, so that
+ * waiting workers cannot starve the pool.
+ */
+FLUC_EXPORT void fluc_task_group_join (FlucTaskGroup *group)
+    EXCLUDES (&group->monitor);
+
+G_END_DECLS
+#endif /* _FLUC_THREAD_POOL_H_ */
@@ -9,6 +9,11 @@
 #define _FLUC_THREADS_H_
 
 #include <fluc/threads/fluc_barrier.h>
+#include <fluc/threads/fluc_lock_profile.h>
+#include <fluc/threads/fluc_mpsc_queue.h>
+#include <fluc/threads/fluc_spsc_ring.h>
+#include <fluc/threads/fluc_thread_pool.h>
+#include <fluc/threads/fluc_timer_wheel.h>
 #include <gst/gst.h>
 
 /**
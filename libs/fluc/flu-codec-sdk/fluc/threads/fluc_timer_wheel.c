@@ -0,0 +1,261 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fluc_timer_wheel.h"
+
+/* 4 levels of 64 slots. A timer goes to the lowest level whose span covers
+ * it; when level 0 wraps, the due slot of the level above is cascaded, i.e.
+ * its timers are added again and fall into lower levels. */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_MAX_DELTA ((gint64) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+struct _FlucTimerWheel
+{
+  gint64 resolution;
+  gint64 time;    /* Last advance */
+  gint64 current; /* Next tick to process */
+  guint armed;
+  /* Circular lists, the slot itself is the sentinel */
+  FlucTimer slots[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+static void
+_list_init (FlucTimer *head)
+{
+  head->prev = head->next = head;
+}
+
+static gboolean
+_list_is_empty (FlucTimer *head)
+{
+  return head->next == head;
+}
+
+static void
+_list_append (FlucTimer *head, FlucTimer *timer)
+{
+  timer->prev = head->prev;
+  timer->next = head;
+  head->prev->next = timer;
+  head->prev = timer;
+}
+
+static void
+_list_unlink (FlucTimer *timer)
+{
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->prev = timer->next = NULL;
+}
+
+/* Move all the timers of 'from' to the empty list 'to' */
+static void
+_list_take (FlucTimer *to, FlucTimer *from)
+{
+  if (_list_is_empty (from)) {
+    _list_init (to);
+    return;
+  }
+  to->next = from->next;
+  to->prev = from->prev;
+  to->next->prev = to;
+  to->prev->next = to;
+  _list_init (from);
+}
+
+static void
+_add (FlucTimerWheel *wheel, FlucTimer *timer)
+{
+  gint64 expires = MAX (timer->expires, wheel->current);
+  gint64 delta = expires - wheel->current;
+  guint level = 0;
+
+  /* Too far away: park it in the last slot that will be cascaded in time */
+  if (delta >= WHEEL_MAX_DELTA) {
+    delta = WHEEL_MAX_DELTA - 1;
+    expires = wheel->current + delta;
+  }
+
+  while (delta >= (gint64) 1 << (WHEEL_BITS * (level + 1)))
+    level++;
+
+  _list_append (
+      &wheel->slots[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK],
+      timer);
+}
+
+static void
+_cascade (FlucTimerWheel *wheel, guint level, guint index)
+{
+  FlucTimer list;
+
+  _list_take (&list, &wheel->slots[level][index]);
+  while (!_list_is_empty (&list)) {
+    FlucTimer *timer = list.next;
+    _list_unlink (timer);
+    _add (wheel, timer);
+  }
+}
+
+/* Process the current tick. Returns the number of expired timers. */
+static guint
+_tick (FlucTimerWheel *wheel)
+{
+  guint index = wheel->current & WHEEL_MASK;
+  guint level, expired = 0;
+  FlucTimer list;
+
+  if (!index) {
+    for (level = 1; level < WHEEL_LEVELS; level++) {
+      guint i = (wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK;
+      _cascade (wheel, level, i);
+      if (i)
+        break;
+    }
+  }
+
+  /* Timers armed from the callbacks must go to the next tick onwards */
+  _list_take (&list, &wheel->slots[0][index]);
+  wheel->current++;
+
+  while (!_list_is_empty (&list)) {
+    FlucTimer *timer = list.next;
+    _list_unlink (timer);
+    wheel->armed--;
+    expired++;
+    timer->func (timer, timer->data);
+  }
+
+  return expired;
+}
+
+/*********************************************************************
+ * public functions
+ ********************************************************************/
+
+void
+fluc_timer_init (FlucTimer *timer, FlucTimerFunc func, gpointer data)
+{
+  timer->prev = timer->next = NULL;
+  timer->expires = 0;
+  timer->func = func;
+  timer->data = data;
+}
+
+gboolean
+fluc_timer_is_armed (FlucTimer *timer)
+{
+  return timer->next != NULL;
+}
+
+FlucTimerWheel *
+fluc_timer_wheel_new (gint64 resolution, gint64 now)
+{
+  FlucTimerWheel *wheel;
+  guint level, slot;
+
+  g_return_val_if_fail (resolution > 0, NULL);
+
+  wheel = g_new0 (FlucTimerWheel, 1);
+  wheel->resolution = resolution;
+  wheel->time = now;
+  wheel->current = now / resolution;
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      _list_init (&wheel->slots[level][slot]);
+
+  return wheel;
+}
+
+void
+fluc_timer_wheel_free (FlucTimerWheel *wheel)
+{
+  guint level, slot;
+
+  /* Leave the timers disarmed */
+  for (level = 0; level < WHEEL_LEVELS; level++) {
+    for (slot = 0; slot < WHEEL_SLOTS; slot++) {
+      FlucTimer *head = &wheel->slots[level][slot];
+      while (!_list_is_empty (head))
+        _list_unlink (head->next);
+    }
+  }
+  g_free (wheel);
+}
+
+void
+fluc_timer_wheel_arm (FlucTimerWheel *wheel, FlucTimer *timer, gint64 expires)
+{
+  if (fluc_timer_is_armed (timer))
+    _list_unlink (timer);
+  else
+    wheel->armed++;
+
+  /* Rounded up, so it never expires early */
+  timer->expires = (expires + wheel->resolution - 1) / wheel->resolution;
+  _add (wheel, timer);
+}
+
+void
+fluc_timer_wheel_cancel (FlucTimerWheel *wheel, FlucTimer *timer)
+{
+  if (!fluc_timer_is_armed (timer))
+    return;
+
+  _list_unlink (timer);
+  wheel->armed--;
+}
+
+guint
+fluc_timer_wheel_advance (FlucTimerWheel *wheel, gint64 now)
+{
+  gint64 now_tick = now / wheel->resolution;
+  guint expired = 0;
+
+  wheel->time = now;
+
+  while (wheel->current <= now_tick) {
+    /* Nothing can expire, skip the idle ticks */
+    if (!wheel->armed) {
+      wheel->current = now_tick + 1;
+      break;
+    }
+    expired += _tick (wheel);
+  }
+
+  return expired;
+}
+
+gint64
+fluc_timer_wheel_get_time (FlucTimerWheel *wheel)
+{
+  return wheel->time;
+}
+
+gint64
+fluc_timer_wheel_get_next_deadline (FlucTimerWheel *wheel)
+{
+  gint64 tick;
+
+  if (!wheel->armed)
+    return -1;
+
+  /* Timers in the upper levels are only known once cascaded, which happens
+   * when level 0 wraps, so that is the latest deadline */
+  for (tick = wheel->current;; tick++) {
+    if (!_list_is_empty (&wheel->slots[0][tick & WHEEL_MASK]) ||
+        !(tick & WHEEL_MASK))
+      return tick * wheel->resolution;
+  }
+}
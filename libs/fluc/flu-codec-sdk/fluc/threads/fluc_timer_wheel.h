@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+
+
+#ifndef _FLUC_TIMER_WHEEL_H_
+#define _FLUC_TIMER_WHEEL_H_
+
+#include <fluc/fluc_export.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Hierarchical timer wheel, for event loops handling many timeouts.
+ * Arming, cancelling and expiring a timer are O(1) and the wheel never
+ * reads the clock: the loop passes the current time to
+ * fluc_timer_wheel_advance(), typically once per iteration.
+ * Timers expire on the first advance at or after their expiration time,
+ * rounded up to the resolution, never before.
+ * A wheel is not thread safe: it belongs to the loop driving it, and any
+ * call from another thread must be serialized with the loop by a lock.
+ *
+ * Times are all in μs, as returned by g_get_monotonic_time().
+ */
+typedef struct _FlucTimerWheel FlucTimerWheel;
+typedef struct _FlucTimer FlucTimer;
+
+typedef void (*FlucTimerFunc) (FlucTimer *timer, gpointer data);
+
+/**
+ * Meant to be embedded in the structure it times out, so no allocation is
+ * needed. Initialize with fluc_timer_init(), do not access its fields.
+ */
+struct _FlucTimer
+{
+  FlucTimer *prev;
+  FlucTimer *next;
+  gint64 expires; /* In ticks */
+  FlucTimerFunc func;
+  gpointer data;
+};
+
+FLUC_EXPORT void fluc_timer_init (
+    FlucTimer *timer, FlucTimerFunc func, gpointer data);
+FLUC_EXPORT gboolean fluc_timer_is_armed (FlucTimer *timer);
+
+/**
+ * Create a wheel with the given tick length, starting at 'now'.
+ * Timers further away than 2^24 ticks are clamped and re-armed when they
+ * get closer, so they still expire on time.
+ */
+FLUC_EXPORT FlucTimerWheel *fluc_timer_wheel_new (
+    gint64 resolution, gint64 now);
+
+/**
+ * Timers still armed are just forgotten.
+ */
+FLUC_EXPORT void fluc_timer_wheel_free (FlucTimerWheel *wheel);
+
+/**
+ * Arm the timer to expire at 'expires', moving it if it was already armed.
+ */
+FLUC_EXPORT void fluc_timer_wheel_arm (
+    FlucTimerWheel *wheel, FlucTimer *timer, gint64 expires);
+FLUC_EXPORT void fluc_timer_wheel_cancel (
+    FlucTimerWheel *wheel, FlucTimer *timer);
+
+/**
+ * Move the wheel to 'now' and call the function of every timer that
+ * expired, in expiration order. Timers are disarmed before their function is
+ * called, which can arm or cancel any timer, itself included.
+ * Returns the number of expired timers.
+ */
+FLUC_EXPORT guint fluc_timer_wheel_advance (FlucTimerWheel *wheel, gint64 now);
+
+/**
+ * Time of the last advance
+ */
+FLUC_EXPORT gint64 fluc_timer_wheel_get_time (FlucTimerWheel *wheel);
+
+/**
+ * Time by which the loop should advance the wheel again, or -1 if no timer
+ * is armed. It may be earlier than the next expiration, but never later.
+ */
+FLUC_EXPORT gint64 fluc_timer_wheel_get_next_deadline (FlucTimerWheel *wheel);
+
+G_END_DECLS
+#endif /* _FLUC_TIMER_WHEEL_H_ */
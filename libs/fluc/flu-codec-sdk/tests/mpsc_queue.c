@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the multiple producer, single consumer queue: the full and empty
+ * cases, closing, and several producers pushing through a small queue at
+ * once, where every item must arrive exactly once and the items of each
+ * producer in the order they were pushed. */
+
+#include <gst/check/gstcheck.h>
+
+#include <fluc/threads/fluc_mpsc_queue.h>
+
+#define N_PRODUCERS 4
+#define ITEMS_PER_PRODUCER 100000
+
+/* Items are never NULL: producer in the high bits, 1-based count below */
+#define MAKE_ITEM(producer, n) GUINT_TO_POINTER ((producer) << 24 | ((n) + 1))
+#define ITEM_PRODUCER(item) (GPOINTER_TO_UINT (item) >> 24)
+#define ITEM_N(item) ((GPOINTER_TO_UINT (item) & 0xffffff) - 1)
+
+GST_START_TEST (test_full_empty)
+{
+  FlucMpscQueue *queue;
+  guint i;
+
+  queue = fluc_mpsc_queue_new (5);
+  fail_unless_equals_int (fluc_mpsc_queue_get_capacity (queue), 8);
+  fail_unless (fluc_mpsc_queue_pop (queue) == NULL);
+
+  /* Go around the ring a few times */
+  for (i = 0; i < 3 * 8; i++) {
+    guint n;
+
+    for (n = 0; n < 8; n++)
+      fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, i + n)));
+    fail_if (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 0)));
+
+    for (n = 0; n < 8; n++)
+      fail_unless (fluc_mpsc_queue_pop (queue) == MAKE_ITEM (0, i + n));
+    fail_unless (fluc_mpsc_queue_pop (queue) == NULL);
+
+    /* Leave one behind so the next round starts at another cell */
+    fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 0)));
+    fail_unless (fluc_mpsc_queue_pop (queue) == MAKE_ITEM (0, 0));
+  }
+
+  fluc_mpsc_queue_free (queue);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_close)
+{
+  FlucMpscQueue *queue;
+
+  queue = fluc_mpsc_queue_new (4);
+  fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 0)));
+  fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 1)));
+  fluc_mpsc_queue_close (queue);
+  fail_unless (fluc_mpsc_queue_is_closed (queue));
+  fail_if (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 2)));
+  fail_if (fluc_mpsc_queue_push_wait (queue, MAKE_ITEM (0, 2), -1));
+
+  /* What was queued before closing can still be popped */
+  fail_unless (fluc_mpsc_queue_pop_wait (queue, -1) == MAKE_ITEM (0, 0));
+  fail_unless (fluc_mpsc_queue_pop_wait (queue, -1) == MAKE_ITEM (0, 1));
+  fail_unless (fluc_mpsc_queue_pop_wait (queue, -1) == NULL);
+
+  fluc_mpsc_queue_free (queue);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_timeout)
+{
+  FlucMpscQueue *queue;
+
+  /* A single cell could not tell full from empty */
+  queue = fluc_mpsc_queue_new (1);
+  fail_unless_equals_int (fluc_mpsc_queue_get_capacity (queue), 2);
+  fail_unless (fluc_mpsc_queue_pop_wait (
+                   queue, g_get_monotonic_time () + 1000) == NULL);
+  fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 0)));
+  fail_unless (fluc_mpsc_queue_push (queue, MAKE_ITEM (0, 1)));
+  fail_if (fluc_mpsc_queue_push_wait (
+      queue, MAKE_ITEM (0, 2), g_get_monotonic_time () + 1000));
+  fluc_mpsc_queue_free (queue);
+}
+GST_END_TEST;
+
+typedef struct
+{
+  FlucMpscQueue *queue;
+  guint index;
+} Producer;
+
+static gpointer
+producer_function (gpointer data)
+{
+  Producer *producer = data;
+  guint n;
+
+  for (n = 0; n < ITEMS_PER_PRODUCER; n++) {
+    /* Alternate the blocking and the spinning paths */
+    if (n % 2) {
+      fail_unless (fluc_mpsc_queue_push_wait (
+          producer->queue, MAKE_ITEM (producer->index, n), -1));
+    } else {
+      while (!fluc_mpsc_queue_push (
+          producer->queue, MAKE_ITEM (producer->index, n)))
+        g_thread_yield ();
+    }
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_producers)
+{
+  FlucMpscQueue *queue;
+  Producer producers[N_PRODUCERS];
+  GThread *threads[N_PRODUCERS];
+  guint next[N_PRODUCERS] = { 0 };
+  guint i, received;
+
+  queue = fluc_mpsc_queue_new (64);
+  for (i = 0; i < N_PRODUCERS; i++) {
+    producers[i].queue = queue;
+    producers[i].index = i;
+    threads[i] = g_thread_new ("producer", producer_function, &producers[i]);
+  }
+
+  for (received = 0; received < N_PRODUCERS * ITEMS_PER_PRODUCER;
+       received++) {
+    gpointer item = fluc_mpsc_queue_pop_wait (queue, -1);
+    guint producer;
+
+    fail_unless (item != NULL);
+    producer = ITEM_PRODUCER (item);
+    fail_unless (producer < N_PRODUCERS);
+    if (producer >= N_PRODUCERS)
+      break;
+    fail_unless_equals_int (ITEM_N (item), next[producer]);
+    next[producer] = ITEM_N (item) + 1;
+  }
+
+  for (i = 0; i < N_PRODUCERS; i++) {
+    g_thread_join (threads[i]);
+    fail_unless_equals_int (next[i], ITEMS_PER_PRODUCER);
+  }
+  fail_unless (fluc_mpsc_queue_pop (queue) == NULL);
+
+  fluc_mpsc_queue_free (queue);
+}
+GST_END_TEST;
+
+static Suite *
+fluc_mpsc_queue_suite (void)
+{
+  Suite *s = suite_create ("fluc_mpsc_queue");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_full_empty);
+  tcase_add_test (tc, test_close);
+  tcase_add_test (tc, test_timeout);
+  tcase_add_test (tc, test_producers);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fluc_mpsc_queue);
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the single producer, single consumer ring: the full and empty
+ * cases, wrapping around the end of the buffer with sizes that do not
+ * divide the capacity, closing, and a producer and a consumer streaming a
+ * known sequence through it. */
+
+#include <gst/check/gstcheck.h>
+
+#include <fluc/threads/fluc_spsc_ring.h>
+
+#define STREAM_SIZE (4 * 1024 * 1024)
+/* A period prime to the capacity, so stale data is never mistaken for new */
+#define STREAM_BYTE(pos) ((pos) % 251)
+
+GST_START_TEST (test_capacity)
+{
+  FlucSpscRing *ring;
+
+  ring = fluc_spsc_ring_new (100);
+  fail_unless_equals_int (fluc_spsc_ring_get_capacity (ring), 128);
+  fail_unless_equals_int (fluc_spsc_ring_get_readable (ring), 0);
+  fail_unless_equals_int (fluc_spsc_ring_get_writable (ring), 128);
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_full_empty)
+{
+  FlucSpscRing *ring;
+  guint8 in[40], out[40];
+  guint i;
+
+  for (i = 0; i < sizeof (in); i++)
+    in[i] = i;
+
+  ring = fluc_spsc_ring_new (32);
+  fail_unless_equals_int (fluc_spsc_ring_read (ring, out, sizeof (out)), 0);
+
+  /* Only what fits is written */
+  fail_unless_equals_int (fluc_spsc_ring_write (ring, in, sizeof (in)), 32);
+  fail_unless_equals_int (fluc_spsc_ring_get_readable (ring), 32);
+  fail_unless_equals_int (fluc_spsc_ring_get_writable (ring), 0);
+  fail_unless_equals_int (fluc_spsc_ring_write (ring, in, 1), 0);
+
+  /* Only what is there is read */
+  fail_unless_equals_int (fluc_spsc_ring_read (ring, out, sizeof (out)), 32);
+  fail_unless (memcmp (in, out, 32) == 0);
+  fail_unless_equals_int (fluc_spsc_ring_get_readable (ring), 0);
+  fail_unless_equals_int (fluc_spsc_ring_get_writable (ring), 32);
+  fail_unless_equals_int (fluc_spsc_ring_read (ring, out, 1), 0);
+
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_wrap_around)
+{
+  FlucSpscRing *ring;
+  guint8 in[13], out[13];
+  guint8 next_in = 0, next_out = 0;
+  guint round, i;
+
+  /* 13 and 7 do not divide 64, so the copies split at every possible
+   * offset of the buffer over the rounds */
+  ring = fluc_spsc_ring_new (64);
+  for (round = 0; round < 1000; round++) {
+    gsize written, read;
+
+    for (i = 0; i < sizeof (in); i++)
+      in[i] = next_in + i;
+    written = fluc_spsc_ring_write (ring, in, sizeof (in));
+    next_in += written;
+
+    read = fluc_spsc_ring_read (ring, out, round % 2 ? 7 : sizeof (out));
+    for (i = 0; i < read; i++)
+      fail_unless_equals_int (out[i], (guint8) (next_out + i));
+    next_out += read;
+
+    fail_unless_equals_int (fluc_spsc_ring_get_readable (ring),
+        (guint8) (next_in - next_out));
+  }
+
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_close)
+{
+  FlucSpscRing *ring;
+  guint8 out[16];
+
+  ring = fluc_spsc_ring_new (16);
+  fail_unless_equals_int (fluc_spsc_ring_write (ring, "abcd", 4), 4);
+  fluc_spsc_ring_close (ring);
+  fail_unless (fluc_spsc_ring_is_closed (ring));
+
+  /* What was written before closing can still be read */
+  fail_unless_equals_int (
+      fluc_spsc_ring_read_wait (ring, out, sizeof (out), -1), 4);
+  fail_unless (memcmp (out, "abcd", 4) == 0);
+  fail_unless_equals_int (
+      fluc_spsc_ring_read_wait (ring, out, sizeof (out), -1), 0);
+  fail_unless_equals_int (
+      fluc_spsc_ring_write_wait (ring, "efgh", 4, -1), 0);
+
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_timeout)
+{
+  FlucSpscRing *ring;
+  guint8 data[24] = { 0 };
+
+  ring = fluc_spsc_ring_new (16);
+  fail_unless_equals_int (fluc_spsc_ring_read_wait (ring, data, sizeof (data),
+                              g_get_monotonic_time () + 1000),
+      0);
+  /* Returns with the part that fitted */
+  fail_unless_equals_int (fluc_spsc_ring_write_wait (ring, data, sizeof (data),
+                              g_get_monotonic_time () + 1000),
+      16);
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+static gpointer
+stream_producer (gpointer data)
+{
+  FlucSpscRing *ring = data;
+  guint8 chunk[1000];
+  guint32 pos = 0;
+
+  while (pos < STREAM_SIZE) {
+    gsize size = 1 + g_random_int_range (0, sizeof (chunk));
+    gsize i;
+
+    size = MIN (size, STREAM_SIZE - pos);
+    for (i = 0; i < size; i++)
+      chunk[i] = STREAM_BYTE (pos + i);
+    fail_unless_equals_int (
+        fluc_spsc_ring_write_wait (ring, chunk, size, -1), size);
+    pos += size;
+  }
+  fluc_spsc_ring_close (ring);
+
+  return NULL;
+}
+
+GST_START_TEST (test_stream)
+{
+  FlucSpscRing *ring;
+  GThread *producer;
+  guint8 chunk[777];
+  guint32 pos = 0;
+  gsize size;
+
+  ring = fluc_spsc_ring_new (4096);
+  producer = g_thread_new ("producer", stream_producer, ring);
+
+  while ((size = fluc_spsc_ring_read_wait (ring, chunk,
+              1 + g_random_int_range (0, sizeof (chunk)), -1))) {
+    gsize i;
+
+    for (i = 0; i < size; i++) {
+      if (chunk[i] != STREAM_BYTE (pos + i))
+        break;
+    }
+    fail_unless (i == size, "Corrupted data at %u", pos + (guint) i);
+    pos += size;
+  }
+  fail_unless_equals_int (pos, STREAM_SIZE);
+
+  g_thread_join (producer);
+  fluc_spsc_ring_free (ring);
+}
+GST_END_TEST;
+
+static Suite *
+fluc_spsc_ring_suite (void)
+{
+  Suite *s = suite_create ("fluc_spsc_ring");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_capacity);
+  tcase_add_test (tc, test_full_empty);
+  tcase_add_test (tc, test_wrap_around);
+  tcase_add_test (tc, test_close);
+  tcase_add_test (tc, test_timeout);
+  tcase_add_test (tc, test_stream);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fluc_spsc_ring);
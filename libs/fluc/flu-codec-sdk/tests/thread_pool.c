@@ -0,0 +1,220 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks that the thread pool runs every task exactly once: waited for in
+ * groups, joined from inside other tasks, stolen by idle workers and still
+ * queued when the pool is freed. */
+
+#include <gst/check/gstcheck.h>
+
+#include <fluc/threads/fluc_thread_pool.h>
+
+#define N_TASKS 10000
+#define SPLIT_DEPTH 10
+
+static void
+count_task (gpointer data)
+{
+  g_atomic_int_inc ((gint *) data);
+}
+
+static void
+slow_task (gpointer data)
+{
+  g_usleep (100);
+  g_atomic_int_inc ((gint *) data);
+}
+
+GST_START_TEST (test_run_all)
+{
+  FlucThreadPool *pool;
+  FlucTaskGroup *group;
+  gint count = 0;
+  gint i;
+
+  pool = fluc_thread_pool_new (4, FALSE);
+  fail_unless_equals_int (fluc_thread_pool_get_n_workers (pool), 4);
+
+  group = fluc_task_group_new (pool);
+  for (i = 0; i < N_TASKS; i++)
+    fluc_thread_pool_push (pool, count_task, &count, group);
+  fluc_task_group_wait (group);
+  fail_unless_equals_int (g_atomic_int_get (&count), N_TASKS);
+
+  /* An empty group does not block */
+  fluc_task_group_wait (group);
+  fluc_task_group_join (group);
+
+  fluc_task_group_free (group);
+  fluc_thread_pool_free (pool);
+}
+GST_END_TEST;
+
+typedef struct
+{
+  FlucThreadPool *pool;
+  gint depth;
+  gint *count;
+} SplitData;
+
+/* Splits in two until depth runs out, joining the halves from inside the
+ * task. With fewer workers than levels, this only completes if joining
+ * workers run queued tasks instead of blocking */
+static void
+split_task (gpointer data)
+{
+  SplitData *split = data;
+  SplitData halves[2];
+  FlucTaskGroup *group;
+  gint i;
+
+  if (!split->depth) {
+    g_atomic_int_inc (split->count);
+    return;
+  }
+
+  group = fluc_task_group_new (split->pool);
+  for (i = 0; i < 2; i++) {
+    halves[i] = *split;
+    halves[i].depth--;
+    fluc_thread_pool_push (split->pool, split_task, &halves[i], group);
+  }
+  fluc_task_group_join (group);
+  fluc_task_group_free (group);
+}
+
+GST_START_TEST (test_nested_join)
+{
+  FlucThreadPool *pool;
+  FlucTaskGroup *group;
+  SplitData split;
+  gint count = 0;
+
+  pool = fluc_thread_pool_new (2, FALSE);
+  split.pool = pool;
+  split.depth = SPLIT_DEPTH;
+  split.count = &count;
+
+  group = fluc_task_group_new (pool);
+  fluc_thread_pool_push (pool, split_task, &split, group);
+  fluc_task_group_join (group);
+  fail_unless_equals_int (g_atomic_int_get (&count), 1 << SPLIT_DEPTH);
+
+  fluc_task_group_free (group);
+  fluc_thread_pool_free (pool);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_free_with_queued_tasks)
+{
+  FlucThreadPool *pool;
+  gint count = 0;
+  gint i;
+
+  /* Most of the tasks are still queued when the pool is freed */
+  pool = fluc_thread_pool_new (2, FALSE);
+  for (i = 0; i < 1000; i++)
+    fluc_thread_pool_push (pool, slow_task, &count, NULL);
+  fluc_thread_pool_free (pool);
+
+  fail_unless_equals_int (count, 1000);
+}
+GST_END_TEST;
+
+typedef struct
+{
+  FlucThreadPool *pool;
+  FlucTaskGroup *group;
+  GMutex lock;
+  GHashTable *threads;
+} StealData;
+
+static void
+record_thread_task (gpointer data)
+{
+  StealData *steal = data;
+
+  g_usleep (100);
+  g_mutex_lock (&steal->lock);
+  g_hash_table_add (steal->threads, g_thread_self ());
+  g_mutex_unlock (&steal->lock);
+}
+
+static void
+spawn_task (gpointer data)
+{
+  StealData *steal = data;
+  gint i;
+
+  /* These go to the queue of the current worker, the others have to steal
+   * them to get any work */
+  for (i = 0; i < 200; i++)
+    fluc_thread_pool_push (steal->pool, record_thread_task, steal,
+        steal->group);
+}
+
+GST_START_TEST (test_steal)
+{
+  StealData steal;
+
+  steal.pool = fluc_thread_pool_new (4, FALSE);
+  steal.group = fluc_task_group_new (steal.pool);
+  g_mutex_init (&steal.lock);
+  steal.threads = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  fluc_thread_pool_push (steal.pool, spawn_task, &steal, steal.group);
+  fluc_task_group_wait (steal.group);
+  fail_unless (g_hash_table_size (steal.threads) > 1);
+
+  fluc_task_group_free (steal.group);
+  fluc_thread_pool_free (steal.pool);
+  g_hash_table_unref (steal.threads);
+  g_mutex_clear (&steal.lock);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_shared_pool)
+{
+  FlucTaskGroup *group;
+  gint count = 0;
+
+  fail_unless (fluc_thread_pools_get_shared () == NULL);
+
+  fluc_thread_pools_init ();
+  fluc_thread_pools_init ();
+  fail_unless (fluc_thread_pools_get_shared () != NULL);
+
+  group = fluc_task_group_new (fluc_thread_pools_get_shared ());
+  fluc_thread_pool_push (
+      fluc_thread_pools_get_shared (), count_task, &count, group);
+  fluc_task_group_wait (group);
+  fluc_task_group_free (group);
+  fail_unless_equals_int (count, 1);
+
+  /* Only the last user frees it */
+  fluc_thread_pools_dispose ();
+  fail_unless (fluc_thread_pools_get_shared () != NULL);
+  fluc_thread_pools_dispose ();
+  fail_unless (fluc_thread_pools_get_shared () == NULL);
+}
+GST_END_TEST;
+
+static Suite *
+fluc_thread_pool_suite (void)
+{
+  Suite *s = suite_create ("fluc_thread_pool");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_run_all);
+  tcase_add_test (tc, test_nested_join);
+  tcase_add_test (tc, test_free_with_queued_tasks);
+  tcase_add_test (tc, test_steal);
+  tcase_add_test (tc, test_shared_pool);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fluc_thread_pool);
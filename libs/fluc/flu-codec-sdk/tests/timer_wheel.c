@@ -0,0 +1,306 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks that timers expire on the first advance at or after their
+ * expiration time and in expiration order, whichever level of the wheel they
+ * start in, including timeouts beyond the span of the wheel, and that they
+ * can be cancelled and re-armed, from the callbacks too. */
+
+#include <gst/check/gstcheck.h>
+
+#include <fluc/threads/fluc_timer_wheel.h>
+
+#define RESOLUTION 1000
+#define N_TIMERS 2000
+/* Span of the wheel, further timers are parked and re-armed */
+#define WHEEL_SPAN ((gint64) 1 << 24)
+
+typedef struct
+{
+  FlucTimer timer;
+  gint64 expires;
+  gint fired;
+  /* Re-armed this many times from the callback, 'period' later */
+  gint rearm;
+  gint64 period;
+  /* Cancelled from the callback */
+  FlucTimer *victim;
+} TestTimer;
+
+static FlucTimerWheel *wheel;
+/* Time of the advance in progress and of the previous one */
+static gint64 now;
+static gint64 last;
+/* Expiration time of the last timer fired during the advance */
+static gint64 last_fired;
+
+static gint64
+round_up (gint64 time)
+{
+  return (time + RESOLUTION - 1) / RESOLUTION * RESOLUTION;
+}
+
+static void
+timer_fired (FlucTimer *timer, gpointer data)
+{
+  TestTimer *t = data;
+  gint64 expires = round_up (t->expires);
+
+  fail_if (fluc_timer_is_armed (timer));
+  fail_unless (expires <= now, "Expired early");
+  fail_unless (expires > last, "Expired late");
+  fail_unless (expires >= last_fired, "Expired out of order");
+  last_fired = expires;
+  t->fired++;
+
+  if (t->victim)
+    fluc_timer_wheel_cancel (wheel, t->victim);
+  if (t->rearm) {
+    t->rearm--;
+    t->expires += t->period;
+    fluc_timer_wheel_arm (wheel, timer, t->expires);
+  }
+}
+
+static void
+test_timer_init (TestTimer *t, gint64 expires)
+{
+  fluc_timer_init (&t->timer, timer_fired, t);
+  t->expires = expires;
+  t->fired = 0;
+  t->rearm = 0;
+  t->period = 0;
+  t->victim = NULL;
+}
+
+static void
+setup_wheel (gint64 time)
+{
+  wheel = fluc_timer_wheel_new (RESOLUTION, time);
+  now = last = time;
+}
+
+static void
+advance (gint64 time, guint expected)
+{
+  last_fired = G_MININT64;
+  now = time;
+  fail_unless_equals_int (fluc_timer_wheel_advance (wheel, now), expected);
+  fail_unless_equals_uint64 (fluc_timer_wheel_get_time (wheel), now);
+  last = now;
+}
+
+GST_START_TEST (test_random)
+{
+  GRand *rand = g_rand_new_with_seed (0x5ee1);
+  TestTimer *timers;
+  gint64 start = 12345678;
+  gint i, pending = N_TIMERS;
+
+  setup_wheel (start);
+  fail_unless_equals_int (fluc_timer_wheel_get_next_deadline (wheel), -1);
+
+  /* Spread over the first three levels, not aligned to the resolution */
+  timers = g_new (TestTimer, N_TIMERS);
+  for (i = 0; i < N_TIMERS; i++) {
+    test_timer_init (&timers[i],
+        start + g_rand_int_range (rand, 0, 300000) * (gint64) RESOLUTION / 8);
+    fluc_timer_wheel_arm (wheel, &timers[i].timer, timers[i].expires);
+    fail_unless (fluc_timer_is_armed (&timers[i].timer));
+  }
+
+  while (pending) {
+    gint64 deadline = fluc_timer_wheel_get_next_deadline (wheel);
+    gint64 time = last + g_rand_int_range (rand, 0, 200) * RESOLUTION / 4;
+    guint expected = 0;
+
+    for (i = 0; i < N_TIMERS; i++) {
+      gint64 expires = round_up (timers[i].expires);
+
+      if (timers[i].fired)
+        continue;
+      fail_unless (deadline <= expires, "Deadline later than a timer");
+      if (expires <= time)
+        expected++;
+    }
+    advance (time, expected);
+    pending -= expected;
+  }
+
+  for (i = 0; i < N_TIMERS; i++)
+    fail_unless_equals_int (timers[i].fired, 1);
+  fail_unless_equals_int (fluc_timer_wheel_get_next_deadline (wheel), -1);
+
+  fluc_timer_wheel_free (wheel);
+  g_free (timers);
+  g_rand_free (rand);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_cancel)
+{
+  TestTimer timers[100];
+  gint i;
+
+  setup_wheel (0);
+  for (i = 0; i < 100; i++) {
+    test_timer_init (&timers[i], (i + 1) * 100 * RESOLUTION);
+    fluc_timer_wheel_arm (wheel, &timers[i].timer, timers[i].expires);
+  }
+
+  /* Cancelling a disarmed timer is fine */
+  for (i = 0; i < 100; i += 2) {
+    fluc_timer_wheel_cancel (wheel, &timers[i].timer);
+    fail_if (fluc_timer_is_armed (&timers[i].timer));
+    fluc_timer_wheel_cancel (wheel, &timers[i].timer);
+  }
+
+  advance (100 * 100 * RESOLUTION, 50);
+  for (i = 0; i < 100; i++)
+    fail_unless_equals_int (timers[i].fired, i % 2);
+
+  /* Nothing left, even though some were in the upper levels */
+  fail_unless_equals_int (fluc_timer_wheel_get_next_deadline (wheel), -1);
+  advance (1000 * 100 * RESOLUTION, 0);
+
+  fluc_timer_wheel_free (wheel);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_cancel_from_callback)
+{
+  TestTimer killer, victim;
+
+  /* Both in the same tick, the victim is already out of the wheel when
+   * the killer runs */
+  setup_wheel (0);
+  test_timer_init (&killer, 100 * RESOLUTION);
+  test_timer_init (&victim, 100 * RESOLUTION);
+  killer.victim = &victim.timer;
+  fluc_timer_wheel_arm (wheel, &killer.timer, killer.expires);
+  fluc_timer_wheel_arm (wheel, &victim.timer, victim.expires);
+
+  advance (200 * RESOLUTION, 1);
+  fail_unless_equals_int (killer.fired, 1);
+  fail_unless_equals_int (victim.fired, 0);
+  fail_if (fluc_timer_is_armed (&victim.timer));
+  fail_unless_equals_int (fluc_timer_wheel_get_next_deadline (wheel), -1);
+
+  fluc_timer_wheel_free (wheel);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_rearm)
+{
+  TestTimer t;
+  gint i;
+
+  setup_wheel (0);
+
+  /* Moving an armed timer earlier and later */
+  test_timer_init (&t, 10 * RESOLUTION);
+  fluc_timer_wheel_arm (wheel, &t.timer, 5000 * RESOLUTION);
+  fluc_timer_wheel_arm (wheel, &t.timer, t.expires);
+  advance (9 * RESOLUTION, 0);
+  advance (10 * RESOLUTION, 1);
+
+  t.expires = 70 * RESOLUTION;
+  fluc_timer_wheel_arm (wheel, &t.timer, 20 * RESOLUTION);
+  fluc_timer_wheel_arm (wheel, &t.timer, t.expires);
+  advance (69 * RESOLUTION, 0);
+  advance (70 * RESOLUTION, 1);
+  fail_unless_equals_int (t.fired, 2);
+
+  /* Periodic, re-armed from the callback across the level boundaries */
+  t.fired = 0;
+  t.rearm = 99;
+  t.period = 7 * RESOLUTION;
+  t.expires = now + t.period;
+  fluc_timer_wheel_arm (wheel, &t.timer, t.expires);
+  for (i = 0; i < 100 * 7; i++)
+    advance (now + RESOLUTION, round_up (t.expires) <= now + RESOLUTION);
+  fail_unless_equals_int (t.fired, 100);
+  fail_if (fluc_timer_is_armed (&t.timer));
+
+  /* Re-armed in the past, expires on the next advance, not the same one */
+  t.fired = 0;
+  t.rearm = 1;
+  t.period = -10 * RESOLUTION;
+  t.expires = now + RESOLUTION;
+  fluc_timer_wheel_arm (wheel, &t.timer, t.expires);
+  advance (now + RESOLUTION, 1);
+  fail_unless (fluc_timer_is_armed (&t.timer));
+  /* Not late, it expires on the advance right after being armed */
+  t.expires = now + 1;
+  advance (now + RESOLUTION, 1);
+  fail_unless_equals_int (t.fired, 2);
+
+  fluc_timer_wheel_free (wheel);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_long_timeout)
+{
+  TestTimer far, cancelled;
+  gint64 step = (WHEEL_SPAN / 16) * RESOLUTION;
+
+  /* Beyond the span of the wheel, they are parked and re-armed on the way */
+  setup_wheel (0);
+  test_timer_init (&far, (3 * WHEEL_SPAN + 5) * RESOLUTION);
+  test_timer_init (&cancelled, (2 * WHEEL_SPAN + 7) * RESOLUTION);
+  fluc_timer_wheel_arm (wheel, &far.timer, far.expires);
+  fluc_timer_wheel_arm (wheel, &cancelled.timer, cancelled.expires);
+
+  while (now + step < far.expires) {
+    fail_unless (fluc_timer_wheel_get_next_deadline (wheel) <= far.expires);
+    advance (now + step, 0);
+    if (now > WHEEL_SPAN * RESOLUTION)
+      fluc_timer_wheel_cancel (wheel, &cancelled.timer);
+  }
+  advance (far.expires - 1, 0);
+  advance (far.expires, 1);
+  fail_unless_equals_int (far.fired, 1);
+  fail_unless_equals_int (cancelled.fired, 0);
+  fail_unless_equals_int (fluc_timer_wheel_get_next_deadline (wheel), -1);
+
+  fluc_timer_wheel_free (wheel);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_idle_skip)
+{
+  TestTimer t;
+
+  /* Advancing an empty wheel far away, then arming relative to it */
+  setup_wheel (0);
+  advance (10 * WHEEL_SPAN * RESOLUTION, 0);
+  test_timer_init (&t, now + 100 * RESOLUTION);
+  fluc_timer_wheel_arm (wheel, &t.timer, t.expires);
+  fail_unless (fluc_timer_wheel_get_next_deadline (wheel) <= t.expires);
+  advance (now + 99 * RESOLUTION, 0);
+  advance (now + RESOLUTION, 1);
+
+  fluc_timer_wheel_free (wheel);
+}
+GST_END_TEST;
+
+static Suite *
+fluc_timer_wheel_suite (void)
+{
+  Suite *s = suite_create ("fluc_timer_wheel");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_random);
+  tcase_add_test (tc, test_cancel);
+  tcase_add_test (tc, test_cancel_from_callback);
+  tcase_add_test (tc, test_rearm);
+  tcase_add_test (tc, test_long_timeout);
+  tcase_add_test (tc, test_idle_skip);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fluc_timer_wheel);
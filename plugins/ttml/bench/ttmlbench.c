@@ -0,0 +1,322 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * ttmlparse benchmarks on synthetic documents.
+ * Each scenario parses documents of growing number of cues and prints one
+ * record per size, either as a JSON object per line or as CSV. The cost per
+ * cue must stay flat as the documents grow; 'scaling' is the cost per cue
+ * relative to the smallest document of the scenario.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+typedef struct _BenchDocument
+{
+  gboolean ordered;  /* Set the assume_ordered_spans property */
+  gboolean animated; /* One <set> per cue, generating attribute events */
+  guint overlap;     /* Cues active at the same time */
+  gboolean builtin;  /* Set the builtin_tokenizer property */
+} BenchDocument;
+
+typedef struct _BenchResult
+{
+  const gchar *scenario;
+  guint cues;
+  gsize bytes;
+  guint buffers;
+  gint64 wall_time; /* us, best of the repetitions */
+  gint64 cpu_time;  /* us, of the best repetition */
+  gdouble scaling;
+} BenchResult;
+
+typedef struct _BenchScenario
+{
+  const gchar *name;
+  BenchDocument doc;
+} BenchScenario;
+
+static gint opt_min_cues = 1000;
+static gint opt_max_cues = 64000;
+static gint opt_repeat = 3;
+static gchar *opt_format = NULL;
+static gchar **opt_scenarios = NULL;
+
+static GOptionEntry entries[] = {
+  { "min-cues", 'n', 0, G_OPTION_ARG_INT, &opt_min_cues,
+      "Cues in the smallest document", "N" },
+  { "max-cues", 'm', 0, G_OPTION_ARG_INT, &opt_max_cues,
+      "Cues in the largest document, sizes double up to it", "N" },
+  { "repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+      "Runs per size, the fastest one is reported", "N" },
+  { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format,
+      "Output format: json (default) or csv", "FORMAT" },
+  { "scenario", 'S', 0, G_OPTION_ARG_STRING_ARRAY, &opt_scenarios,
+      "Run only this scenario (can be repeated)", "NAME" },
+  { NULL }
+};
+
+static const BenchScenario scenarios[] = {
+  /* The whole timeline is built before anything is output */
+  { "unordered", { FALSE, FALSE, 1 } },
+  /* Flushed as the cues arrive */
+  { "ordered", { TRUE, FALSE, 1 } },
+  { "animated", { FALSE, TRUE, 1 } },
+  { "overlapping", { FALSE, FALSE, 4 } },
+  /* Same as "unordered", parsed without libxml */
+  { "tokenizer", { FALSE, FALSE, 1, TRUE } },
+  { NULL }
+};
+
+static gint64
+_process_cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+             G_USEC_PER_SEC +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void
+_append_time (GString *str, guint64 ms)
+{
+  g_string_append_printf (str, "%02u:%02u:%02u.%03u",
+      (guint) (ms / 3600000), (guint) (ms / 60000 % 60),
+      (guint) (ms / 1000 % 60), (guint) (ms % 1000));
+}
+
+/* A cue starts every second and lasts 'overlap' seconds minus a bit */
+static GString *
+_document_new (const BenchDocument *doc, guint cues)
+{
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  g_string_append (str,
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\" "
+      "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">\n"
+      "<head>\n"
+      "<styling><style xml:id=\"s1\" tts:color=\"white\" "
+      "tts:fontSize=\"100%\"/></styling>\n"
+      "<layout><region xml:id=\"r1\" tts:origin=\"10% 80%\" "
+      "tts:extent=\"80% 20%\"/></layout>\n"
+      "</head>\n"
+      "<body region=\"r1\" style=\"s1\"><div>\n");
+
+  for (i = 0; i < cues; i++) {
+    guint64 begin = (guint64) i * 1000;
+
+    g_string_append (str, "<p begin=\"");
+    _append_time (str, begin);
+    g_string_append (str, "\" end=\"");
+    _append_time (str, begin + doc->overlap * 1000 - 100);
+    g_string_append_printf (str, "\">Cue number %u<br/>second line", i);
+    if (doc->animated)
+      g_string_append (str, "<set begin=\"0.5s\" tts:color=\"yellow\"/>");
+    g_string_append (str, "</p>\n");
+  }
+
+  g_string_append (str, "</div></body>\n</tt>\n");
+  return str;
+}
+
+static void
+_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, guint *count)
+{
+  (*count)++;
+}
+
+/* Parse the file once, returns FALSE on error */
+static gboolean
+_run (const BenchDocument *doc, const gchar *location, BenchResult *r)
+{
+  GstElement *pipeline, *src, *filter, *parse, *sink;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean ret;
+  gint64 wall, cpu;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  parse = gst_element_factory_make ("ttmlparse", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!pipeline || !src || !filter || !parse || !sink) {
+    g_printerr ("Missing elements, is GST_PLUGIN_PATH set?\n");
+    return FALSE;
+  }
+
+  caps = gst_caps_new_empty_simple ("application/ttml+xml");
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (src, "location", location, NULL);
+  g_object_set (parse, "assume_ordered_spans", doc->ordered,
+      "builtin_tokenizer", doc->builtin, NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+
+  r->buffers = 0;
+  g_signal_connect (sink, "handoff", G_CALLBACK (_handoff_cb), &r->buffers);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, filter, parse, sink, NULL);
+  gst_element_link_many (src, filter, parse, sink, NULL);
+
+  wall = g_get_monotonic_time ();
+  cpu = _process_cpu_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (
+      bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  ret = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+  if (!ret) {
+    GError *err = NULL;
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s\n", err->message);
+    g_error_free (err);
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  wall = g_get_monotonic_time () - wall;
+  cpu = _process_cpu_time () - cpu;
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  if (ret && (!r->wall_time || wall < r->wall_time)) {
+    r->wall_time = wall;
+    r->cpu_time = cpu;
+  }
+
+  return ret;
+}
+
+static void
+_print_result (BenchResult *r)
+{
+  static gboolean header_printed = FALSE;
+  gdouble seconds = r->wall_time / (gdouble) G_USEC_PER_SEC;
+  gdouble us_per_cue = r->wall_time / (gdouble) r->cues;
+
+  if (!g_strcmp0 (opt_format, "csv")) {
+    if (!header_printed) {
+      g_printf ("scenario,cues,bytes,buffers,seconds,us_per_cue,cpu_ms,"
+                "scaling\n");
+      header_printed = TRUE;
+    }
+    g_printf ("%s,%u,%" G_GSIZE_FORMAT ",%u,%.6f,%.3f,%.3f,%.3f\n",
+        r->scenario, r->cues, r->bytes, r->buffers, seconds, us_per_cue,
+        r->cpu_time / 1000.0, r->scaling);
+  } else {
+    g_printf ("{\"scenario\":\"%s\",\"cues\":%u,\"bytes\":%" G_GSIZE_FORMAT
+              ",\"buffers\":%u,\"seconds\":%.6f,\"us_per_cue\":%.3f,"
+              "\"cpu_ms\":%.3f,\"scaling\":%.3f}\n",
+        r->scenario, r->cues, r->bytes, r->buffers, seconds, us_per_cue,
+        r->cpu_time / 1000.0, r->scaling);
+  }
+}
+
+static gboolean
+_scenario_run (const BenchScenario *s)
+{
+  gdouble base_cost = 0;
+  guint cues;
+
+  for (cues = opt_min_cues; cues <= (guint) opt_max_cues; cues *= 2) {
+    BenchResult r;
+    GString *doc;
+    GError *err = NULL;
+    gchar *location;
+    gint fd, i;
+    gboolean ok = TRUE;
+
+    memset (&r, 0, sizeof (BenchResult));
+    r.scenario = s->name;
+    r.cues = cues;
+
+    doc = _document_new (&s->doc, cues);
+    r.bytes = doc->len;
+    fd = g_file_open_tmp ("ttmlbench-XXXXXX.ttml", &location, &err);
+    if (fd < 0) {
+      g_printerr ("%s\n", err->message);
+      g_error_free (err);
+      g_string_free (doc, TRUE);
+      return FALSE;
+    }
+    g_close (fd, NULL);
+    ok = g_file_set_contents (location, doc->str, doc->len, NULL);
+    g_string_free (doc, TRUE);
+
+    for (i = 0; ok && i < opt_repeat; i++)
+      ok = _run (&s->doc, location, &r);
+
+    g_unlink (location);
+    g_free (location);
+    if (!ok)
+      return FALSE;
+
+    if (!base_cost)
+      base_cost = r.wall_time / (gdouble) cues;
+    r.scaling = base_cost > 0 ? r.wall_time / (gdouble) cues / base_cost : 0;
+    _print_result (&r);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+_scenario_selected (const gchar *name)
+{
+  gchar **it;
+
+  if (!opt_scenarios)
+    return TRUE;
+  for (it = opt_scenarios; *it; it++)
+    if (!strcmp (*it, name))
+      return TRUE;
+  return FALSE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  const BenchScenario *s;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- ttmlparse benchmarks");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    g_error_free (err);
+    g_option_context_free (ctx);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_min_cues < 1 || opt_max_cues < opt_min_cues || opt_repeat < 1) {
+    g_printerr ("cues and repeat must be positive, max-cues >= min-cues\n");
+    return -1;
+  }
+
+  for (s = scenarios; s->name; s++) {
+    if (_scenario_selected (s->name) && !_scenario_run (s)) {
+      ret = -1;
+      break;
+    }
+  }
+
+  g_strfreev (opt_scenarios);
+  g_free (opt_format);
+
+  return ret;
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Built-in tokenizer benchmarks against libxml2's push parser.
+ * Each scenario feeds the same synthetic documents, in buffers of a fixed
+ * size, to both parsers with SAX2 callbacks which do nothing, and prints one
+ * record per parser, either as a JSON object per line or as CSV. 'speedup'
+ * is the time libxml2 took divided by the time of the parser.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <string.h>
+#include <libxml/parser.h>
+
+#include "gstttmltokenizer.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+typedef struct _BenchScenario
+{
+  const gchar *name;
+  guint cues;      /* Per document */
+  guint documents; /* Parsed one after the other, as in a segmented stream */
+  gsize buffer_size;
+} BenchScenario;
+
+typedef void (*BenchParse) (const gchar *data, gsize len, gsize buffer_size,
+    guint documents);
+
+static gint opt_repeat = 5;
+static gchar *opt_format = NULL;
+static gchar **opt_scenarios = NULL;
+
+static GOptionEntry entries[] = {
+  { "repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+      "Runs per parser, the fastest one is reported", "N" },
+  { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format,
+      "Output format: json (default) or csv", "FORMAT" },
+  { "scenario", 'S', 0, G_OPTION_ARG_STRING_ARRAY, &opt_scenarios,
+      "Run only this scenario (can be repeated)", "NAME" },
+  { NULL }
+};
+
+static const BenchScenario scenarios[] = {
+  /* One large file */
+  { "large", 64000, 1, 4096 },
+  /* The same, arriving in small buffers */
+  { "small-buffers", 64000, 1, 16 },
+  /* Short documents, as live streams carry them */
+  { "segments", 3, 20000, 4096 },
+  { NULL }
+};
+
+static void
+_start_element (void *ctx, const xmlChar *name, const xmlChar *prefix,
+    const xmlChar *uri, int nb_namespaces, const xmlChar **namespaces,
+    int nb_attributes, int nb_defaulted, const xmlChar **attrs)
+{
+}
+
+static void
+_end_element (void *ctx, const xmlChar *name, const xmlChar *prefix,
+    const xmlChar *uri)
+{
+}
+
+static void
+_characters (void *ctx, const xmlChar *ch, int len)
+{
+}
+
+static void
+_document (void *ctx)
+{
+}
+
+static xmlEntityPtr
+_get_entity (void *ctx, const xmlChar *name)
+{
+  return xmlGetPredefinedEntity (name);
+}
+
+static xmlSAXHandler handler;
+
+static GString *
+_document_new (guint cues)
+{
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  g_string_append (str,
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\" "
+      "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">\n"
+      "<head>\n"
+      "<styling><style xml:id=\"s1\" tts:color=\"white\" "
+      "tts:fontSize=\"100%\"/></styling>\n"
+      "</head>\n"
+      "<body style=\"s1\"><div>\n");
+
+  for (i = 0; i < cues; i++) {
+    g_string_append_printf (str,
+        "<p begin=\"%02u:%02u:%02u.000\" end=\"%02u:%02u:%02u.900\">"
+        "Cue number %u<br/>second line &amp; more</p>\n",
+        i / 3600, i / 60 % 60, i % 60, i / 3600, i / 60 % 60, i % 60, i);
+  }
+
+  g_string_append (str, "</div></body>\n</tt>\n");
+  return str;
+}
+
+static void
+_parse_libxml (
+    const gchar *data, gsize len, gsize buffer_size, guint documents)
+{
+  xmlParserCtxtPtr parser;
+  guint i;
+
+  parser = xmlCreatePushParserCtxt (&handler, NULL, NULL, 0, NULL);
+  for (i = 0; i < documents; i++) {
+    gsize pos;
+
+    xmlCtxtResetPush (parser, NULL, 0, NULL, NULL);
+    for (pos = 0; pos < len; pos += buffer_size)
+      xmlParseChunk (parser, data + pos, MIN (buffer_size, len - pos), 0);
+    xmlParseChunk (parser, NULL, 0, 1);
+  }
+  xmlFreeParserCtxt (parser);
+}
+
+static void
+_parse_tokenizer (
+    const gchar *data, gsize len, gsize buffer_size, guint documents)
+{
+  GstTTMLTokenizer *tokenizer;
+  guint i;
+
+  tokenizer = gst_ttml_tokenizer_new (&handler, NULL);
+  for (i = 0; i < documents; i++) {
+    gsize pos;
+
+    gst_ttml_tokenizer_reset (tokenizer);
+    for (pos = 0; pos < len; pos += buffer_size)
+      gst_ttml_tokenizer_feed (
+          tokenizer, data + pos, MIN (buffer_size, len - pos));
+    gst_ttml_tokenizer_finish (tokenizer);
+  }
+  gst_ttml_tokenizer_free (tokenizer);
+}
+
+/* Wall time in us of the fastest run */
+static gint64
+_run (BenchParse parse, const GString *doc, const BenchScenario *s)
+{
+  gint64 best = G_MAXINT64;
+  gint i;
+
+  for (i = 0; i < opt_repeat; i++) {
+    gint64 wall = g_get_monotonic_time ();
+
+    parse (doc->str, doc->len, s->buffer_size, s->documents);
+    wall = g_get_monotonic_time () - wall;
+    best = MIN (best, wall);
+  }
+
+  return best;
+}
+
+static void
+_print_result (const BenchScenario *s, const gchar *parser, gsize bytes,
+    gint64 wall_time, gdouble speedup)
+{
+  static gboolean header_printed = FALSE;
+  gdouble seconds = wall_time / (gdouble) G_USEC_PER_SEC;
+
+  if (!g_strcmp0 (opt_format, "csv")) {
+    if (!header_printed) {
+      g_printf ("scenario,parser,documents,bytes,buffer_size,seconds,"
+                "speedup\n");
+      header_printed = TRUE;
+    }
+    g_printf ("%s,%s,%u,%" G_GSIZE_FORMAT ",%" G_GSIZE_FORMAT ",%.6f,%.3f\n",
+        s->name, parser, s->documents, bytes, s->buffer_size, seconds,
+        speedup);
+  } else {
+    g_printf ("{\"scenario\":\"%s\",\"parser\":\"%s\",\"documents\":%u,"
+              "\"bytes\":%" G_GSIZE_FORMAT ",\"buffer_size\":%" G_GSIZE_FORMAT
+              ",\"seconds\":%.6f,\"speedup\":%.3f}\n",
+        s->name, parser, s->documents, bytes, s->buffer_size, seconds,
+        speedup);
+  }
+}
+
+static void
+_scenario_run (const BenchScenario *s)
+{
+  GString *doc = _document_new (s->cues);
+  gint64 libxml, tokenizer;
+
+  libxml = _run (_parse_libxml, doc, s);
+  tokenizer = _run (_parse_tokenizer, doc, s);
+
+  _print_result (s, "libxml2", doc->len, libxml, 1.0);
+  _print_result (s, "tokenizer", doc->len, tokenizer,
+      tokenizer ? libxml / (gdouble) tokenizer : 0);
+
+  g_string_free (doc, TRUE);
+}
+
+static gboolean
+_scenario_selected (const gchar *name)
+{
+  gchar **it;
+
+  if (!opt_scenarios)
+    return TRUE;
+  for (it = opt_scenarios; *it; it++)
+    if (!strcmp (*it, name))
+      return TRUE;
+  return FALSE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  const BenchScenario *s;
+
+  ctx = g_option_context_new ("- TTML tokenizer benchmarks");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    g_error_free (err);
+    g_option_context_free (ctx);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_repeat < 1) {
+    g_printerr ("repeat must be positive\n");
+    return -1;
+  }
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  memset (&handler, 0, sizeof (handler));
+  handler.initialized = XML_SAX2_MAGIC;
+  handler.getEntity = _get_entity;
+  handler.startDocument = _document;
+  handler.endDocument = _document;
+  handler.startElementNs = _start_element;
+  handler.endElementNs = _end_element;
+  handler.characters = _characters;
+
+  for (s = scenarios; s->name; s++) {
+    if (_scenario_selected (s->name))
+      _scenario_run (s);
+  }
+
+  g_strfreev (opt_scenarios);
+  g_free (opt_format);
+
+  return 0;
+}
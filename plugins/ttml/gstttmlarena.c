@@ -0,0 +1,232 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstttmlarena.h"
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+/* Usable size of regular chunks. Bigger allocations get a chunk of their
+ * own. */
+#define GST_TTML_ARENA_CHUNK_SIZE (16 * 1024)
+#define GST_TTML_ARENA_LARGE_SIZE (GST_TTML_ARENA_CHUNK_SIZE / 8)
+
+/* Regular chunks kept for the next document when clearing the arena */
+#define GST_TTML_ARENA_KEEP_CHUNKS 8
+
+#define GST_TTML_ARENA_ROUND(size)                                            \
+  (((size) + GST_TTML_ARENA_ALIGN - 1) & ~(gsize) (GST_TTML_ARENA_ALIGN - 1))
+
+/* The data follows the header, which keeps it aligned for any type */
+struct _GstTTMLArenaChunk
+{
+  GstTTMLArenaChunk *next;
+  gsize size;
+};
+
+#define GST_TTML_ARENA_CHUNK_DATA(chunk) ((guint8 *) ((chunk) + 1))
+
+G_STATIC_ASSERT (sizeof (GstTTMLArenaChunk) % sizeof (gdouble) == 0);
+
+static GstTTMLArenaChunk *
+gst_ttml_arena_chunk_new (gsize size)
+{
+  GstTTMLArenaChunk *chunk = g_malloc (sizeof (GstTTMLArenaChunk) + size);
+
+  chunk->next = NULL;
+  chunk->size = size;
+  return chunk;
+}
+
+static void
+gst_ttml_arena_chunk_list_free (GstTTMLArenaChunk *chunk)
+{
+  while (chunk) {
+    GstTTMLArenaChunk *next = chunk->next;
+    g_free (chunk);
+    chunk = next;
+  }
+}
+
+/* Allocate zero-filled memory */
+gpointer
+gst_ttml_arena_alloc (GstTTMLArena *arena, gsize size)
+{
+  GstTTMLArenaChunk *chunk;
+  guint8 *mem;
+  guint cls;
+
+  if (!arena)
+    return g_malloc0 (size);
+
+  size = GST_TTML_ARENA_ROUND (MAX (size, 1));
+  cls = size / GST_TTML_ARENA_ALIGN - 1;
+  if (cls < GST_TTML_ARENA_CLASSES && arena->free_lists[cls]) {
+    mem = arena->free_lists[cls];
+    arena->free_lists[cls] = *(gpointer *) mem;
+    return memset (mem, 0, size);
+  }
+
+  if (size > GST_TTML_ARENA_LARGE_SIZE) {
+    chunk = gst_ttml_arena_chunk_new (size);
+    chunk->next = arena->large;
+    arena->large = chunk;
+    return memset (GST_TTML_ARENA_CHUNK_DATA (chunk), 0, size);
+  }
+
+  if (!arena->current || arena->offset + size > arena->current->size) {
+    if (arena->current && arena->current->next) {
+      /* Reuse a chunk kept by the last clear */
+      arena->current = arena->current->next;
+    } else {
+      chunk = gst_ttml_arena_chunk_new (GST_TTML_ARENA_CHUNK_SIZE);
+      if (arena->current)
+        arena->current->next = chunk;
+      else
+        arena->chunks = chunk;
+      arena->current = chunk;
+    }
+    arena->offset = 0;
+  }
+
+  mem = GST_TTML_ARENA_CHUNK_DATA (arena->current) + arena->offset;
+  arena->offset += size;
+  return memset (mem, 0, size);
+}
+
+/* Give back a block to the arena, for later allocations of the same size.
+ * 'size' can be smaller than the allocated size, but not bigger. Big blocks
+ * are only released by gst_ttml_arena_clear. */
+void
+gst_ttml_arena_free (GstTTMLArena *arena, gpointer mem, gsize size)
+{
+  guint cls;
+
+  if (!mem)
+    return;
+
+  if (!arena) {
+    g_free (mem);
+    return;
+  }
+
+  size = GST_TTML_ARENA_ROUND (MAX (size, 1));
+  cls = size / GST_TTML_ARENA_ALIGN - 1;
+  if (cls >= GST_TTML_ARENA_CLASSES)
+    return;
+
+  *(gpointer *) mem = arena->free_lists[cls];
+  arena->free_lists[cls] = mem;
+}
+
+gpointer
+gst_ttml_arena_memdup (GstTTMLArena *arena, gconstpointer mem, gsize size)
+{
+  gpointer copy;
+
+  if (!mem)
+    return NULL;
+
+  copy = arena ? gst_ttml_arena_alloc (arena, size) : g_malloc (size);
+  return memcpy (copy, mem, size);
+}
+
+gchar *
+gst_ttml_arena_strdup (GstTTMLArena *arena, const gchar *str)
+{
+  if (!str)
+    return NULL;
+
+  if (!arena)
+    return g_strdup (str);
+
+  return gst_ttml_arena_memdup (arena, str, strlen (str) + 1);
+}
+
+void
+gst_ttml_arena_strfree (GstTTMLArena *arena, gchar *str)
+{
+  if (str)
+    gst_ttml_arena_free (arena, str, strlen (str) + 1);
+}
+
+/* Same as g_list_prepend, with the link allocated from the arena */
+GList *
+gst_ttml_arena_list_prepend (GstTTMLArena *arena, GList *list, gpointer data)
+{
+  GList *link;
+
+  if (!arena)
+    return g_list_prepend (list, data);
+
+  link = gst_ttml_arena_alloc (arena, sizeof (GList));
+  link->data = data;
+  link->next = list;
+  if (list) {
+    link->prev = list->prev;
+    if (list->prev)
+      list->prev->next = link;
+    list->prev = link;
+  }
+  return link;
+}
+
+/* Same as g_list_delete_link, for lists built with the function above */
+GList *
+gst_ttml_arena_list_delete_link (GstTTMLArena *arena, GList *list, GList *link)
+{
+  if (!arena)
+    return g_list_delete_link (list, link);
+
+  if (link->prev)
+    link->prev->next = link->next;
+  if (link->next)
+    link->next->prev = link->prev;
+  if (link == list)
+    list = link->next;
+  gst_ttml_arena_free (arena, link, sizeof (GList));
+  return list;
+}
+
+/* Release all objects allocated from the arena at once. Part of the memory
+ * is kept to speed up allocations afterwards. */
+void
+gst_ttml_arena_clear (GstTTMLArena *arena)
+{
+  GstTTMLArenaChunk *last = arena->chunks;
+  guint kept = 1;
+
+  gst_ttml_arena_chunk_list_free (arena->large);
+  arena->large = NULL;
+
+  if (last) {
+    while (last->next && kept < GST_TTML_ARENA_KEEP_CHUNKS) {
+      last = last->next;
+      kept++;
+    }
+    gst_ttml_arena_chunk_list_free (last->next);
+    last->next = NULL;
+    GST_LOG ("Cleared arena, keeping %u chunks", kept);
+  }
+
+  arena->current = arena->chunks;
+  arena->offset = 0;
+  memset (arena->free_lists, 0, sizeof (arena->free_lists));
+}
+
+/* Release all objects and all the memory of the arena */
+void
+gst_ttml_arena_release (GstTTMLArena *arena)
+{
+  gst_ttml_arena_clear (arena);
+  gst_ttml_arena_chunk_list_free (arena->chunks);
+  arena->chunks = NULL;
+  arena->current = NULL;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_ARENA_H__
+#define __GST_TTML_ARENA_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+/* Allocations are rounded up to this, and freed blocks are kept in one free
+ * list per size, up to the number of classes */
+#define GST_TTML_ARENA_ALIGN 16
+#define GST_TTML_ARENA_CLASSES 32
+
+typedef struct _GstTTMLArenaChunk GstTTMLArenaChunk;
+
+/* Memory for the short-lived objects of a document. Allocating is mostly
+ * bumping a pointer, freed blocks are recycled for allocations of the same
+ * size, and everything is released at once by gst_ttml_arena_clear.
+ * Objects which must survive the arena have to be copied to the heap before
+ * that ("promoted").
+ * All functions accept a NULL arena, in which case the regular heap is used,
+ * so code can handle both kinds of objects alike.
+ * A zero-filled arena is a valid empty arena. It is not thread-safe. */
+struct _GstTTMLArena
+{
+  GstTTMLArenaChunk *chunks;
+  GstTTMLArenaChunk *current;
+  gsize offset;
+  GstTTMLArenaChunk *large;
+  gpointer free_lists[GST_TTML_ARENA_CLASSES];
+};
+
+gpointer gst_ttml_arena_alloc (GstTTMLArena *arena, gsize size);
+
+void gst_ttml_arena_free (GstTTMLArena *arena, gpointer mem, gsize size);
+
+gpointer gst_ttml_arena_memdup (
+    GstTTMLArena *arena, gconstpointer mem, gsize size);
+
+gchar *gst_ttml_arena_strdup (GstTTMLArena *arena, const gchar *str);
+
+void gst_ttml_arena_strfree (GstTTMLArena *arena, gchar *str);
+
+GList *gst_ttml_arena_list_prepend (
+    GstTTMLArena *arena, GList *list, gpointer data);
+
+GList *gst_ttml_arena_list_delete_link (
+    GstTTMLArena *arena, GList *list, GList *link);
+
+void gst_ttml_arena_clear (GstTTMLArena *arena);
+
+void gst_ttml_arena_release (GstTTMLArena *arena);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_ARENA_H__ */
@@ -7,93 +7,28 @@
 #include "config.h"
 #endif
 
-#include "locale.h"
-
 #include "gstttmlattribute.h"
+#include "gstttmlarena.h"
+#include "gstttmlexpression.h"
 #include "gstttmlstate.h"
 #include "gstttmlutils.h"
 #include <string.h>
-#include <stdio.h>
 #include <time.h>
 
 GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
 #define GST_CAT_DEFAULT ttmlbase_debug
 
-#define MAKE_COLOR(r, g, b, a) ((r) << 24 | (g) << 16 | (b) << 8 | (a))
-
-static struct _GstTTMLNamedColor
-{
-  const gchar *name;
-  guint32 color;
-} GstTTMLNamedColors[] = { { "transparent", 0x00000000 },
-  { "black", 0x000000ff }, { "silver", 0xc0c0c0ff }, { "gray", 0x808080ff },
-  { "white", 0xffffffff }, { "maroon", 0x800000ff }, { "red", 0xff0000ff },
-  { "purple", 0x800080ff }, { "fuchsia", 0xff00ffff },
-  { "magenta", 0xff00ffff }, { "green", 0x008000ff }, { "lime", 0x00ff00ff },
-  { "olive", 0x808000ff }, { "yellow", 0xffff00ff }, { "navy", 0x000080ff },
-  { "blue", 0x0000ffff }, { "teal", 0x008080ff }, { "aqua", 0x00ffffff },
-  { "cyan", 0x00ffffff }, { NULL, 0x00000000 } };
-
 /* Parse both types of time expressions as specified in the TTML specification,
  * be it in 00:00:00:00 or 00s forms */
 static GstClockTime
 gst_ttml_attribute_parse_time_expression (
     const GstTTMLState *state, const gchar *expr)
 {
-  gdouble h, m, s, count;
-  int f, subf;
-  char metric[3] = "\0\0";
-  GstClockTime res = GST_CLOCK_TIME_NONE;
-  char *previous_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
+  GstClockTime res = gst_ttml_expression_parse_time (state, expr);
 
-  setlocale (LC_NUMERIC, "C");
-  if (sscanf (expr, "%lf:%lf:%lf:%d.%d", &h, &m, &s, &f, &subf) == 5) {
-    res =
-        (GstClockTime) ((h * 3600 + m * 60 + s +
-                            (f + subf / (gdouble) state->sub_frame_rate) *
-                                state->frame_rate_den /
-                                (state->frame_rate * state->frame_rate_num)) *
-                        GST_SECOND);
-  } else if (sscanf (expr, "%lf:%lf:%lf:%d", &h, &m, &s, &f) == 4) {
-    res =
-        (GstClockTime) ((h * 3600 + m * 60 + s +
-                            f * state->frame_rate_den /
-                                (state->frame_rate * state->frame_rate_num)) *
-                        GST_SECOND);
-  } else if (sscanf (expr, "%lf:%lf:%lf", &h, &m, &s) == 3) {
-    res = (GstClockTime) ((h * 3600 + m * 60 + s) * GST_SECOND);
-  } else if (sscanf (expr, "%lf%2[hmstf]", &count, metric) == 2) {
-    double scale = 0;
-    switch (metric[0]) {
-      case 'h':
-        scale = 3600 * GST_SECOND;
-        break;
-      case 'm':
-        if (metric[1] == 's')
-          scale = GST_MSECOND;
-        else
-          scale = 60 * GST_SECOND;
-        break;
-      case 's':
-        scale = GST_SECOND;
-        break;
-      case 't':
-        scale = 1.0 / state->tick_rate;
-        break;
-      case 'f':
-        scale = GST_SECOND * state->frame_rate_den /
-                (state->frame_rate * state->frame_rate_num);
-        break;
-      default:
-        GST_WARNING ("Unknown metric %s", metric);
-        break;
-    }
-    res = (GstClockTime) (count * scale);
-  } else {
+  if (res == GST_CLOCK_TIME_NONE) {
     GST_WARNING ("Unrecognized time expression: %s", expr);
   }
-  setlocale (LC_NUMERIC, previous_locale);
-  g_free (previous_locale);
 
   if (state->time_base == GST_TTML_TIME_BASE_CLOCK) {
     GstClockTime tmp = res / GST_SECOND;
@@ -157,54 +92,15 @@ gst_ttml_attribute_parse_time_expression (
   return res;
 }
 
-/* Parse all color expressions as per the TTML specification:
-  : "#" rrggbb
-  | "#" rrggbbaa
-  | "rgb" "(" r-value "," g-value "," b-value ")"
-  | "rgba" "(" r-value "," g-value "," b-value "," a-value ")"
-  | <namedColor>
- */
+/* Reads two integers separated by white space. Returns FALSE if any of them
+ * is missing, in which case only the first one might have been written. */
 static gboolean
-gst_ttml_attribute_parse_color_expression (
-    const gchar *expr, guint32 *color, const gchar **end)
+gst_ttml_attribute_parse_int_pair (const gchar *expr, gint *a, gint *b)
 {
-  guint r, g, b, a;
-  int n = 0;
-  if (end)
-    *end = expr;
-  /* FIXME: This will read "#FF8040 2px p2x" as rgba(FF, 80, 40 2) */
-  if (sscanf (expr, "#%02x%02x%02x%02x%n", &r, &g, &b, &a, &n) == 4) {
-    *color = MAKE_COLOR (r, g, b, a);
-  } else if (sscanf (expr, "#%02x%02x%02x%n", &r, &g, &b, &n) == 3) {
-    *color = MAKE_COLOR (r, g, b, 0xFF);
-  } else if (sscanf (expr, "rgb(%d,%d,%d)%n", &r, &g, &b, &n) == 3) {
-    *color = MAKE_COLOR (r, g, b, 0xFF);
-  } else if (sscanf (expr, "rgba(%d,%d,%d,%d)%n", &r, &g, &b, &a, &n) == 4) {
-    *color = MAKE_COLOR (r, g, b, a);
-  } else {
-    struct _GstTTMLNamedColor *c = GstTTMLNamedColors;
-    while (c->name) {
-      if (!g_ascii_strncasecmp (expr, c->name, strlen (c->name))) {
-        *color = c->color;
-        n = strlen (c->name);
-        break;
-      }
-      c++;
-    }
-    if (!c->name) {
-      *color = 0xFFFFFFFF;
-      return FALSE;
-    }
-  }
-
-  /* Skip trailing whitespace */
-  if (end) {
-    while (expr[n] != '\0' && g_ascii_isspace (expr[n]))
-      n++;
-    *end = expr + n;
-  }
+  const gchar *end;
 
-  return TRUE;
+  return gst_ttml_expression_parse_int (expr, a, &end) &&
+         gst_ttml_expression_parse_int (end, b, NULL);
 }
 
 static gchar *
@@ -214,99 +110,6 @@ gst_ttml_attribute_dump_color_expression (guint32 color)
       (color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
 }
 
-/* Parse <length> expressions as per the TTML specification.
- * Returns TRUE on error.
-<length>
-  : scalar
-  | percentage
-scalar
-  : number units
-percentage
-  : number "%"
-units
-  : "px"
-  | "em"
-  | "c"
- */
-static gboolean
-gst_ttml_attribute_parse_length_expression (const gchar *expr, gfloat *value,
-    GstTTMLLengthUnit *unit, const gchar **end)
-{
-  int n;
-  gboolean error = FALSE;
-
-  *value = 1.f;
-  *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
-  if (end)
-    *end = expr;
-  n = 0;
-  if (sscanf (expr, "%f%n", value, &n)) {
-    if (n > 0 && expr[n - 1] == 'e') {
-      /* sscanf consumes the "e" in "2em" when reading floats. Undo it. */
-      n--;
-    }
-    if (end)
-      *end += n;
-    if (!g_ascii_strncasecmp (expr + n, "px", 2)) {
-      *unit = GST_TTML_LENGTH_UNIT_PIXELS;
-      if (end)
-        *end += 2;
-    } else if (!g_ascii_strncasecmp (expr + n, "em", 2)) {
-      *unit = GST_TTML_LENGTH_UNIT_EM;
-      if (end)
-        *end += 2;
-    } else if (!g_ascii_strncasecmp (expr + n, "c", 1)) {
-      *unit = GST_TTML_LENGTH_UNIT_CELLS;
-      if (end)
-        *end += 1;
-    } else if (!g_ascii_strncasecmp (expr + n, "%", 1)) {
-      *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
-      *value /= 100.0;
-      if (end)
-        *end += 1;
-    } else {
-      *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
-      error = TRUE;
-    }
-  } else {
-    error = TRUE;
-  }
-
-  if (error) {
-    GST_WARNING ("Could not understand length expression '%s', using %g (%s)",
-        expr, *value, gst_ttml_utils_enum_name (*unit, LengthUnit));
-  }
-  return error;
-}
-
-/* Reads a list of <length> expressions and returns the number of elements.
- * The UNIT of elements not read is set to NOT_PRESENT.
- */
-static gboolean
-gst_ttml_attribute_parse_lengths_list (
-    const gchar *expr, GstTTMLLength *length, int max_elements)
-{
-  const gchar *next;
-  int ndx = 0, i;
-  gboolean error;
-
-  do {
-    error = gst_ttml_attribute_parse_length_expression (
-        expr, &length[ndx].f, &length[ndx].unit, &next);
-    if (!error) {
-      expr = next;
-      ndx++;
-    }
-  } while (!error && *next != '\0' && ndx < max_elements);
-
-  /* Mark all other elements as NOT PRESENT */
-  for (i = ndx; i < max_elements; i++) {
-    length[i].unit = GST_TTML_LENGTH_UNIT_NOT_PRESENT;
-  }
-
-  return ndx;
-}
-
 /* Turns as many relative units as possible into absolute pixel units.
  * Either state or style_override can be NULL. Not both. */
 static void
@@ -398,15 +201,7 @@ gst_ttml_attribute_normalize_length (const GstTTMLState *state,
 gchar *
 gst_ttml_attribute_dump_time_expression (GstClockTime time)
 {
-  gchar *ret;
-  char *previous_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
-
-  setlocale (LC_NUMERIC, "C");
-  ret = g_strdup_printf ("%" GST_TIME_FORMAT, GST_TIME_ARGS (time));
-  setlocale (LC_NUMERIC, previous_locale);
-  g_free (previous_locale);
-
-  return ret;
+  return g_strdup_printf ("%" GST_TIME_FORMAT, GST_TIME_ARGS (time));
 }
 
 gfloat
@@ -430,34 +225,46 @@ gst_ttml_attribute_is_length_present (const GstTTMLAttribute *attr, int index)
          GST_TTML_LENGTH_UNIT_NOT_PRESENT;
 }
 
+/* Convert an attribute name into an attribute type.
+ * Returns GST_TTML_ATTR_UNKNOWN for non-TTML namespaces. */
+GstTTMLAttributeType
+gst_ttml_attribute_type_parse (const char *ns, const char *name)
+{
+  if (!gst_ttml_utils_namespace_is_ttml (ns)) {
+    GST_WARNING ("Ignoring non-TTML namespace in attribute %s:%s", ns, name);
+    return GST_TTML_ATTR_UNKNOWN;
+  }
+
+  return gst_ttml_utils_enum_parse (name, AttributeType);
+}
+
 /* Read a name-value pair of strings and produce a new GstTTMLattribute.
- * Returns NULL if the attribute was unknown, and uses g_new to allocate
- * the new attribute. */
+ * Returns NULL if the attribute was unknown. The new attribute is allocated
+ * from the arena of the state, so it is only valid for the current
+ * document. */
 GstTTMLAttribute *
 gst_ttml_attribute_parse (
     GstTTMLState *state, const char *ns, const char *name, const char *value)
 {
-  GstTTMLAttribute *attr = NULL;
-  GstTTMLAttributeType type;
-  char *previous_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
-
-  if (!gst_ttml_utils_namespace_is_ttml (ns)) {
-    GST_WARNING (
-        "Ignoring non-TTML namespace in attribute %s:%s=%s", ns, name, value);
-    g_free (previous_locale);
-    return NULL;
-  }
+  return gst_ttml_attribute_parse_typed (
+      state, gst_ttml_attribute_type_parse (ns, name), name, value);
+}
 
-  setlocale (LC_NUMERIC, "C");
+/* Same as gst_ttml_attribute_parse(), for an attribute whose type was
+ * already parsed from 'name' */
+GstTTMLAttribute *
+gst_ttml_attribute_parse_typed (GstTTMLState *state,
+    GstTTMLAttributeType type, const char *name, const char *value)
+{
+  GstTTMLAttribute *attr = NULL;
 
   GST_LOG ("Parsing attribute %s=%s", name, value);
-  type = gst_ttml_utils_enum_parse (name, AttributeType);
   if (type == GST_TTML_ATTR_UNKNOWN) {
     GST_DEBUG ("  Skipping unknown attribute: %s=%s", name, value);
     goto beach;
   }
 
-  attr = gst_ttml_attribute_new ();
+  attr = gst_ttml_attribute_new (&state->arena);
   attr->type = type;
   attr->timeline = NULL;
 
@@ -477,8 +284,8 @@ gst_ttml_attribute_parse (
       GST_LOG ("Parsed '%s' frameRate into %g", value, attr->value.d);
       break;
     case GST_TTML_ATTR_FRAME_RATE_MULTIPLIER:
-      if (sscanf (value, "%d %d", &attr->value.fraction.num,
-              &attr->value.fraction.den) != 2) {
+      if (!gst_ttml_attribute_parse_int_pair (value,
+              &attr->value.fraction.num, &attr->value.fraction.den)) {
         GST_WARNING ("Could not understand '%s' frameRateMultiplier", value);
       }
       GST_LOG ("Parsed '%s' frameRateMultiplier into num=%d den=%d", value,
@@ -518,8 +325,8 @@ gst_ttml_attribute_parse (
           gst_ttml_utils_enum_name (attr->value.clock_mode, ClockMode));
       break;
     case GST_TTML_ATTR_PIXEL_ASPECT_RATIO:
-      if (sscanf (value, "%d %d", &attr->value.fraction.num,
-              &attr->value.fraction.den) != 2) {
+      if (!gst_ttml_attribute_parse_int_pair (value,
+              &attr->value.fraction.num, &attr->value.fraction.den)) {
         GST_WARNING ("Could not understand '%s' pixelAspectRatio", value);
       }
       GST_LOG ("Parsed '%s' pixelAspectRatio into num=%d den=%d", value,
@@ -528,7 +335,7 @@ gst_ttml_attribute_parse (
     case GST_TTML_ATTR_COLOR:
     case GST_TTML_ATTR_BACKGROUND_COLOR:
     case GST_TTML_ATTR_BACKGROUND_REGION_COLOR:
-      if (!gst_ttml_attribute_parse_color_expression (
+      if (!gst_ttml_expression_parse_color (
               value, &attr->value.color, NULL))
         GST_WARNING ("Could not understand color expression '%s'", value);
       GST_LOG ("Parsed '%s' color into #%08X", value, attr->value.color);
@@ -538,11 +345,13 @@ gst_ttml_attribute_parse (
       GST_LOG ("Parsed '%s' display into display=%d", value, attr->value.b);
       break;
     case GST_TTML_ATTR_FONT_FAMILY:
-      attr->value.string = g_strstrip (g_strdup (value));
+      attr->value.string =
+          g_strstrip (gst_ttml_arena_strdup (attr->arena, value));
       GST_LOG ("Parsed '%s' font family", value);
       break;
     case GST_TTML_ATTR_FONT_SIZE:
-      gst_ttml_attribute_parse_lengths_list (value, attr->value.raw_length, 2);
+      gst_ttml_expression_parse_lengths_list (
+          value, attr->value.raw_length, 2);
       gst_ttml_attribute_normalize_length (
           state, NULL, attr->type, &attr->value.raw_length[0], 0);
       gst_ttml_attribute_normalize_length (
@@ -585,15 +394,18 @@ gst_ttml_attribute_parse (
               attr->value.text_decoration, TextDecoration));
       break;
     case GST_TTML_ATTR_ID:
-      attr->value.string = g_strstrip (g_strdup (value));
+      attr->value.string =
+          g_strstrip (gst_ttml_arena_strdup (attr->arena, value));
       GST_LOG ("Parsed '%s' id", value);
       break;
     case GST_TTML_ATTR_STYLE:
-      attr->value.string = g_strstrip (g_strdup (value));
+      attr->value.string =
+          g_strstrip (gst_ttml_arena_strdup (attr->arena, value));
       GST_LOG ("Parsed '%s' style", value);
       break;
     case GST_TTML_ATTR_REGION:
-      attr->value.string = g_strstrip (g_strdup (value));
+      attr->value.string =
+          g_strstrip (gst_ttml_arena_strdup (attr->arena, value));
       GST_LOG ("Parsed '%s' region", value);
       break;
     case GST_TTML_ATTR_ORIGIN:
@@ -604,7 +416,7 @@ gst_ttml_attribute_parse (
         attr->value.raw_length[1].f = 0.f;
         attr->value.raw_length[1].unit = GST_TTML_LENGTH_UNIT_RELATIVE;
       } else {
-        gst_ttml_attribute_parse_lengths_list (
+        gst_ttml_expression_parse_lengths_list (
             value, attr->value.raw_length, 2);
         if (attr->value.raw_length[1].unit ==
             GST_TTML_LENGTH_UNIT_NOT_PRESENT) {
@@ -630,7 +442,7 @@ gst_ttml_attribute_parse (
         attr->value.raw_length[1].f = 1.f;
         attr->value.raw_length[1].unit = GST_TTML_LENGTH_UNIT_RELATIVE;
       } else {
-        gst_ttml_attribute_parse_lengths_list (
+        gst_ttml_expression_parse_lengths_list (
             value, attr->value.raw_length, 2);
         if (attr->value.raw_length[1].unit ==
             GST_TTML_LENGTH_UNIT_NOT_PRESENT) {
@@ -677,7 +489,7 @@ gst_ttml_attribute_parse (
       break;
     case GST_TTML_ATTR_CELLRESOLUTION: {
       int numx = 32, numy = 15;
-      if (sscanf (value, "%d %d", &numx, &numy) != 2) {
+      if (!gst_ttml_attribute_parse_int_pair (value, &numx, &numy)) {
         GST_WARNING ("Could not understand '%s' cellResolution", value);
       }
       attr->value.raw_length[0].f = numx;
@@ -693,10 +505,10 @@ gst_ttml_attribute_parse (
             GST_TTML_LENGTH_UNIT_NOT_PRESENT;
       } else {
         const gchar *ptr;
-        gst_ttml_attribute_parse_color_expression (
+        gst_ttml_expression_parse_color (
             value, &attr->value.text_outline.color, &ptr);
         attr->value.text_outline.use_current_color = (ptr == value);
-        gst_ttml_attribute_parse_lengths_list (
+        gst_ttml_expression_parse_lengths_list (
             ptr, attr->value.text_outline.length, 2);
         /* Relative measures are relative to the block progression direction */
         gst_ttml_attribute_normalize_length (
@@ -732,7 +544,7 @@ gst_ttml_attribute_parse (
         attr->value.raw_length[0].f = 0.f;
         attr->value.raw_length[0].unit = GST_TTML_LENGTH_UNIT_NOT_PRESENT;
       } else {
-        gst_ttml_attribute_parse_length_expression (value,
+        gst_ttml_expression_parse_length (value,
             &attr->value.raw_length[0].f, &attr->value.raw_length[0].unit,
             NULL);
       }
@@ -758,7 +570,7 @@ gst_ttml_attribute_parse (
       static const int padding_map[4][3] = { { 0, 0, 0 }, { 1, 0, 1 },
         { 1, 2, 1 }, { 1, 2, 3 } };
 
-      num_elements = gst_ttml_attribute_parse_lengths_list (
+      num_elements = gst_ttml_expression_parse_lengths_list (
           value, attr->value.raw_length, 4);
       if (num_elements > 0) {
         for (i = 3; i > 0; i--) {
@@ -873,7 +685,8 @@ gst_ttml_attribute_parse (
         attr->value.string = NULL;
         GST_LOG ("Parsed '%s' background image to NOTHING", value);
       } else {
-        attr->value.string = g_strstrip (g_strdup (value));
+        attr->value.string =
+            g_strstrip (gst_ttml_arena_strdup (attr->arena, value));
         GST_LOG ("Parsed '%s' background image", value);
       }
       break;
@@ -892,7 +705,7 @@ gst_ttml_attribute_parse (
                  gst_ttml_utils_attr_value_is (value, "bottom")) {
         attr->value.raw_length[0].f = 1.f;
       } else {
-        gst_ttml_attribute_parse_length_expression (value,
+        gst_ttml_expression_parse_length (value,
             &attr->value.raw_length[0].f, &attr->value.raw_length[0].unit,
             NULL);
       }
@@ -909,34 +722,26 @@ gst_ttml_attribute_parse (
       GST_WARNING ("Attribute not implemented parsing: %s=%s", name, value);
       /* We should never reach here, anyway, dispose of the useless attribute
        */
-      g_free (attr);
+      gst_ttml_attribute_free (attr);
       attr = NULL;
       goto beach;
   }
 
   if (!attr->value.string) {
     GST_LOG ("No string assigned, assigning original string");
-    attr->value.string = g_strdup (value);
+    attr->value.string = gst_ttml_arena_strdup (attr->arena, value);
   }
 
 beach:
-  setlocale (LC_NUMERIC, previous_locale);
-  g_free (previous_locale);
-
   return attr;
 }
 
 static gchar *
 gst_ttml_attribute_dump_double_expression (gdouble d)
 {
-  gchar *ret;
-  char *previous_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
+  gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
 
-  setlocale (LC_NUMERIC, "C");
-  ret = g_strdup_printf ("%lf", d);
-  setlocale (LC_NUMERIC, previous_locale);
-  g_free (previous_locale);
-  return ret;
+  return g_strdup (g_ascii_formatd (buffer, sizeof (buffer), "%f", d));
 }
 
 gchar *
@@ -1052,7 +857,7 @@ gst_ttml_attribute_dump (GstTTMLAttribute *attr)
         ret = g_strdup ("hidden");
       break;
     case GST_TTML_ATTR_OPACITY:
-      ret = g_strdup_printf ("%lf", attr->value.d);
+      ret = gst_ttml_attribute_dump_double_expression (attr->value.d);
       break;
     case GST_TTML_ATTR_UNICODE_BIDI:
       break;
@@ -1086,68 +891,88 @@ gst_ttml_attribute_dump (GstTTMLAttribute *attr)
 void
 gst_ttml_attribute_free (GstTTMLAttribute *attr)
 {
+  GstTTMLArena *arena;
+
   if (!attr)
     return;
 
-  g_free (attr->value.string);
+  arena = attr->arena;
+  gst_ttml_arena_strfree (arena, attr->value.string);
 
-  if (attr->timeline) {
-    g_list_free_full (
-        attr->timeline, (GDestroyNotify) gst_ttml_attribute_event_free);
+  while (attr->timeline) {
+    GstTTMLAttributeEvent *attr_event = attr->timeline->data;
+    gst_ttml_attribute_free (attr_event->attr);
+    gst_ttml_arena_free (arena, attr_event, sizeof (GstTTMLAttributeEvent));
+    attr->timeline = gst_ttml_arena_list_delete_link (
+        arena, attr->timeline, attr->timeline);
   }
-  g_free (attr);
+  gst_ttml_arena_free (arena, attr, sizeof (GstTTMLAttribute));
 }
 
-/* Deallocates a GstTTMLAttributeEvent */
-void
-gst_ttml_attribute_event_free (GstTTMLAttributeEvent *attr_event)
-{
-  gst_ttml_attribute_free (attr_event->attr);
-  g_free (attr_event);
-}
-
-/* Create a copy of an attribute */
+/* Create a copy of an attribute, allocated from the given arena (which can
+ * be NULL to use the heap) */
 GstTTMLAttribute *
-gst_ttml_attribute_copy (
-    const GstTTMLAttribute *src, gboolean include_timeline)
+gst_ttml_attribute_copy (GstTTMLArena *arena, const GstTTMLAttribute *src,
+    gboolean include_timeline)
 {
-  GstTTMLAttribute *dest = gst_ttml_attribute_new ();
+  GstTTMLAttribute *dest = gst_ttml_attribute_new (arena);
   dest->type = src->type;
   memcpy (&dest->value, &src->value, sizeof (dest->value));
   if (src->value.string)
-    dest->value.string = g_strdup (src->value.string);
+    dest->value.string = gst_ttml_arena_strdup (arena, src->value.string);
 
   if (src->timeline && include_timeline) {
     /* Copy the timeline too */
-    GList *link = dest->timeline = g_list_copy (src->timeline);
-    while (link) {
+    GList *link;
+    for (link = src->timeline; link; link = link->next) {
       GstTTMLAttributeEvent *src_event = (GstTTMLAttributeEvent *) link->data;
-      GstTTMLAttributeEvent *dst_event = g_new (GstTTMLAttributeEvent, 1);
+      GstTTMLAttributeEvent *dst_event =
+          gst_ttml_arena_alloc (arena, sizeof (GstTTMLAttributeEvent));
       dst_event->timestamp = src_event->timestamp;
-      dst_event->attr = gst_ttml_attribute_copy (src_event->attr, FALSE);
-      link->data = dst_event;
-      link = link->next;
+      dst_event->attr =
+          gst_ttml_attribute_copy (arena, src_event->attr, FALSE);
+      dest->timeline =
+          gst_ttml_arena_list_prepend (arena, dest->timeline, dst_event);
     }
+    dest->timeline = g_list_reverse (dest->timeline);
   } else {
     dest->timeline = NULL;
   }
   return dest;
 }
 
-/* Create a new attribute. */
+/* Create a heap copy of an attribute allocated from an arena, so it outlives
+ * it, and free the original. Heap attributes are returned unchanged. */
 GstTTMLAttribute *
-gst_ttml_attribute_new ()
+gst_ttml_attribute_promote (GstTTMLAttribute *attr)
 {
-  GstTTMLAttribute *attr = g_new0 (GstTTMLAttribute, 1);
+  GstTTMLAttribute *promoted;
+
+  if (!attr || !attr->arena)
+    return attr;
+
+  promoted = gst_ttml_attribute_copy (NULL, attr, TRUE);
+  gst_ttml_attribute_free (attr);
+  return promoted;
+}
+
+/* Create a new attribute, allocated from the given arena, or from the heap
+ * if it is NULL. */
+GstTTMLAttribute *
+gst_ttml_attribute_new (GstTTMLArena *arena)
+{
+  GstTTMLAttribute *attr =
+      gst_ttml_arena_alloc (arena, sizeof (GstTTMLAttribute));
+  attr->arena = arena;
   return attr;
 }
 
 /* Create a new "node_type" attribute. Typically, attribute types are created
  * in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_node (GstTTMLNodeType node_type)
+gst_ttml_attribute_new_node (GstTTMLArena *arena, GstTTMLNodeType node_type)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = GST_TTML_ATTR_NODE_TYPE;
   attr->timeline = NULL;
   attr->value.node_type = node_type;
@@ -1157,9 +982,10 @@ gst_ttml_attribute_new_node (GstTTMLNodeType node_type)
 /* Create a new boolean attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_boolean (GstTTMLAttributeType type, gboolean b)
+gst_ttml_attribute_new_boolean (
+    GstTTMLArena *arena, GstTTMLAttributeType type, gboolean b)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
   attr->value.b = b;
@@ -1169,9 +995,10 @@ gst_ttml_attribute_new_boolean (GstTTMLAttributeType type, gboolean b)
 /* Create a new int attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_int (GstTTMLAttributeType type, gint i)
+gst_ttml_attribute_new_int (
+    GstTTMLArena *arena, GstTTMLAttributeType type, gint i)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
   attr->value.i = i;
@@ -1181,9 +1008,10 @@ gst_ttml_attribute_new_int (GstTTMLAttributeType type, gint i)
 /* Create a new time attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_time (GstTTMLAttributeType type, GstClockTime time)
+gst_ttml_attribute_new_time (
+    GstTTMLArena *arena, GstTTMLAttributeType type, GstClockTime time)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
   attr->value.time = time;
@@ -1193,21 +1021,23 @@ gst_ttml_attribute_new_time (GstTTMLAttributeType type, GstClockTime time)
 /* Create a new string attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_string (GstTTMLAttributeType type, const gchar *str)
+gst_ttml_attribute_new_string (
+    GstTTMLArena *arena, GstTTMLAttributeType type, const gchar *str)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
-  attr->value.string = g_strdup (str);
+  attr->value.string = gst_ttml_arena_strdup (arena, str);
   return attr;
 }
 
 /* Create a new gdouble attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_double (GstTTMLAttributeType type, gdouble d)
+gst_ttml_attribute_new_double (
+    GstTTMLArena *arena, GstTTMLAttributeType type, gdouble d)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
   attr->value.d = d;
@@ -1217,9 +1047,10 @@ gst_ttml_attribute_new_double (GstTTMLAttributeType type, gdouble d)
 /* Create a new fraction attribute. Typically, attributes are
  * created in the _attribute_parse() method above. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_fraction (GstTTMLAttributeType type, gint num, gint den)
+gst_ttml_attribute_new_fraction (
+    GstTTMLArena *arena, GstTTMLAttributeType type, gint num, gint den)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = type;
   attr->timeline = NULL;
   attr->value.fraction.num = num;
@@ -1230,15 +1061,59 @@ gst_ttml_attribute_new_fraction (GstTTMLAttributeType type, gint num, gint den)
 /* Create a new style removal attribute, used to push attrs which have no
  * previous value. */
 GstTTMLAttribute *
-gst_ttml_attribute_new_style_removal (GstTTMLAttributeType removed_style)
+gst_ttml_attribute_new_style_removal (
+    GstTTMLArena *arena, GstTTMLAttributeType removed_style)
 {
-  GstTTMLAttribute *attr = gst_ttml_attribute_new ();
+  GstTTMLAttribute *attr = gst_ttml_attribute_new (arena);
   attr->type = GST_TTML_ATTR_STYLE_REMOVAL;
   attr->timeline = NULL;
   attr->value.removed_attribute_type = removed_style;
   return attr;
 }
 
+/* Size of the non-string part of the attribute values, which starts at the
+ * anonymous union. Attributes are zero-filled when created, so bytes unused
+ * by the current member are always zero and can be compared and hashed. */
+#define GST_TTML_ATTRIBUTE_VALUE_OFFSET                                       \
+  G_STRUCT_OFFSET (struct _GstTTMLAttributeValue, node_type)
+#define GST_TTML_ATTRIBUTE_VALUE_SIZE                                         \
+  (sizeof (struct _GstTTMLAttributeValue) - GST_TTML_ATTRIBUTE_VALUE_OFFSET)
+
+/* Whether both attributes have the same type and value. Their timelines are
+ * not taken into account. */
+gboolean
+gst_ttml_attribute_equal (
+    const GstTTMLAttribute *a, const GstTTMLAttribute *b)
+{
+  if (a == b)
+    return TRUE;
+
+  return a->type == b->type && !g_strcmp0 (a->value.string, b->value.string) &&
+         !memcmp ((const guint8 *) &a->value + GST_TTML_ATTRIBUTE_VALUE_OFFSET,
+             (const guint8 *) &b->value + GST_TTML_ATTRIBUTE_VALUE_OFFSET,
+             GST_TTML_ATTRIBUTE_VALUE_SIZE);
+}
+
+/* Hash of the type and value of the attribute, consistent with
+ * gst_ttml_attribute_equal */
+guint
+gst_ttml_attribute_hash (const GstTTMLAttribute *attr)
+{
+  const guint8 *data =
+      (const guint8 *) &attr->value + GST_TTML_ATTRIBUTE_VALUE_OFFSET;
+  guint hash = 2166136261u ^ attr->type;
+  gsize i;
+
+  /* FNV-1a */
+  for (i = 0; i < GST_TTML_ATTRIBUTE_VALUE_SIZE; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+
+  if (attr->value.string)
+    hash ^= g_str_hash (attr->value.string);
+
+  return hash;
+}
+
 /* Comparison function for attribute types */
 gint
 gst_ttml_attribute_compare_type_func (
@@ -1256,14 +1131,16 @@ gst_ttml_attribute_event_compare (
 }
 
 /* Create a new event containing the src_attr and add it to the timeline of
- * dst_attr */
+ * dst_attr. Only used for the attributes of styles, which live on the
+ * heap. */
 void
 gst_ttml_attribute_add_event (GstTTMLAttribute *dst_attr,
     GstClockTime timestamp, GstTTMLAttribute *src_attr)
 {
   GstTTMLAttributeEvent *event = g_new (GstTTMLAttributeEvent, 1);
+  g_assert (dst_attr->arena == NULL);
   event->timestamp = timestamp;
-  event->attr = gst_ttml_attribute_copy (src_attr, FALSE);
+  event->attr = gst_ttml_attribute_copy (NULL, src_attr, FALSE);
   dst_attr->timeline = g_list_insert_sorted (dst_attr->timeline, event,
       (GCompareFunc) gst_ttml_attribute_event_compare);
   GST_DEBUG ("Added attribute event to %s at %" GST_TIME_FORMAT,
@@ -67,6 +67,7 @@ struct _GstTTMLAttribute
     };
   } value;
   GList *timeline;
+  GstTTMLArena *arena; /* Where it was allocated from, NULL for the heap */
 };
 
 struct _GstTTMLAttributeEvent
@@ -77,41 +78,46 @@ struct _GstTTMLAttributeEvent
 
 GstTTMLAttribute *gst_ttml_attribute_parse (
     GstTTMLState *state, const char *ns, const char *name, const char *value);
+GstTTMLAttributeType gst_ttml_attribute_type_parse (
+    const char *ns, const char *name);
+GstTTMLAttribute *gst_ttml_attribute_parse_typed (GstTTMLState *state,
+    GstTTMLAttributeType type, const char *name, const char *value);
 gchar *gst_ttml_attribute_dump (GstTTMLAttribute *attr);
 
 gchar *gst_ttml_attribute_dump_time_expression (GstClockTime time);
 
 void gst_ttml_attribute_free (GstTTMLAttribute *attr);
 
-void gst_ttml_attribute_event_free (GstTTMLAttributeEvent *attr_event);
-
-GstTTMLAttribute *gst_ttml_attribute_copy (
+GstTTMLAttribute *gst_ttml_attribute_copy (GstTTMLArena *arena,
     const GstTTMLAttribute *src, gboolean include_timeline);
 
-GstTTMLAttribute *gst_ttml_attribute_new ();
+GstTTMLAttribute *gst_ttml_attribute_promote (GstTTMLAttribute *attr);
+
+GstTTMLAttribute *gst_ttml_attribute_new (GstTTMLArena *arena);
 
-GstTTMLAttribute *gst_ttml_attribute_new_node (GstTTMLNodeType node_type);
+GstTTMLAttribute *gst_ttml_attribute_new_node (
+    GstTTMLArena *arena, GstTTMLNodeType node_type);
 
 GstTTMLAttribute *gst_ttml_attribute_new_boolean (
-    GstTTMLAttributeType type, gboolean b);
+    GstTTMLArena *arena, GstTTMLAttributeType type, gboolean b);
 
 GstTTMLAttribute *gst_ttml_attribute_new_int (
-    GstTTMLAttributeType type, gint i);
+    GstTTMLArena *arena, GstTTMLAttributeType type, gint i);
 
 GstTTMLAttribute *gst_ttml_attribute_new_time (
-    GstTTMLAttributeType type, GstClockTime time);
+    GstTTMLArena *arena, GstTTMLAttributeType type, GstClockTime time);
 
 GstTTMLAttribute *gst_ttml_attribute_new_string (
-    GstTTMLAttributeType type, const gchar *str);
+    GstTTMLArena *arena, GstTTMLAttributeType type, const gchar *str);
 
 GstTTMLAttribute *gst_ttml_attribute_new_double (
-    GstTTMLAttributeType type, gdouble d);
+    GstTTMLArena *arena, GstTTMLAttributeType type, gdouble d);
 
 GstTTMLAttribute *gst_ttml_attribute_new_fraction (
-    GstTTMLAttributeType type, gint num, gint den);
+    GstTTMLArena *arena, GstTTMLAttributeType type, gint num, gint den);
 
 GstTTMLAttribute *gst_ttml_attribute_new_style_removal (
-    GstTTMLAttributeType removed_style);
+    GstTTMLArena *arena, GstTTMLAttributeType removed_style);
 
 gfloat gst_ttml_attribute_get_normalized_length (const GstTTMLState *state,
     const GstTTMLStyle *style_override, const GstTTMLAttribute *attr,
@@ -120,6 +126,11 @@ gfloat gst_ttml_attribute_get_normalized_length (const GstTTMLState *state,
 gboolean gst_ttml_attribute_is_length_present (
     const GstTTMLAttribute *attr, int index);
 
+gboolean gst_ttml_attribute_equal (
+    const GstTTMLAttribute *a, const GstTTMLAttribute *b);
+
+guint gst_ttml_attribute_hash (const GstTTMLAttribute *attr);
+
 gint gst_ttml_attribute_compare_type_func (
     GstTTMLAttribute *attr, GstTTMLAttributeType type);
 
@@ -10,29 +10,39 @@
 #include <string.h>
 
 #include <libxml/parser.h>
+#include <libxml/dict.h>
 #include <gst/gstconfig.h>
 
 #include "gstttmlbase.h"
+#include "gstttmlarena.h"
+#include "gstttmlcache.h"
 #include "gstttmlstate.h"
 #include "gstttmltype.h"
 #include "gstttmlspan.h"
 #include "gstttmlevent.h"
+#include "gstttmltimeline.h"
 #include "gstttmlattribute.h"
 #include "gstttmlutils.h"
 #include "gstttmlnamespace.h"
+#include "gstttmlsaxlog.h"
+#include "gstttmltokenizer.h"
 
 GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
 #define GST_CAT_DEFAULT ttmlbase_debug
 #define TTML_DEBUG_XML_INPUT 0
 
-/* We dynamically allocate and reallocate a buffer for sax chars accumulation,
- * minimizing reallocations.
- * This is the minimum free size in the buffer before we reallocate more */
-#define TTML_SAX_BUFFER_MIN_FREE_SIZE 0x10
-#define TTML_SAX_BUFFER_GROW_SIZE 0x400
+/* In live mode, how late a text span can arrive */
+#define DEFAULT_MAX_LOOKAHEAD (500 * GST_MSECOND)
 
-/* check for white space as required for TTML & UTF-8 */
-#define is_whitespace(c) ((guchar) (c) <= 0x20)
+/* Documents are parsed in the streaming thread by default */
+#define DEFAULT_PARSE_THREADS 1
+
+/* Complete documents a buffer must hold to parse them in worker threads */
+#define PARSE_POOL_MIN_DOCUMENTS 2
+
+/* Names the dictionary of the parser can hold before the parser is created
+ * again. TTML documents use a few dozen. */
+#define PARSER_DICT_MAX_SIZE 4096
 
 static GstElementClass *parent_class = NULL;
 
@@ -40,6 +50,11 @@ enum
 {
   PROP_0,
   PROP_ASSUME_ORDERED_SPANS,
+  PROP_LIVE,
+  PROP_MAX_LOOKAHEAD,
+  PROP_OUTPUT_QUEUE_SIZE,
+  PROP_PARSE_THREADS,
+  PROP_BUILTIN_TOKENIZER,
 };
 
 static GstStaticPadTemplate ttmlbase_sink_template = GST_STATIC_PAD_TEMPLATE (
@@ -89,6 +104,135 @@ static gboolean gst_ttmlbase_downstream_negotiation (GstTTMLBase *base);
 static void gst_ttmlbase_sax_characters (
     void *ctx, const xmlChar *ch, int len);
 
+/* Drop the queued output. Called with the output lock. */
+static void
+gst_ttmlbase_output_drop_queued (GstTTMLBase *base)
+{
+  GstMiniObject *item;
+
+  while ((item = g_queue_pop_head (&base->output_queue)))
+    gst_mini_object_unref (item);
+}
+
+/* Make the queue refuse (and drop) the output, and wake up anybody waiting
+ * on it, or make it work again */
+static void
+gst_ttmlbase_output_set_flushing (GstTTMLBase *base, gboolean flushing)
+{
+  g_mutex_lock (&base->output_lock);
+  base->output_flushing = flushing;
+  if (flushing)
+    gst_ttmlbase_output_drop_queued (base);
+  else
+    base->output_status = GST_FLOW_OK;
+  g_cond_broadcast (&base->output_cond);
+  g_mutex_unlock (&base->output_lock);
+}
+
+/* Stop the src pad task, either the output or the cached timeline one. It
+ * is stopped and not just paused, because starting a task which already
+ * exists keeps its function, and the next one might be the other. */
+static void
+gst_ttmlbase_output_pause (GstTTMLBase *base)
+{
+  gst_ttmlbase_output_set_flushing (base, TRUE);
+  gst_pad_stop_task (base->srcpad);
+  base->output_started = FALSE;
+}
+
+/* The src pad task, which pushes the queued output downstream */
+static void
+gst_ttmlbase_output_loop (GstTTMLBase *base)
+{
+  GstMiniObject *item;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&base->output_lock);
+  while (!base->output_flushing && g_queue_is_empty (&base->output_queue))
+    g_cond_wait (&base->output_cond, &base->output_lock);
+  if (base->output_flushing) {
+    g_mutex_unlock (&base->output_lock);
+    GST_DEBUG_OBJECT (base, "Pausing output task");
+    gst_pad_pause_task (base->srcpad);
+    return;
+  }
+  item = g_queue_pop_head (&base->output_queue);
+  g_cond_broadcast (&base->output_cond);
+  g_mutex_unlock (&base->output_lock);
+
+  if (GST_IS_BUFFER (item)) {
+    ret = gst_pad_push (base->srcpad, GST_BUFFER_CAST (item));
+  } else {
+    gst_pad_push_event (base->srcpad, GST_EVENT_CAST (item));
+  }
+
+  if (ret != GST_FLOW_OK) {
+    /* Reported upstream by the next chain call */
+    GST_DEBUG_OBJECT (
+        base, "Downstream returned %s", gst_flow_get_name (ret));
+    g_mutex_lock (&base->output_lock);
+    base->output_status = ret;
+    g_mutex_unlock (&base->output_lock);
+  }
+}
+
+/* Whether the output goes through the queue. Once upstream is over, the
+ * cached timeline can be played by the src pad task instead, and it pushes
+ * directly. */
+static gboolean
+gst_ttmlbase_output_is_queued (GstTTMLBase *base)
+{
+  return base->output_queue_size && !base->upstream_eos;
+}
+
+/* Queue a buffer or a serialized event for the src pad task, waiting while
+ * the queue is full. Returns the result of the last push made by the task,
+ * since that is what upstream has to know about. */
+static GstFlowReturn
+gst_ttmlbase_output_enqueue (GstTTMLBase *base, GstMiniObject *item)
+{
+  GstFlowReturn ret;
+
+  g_mutex_lock (&base->output_lock);
+  if (!base->output_started && !base->output_flushing) {
+    base->output_started = gst_pad_start_task (base->srcpad,
+        (GstTaskFunction) gst_ttmlbase_output_loop, base, NULL);
+  }
+  while (!base->output_flushing &&
+         g_queue_get_length (&base->output_queue) >= base->output_queue_size)
+    g_cond_wait (&base->output_cond, &base->output_lock);
+  if (base->output_flushing) {
+    gst_mini_object_unref (item);
+    ret = GST_FLOW_FLUSHING;
+  } else {
+    g_queue_push_tail (&base->output_queue, item);
+    g_cond_broadcast (&base->output_cond);
+    ret = base->output_status;
+  }
+  g_mutex_unlock (&base->output_lock);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_ttmlbase_push_buffer (GstTTMLBase *base, GstBuffer *buffer)
+{
+  if (gst_ttmlbase_output_is_queued (base))
+    return gst_ttmlbase_output_enqueue (base, GST_MINI_OBJECT_CAST (buffer));
+
+  return gst_pad_push (base->srcpad, buffer);
+}
+
+static gboolean
+gst_ttmlbase_push_event (GstTTMLBase *base, GstEvent *event)
+{
+  if (GST_EVENT_IS_SERIALIZED (event) && gst_ttmlbase_output_is_queued (base))
+    return gst_ttmlbase_output_enqueue (base, GST_MINI_OBJECT_CAST (event)) ==
+           GST_FLOW_OK;
+
+  return gst_pad_push_event (base->srcpad, event);
+}
+
 /* Generate and Pad push a buffer, using the correct timestamps and clipping */
 static void
 gst_ttmlbase_gen_buffer (
@@ -173,7 +317,7 @@ gst_ttmlbase_gen_buffer (
           GST_TIME_ARGS (base->segment->start),
           GST_TIME_ARGS (base->segment->stop),
           GST_TIME_ARGS (base->segment->time));
-      gst_pad_push_event (base->srcpad, event);
+      gst_ttmlbase_push_event (base, event);
       base->newsegment_needed = FALSE;
     }
 
@@ -188,7 +332,7 @@ gst_ttmlbase_gen_buffer (
         GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)));
     GST_TTML_UTILS_MEMDUMP_BUFFER_OBJECT (base, "Content:", buffer);
 
-    base->current_gst_status = gst_pad_push (base->srcpad, buffer);
+    base->current_gst_status = gst_ttmlbase_push_buffer (base, buffer);
     base->last_out_time = clip_stop;
   } else {
     GST_DEBUG_OBJECT (base,
@@ -198,11 +342,11 @@ gst_ttmlbase_gen_buffer (
 }
 
 /* Execute the given event */
-GList *
-gst_ttmlbase_parse_event (
-    GstTTMLEvent *event, GstTTMLBase *base, GList *timeline)
+void
+gst_ttmlbase_parse_event (GstTTMLEvent *event, GstTTMLBase *base)
 {
-  GList *output_timeline = timeline;
+  if (base->cache_recording)
+    gst_ttml_cache_add_event (base->cache, event);
 
   switch (event->type) {
     case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
@@ -223,13 +367,10 @@ gst_ttmlbase_parse_event (
           event->data.attr_update.id, event->data.attr_update.attr);
       break;
     case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      /* This moves the attributes of the style to the hash of regions, so
+       * they are not freed with the event below */
       gst_ttml_state_new_region (&base->state, event->data.region_begin.id,
           &event->data.region_begin.style);
-      /* Remove the style from the event, so that when we free the event below
-       * the style does not get freed too (it belongs to the hash of regions
-       * now)
-       */
-      event->data.region_begin.style.attributes = NULL;
       break;
     case GST_TTML_EVENT_TYPE_REGION_END:
       gst_ttml_state_remove_region (&base->state, event->data.region_end.id);
@@ -243,7 +384,6 @@ gst_ttmlbase_parse_event (
       break;
   }
   gst_ttml_event_free (event);
-  return output_timeline;
 }
 
 /* Allocate a new span to hold new characters, and insert into the timeline
@@ -254,14 +394,13 @@ gst_ttmlbase_parse_event (
 static void
 gst_ttmlbase_add_span (GstTTMLBase *base, gboolean newline)
 {
-  const gchar *content_end = NULL;
   GstTTMLSpan *span;
   GstTTMLEvent *event;
   guint id;
   GstTTMLBuffer *buf = &base->buffer;
 
-  /* validate UTF-8 content. Should we care? */
-  if (!g_utf8_validate (buf->data, buf->len, &content_end)) {
+  /* validate UTF-8 content, as it was accumulated. Should we care? */
+  if (!gst_ttml_buffer_is_valid (buf)) {
     GST_WARNING_OBJECT (base, "Content is not valid UTF-8");
     goto beach;
   }
@@ -306,33 +445,39 @@ gst_ttmlbase_add_span (GstTTMLBase *base, gboolean newline)
   /* If assuming ordered spans, as soon as our begin is later than the
    * latest event in the timeline, we can flush the timeline */
   if (base->assume_ordered_spans && base->state.begin > base->last_out_time) {
-    base->timeline = gst_ttml_event_list_flush (base->timeline,
-        (GstTTMLEventParseFunc) gst_ttmlbase_parse_event,
-        (GstTTMLEventGenBufferFunc) gst_ttmlbase_gen_buffer, base);
+    gst_ttml_timeline_flush (&base->timeline,
+        (GstTTMLTimelineParseFunc) gst_ttmlbase_parse_event,
+        (GstTTMLTimelineGenBufferFunc) gst_ttmlbase_gen_buffer, base);
   }
 
   /* Create a new span to hold these characters, with an ever-increasing
    * ID number. */
   id = base->state.last_span_id++;
-  span = gst_ttml_span_new (id, buf->len, buf->data, &base->state.style);
+  span = gst_ttml_span_new (
+      &base->state.arena, id, buf->len, buf->data, &base->state.style);
   if (!span) {
     GST_DEBUG ("Empty span. Dropping.");
     goto beach;
   }
 
+  if (GST_CLOCK_TIME_IS_VALID (base->state.begin) &&
+      (!GST_CLOCK_TIME_IS_VALID (base->newest_begin) ||
+          base->state.begin > base->newest_begin))
+    base->newest_begin = base->state.begin;
+
   /* Insert BEGIN and END events in the timeline, with the same ID */
-  event = gst_ttml_event_new_span_begin (&base->state, span);
-  base->timeline = gst_ttml_event_list_insert (base->timeline, event);
+  event =
+      gst_ttml_event_new_span_begin (&base->state.arena, &base->state, span);
+  gst_ttml_timeline_insert (&base->timeline, event);
 
-  event = gst_ttml_event_new_span_end (&base->state, id);
-  base->timeline = gst_ttml_event_list_insert (base->timeline, event);
+  event = gst_ttml_event_new_span_end (&base->state.arena, &base->state, id);
+  gst_ttml_timeline_insert (&base->timeline, event);
 
-  base->timeline =
-      gst_ttml_style_gen_span_events (id, &base->state.style, base->timeline);
+  gst_ttml_style_gen_span_events (id, &base->state.style, &base->timeline);
 
 beach:
   /* empty the accumulator buffer */
-  buf->len = 0;
+  gst_ttml_buffer_clear (buf);
   buf->preserve_whitespace = base->state.whitespace_preserve;
 }
 
@@ -357,22 +502,23 @@ gst_ttmlbase_add_region (GstTTMLBase *base)
      * index. See gst_ttml_attribute_parse() for GST_TTML_ATTR_ZINDEX. This
      * forces lexical order of rendering on overlapping regions without
      * explicit zIndex. */
-    attr = gst_ttml_attribute_new_int (
+    attr = gst_ttml_attribute_new_int (&base->state.arena,
         GST_TTML_ATTR_ZINDEX, base->state.last_zindex_micro);
     base->state.last_zindex_micro++;
     gst_ttml_state_push_attribute (&base->state, attr);
   }
 
   /* Insert BEGIN and END events in the timeline */
-  event = gst_ttml_event_new_region_begin (
+  event = gst_ttml_event_new_region_begin (&base->state.arena,
       base->state.begin, base->state.id, &base->state.style);
-  base->timeline = gst_ttml_event_list_insert (base->timeline, event);
+  gst_ttml_timeline_insert (&base->timeline, event);
 
-  event = gst_ttml_event_new_region_end (base->state.end, base->state.id);
-  base->timeline = gst_ttml_event_list_insert (base->timeline, event);
+  event = gst_ttml_event_new_region_end (
+      &base->state.arena, base->state.end, base->state.id);
+  gst_ttml_timeline_insert (&base->timeline, event);
 
-  base->timeline = gst_ttml_style_gen_region_events (
-      base->state.id, &base->state.style, base->timeline);
+  gst_ttml_style_gen_region_events (
+      base->state.id, &base->state.style, &base->timeline);
 
   /* We keep the attr pointer, but its content does not belong to us, there
    * is no harm in overwritting it here. */
@@ -380,17 +526,16 @@ gst_ttmlbase_add_region (GstTTMLBase *base)
   gst_ttml_attribute_free (attr);
 }
 
-/* Base64-decodes the now complete embedded data and adds it to the hash of
- * saved data, using the current ID. Data still needs to be PNG-decoded if
+/* Adds the now complete embedded data, already base64-decoded, to the hash
+ * of saved data, using the current ID. Data still needs to be PNG-decoded if
  * it is an image. */
 static void
-gst_ttmlbase_decode_data (GstTTMLBase *base)
+gst_ttmlbase_store_data (GstTTMLBase *base)
 {
-  GstTTMLBuffer *buf = &base->buffer;
+  GstTTMLBase64 *b64 = &base->image;
   GstTTMLAttribute *attr;
-  gsize decoded_length;
 
-  if (!buf->len) {
+  if (!b64->len) {
     GST_WARNING_OBJECT (base, "Found empty data node. Ignoring.");
     goto beach;
   }
@@ -419,20 +564,93 @@ gst_ttmlbase_decode_data (GstTTMLBase *base)
     goto beach;
   }
 
-  /* Add terminator, for glib's base64 decoder. Our allocator ensures there's
-   * space for it, no need to reallocate */
-  buf->data[buf->len] = '\0';
-
-  /* Decode */
-  g_base64_decode_inplace ((gchar *) buf->data, &decoded_length);
-
-  /* Store */
+  /* Store, the data was decoded while it was parsed */
   gst_ttml_state_save_data (
-      &base->state, (guint8 *) buf->data, decoded_length, base->state.id);
-  goto beach;
+      &base->state, gst_ttml_base64_steal (b64), base->state.id);
 
 beach:
-  buf->len = 0;
+  gst_ttml_base64_clear (b64);
+}
+
+/* Namespace to hand to the node type and attribute parsers: NULL if the URI
+ * is a TTML one, which they take as the default namespace, so each URI is
+ * only classified once per document */
+static const gchar *
+gst_ttmlbase_resolve_namespace (GstTTMLBase *base, const xmlChar *uri)
+{
+  GstTTMLBaseNamespaceCache *entry = base->namespace_cache;
+  GstTTMLBaseNamespaceCache *last =
+      entry + GST_TTMLBASE_NAMESPACE_CACHE_SIZE - 1;
+
+  if (!uri)
+    return NULL;
+
+  while (entry->uri && entry->uri != uri && entry < last)
+    entry++;
+  if (entry->uri != uri) {
+    /* Not seen yet. When the cache is full, the last entry is replaced. */
+    entry->uri = uri;
+    entry->is_ttml = gst_ttml_utils_namespace_is_ttml ((const gchar *) uri);
+  }
+
+  return entry->is_ttml ? NULL : (const gchar *) uri;
+}
+
+static GstTTMLBaseNameCache *
+gst_ttmlbase_name_cache_lookup (
+    GstTTMLBaseNameCache *cache, const xmlChar *name, const xmlChar *uri)
+{
+  gsize key = GPOINTER_TO_SIZE (name) ^ GPOINTER_TO_SIZE (uri);
+
+  return &cache[(key ^ (key >> 7)) & (GST_TTMLBASE_NAME_CACHE_SIZE - 1)];
+}
+
+/* Node type of an element. Each name is only classified once for as long
+ * as the parser keeps its dictionary. */
+static GstTTMLNodeType
+gst_ttmlbase_node_type (GstTTMLBase *base, const xmlChar *name,
+    const xmlChar *prefix, const xmlChar *uri)
+{
+  GstTTMLBaseNameCache *entry;
+
+  uri = !prefix ? NULL : uri;
+  entry = gst_ttmlbase_name_cache_lookup (base->node_cache, name, uri);
+  if (entry->name != name || entry->uri != uri) {
+    entry->name = name;
+    entry->uri = uri;
+    entry->type = gst_ttml_utils_node_type_parse (
+        gst_ttmlbase_resolve_namespace (base, uri), (const gchar *) name);
+  }
+
+  return (GstTTMLNodeType) entry->type;
+}
+
+/* Same as gst_ttmlbase_node_type(), for attributes */
+static GstTTMLAttributeType
+gst_ttmlbase_attribute_type (GstTTMLBase *base, const xmlChar *name,
+    const xmlChar *prefix, const xmlChar *uri)
+{
+  GstTTMLBaseNameCache *entry;
+
+  uri = !prefix ? NULL : uri;
+  entry = gst_ttmlbase_name_cache_lookup (base->attribute_cache, name, uri);
+  if (entry->name != name || entry->uri != uri) {
+    entry->name = name;
+    entry->uri = uri;
+    entry->type = gst_ttml_attribute_type_parse (
+        gst_ttmlbase_resolve_namespace (base, uri), (const gchar *) name);
+  }
+
+  return (GstTTMLAttributeType) entry->type;
+}
+
+/* The names in the caches belong to a dictionary which is going away */
+static void
+gst_ttmlbase_names_forget (GstTTMLBase *base)
+{
+  memset (base->namespace_cache, 0, sizeof (base->namespace_cache));
+  memset (base->node_cache, 0, sizeof (base->node_cache));
+  memset (base->attribute_cache, 0, sizeof (base->attribute_cache));
 }
 
 /* Helper method to turn SAX2's gchar * attribute array into a GstTTMLAttribute
@@ -441,15 +659,23 @@ static void
 gst_ttmlbase_push_attr (
     GstTTMLBase *base, const gchar **xml_attr, gboolean *dur_attr_found)
 {
-  /* Create a local copy of the attr value, since SAX2 does not
-   * NULL-terminate the string */
-  gsize value_len = xml_attr[4] - xml_attr[3];
-  gchar *value = (gchar *) alloca (value_len + 1);
+  const gchar *value = xml_attr[3];
   GstTTMLAttribute *ttml_attr;
-  memcpy (value, xml_attr[3], value_len);
-  value[value_len] = '\0';
-  ttml_attr = gst_ttml_attribute_parse (
-      &base->state, !xml_attr[1] ? NULL : xml_attr[2], xml_attr[0], value);
+
+  /* Create a local copy of the attr value, since libxml's SAX2 does not
+   * NULL-terminate the string. The built-in tokenizer does. */
+  if (*xml_attr[4] != '\0') {
+    gsize value_len = xml_attr[4] - xml_attr[3];
+    gchar *copy = (gchar *) alloca (value_len + 1);
+
+    memcpy (copy, xml_attr[3], value_len);
+    copy[value_len] = '\0';
+    value = copy;
+  }
+  ttml_attr = gst_ttml_attribute_parse_typed (&base->state,
+      gst_ttmlbase_attribute_type (base, (const xmlChar *) xml_attr[0],
+          (const xmlChar *) xml_attr[1], (const xmlChar *) xml_attr[2]),
+      xml_attr[0], value);
   if (ttml_attr) {
     if (ttml_attr->type == GST_TTML_ATTR_DUR)
       *dur_attr_found = TRUE;
@@ -457,6 +683,98 @@ gst_ttmlbase_push_attr (
   }
 }
 
+/* Forget about the head of the document being parsed */
+static void
+gst_ttmlbase_head_drop_pending (GstTTMLBase *base)
+{
+  base->timeline.capture = NULL;
+  gst_ttml_head_cache_free (base->head_pending);
+  base->head_pending = NULL;
+  base->head_state = GST_TTMLBASE_HEAD_NONE;
+}
+
+/* Called before creating a parser for the document starting at 'data'.
+ * Returns how many bytes to feed to the parser before the rest of the
+ * document, which starts at 'resume'. If the document repeats the head of
+ * the previous one, the head is left out and its stored results will be
+ * applied instead. Otherwise, the results of parsing it are stored. */
+static gsize
+gst_ttmlbase_head_prepare (
+    GstTTMLBase *base, const gchar *data, gsize len, gsize *resume)
+{
+  gsize head_start, head_end;
+
+  gst_ttmlbase_head_drop_pending (base);
+  base->head_depth = 0;
+  *resume = len;
+
+  if (!gst_ttml_head_cache_find_head (data, len, &head_start, &head_end))
+    return len;
+
+  if (base->head_cache &&
+      gst_ttml_head_cache_matches (base->head_cache, data, len)) {
+    GST_DEBUG_OBJECT (base, "Document repeats the previous head, skipping "
+                            "%" G_GSIZE_FORMAT " bytes",
+        head_end - head_start);
+    base->head_state = GST_TTMLBASE_HEAD_REPLAY_PENDING;
+    *resume = head_end;
+    return head_start;
+  }
+
+  base->head_pending = gst_ttml_head_cache_new (data, head_start, head_end);
+  base->head_state = GST_TTMLBASE_HEAD_CAPTURE_PENDING;
+  return len;
+}
+
+/* Track the head while elements are opened. The head is known to be the
+ * first child of the root element. */
+static void
+gst_ttmlbase_head_element_start (GstTTMLBase *base)
+{
+  if (base->head_depth++ != 1)
+    return;
+
+  switch (base->head_state) {
+    case GST_TTMLBASE_HEAD_CAPTURE_PENDING:
+      base->timeline.capture = base->head_pending->events;
+      base->head_state = GST_TTMLBASE_HEAD_CAPTURING;
+      break;
+    case GST_TTMLBASE_HEAD_REPLAY_PENDING:
+      gst_ttml_head_cache_apply (
+          base->head_cache, &base->state, &base->timeline);
+      base->head_state = GST_TTMLBASE_HEAD_NONE;
+      break;
+    default:
+      break;
+  }
+}
+
+/* Track the head while elements are closed */
+static void
+gst_ttmlbase_head_element_end (GstTTMLBase *base)
+{
+  if (base->head_state == GST_TTMLBASE_HEAD_NONE || !base->head_depth)
+    return;
+
+  base->head_depth--;
+  if (base->head_depth == 1 &&
+      base->head_state == GST_TTMLBASE_HEAD_CAPTURING) {
+    /* All the children of the head have been processed */
+    gst_ttml_head_cache_store (base->head_pending, &base->state);
+    gst_ttml_head_cache_free (base->head_cache);
+    base->head_cache = base->head_pending;
+    base->head_pending = NULL;
+    base->timeline.capture = NULL;
+    base->head_state = GST_TTMLBASE_HEAD_NONE;
+  } else if (base->head_depth == 0) {
+    /* The root element had no other children */
+    if (base->head_state == GST_TTMLBASE_HEAD_REPLAY_PENDING)
+      gst_ttml_head_cache_apply (
+          base->head_cache, &base->state, &base->timeline);
+    gst_ttmlbase_head_drop_pending (base);
+  }
+}
+
 /* Process a node start. Just push all its attributes onto the stack. */
 static void
 gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
@@ -475,15 +793,17 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
   GST_LOG_OBJECT (base, "New element: %s prefix:%s URI:%s", name,
       prefix ? (char *) prefix : "NULL", URI ? (char *) URI : "NULL");
 
-  node_type = gst_ttml_utils_node_type_parse (
-      !prefix ? NULL : (const gchar *) URI, (const gchar *) name);
+  if (base->head_state != GST_TTMLBASE_HEAD_NONE)
+    gst_ttmlbase_head_element_start (base);
+
+  node_type = gst_ttmlbase_node_type (base, name, prefix, URI);
   GST_DEBUG ("Parsed name '%s' into node type %s", name,
       gst_ttml_utils_enum_name (node_type, NodeType));
   /* Special actions for some node types */
   switch (node_type) {
     case GST_TTML_NODE_TYPE_P:
       base->buffer.enable = TRUE;
-      base->buffer.len = 0;
+      gst_ttml_buffer_clear (&base->buffer);
       base->buffer.preserve_whitespace = base->state.whitespace_preserve;
       base->buffer.insert_space = TRUE;
       base->buffer.line_has_chars = FALSE;
@@ -491,7 +811,7 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
     case GST_TTML_NODE_TYPE_SPAN:
       gst_ttmlbase_add_span (base, FALSE);
       base->buffer.enable = TRUE;
-      base->buffer.len = 0;
+      gst_ttml_buffer_clear (&base->buffer);
       base->buffer.preserve_whitespace = base->state.whitespace_preserve;
       base->buffer.insert_space = TRUE;
       break;
@@ -500,10 +820,8 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
         GST_WARNING_OBJECT (base,
             "Image node is invalid outside of metadata node. Parsing anyway.");
       }
-      base->buffer.enable = TRUE;
-      base->buffer.len = 0;
-      base->buffer.preserve_whitespace = FALSE;
-      base->buffer.insert_space = FALSE;
+      gst_ttml_base64_clear (&base->image);
+      base->image.enable = TRUE;
       break;
     case GST_TTML_NODE_TYPE_TT: {
       /* store namespaces and initialize default values depending on
@@ -552,12 +870,12 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
   if (node_type != GST_TTML_NODE_TYPE_STYLE || !base->in_layout_node) {
     /* Push onto the stack the node type, which will serve as delimiter when
      * popping attributes. */
-    ttml_attr = gst_ttml_attribute_new_node (node_type);
+    ttml_attr = gst_ttml_attribute_new_node (&base->state.arena, node_type);
     gst_ttml_state_push_attribute (&base->state, ttml_attr);
     /* If this node did not specify the time_container attribute, set it
      * manually to "parallel", as this is not inherited. */
     ttml_attr = gst_ttml_attribute_new_boolean (
-        GST_TTML_ATTR_SEQUENTIAL_TIME_CONTAINER, FALSE);
+        &base->state.arena, GST_TTML_ATTR_SEQUENTIAL_TIME_CONTAINER, FALSE);
     gst_ttml_state_push_attribute (&base->state, ttml_attr);
     /* Manually push a 0 BEGIN attribute when in sequential mode.
      * If the node defines it, its value will overwrite this one.
@@ -565,7 +883,8 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
      * the node does not define a BEGIN time, since it is taken into account in
      * the _merge_attribute method. */
     if (is_container_seq) {
-      ttml_attr = gst_ttml_attribute_new_time (GST_TTML_ATTR_BEGIN, 0);
+      ttml_attr = gst_ttml_attribute_new_time (
+          &base->state.arena, GST_TTML_ATTR_BEGIN, 0);
       gst_ttml_state_push_attribute (&base->state, ttml_attr);
     }
   } else {
@@ -596,7 +915,8 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
    * sequential mode. In this case this node must be ignored and this seemed
    * like the simplest way. */
   if (is_container_seq && !dur_attr_found) {
-    ttml_attr = gst_ttml_attribute_new_time (GST_TTML_ATTR_DUR, 0);
+    ttml_attr = gst_ttml_attribute_new_time (
+        &base->state.arena, GST_TTML_ATTR_DUR, 0);
     gst_ttml_state_push_attribute (&base->state, ttml_attr);
   }
 
@@ -605,12 +925,36 @@ gst_ttmlbase_sax2_element_start_ns (void *ctx, const xmlChar *name,
   base->state.container_begin = base->state.begin;
   base->state.container_end = base->state.end;
 
+  /* The text of paragraphs and spans reaches the timeline when they are
+   * closed. Nested ones cannot begin earlier than their parents. */
+  if (node_type == GST_TTML_NODE_TYPE_P ||
+      node_type == GST_TTML_NODE_TYPE_SPAN) {
+    base->open_level++;
+    if (!GST_CLOCK_TIME_IS_VALID (base->open_begin) &&
+        GST_CLOCK_TIME_IS_VALID (base->state.begin)) {
+      base->open_begin = base->state.begin;
+      base->open_begin_level = base->open_level;
+    }
+  }
+
   /* Handle special node types which have effect as soon as they are found */
   if (node_type == GST_TTML_NODE_TYPE_BR) {
     gst_ttmlbase_add_span (base, TRUE);
   }
 }
 
+/* A paragraph or span has been closed, its text is in the timeline */
+static void
+gst_ttmlbase_close_text_element (GstTTMLBase *base)
+{
+  if (!base->open_level)
+    return;
+
+  if (base->open_level == base->open_begin_level)
+    base->open_begin = GST_CLOCK_TIME_NONE;
+  base->open_level--;
+}
+
 /* Process a node end. Just pop previous state from the stack. */
 static void
 gst_ttmlbase_sax2_element_end_ns (
@@ -624,8 +968,9 @@ gst_ttmlbase_sax2_element_end_ns (
   GstTTMLNodeType current_node_type;
 
   GST_LOG_OBJECT (base, "End element: %s", name);
-  current_node_type = gst_ttml_utils_node_type_parse (
-      !prefix ? NULL : (const gchar *) URI, (const gchar *) name);
+  gst_ttmlbase_head_element_end (base);
+
+  current_node_type = gst_ttmlbase_node_type (base, name, prefix, URI);
 
   if (current_node_type == GST_TTML_NODE_TYPE_STYLE && base->in_layout_node) {
     /* We are closing a style node inside a layout. Its attributes are to be
@@ -640,13 +985,15 @@ gst_ttmlbase_sax2_element_end_ns (
     case GST_TTML_NODE_TYPE_P:
       gst_ttmlbase_add_span (base, TRUE);
       base->buffer.enable = FALSE;
+      gst_ttmlbase_close_text_element (base);
       break;
     case GST_TTML_NODE_TYPE_SPAN:
       gst_ttmlbase_add_span (base, FALSE);
+      gst_ttmlbase_close_text_element (base);
       break;
     case GST_TTML_NODE_TYPE_SMPTE_IMAGE:
-      gst_ttmlbase_decode_data (base);
-      base->buffer.enable = FALSE;
+      gst_ttmlbase_store_data (base);
+      base->image.enable = FALSE;
       break;
     case GST_TTML_NODE_TYPE_STYLING:
       if (!base->in_styling_node) {
@@ -698,10 +1045,9 @@ gst_ttmlbase_sax2_element_end_ns (
       /* We are changing an attr which has not been defined yet */
       if (!attr) {
         /* FIXME: This can be certainly improved */
-        attr = g_new0 (GstTTMLAttribute, 1);
+        attr = gst_ttml_attribute_new (NULL);
         attr->type = type;
-        base->state.style.attributes =
-            g_list_append (base->state.style.attributes, attr);
+        gst_ttml_style_take_attr (&base->state.style, attr);
       }
       gst_ttml_attribute_add_event (attr, current_begin, prev_attr);
       gst_ttml_attribute_add_event (attr, current_end - 1, attr);
@@ -733,49 +1079,18 @@ static void
 gst_ttmlbase_sax_characters (void *ctx, const xmlChar *ch, int len)
 {
   GstTTMLBase *base = GST_TTMLBASE (ctx);
-  GstTTMLBuffer *buf = &base->buffer;
-  gsize tlen;
 
-  if (!base->buffer.enable)
+  if (base->image.enable) {
+    /* decode as they come, the encoded text is not kept */
+    gst_ttml_base64_append (&base->image, (const gchar *) ch, len);
     return;
-
-  /* allocate or reallocate buffer if needed */
-  tlen = buf->len + len;
-  if (tlen + TTML_SAX_BUFFER_MIN_FREE_SIZE >= buf->size) {
-    gsize size = tlen + TTML_SAX_BUFFER_GROW_SIZE;
-    if (!buf->size) {
-      buf->data = g_malloc (size);
-    } else {
-      buf->data = g_realloc (buf->data, size);
-    }
-    buf->size = size;
   }
 
+  if (!base->buffer.enable)
+    return;
+
   /* accumulate characters in buffer */
-  if (buf->preserve_whitespace) {
-    memcpy (buf->data + buf->len, ch, len);
-    buf->len = tlen;
-  } else {
-    const gchar *src = (const gchar *) ch;
-    gchar *dst = buf->data + buf->len;
-    const gchar *end = src + len;
-    gchar c;
-
-    while (src < end) {
-      c = *src++;
-      if (is_whitespace (c)) {
-        buf->collapsing = TRUE;
-      } else {
-        if (buf->collapsing && buf->line_has_chars && buf->insert_space) {
-          *dst++ = ' ';
-        }
-        *dst++ = c;
-        buf->collapsing = FALSE;
-        buf->line_has_chars = TRUE;
-      }
-    }
-    buf->len = dst - buf->data;
-  }
+  gst_ttml_buffer_append (&base->buffer, (const gchar *) ch, len);
 }
 
 /* Parse SAX warnings (simply shown as debug logs) */
@@ -829,7 +1144,20 @@ gst_ttmlbase_sax_document_start (void *ctx)
 
   base->in_styling_node = FALSE;
   base->in_layout_node = FALSE;
+  /* Resetting the state clears its arena: the events not flushed yet and the
+   * active spans of the previous document must survive it */
+  gst_ttml_timeline_promote (&base->timeline);
+  gst_ttml_span_list_promote (base->active_spans);
   gst_ttml_state_reset (&base->state);
+
+  /* Only a stream made of a single, untimed, document can be played again
+   * from the cache */
+  gst_ttml_cache_free (base->cache);
+  base->cache = NULL;
+  base->cache_recording = base->documents_since_flush++ == 0 &&
+                          !GST_CLOCK_TIME_IS_VALID (base->input_buf_stop);
+  if (base->cache_recording)
+    base->cache = gst_ttml_cache_new ();
 }
 
 static void
@@ -838,9 +1166,24 @@ gst_ttmlbase_sax_document_end (void *ctx)
   GstTTMLBase *base = GST_TTMLBASE (ctx);
   GST_LOG_OBJECT (GST_TTMLBASE (ctx), "Document complete");
 
-  base->timeline = gst_ttml_event_list_flush (base->timeline,
-      (GstTTMLEventParseFunc) gst_ttmlbase_parse_event,
-      (GstTTMLEventGenBufferFunc) gst_ttmlbase_gen_buffer, base);
+  gst_ttml_timeline_flush (&base->timeline,
+      (GstTTMLTimelineParseFunc) gst_ttmlbase_parse_event,
+      (GstTTMLTimelineGenBufferFunc) gst_ttmlbase_gen_buffer, base);
+
+  if (base->cache_recording) {
+    gchar *uri = gst_ttmlbase_uri_get (base->sinkpad);
+
+    base->cache_recording = FALSE;
+    if (uri) {
+      gst_ttml_cache_complete (
+          base->cache, uri, &base->state, base->namespaces);
+      g_free (uri);
+    } else {
+      GST_DEBUG_OBJECT (base, "Unknown document URI, not caching it");
+      gst_ttml_cache_free (base->cache);
+      base->cache = NULL;
+    }
+  }
 }
 
 static xmlSAXHandler gst_ttmlbase_sax_handler = {
@@ -878,23 +1221,129 @@ static xmlSAXHandler gst_ttmlbase_sax_handler = {
   /* .xmlStructuredError = */ NULL
 };
 
-/* Free any parsing-related information held by the element */
+/* Dictionary with the names of the TTML vocabulary, shared by the parsers
+ * of all elements, so these names always come with the same pointers. It
+ * is never modified once created, which makes it safe to look names up in
+ * it from any thread. */
 static void
-gst_ttmlbase_reset (GstTTMLBase *base)
+gst_ttmlbase_dict_add (const gchar *name, xmlDictPtr dict)
 {
-  GstTTMLBaseClass *klass = GST_TTMLBASE_GET_CLASS (base);
+  xmlDictLookup (dict, (const xmlChar *) name, -1);
+}
 
-  GST_DEBUG_OBJECT (base, "Resetting parsing information");
+static xmlDictPtr
+gst_ttmlbase_dict_get (void)
+{
+  static gsize dict = 0;
+
+  if (g_once_init_enter (&dict)) {
+    xmlDictPtr vocabulary = xmlDictCreate ();
+
+    gst_ttml_utils_enum_foreach_name (
+        NodeType, (GFunc) gst_ttmlbase_dict_add, vocabulary);
+    gst_ttml_utils_enum_foreach_name (
+        AttributeType, (GFunc) gst_ttmlbase_dict_add, vocabulary);
+    xmlDictLookup (vocabulary, (const xmlChar *) "xml", -1);
+    xmlDictLookup (vocabulary, (const xmlChar *) "xmlns", -1);
+    xmlDictLookup (vocabulary, XML_XML_NAMESPACE, -1);
+    g_once_init_leave (&dict, (gsize) vocabulary);
+  }
+
+  return (xmlDictPtr) dict;
+}
+
+/* Create the XML parser of the element. It is reset for every document,
+ * and its dictionary stacked on top of the shared one. */
+static gboolean
+gst_ttmlbase_parser_new (GstTTMLBase *base)
+{
+  xmlParserCtxtPtr parser;
+  xmlDictPtr dict;
+
+  parser =
+      xmlCreatePushParserCtxt (&gst_ttmlbase_sax_handler, base, NULL, 0, NULL);
+  if (!parser)
+    return FALSE;
+
+  dict = xmlDictCreateSub (gst_ttmlbase_dict_get ());
+  if (dict) {
+    /* The context keeps pointers to some strings of its dictionary */
+    xmlDictFree (parser->dict);
+    parser->dict = dict;
+    parser->str_xml = xmlDictLookup (dict, (const xmlChar *) "xml", 3);
+    parser->str_xmlns = xmlDictLookup (dict, (const xmlChar *) "xmlns", 5);
+    parser->str_xml_ns = xmlDictLookup (dict, XML_XML_NAMESPACE, 36);
+  }
+  base->xml_parser = parser;
+  return TRUE;
+}
+
+/* Whether a document is being parsed, by libxml or by the built-in
+ * tokenizer */
+static gboolean
+gst_ttmlbase_parsing (GstTTMLBase *base)
+{
+  return base->parser_busy;
+}
+
+/* The current document is over, even if it was not complete */
+static void
+gst_ttmlbase_parser_terminate (GstTTMLBase *base)
+{
+  if (!base->parser_busy)
+    return;
+  if (base->tokenizer)
+    gst_ttml_tokenizer_finish (base->tokenizer);
+  else
+    xmlParseChunk (base->xml_parser, NULL, 0, 1);
+}
 
+static void
+gst_ttmlbase_parser_free (GstTTMLBase *base)
+{
   if (base->xml_parser) {
     xmlFreeParserCtxt (base->xml_parser);
     base->xml_parser = NULL;
   }
+  gst_ttml_tokenizer_free (base->tokenizer);
+  base->tokenizer = NULL;
+  base->parser_busy = FALSE;
+  gst_ttmlbase_names_forget (base);
+}
 
-  if (base->timeline) {
-    g_list_free_full (base->timeline, (GDestroyNotify) gst_ttml_event_free);
-    base->timeline = NULL;
+/* Done with the current document. The parser is kept for the next one,
+ * unless the names of its dictionary grew past what TTML documents use. */
+static void
+gst_ttmlbase_parser_release (GstTTMLBase *base)
+{
+  base->parser_busy = FALSE;
+  if ((base->xml_parser &&
+          xmlDictSize (base->xml_parser->dict) > PARSER_DICT_MAX_SIZE) ||
+      (base->tokenizer &&
+          base->tokenizer->dict_used > PARSER_DICT_MAX_SIZE)) {
+    GST_DEBUG_OBJECT (base, "Too many names, dropping the parser");
+    gst_ttmlbase_parser_free (base);
   }
+}
+
+/* Free any parsing-related information held by the element */
+static void
+gst_ttmlbase_reset (GstTTMLBase *base)
+{
+  GstTTMLBaseClass *klass = GST_TTMLBASE_GET_CLASS (base);
+
+  GST_DEBUG_OBJECT (base, "Resetting parsing information");
+
+  gst_ttmlbase_parser_release (base);
+  gst_ttmlbase_head_drop_pending (base);
+  gst_ttml_scanner_init (&base->scanner);
+  base->newest_begin = GST_CLOCK_TIME_NONE;
+  base->open_begin = GST_CLOCK_TIME_NONE;
+  base->open_level = 0;
+
+  gst_ttml_timeline_clear (&base->timeline);
+  gst_ttml_base64_clear (&base->image);
+  base->image.enable = FALSE;
 
   if (base->active_spans) {
     g_list_free_full (base->active_spans, (GDestroyNotify) gst_ttml_span_free);
@@ -1020,6 +1469,252 @@ gst_ttmlbase_dump_buffer (GstTTMLBase *base, GstBuffer *buffer)
   gst_buffer_unmap (buffer, &map);
 }
 
+/* In live mode, execute the events which are final already and output
+ * everything up to that point, instead of waiting for the end of the
+ * document. Content is assumed to arrive in chronological order, give or
+ * take the maximum lookahead, and not to begin before the timestamp of the
+ * buffer carrying it. The output cannot go past the beginning of an open
+ * paragraph or span either, since their text is not in the timeline yet. */
+static void
+gst_ttmlbase_live_flush (GstTTMLBase *base)
+{
+  GstClockTime watermark = base->input_buf_start;
+  GstTTMLEvent *event;
+
+  if (GST_CLOCK_TIME_IS_VALID (base->newest_begin) &&
+      base->newest_begin > base->max_lookahead)
+    watermark = MAX (watermark, base->newest_begin - base->max_lookahead);
+  if (GST_CLOCK_TIME_IS_VALID (base->open_begin))
+    watermark = MIN (watermark, base->open_begin);
+
+  if (watermark <= base->last_out_time)
+    return;
+
+  GST_LOG_OBJECT (base, "Flushing up to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (watermark));
+  /* Events at the watermark itself are kept, content beginning at the same
+   * time might still come */
+  while ((event = gst_ttml_timeline_peek (&base->timeline)) &&
+         event->timestamp < watermark) {
+    gst_ttml_timeline_pop (&base->timeline);
+    if (event->timestamp > base->last_out_time)
+      gst_ttmlbase_gen_buffer (base->last_out_time, event->timestamp, base);
+    gst_ttmlbase_parse_event (event, base);
+  }
+
+  gst_ttmlbase_gen_buffer (base->last_out_time, watermark, base);
+}
+
+/* In live mode, content is output once input with a later timestamp has
+ * been parsed (see gst_ttmlbase_live_flush()), so when a buffer ends inside
+ * an open document, its content is held back until the next buffer: for its
+ * duration at first, and then for the time until the next timestamp.
+ * Buffers carrying whole documents hold nothing back, however sparse they
+ * are. Content further than the maximum lookahead from the newest one is
+ * output without waiting for more input, which caps the holdback. Called
+ * after parsing each buffer. A LATENCY message is posted when it grows, so
+ * the pipeline asks again. */
+static void
+gst_ttmlbase_live_update_holdback (
+    GstTTMLBase *base, GstClockTime ts, GstClockTime dur)
+{
+  GstClockTime holdback = 0;
+
+  if (base->input_prev_open &&
+      GST_CLOCK_TIME_IS_VALID (base->input_prev_start) &&
+      ts > base->input_prev_start)
+    holdback = ts - base->input_prev_start;
+  base->input_prev_start = ts;
+  base->input_prev_open = gst_ttmlbase_parsing (base);
+  if (base->input_prev_open && GST_CLOCK_TIME_IS_VALID (dur))
+    holdback = MAX (holdback, dur);
+  holdback = MIN (holdback, base->max_lookahead);
+
+  if (holdback <= base->live_holdback)
+    return;
+
+  GST_DEBUG_OBJECT (base, "Output held back for up to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (holdback));
+  base->live_holdback = holdback;
+  gst_element_post_message (
+      GST_ELEMENT (base), gst_message_new_latency (GST_OBJECT (base)));
+}
+
+/* Feed a chunk of the current document to the SAX parser, creating it if
+ * this is the first one. Returns FALSE if the parser could not be created. */
+static gboolean
+gst_ttmlbase_parse_chunk (GstTTMLBase *base, const gchar *data, gsize size)
+{
+  gboolean ok;
+
+  if (!gst_ttmlbase_parsing (base)) {
+    gsize resume;
+    gsize len = gst_ttmlbase_head_prepare (base, data, size, &resume);
+
+    GST_DEBUG_OBJECT (base,
+        "Creating XML parser and parsing chunk (%d bytes)", (int) size);
+    if (base->builtin_tokenizer) {
+      if (base->tokenizer)
+        gst_ttml_tokenizer_reset (base->tokenizer);
+      else
+        base->tokenizer =
+            gst_ttml_tokenizer_new (&gst_ttmlbase_sax_handler, base);
+      base->parser_busy = TRUE;
+      if (!gst_ttml_tokenizer_feed (base->tokenizer, data, len))
+        GST_WARNING_OBJECT (base, "XML Parsing failed");
+    } else {
+      if ((!base->xml_parser && !gst_ttmlbase_parser_new (base)) ||
+          xmlCtxtResetPush (base->xml_parser, data, (int) len, NULL, NULL)) {
+        GST_ERROR_OBJECT (base, "XML parser creation failed");
+        gst_ttmlbase_head_drop_pending (base);
+        return FALSE;
+      }
+      base->parser_busy = TRUE;
+    }
+    if (resume == size) {
+      GST_DEBUG_OBJECT (base, "XML Chunk finished");
+      return TRUE;
+    }
+    /* The head was left out, feed what comes after it */
+    data += resume;
+    size -= resume;
+  }
+
+  GST_DEBUG_OBJECT (base, "Parsing XML chunk (%d bytes)", (int) size);
+  if (base->tokenizer)
+    ok = gst_ttml_tokenizer_feed (base->tokenizer, data, size);
+  else
+    ok = xmlParseChunk (base->xml_parser, data, (int) size, 0) == 0;
+  if (!ok) {
+    GST_WARNING_OBJECT (base, "XML Parsing failed");
+  } else {
+    GST_DEBUG_OBJECT (base, "XML Chunk finished");
+  }
+  return TRUE;
+}
+
+static void
+gst_ttmlbase_parse_worker (GstTTMLSaxLog *log, GstTTMLBase *base)
+{
+  gst_ttml_sax_log_parse (log, base->builtin_tokenizer);
+}
+
+/* Create the pool of parsing threads, if not done already. The object lock
+ * protects the pointer from set_property, which resizes the pool. */
+static gboolean
+gst_ttmlbase_parse_pool_get (GstTTMLBase *base)
+{
+  GError *error = NULL;
+
+  if (base->parse_pool)
+    return TRUE;
+
+  /* libxml must be initialized before parsers are created in parallel */
+  xmlInitParser ();
+  GST_OBJECT_LOCK (base);
+  base->parse_pool = g_thread_pool_new ((GFunc) gst_ttmlbase_parse_worker,
+      base, (gint) base->parse_threads, FALSE, &error);
+  GST_OBJECT_UNLOCK (base);
+  if (!base->parse_pool) {
+    GST_WARNING_OBJECT (base, "Could not create parsing threads: %s",
+        error->message);
+    g_error_free (error);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (base, "Created %u parsing threads", base->parse_threads);
+  return TRUE;
+}
+
+static void
+gst_ttmlbase_parse_pool_free (GstTTMLBase *base)
+{
+  GThreadPool *pool;
+
+  GST_OBJECT_LOCK (base);
+  pool = base->parse_pool;
+  base->parse_pool = NULL;
+  GST_OBJECT_UNLOCK (base);
+
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+/* When several complete documents start at 'data', parse them in worker
+ * threads. Their callbacks are then run in order, and each document is
+ * finished as the streaming thread finishes it, so the results are the
+ * same as parsing them one after another. Returns the bytes consumed, 0 if
+ * the streaming thread must parse what comes next. */
+static gsize
+gst_ttmlbase_parse_documents (GstTTMLBase *base, const gchar *data, gsize len)
+{
+  GstTTMLScanner scanner = base->scanner;
+  GPtrArray *logs;
+  gsize pos = 0, consumed = 0;
+  guint i;
+
+  if (base->parse_threads < 2 || gst_ttmlbase_parsing (base))
+    return 0;
+
+  /* Only documents which end in this buffer can be parsed in one piece */
+  logs = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_ttml_sax_log_free);
+  while (pos < len) {
+    GstTTMLScannerBoundary boundary;
+    gsize doc_len;
+
+    while (pos < len && g_ascii_isspace (data[pos]))
+      pos++;
+    if (pos == len)
+      break;
+    doc_len =
+        gst_ttml_scanner_scan (&scanner, data + pos, len - pos, &boundary);
+    if (boundary != GST_TTML_SCANNER_BOUNDARY_END)
+      break;
+    g_ptr_array_add (logs, gst_ttml_sax_log_new (data + pos, doc_len));
+    pos += doc_len;
+    consumed = pos;
+  }
+
+  if (logs->len < PARSE_POOL_MIN_DOCUMENTS ||
+      !gst_ttmlbase_parse_pool_get (base)) {
+    g_ptr_array_unref (logs);
+    return 0;
+  }
+
+  GST_DEBUG_OBJECT (base, "Parsing %u documents in parallel", logs->len);
+  for (i = 0; i < logs->len; i++)
+    g_thread_pool_push (base->parse_pool, g_ptr_array_index (logs, i), NULL);
+
+  for (i = 0; i < logs->len; i++) {
+    GstTTMLSaxLog *log = g_ptr_array_index (logs, i);
+
+    if (gst_ttml_sax_log_wait (log)) {
+      /* The names of the log are not those of the parser */
+      gst_ttmlbase_names_forget (base);
+      gst_ttml_sax_log_replay (log, &gst_ttmlbase_sax_handler, base);
+      gst_ttmlbase_names_forget (base);
+    } else if (gst_ttmlbase_parse_chunk (base, log->data, log->len)) {
+      gst_ttmlbase_parser_terminate (base);
+    } else {
+      /* As in the streaming thread, the rest of the buffer is dropped */
+      consumed = len;
+      i++;
+      break;
+    }
+
+    gst_ttmlbase_reset (base);
+    base->base_time = GST_CLOCK_TIME_NONE;
+  }
+
+  /* The workers must be done with the remaining logs before freeing them */
+  for (; i < logs->len; i++)
+    gst_ttml_sax_log_wait (g_ptr_array_index (logs, i));
+  g_ptr_array_unref (logs);
+
+  return consumed;
+}
+
 static GstFlowReturn
 gst_ttmlbase_handle_buffer (GstPad *pad, GstBuffer *buffer)
 {
@@ -1057,92 +1752,80 @@ gst_ttmlbase_handle_buffer (GstPad *pad, GstBuffer *buffer)
   buffer_data = (const char *) map.data;
   buffer_len = map.size;
   do {
-    const char *next_buffer_data = NULL;
-    int next_buffer_len = 0;
-
-    /* Look for start-of-document tag */
-    /* This might happen because two XML files come in different buffers
-     * but there's no ending /tt> tag but an empty /> one
-     */
-    if (base->xml_parser &&
-        (g_strstr_len (buffer_data, buffer_len, "<tt") ||
-            g_strstr_len (buffer_data, buffer_len, "<?xml"))) {
-      xmlParseChunk (base->xml_parser, NULL, 0, 1);
-      xmlFreeParserCtxt (base->xml_parser);
-      base->xml_parser = NULL;
-    }
-
-    /* Look for end-of-document tags */
-    next_buffer_data = g_strstr_len (buffer_data, buffer_len, "tt>");
-    if (next_buffer_data &&
-        (next_buffer_data[-1] == '/' || next_buffer_data[-1] == ':')) {
-      next_buffer_data += 3;
-    } else {
-      next_buffer_data = NULL;
+    GstTTMLScannerBoundary boundary;
+    gsize chunk_len;
+
+    /* Skip whitespace between documents, or the first thing the new parser
+     * will find will not be the start-of-document tag */
+    if (!gst_ttmlbase_parsing (base)) {
+      while (buffer_len && g_ascii_isspace (*buffer_data)) {
+        GST_DEBUG_OBJECT (base, "Skipping whitespace char 0x%02x",
+            *buffer_data);
+        buffer_data++;
+        buffer_len--;
+      }
+      if (!buffer_len)
+        break;
+
+      chunk_len =
+          gst_ttmlbase_parse_documents (base, buffer_data, buffer_len);
+      if (chunk_len) {
+        buffer_data += chunk_len;
+        buffer_len -= chunk_len;
+        continue;
+      }
     }
 
-    /* If one was detected, this might be a concatenated XML file (multiple
-     * XML files inside the same buffer) and we need to parse them one by one
-     */
-    if (next_buffer_data) {
-      GST_DEBUG_OBJECT (base, "Detected XML document end at position %d of %d",
-          (int) (next_buffer_data - buffer_data), buffer_len);
-      next_buffer_len = buffer_len - (next_buffer_data - buffer_data);
-      buffer_len = next_buffer_data - buffer_data;
+    /* Look for the end of the current document. This might be a
+     * concatenated XML file (multiple XML files inside the same buffer) and
+     * we need to parse them one by one. */
+    chunk_len = gst_ttml_scanner_scan (
+        &base->scanner, buffer_data, buffer_len, &boundary);
+    if (boundary != GST_TTML_SCANNER_BOUNDARY_NONE) {
+      GST_DEBUG_OBJECT (base, "Detected XML document %s at position %d of %d",
+          boundary == GST_TTML_SCANNER_BOUNDARY_END ? "end" : "restart",
+          (int) chunk_len, buffer_len);
     }
 
     /* Feed this data to the SAX parser. The rest of the processing takes place
      * in the callbacks. */
-    if (!base->xml_parser) {
-      GST_DEBUG_OBJECT (base,
-          "Creating XML parser and parsing chunk (%d bytes)", buffer_len);
-      base->xml_parser = xmlCreatePushParserCtxt (
-          &gst_ttmlbase_sax_handler, base, buffer_data, buffer_len, NULL);
-      if (!base->xml_parser) {
-        GST_ERROR_OBJECT (base, "XML parser creation failed");
-        goto beach;
-      } else {
-        GST_DEBUG_OBJECT (base, "XML Chunk finished");
-      }
-    } else {
-      int res;
-      GST_DEBUG_OBJECT (base, "Parsing XML chunk (%d bytes)", buffer_len);
-      res = xmlParseChunk (base->xml_parser, buffer_data, buffer_len, 0);
-      if (res != 0) {
-        GST_WARNING_OBJECT (base, "XML Parsing failed");
-      } else {
-        GST_DEBUG_OBJECT (base, "XML Chunk finished");
-      }
-    }
+    if (chunk_len && !gst_ttmlbase_parse_chunk (base, buffer_data, chunk_len))
+      goto beach;
+    if (base->live && boundary != GST_TTML_SCANNER_BOUNDARY_END &&
+        gst_ttmlbase_parsing (base))
+      gst_ttmlbase_live_flush (base);
 
-    /* If an end-of-document tag was found, terminate this parsing process */
-    if (next_buffer_data) {
+    if (boundary == GST_TTML_SCANNER_BOUNDARY_END) {
       /* Destroy parser, a new one will be created if more XML files arrive */
       GST_DEBUG_OBJECT (base, "Terminating pending XML parsing works");
-      xmlParseChunk (base->xml_parser, NULL, 0, 1);
+      gst_ttmlbase_parser_terminate (base);
 
       gst_ttmlbase_reset (base);
       base->base_time = GST_CLOCK_TIME_NONE;
-
-      /* Remove trailing whitespace, or the first thing the new parser will
-       * find will not be the start-of-document tag */
-      while (next_buffer_len && g_ascii_isspace (*next_buffer_data)) {
-        GST_DEBUG_OBJECT (base, "Skipping trailing whitespace char 0x%02x",
-            *next_buffer_data);
-        next_buffer_data++;
-        next_buffer_len--;
-      }
+    } else if (boundary == GST_TTML_SCANNER_BOUNDARY_RESTART) {
+      /* The previous document was truncated. Its pending events survive,
+       * as with any new document. */
+      gst_ttmlbase_parser_terminate (base);
+      gst_ttmlbase_parser_release (base);
+      /* The XML declaration started in a previous buffer */
+      if (base->scanner.carried &&
+          !gst_ttmlbase_parse_chunk (base, GST_TTML_SCANNER_XML_DECLARATION,
+              base->scanner.carried))
+        goto beach;
     }
 
     /* Process the next XML inside this buffer. If the end-of-document tag was
      * at the end of the buffer (single XML inside single buffer case), then
      * buffer_len will be 0 after this adjustment and no more loops will be
      * performed. */
-    buffer_data = next_buffer_data;
-    buffer_len = next_buffer_len;
+    buffer_data += chunk_len;
+    buffer_len -= chunk_len;
 
   } while (buffer_len);
 
+  if (base->live && GST_CLOCK_TIME_IS_VALID (ts))
+    gst_ttmlbase_live_update_holdback (base, ts, dur);
+
 beach:
   gst_buffer_unmap (buffer, &map);
   gst_buffer_unref (buffer);
@@ -1252,8 +1935,18 @@ gst_ttmlbase_cleanup (GstTTMLBase *base)
   base->newsegment_needed = TRUE;
   base->current_gst_status = GST_FLOW_OK;
   base->input_buf_start = 0;
+  base->input_prev_start = GST_CLOCK_TIME_NONE;
+  base->input_prev_open = FALSE;
   base->last_out_time = 0;
 
+  /* The cache is kept, but an interrupted recording is useless */
+  if (base->cache_recording) {
+    gst_ttml_cache_free (base->cache);
+    base->cache = NULL;
+    base->cache_recording = FALSE;
+  }
+  base->documents_since_flush = 0;
+
   gst_ttmlbase_reset (base);
 }
 
@@ -1312,23 +2005,36 @@ gst_ttmlbase_handle_sink_event (GstPad *pad, GstEvent *event)
           base, "our segment now is %" GST_SEGMENT_FORMAT, base->segment);
       break;
     }
+    case GST_EVENT_FLUSH_START:
+      /* The streaming thread might be waiting for room in the output queue.
+       * Wake it up, so the chain returns as soon as possible. */
+      gst_ttmlbase_output_set_flushing (base, TRUE);
+      ret = gst_pad_push_event (base->srcpad, event);
+      event = NULL;
+      break;
     case GST_EVENT_FLUSH_STOP:
-      /* FIXME we have a race condition when seeking/flushing. The FLUSH_START
-       * triggers a flush in the src pad that causes that every gst_pad_push()
-       * will return GST_FLOW_WRONG_STATE, therefore the the streaming thread
-       * that is iterating over the list of ttml events to render will take
-       * time to clean it up. After the FLUSH_START we'll receive the
-       * FLUSH_STOP where we are just cleaning the list of attributes/tineline
-       * but the chain might be still using it. Remember,
-       * FLUSH_START/FLUSH_STOP might come from different threads
-       */
+      /* FLUSH_STOP is serialized with the buffers, so the streaming thread
+       * is not using the timeline anymore. Without an output queue it might
+       * have taken a while to get here, since it pushes (and fails) every
+       * remaining buffer of the document after the FLUSH_START. With the
+       * queue it returns at once. */
       GST_DEBUG_OBJECT (base, "Flushing TTML parser");
+      /* Stop the output task, or playing from the cache, if we were */
+      gst_ttmlbase_output_pause (base);
+      base->upstream_eos = FALSE;
       gst_ttmlbase_cleanup (base);
       ret = gst_pad_push_event (base->srcpad, event);
       event = NULL;
+      gst_ttmlbase_output_set_flushing (base, FALSE);
+      break;
+    case GST_EVENT_EOS:
+      /* Behind the queued output, if any */
+      ret = gst_ttmlbase_push_event (base, event);
+      base->upstream_eos = TRUE;
+      event = NULL;
       break;
     default:
-      ret = gst_pad_push_event (base->srcpad, event);
+      ret = gst_ttmlbase_push_event (base, event);
       event = NULL;
       break;
   }
@@ -1343,6 +2049,83 @@ beach:
   return ret;
 }
 
+/* Play the cached timeline from the current position, one event per
+ * iteration, the same way the timeline is flushed after parsing */
+static void
+gst_ttmlbase_cache_loop (GstTTMLBase *base)
+{
+  GstTTMLEvent *event;
+
+  if (base->cache_position < gst_ttml_cache_get_length (base->cache)) {
+    event = gst_ttml_cache_get_event (base->cache, base->cache_position++);
+    if (event->timestamp > base->last_out_time)
+      gst_ttmlbase_gen_buffer (base->last_out_time, event->timestamp, base);
+    gst_ttmlbase_parse_event (event, base);
+  } else {
+    GST_DEBUG_OBJECT (base, "Cached timeline complete");
+    if (base->last_out_time < GST_CLOCK_TIME_NONE)
+      gst_ttmlbase_gen_buffer (base->last_out_time, GST_CLOCK_TIME_NONE, base);
+    gst_pad_push_event (base->srcpad, gst_event_new_eos ());
+    gst_pad_pause_task (base->srcpad);
+    return;
+  }
+
+  if (base->current_gst_status != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (base, "Pausing cached timeline: %s",
+        gst_flow_get_name (base->current_gst_status));
+    if (base->current_gst_status == GST_FLOW_NOT_LINKED ||
+        base->current_gst_status < GST_FLOW_EOS) {
+      GST_ELEMENT_ERROR (base, STREAM, FAILED, ("Internal data flow error."),
+          ("streaming task paused, reason %s (%d)",
+              gst_flow_get_name (base->current_gst_status),
+              base->current_gst_status));
+      gst_pad_push_event (base->srcpad, gst_event_new_eos ());
+    }
+    gst_pad_pause_task (base->srcpad);
+  }
+}
+
+/* Answer a flushing seek from the cached timeline of the document, if it
+ * holds the one upstream delivered. The state at the pending segment start
+ * is restored and the rest is played from a task on the src pad, without
+ * reading or parsing the document again. */
+static gboolean
+gst_ttmlbase_cache_seek (GstTTMLBase *base)
+{
+  gchar *uri;
+  gboolean valid;
+
+  if (!base->cache || !base->upstream_eos)
+    return FALSE;
+
+  uri = gst_ttmlbase_uri_get (base->sinkpad);
+  valid = gst_ttml_cache_is_valid (base->cache, uri);
+  g_free (uri);
+  if (!valid)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (base, "Seeking in the cached timeline");
+  gst_pad_push_event (base->srcpad, gst_event_new_flush_start ());
+  /* Wait for any previous playback or output to stop */
+  gst_ttmlbase_output_pause (base);
+  GST_PAD_STREAM_LOCK (base->sinkpad);
+
+  gst_ttmlbase_cleanup (base);
+  gst_pad_push_event (base->srcpad, gst_event_new_flush_stop (TRUE));
+  /* Same as after a FLUSH_STOP from upstream, the output flows again */
+  gst_ttmlbase_output_set_flushing (base, FALSE);
+
+  gst_ttml_cache_restore (base->cache, &base->state, &base->namespaces);
+  base->cache_position = gst_ttml_cache_seek (base->cache,
+      base->segment->start, (GstTTMLCacheEventFunc) gst_ttmlbase_parse_event,
+      base);
+
+  GST_PAD_STREAM_UNLOCK (base->sinkpad);
+
+  return gst_pad_start_task (
+      base->srcpad, (GstTaskFunction) gst_ttmlbase_cache_loop, base, NULL);
+}
+
 static gboolean
 gst_ttmlbase_do_seek (GstTTMLBase *base, GstEvent *seek)
 {
@@ -1364,6 +2147,9 @@ gst_ttmlbase_do_seek (GstTTMLBase *base, GstEvent *seek)
       base->pending_segment, FALSE, rate, GST_FORMAT_TIME, start, stop, start);
   gst_event_unref (seek);
 
+  if ((flags & GST_SEEK_FLAG_FLUSH) && gst_ttmlbase_cache_seek (base))
+    return TRUE;
+
   /* do a 0, -1 seek upstream in bytes */
   seek = gst_event_new_seek (1.0, GST_FORMAT_BYTES, flags, GST_SEEK_TYPE_SET,
       0, GST_SEEK_TYPE_SET, -1);
@@ -1467,6 +2253,28 @@ gst_ttmlbase_handle_src_query (GstPad *pad, GstQuery *query)
       }
       break;
     }
+    case GST_QUERY_LATENCY: {
+      gboolean live;
+      GstClockTime min, max;
+
+      ret = gst_pad_peer_query (base->sinkpad, query);
+      if (ret && base->live) {
+        /* Content of open documents waits for input with later
+         * timestamps, up to the lookahead, see
+         * gst_ttmlbase_live_update_holdback(). Open paragraphs are not
+         * bounded: their text is held until they are closed, in whichever
+         * buffer that happens. */
+        gst_query_parse_latency (query, &live, &min, &max);
+        min += base->live_holdback;
+        if (GST_CLOCK_TIME_IS_VALID (max))
+          max += base->live_holdback;
+        GST_DEBUG_OBJECT (base,
+            "Reporting latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+        gst_query_set_latency (query, live, min, max);
+      }
+      break;
+    }
     default:
       ret = gst_pad_peer_query (base->sinkpad, query);
       break;
@@ -1513,10 +2321,14 @@ gst_ttmlbase_change_state (GstElement *element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_ttmlbase_output_set_flushing (base, FALSE);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* The streaming thread might be waiting for room in the output queue,
+       * and deactivating the pads needs it */
+      gst_ttmlbase_output_set_flushing (base, TRUE);
       break;
     default:
       break;
@@ -1531,7 +2343,16 @@ gst_ttmlbase_change_state (GstElement *element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_DEBUG_OBJECT (base, "going from PAUSED to READY");
+      gst_pad_stop_task (base->srcpad);
+      base->output_started = FALSE;
       gst_ttmlbase_cleanup (base);
+      gst_ttml_cache_free (base->cache);
+      base->cache = NULL;
+      base->upstream_eos = FALSE;
+      gst_ttml_head_cache_free (base->head_cache);
+      base->head_cache = NULL;
+      gst_ttmlbase_parse_pool_free (base);
+      gst_ttmlbase_parser_free (base);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -1552,6 +2373,21 @@ gst_ttmlbase_get_property (
     case PROP_ASSUME_ORDERED_SPANS:
       g_value_set_boolean (value, base->assume_ordered_spans);
       break;
+    case PROP_LIVE:
+      g_value_set_boolean (value, base->live);
+      break;
+    case PROP_MAX_LOOKAHEAD:
+      g_value_set_uint64 (value, base->max_lookahead);
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      g_value_set_uint (value, base->output_queue_size);
+      break;
+    case PROP_PARSE_THREADS:
+      g_value_set_uint (value, base->parse_threads);
+      break;
+    case PROP_BUILTIN_TOKENIZER:
+      g_value_set_boolean (value, base->builtin_tokenizer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1568,6 +2404,26 @@ gst_ttmlbase_set_property (
     case PROP_ASSUME_ORDERED_SPANS:
       base->assume_ordered_spans = g_value_get_boolean (value);
       break;
+    case PROP_LIVE:
+      base->live = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_LOOKAHEAD:
+      base->max_lookahead = g_value_get_uint64 (value);
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      base->output_queue_size = g_value_get_uint (value);
+      break;
+    case PROP_PARSE_THREADS:
+      GST_OBJECT_LOCK (base);
+      base->parse_threads = g_value_get_uint (value);
+      if (base->parse_pool)
+        g_thread_pool_set_max_threads (
+            base->parse_pool, (gint) base->parse_threads, NULL);
+      GST_OBJECT_UNLOCK (base);
+      break;
+    case PROP_BUILTIN_TOKENIZER:
+      base->builtin_tokenizer = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1591,9 +2447,34 @@ gst_ttmlbase_dispose (GObject *object)
     base->pending_segment = NULL;
   }
 
+  gst_ttml_cache_free (base->cache);
+  base->cache = NULL;
+  gst_ttml_head_cache_free (base->head_cache);
+  base->head_cache = NULL;
+  gst_ttmlbase_parse_pool_free (base);
+  gst_ttmlbase_parser_free (base);
+
+  gst_ttml_arena_release (&base->state.arena);
+
+  g_mutex_lock (&base->output_lock);
+  gst_ttmlbase_output_drop_queued (base);
+  g_mutex_unlock (&base->output_lock);
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 
   g_free (base->buffer.data);
+  gst_ttml_base64_clear (&base->image);
+}
+
+static void
+gst_ttmlbase_finalize (GObject *object)
+{
+  GstTTMLBase *base = GST_TTMLBASE (object);
+
+  g_mutex_clear (&base->output_lock);
+  g_cond_clear (&base->output_cond);
+
+  GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
 
 static void
@@ -1618,6 +2499,7 @@ gst_ttmlbase_class_init (GstTTMLBaseClass *klass)
   parent_class = GST_ELEMENT_CLASS (g_type_class_peek_parent (klass));
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_ttmlbase_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_ttmlbase_finalize);
   gobject_class->set_property = GST_DEBUG_FUNCPTR (gst_ttmlbase_set_property);
   gobject_class->get_property = GST_DEBUG_FUNCPTR (gst_ttmlbase_get_property);
 
@@ -1627,6 +2509,37 @@ gst_ttmlbase_class_init (GstTTMLBaseClass *klass)
           "Generate buffers as soon as possible, by assuming that text "
           "spans will arrive in chronological order",
           FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class, PROP_LIVE,
+      g_param_spec_boolean ("live", "Live",
+          "Generate buffers as the input arrives, without waiting for the "
+          "end of the documents, by assuming that content arrives in "
+          "chronological order within the maximum lookahead",
+          FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class, PROP_MAX_LOOKAHEAD,
+      g_param_spec_uint64 ("max_lookahead", "Maximum lookahead",
+          "In live mode, how much earlier than the latest one (in "
+          "nanoseconds) a new text span can begin",
+          0, G_MAXUINT64, DEFAULT_MAX_LOOKAHEAD, G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class, PROP_OUTPUT_QUEUE_SIZE,
+      g_param_spec_uint ("output_queue_size", "Output queue size",
+          "Number of output buffers waiting to be pushed by a separate "
+          "thread, so a slow downstream does not stall parsing. With 0, "
+          "buffers are pushed by the parsing thread.",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_PARSE_THREADS,
+      g_param_spec_uint ("parse_threads", "Parse threads",
+          "Number of threads parsing the documents of a buffer which holds "
+          "several of them. Their results are still processed in order, so "
+          "the output does not change. With 1, documents are parsed by the "
+          "streaming thread. It can be changed while playing.",
+          1, G_MAXINT, DEFAULT_PARSE_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject_class, PROP_BUILTIN_TOKENIZER,
+      g_param_spec_boolean ("builtin_tokenizer", "Built-in tokenizer",
+          "Parse the documents with a tokenizer for the XML used by TTML, "
+          "which does not allocate per element, instead of libxml2. "
+          "Document type declarations are not supported.",
+          FALSE, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY));
 
   /* GstElement overrides */
   gstelement_class->change_state =
@@ -1663,11 +2576,22 @@ gst_ttmlbase_init (GstTTMLBase *base, GstTTMLBaseClass *klass)
   base->newsegment_needed = TRUE;
 
   base->xml_parser = NULL;
+  base->tokenizer = NULL;
+  base->parser_busy = FALSE;
   base->base_time = GST_CLOCK_TIME_NONE;
   base->current_gst_status = GST_FLOW_OK;
-  base->timeline = NULL;
+  gst_ttml_timeline_init (&base->timeline);
 
   base->assume_ordered_spans = FALSE;
+  base->live = FALSE;
+  base->max_lookahead = DEFAULT_MAX_LOOKAHEAD;
+  base->live_holdback = 0;
+  base->output_queue_size = 0;
+  base->parse_threads = DEFAULT_PARSE_THREADS;
+  base->builtin_tokenizer = FALSE;
+  g_queue_init (&base->output_queue);
+  g_mutex_init (&base->output_lock);
+  g_cond_init (&base->output_cond);
 
   base->state.attribute_stack = NULL;
   gst_ttml_state_reset (&base->state);
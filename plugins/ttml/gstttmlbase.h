@@ -10,20 +10,50 @@
 #include <libxml/parser.h>
 #include <gst/gst.h>
 #include "gstttmlstate.h"
+#include "gstttmltimeline.h"
+#include "gstttmlcache.h"
+#include "gstttmlheadcache.h"
+#include "gstttmlscanner.h"
+#include "gstttmlbuffer.h"
+#include "gstttmlbase64.h"
 
 G_BEGIN_DECLS
 
+/* Namespace URIs seen since the dictionary of the XML parser was created,
+ * and whether they are TTML ones. URIs belong to that dictionary, so the
+ * same namespace always comes with the same pointer. */
+#define GST_TTMLBASE_NAMESPACE_CACHE_SIZE 8
+
+typedef struct
+{
+  const xmlChar *uri;
+  gboolean is_ttml;
+} GstTTMLBaseNamespaceCache;
+
+/* Node and attribute types of the names seen since the dictionary of the
+ * XML parser was created, indexed by the address of the name. Names also
+ * belong to the dictionary, so classifying a name seen before takes two
+ * pointer compares. Size must be a power of 2. */
+#define GST_TTMLBASE_NAME_CACHE_SIZE 64
+
 typedef struct
 {
-  gchar *data;
-  gsize size;
-  gsize len;
-  gboolean enable;
-  gboolean preserve_whitespace;
-  gboolean insert_space;
-  gboolean collapsing;
-  gboolean line_has_chars;
-} GstTTMLBuffer;
+  const xmlChar *name;
+  const xmlChar *uri;
+  gint type;
+} GstTTMLBaseNameCache;
+
+/* Progress of the reuse of a parsed document head */
+typedef enum
+{
+  GST_TTMLBASE_HEAD_NONE,
+  /* A head was found, its results will be stored when it is parsed */
+  GST_TTMLBASE_HEAD_CAPTURE_PENDING,
+  GST_TTMLBASE_HEAD_CAPTURING,
+  /* The head was not fed to the parser, its stored results will be applied
+   * when the parser reaches its position */
+  GST_TTMLBASE_HEAD_REPLAY_PENDING
+} GstTTMLBaseHeadState;
 
 /* The GStreamer ttmlbase base element */
 typedef struct _GstTTMLBase
@@ -42,9 +72,17 @@ typedef struct _GstTTMLBase
   GstFlowReturn current_gst_status;
 
   /* XML parsing */
+  /* Kept from one document to the next, with their dictionaries */
   xmlParserCtxtPtr xml_parser;
+  GstTTMLTokenizer *tokenizer;
+  /* A document is being fed to one of them */
+  gboolean parser_busy;
+  GstTTMLScanner scanner;
   GstTTMLState state;
   GList *namespaces;
+  GstTTMLBaseNamespaceCache namespace_cache[GST_TTMLBASE_NAMESPACE_CACHE_SIZE];
+  GstTTMLBaseNameCache node_cache[GST_TTMLBASE_NAME_CACHE_SIZE];
+  GstTTMLBaseNameCache attribute_cache[GST_TTMLBASE_NAME_CACHE_SIZE];
   gboolean is_std_ebu;
   gboolean in_styling_node;
   gboolean in_layout_node;
@@ -52,9 +90,14 @@ typedef struct _GstTTMLBase
 
   /* Properties */
   gboolean assume_ordered_spans;
+  gboolean live;
+  GstClockTime max_lookahead;
+  guint output_queue_size;
+  guint parse_threads;
+  gboolean builtin_tokenizer;
 
   /* Timeline management */
-  GList *timeline;
+  GstTTMLTimeline timeline;
   GstClockTime input_buf_start;
   GstClockTime input_buf_stop;
   GstClockTime base_time;
@@ -63,8 +106,53 @@ typedef struct _GstTTMLBase
   /* Active span list */
   GList *active_spans;
 
+  /* Live mode: latest span begin time, and begin time of the outermost
+   * open paragraph or span with timing, whose text is not in the timeline
+   * yet, and its nesting level */
+  GstClockTime newest_begin;
+  GstClockTime open_begin;
+  guint open_begin_level;
+  guint open_level;
+  /* Live mode: timestamp of the previous input buffer, whether it ended
+   * inside an open document, and how long the output can be held back
+   * waiting for the next one, at most the lookahead. Reported as latency. */
+  GstClockTime input_prev_start;
+  gboolean input_prev_open;
+  GstClockTime live_holdback;
+
+  /* Parsed timeline of the last document, to answer seeks without parsing
+   * it again. Only recorded for the first document after a flush, when the
+   * input is not timestamped (a whole file). */
+  GstTTMLCache *cache;
+  gboolean cache_recording;
+  guint cache_position;
+  guint documents_since_flush;
+  gboolean upstream_eos;
+
+  /* Parsed head of the last document, reused by the following ones when
+   * they repeat it, as segmented streams do */
+  GstTTMLHeadCache *head_cache;
+  GstTTMLHeadCache *head_pending;
+  GstTTMLBaseHeadState head_state;
+  guint head_depth;
+
+  /* Worker threads parsing the complete documents of a buffer holding
+   * several of them */
+  GThreadPool *parse_pool;
+
+  /* Output waiting to be pushed by the src pad task, when the queue size
+   * is not 0, so a slow downstream does not stall parsing */
+  GQueue output_queue;
+  GMutex output_lock;
+  GCond output_cond;
+  gboolean output_flushing;
+  gboolean output_started;
+  GstFlowReturn output_status;
+
   /* buffer to accumulate xml node content */
   GstTTMLBuffer buffer;
+  /* data of the embedded image being parsed */
+  GstTTMLBase64 image;
 } GstTTMLBase;
 
 /* The GStreamer ttmlbase element's class */
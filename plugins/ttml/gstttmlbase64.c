@@ -0,0 +1,294 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlbase64.h"
+#include <string.h>
+
+/* GST_TTML_BASE64_DISABLE_SIMD selects the scalar code on any target, which
+ * the tests use to check both versions */
+#if defined(GST_TTML_BASE64_DISABLE_SIMD)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GST_TTML_BASE64_SSE2
+#define GST_TTML_BASE64_BLOCK 16
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GST_TTML_BASE64_NEON
+#define GST_TTML_BASE64_BLOCK 32
+#endif
+
+/* Ranks of the characters which are not sextets. Anything outside the
+ * alphabet is skipped, as g_base64_decode() does. */
+enum
+{
+  GST_TTML_BASE64_PADDING = 0x40,
+  GST_TTML_BASE64_INVALID = 0xff
+};
+
+#define X GST_TTML_BASE64_INVALID
+#define P GST_TTML_BASE64_PADDING
+
+/* Sextet of each character */
+static const guint8 gst_ttml_base64_rank[256] = {
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X, 62,  X,  X,  X, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61,  X,  X,  X,  P,  X,  X,
+   X,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,  X,  X,  X,  X,  X,
+   X, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X
+};
+
+#undef X
+#undef P
+
+#if defined(GST_TTML_BASE64_SSE2)
+static inline __m128i
+gst_ttml_base64_sse2_range (__m128i c, gchar first, gchar last)
+{
+  return _mm_and_si128 (_mm_cmpgt_epi8 (c, _mm_set1_epi8 (first - 1)),
+      _mm_cmplt_epi8 (c, _mm_set1_epi8 (last + 1)));
+}
+
+/* Decode a block of characters, if all of them are in the alphabet.
+ * Bytes above 0x7f are negative, so out of every range. */
+static inline gboolean
+gst_ttml_base64_decode_block (const gchar *src, guint8 *dst)
+{
+  __m128i c = _mm_loadu_si128 ((const __m128i *) src);
+  __m128i upper = gst_ttml_base64_sse2_range (c, 'A', 'Z');
+  __m128i lower = gst_ttml_base64_sse2_range (c, 'a', 'z');
+  __m128i digit = gst_ttml_base64_sse2_range (c, '0', '9');
+  __m128i plus = _mm_cmpeq_epi8 (c, _mm_set1_epi8 ('+'));
+  __m128i slash = _mm_cmpeq_epi8 (c, _mm_set1_epi8 ('/'));
+  __m128i s;
+  guint32 groups[4];
+
+  s = _mm_or_si128 (_mm_or_si128 (upper, lower),
+      _mm_or_si128 (digit, _mm_or_si128 (plus, slash)));
+  if (_mm_movemask_epi8 (s) != 0xffff)
+    return FALSE;
+
+  /* From characters to sextets */
+  s = _mm_or_si128 (
+      _mm_or_si128 (_mm_and_si128 (upper, _mm_set1_epi8 (0 - 'A')),
+          _mm_and_si128 (lower, _mm_set1_epi8 (26 - 'a'))),
+      _mm_or_si128 (_mm_and_si128 (digit, _mm_set1_epi8 (52 - '0')),
+          _mm_or_si128 (_mm_and_si128 (plus, _mm_set1_epi8 (62 - '+')),
+              _mm_and_si128 (slash, _mm_set1_epi8 (63 - '/')))));
+  s = _mm_add_epi8 (c, s);
+
+  /* Join them in pairs and then in groups of 24 bits, with their bytes in
+   * the order of the stream */
+  s = _mm_or_si128 (
+      _mm_slli_epi16 (_mm_and_si128 (s, _mm_set1_epi16 (0xff)), 6),
+      _mm_srli_epi16 (s, 8));
+  s = _mm_or_si128 (
+      _mm_slli_epi32 (_mm_and_si128 (s, _mm_set1_epi32 (0xffff)), 12),
+      _mm_srli_epi32 (s, 16));
+  s = _mm_or_si128 (
+      _mm_or_si128 (_mm_srli_epi32 (s, 16),
+          _mm_and_si128 (s, _mm_set1_epi32 (0xff00))),
+      _mm_slli_epi32 (_mm_and_si128 (s, _mm_set1_epi32 (0xff)), 16));
+
+  _mm_storeu_si128 ((__m128i *) groups, s);
+  memcpy (dst, &groups[0], 3);
+  memcpy (dst + 3, &groups[1], 3);
+  memcpy (dst + 6, &groups[2], 3);
+  memcpy (dst + 9, &groups[3], 3);
+  return TRUE;
+}
+#elif defined(GST_TTML_BASE64_NEON)
+static inline uint8x8_t
+gst_ttml_base64_neon_range (uint8x8_t c, guint8 first, guint8 last)
+{
+  return vand_u8 (
+      vcge_u8 (c, vdup_n_u8 (first)), vcle_u8 (c, vdup_n_u8 (last)));
+}
+
+/* Sextets of the characters, clearing lanes of 'valid' for those outside
+ * the alphabet */
+static inline uint8x8_t
+gst_ttml_base64_neon_sextets (uint8x8_t c, uint8x8_t *valid)
+{
+  uint8x8_t upper = gst_ttml_base64_neon_range (c, 'A', 'Z');
+  uint8x8_t lower = gst_ttml_base64_neon_range (c, 'a', 'z');
+  uint8x8_t digit = gst_ttml_base64_neon_range (c, '0', '9');
+  uint8x8_t plus = vceq_u8 (c, vdup_n_u8 ('+'));
+  uint8x8_t slash = vceq_u8 (c, vdup_n_u8 ('/'));
+  uint8x8_t offset;
+
+  *valid = vand_u8 (*valid, vorr_u8 (vorr_u8 (upper, lower),
+                                vorr_u8 (digit, vorr_u8 (plus, slash))));
+  offset = vorr_u8 (
+      vorr_u8 (vand_u8 (upper, vdup_n_u8 ((guint8) (0 - 'A'))),
+          vand_u8 (lower, vdup_n_u8 ((guint8) (26 - 'a')))),
+      vorr_u8 (vand_u8 (digit, vdup_n_u8 ((guint8) (52 - '0'))),
+          vorr_u8 (vand_u8 (plus, vdup_n_u8 (62 - '+')),
+              vand_u8 (slash, vdup_n_u8 (63 - '/')))));
+  return vadd_u8 (c, offset);
+}
+
+/* Decode a block of characters, if all of them are in the alphabet. The
+ * load splits them by their position in the group, so the bytes of the
+ * groups come out of three shifts and ORs. */
+static inline gboolean
+gst_ttml_base64_decode_block (const gchar *src, guint8 *dst)
+{
+  uint8x8x4_t c = vld4_u8 ((const guint8 *) src);
+  uint8x8_t valid = vdup_n_u8 (0xff);
+  uint8x8_t s0 = gst_ttml_base64_neon_sextets (c.val[0], &valid);
+  uint8x8_t s1 = gst_ttml_base64_neon_sextets (c.val[1], &valid);
+  uint8x8_t s2 = gst_ttml_base64_neon_sextets (c.val[2], &valid);
+  uint8x8_t s3 = gst_ttml_base64_neon_sextets (c.val[3], &valid);
+  uint8x8x3_t bytes;
+
+  if (vget_lane_u64 (vreinterpret_u64_u8 (valid), 0) != G_MAXUINT64)
+    return FALSE;
+
+  bytes.val[0] = vorr_u8 (vshl_n_u8 (s0, 2), vshr_n_u8 (s1, 4));
+  bytes.val[1] = vorr_u8 (vshl_n_u8 (s1, 4), vshr_n_u8 (s2, 2));
+  bytes.val[2] = vorr_u8 (vshl_n_u8 (s2, 6), s3);
+  vst3_u8 (dst, bytes);
+  return TRUE;
+}
+#endif
+
+/* Decode a group of four characters, if all of them are in the alphabet */
+static inline gboolean
+gst_ttml_base64_decode_group (const gchar *src, guint8 *dst)
+{
+  guint r0 = gst_ttml_base64_rank[(guchar) src[0]];
+  guint r1 = gst_ttml_base64_rank[(guchar) src[1]];
+  guint r2 = gst_ttml_base64_rank[(guchar) src[2]];
+  guint r3 = gst_ttml_base64_rank[(guchar) src[3]];
+  guint32 group;
+
+  /* Padding and invalid characters both have the bit 6 set */
+  if ((r0 | r1 | r2 | r3) & GST_TTML_BASE64_PADDING)
+    return FALSE;
+
+  group = r0 << 18 | r1 << 12 | r2 << 6 | r3;
+  dst[0] = group >> 16;
+  dst[1] = group >> 8;
+  dst[2] = group;
+  return TRUE;
+}
+
+/* Decode base64 text, which can be split anywhere, after what has already
+ * been decoded. Plain runs are decoded a block or a group at a time, and
+ * only the groups around whitespace and padding a character at a time. */
+void
+gst_ttml_base64_append (GstTTMLBase64 *b64, const gchar *src, gsize len)
+{
+  const gchar *end = src + len;
+  guint32 group = b64->group;
+  guint sextets = b64->sextets;
+  guint padding = b64->padding;
+  /* Each group of four sextets gives at most three bytes */
+  gsize needed = b64->len + (sextets + len) / 4 * 3;
+#if defined(GST_TTML_BASE64_BLOCK)
+  const gchar *retry = src;
+#endif
+  guint8 *dst;
+
+  if (needed > b64->size) {
+    b64->size = MAX (b64->size * 2, needed);
+    b64->data = g_realloc (b64->data, b64->size);
+  }
+
+  dst = b64->data + b64->len;
+  while (src < end) {
+    guint rank;
+
+    if (!sextets) {
+#if defined(GST_TTML_BASE64_BLOCK)
+      /* After a block which could not be decoded, go on by groups up to
+       * its end */
+      if (src >= retry) {
+        while (end - src >= GST_TTML_BASE64_BLOCK &&
+            gst_ttml_base64_decode_block (src, dst)) {
+          src += GST_TTML_BASE64_BLOCK;
+          dst += GST_TTML_BASE64_BLOCK / 4 * 3;
+        }
+        retry = src + GST_TTML_BASE64_BLOCK;
+        continue;
+      }
+#endif
+      if (end - src >= 4 && gst_ttml_base64_decode_group (src, dst)) {
+        src += 4;
+        dst += 3;
+        continue;
+      }
+    }
+
+    rank = gst_ttml_base64_rank[(guchar) *src++];
+    if (rank == GST_TTML_BASE64_INVALID)
+      continue;
+    padding = (padding << 1 | (rank == GST_TTML_BASE64_PADDING)) & 3;
+    if (rank == GST_TTML_BASE64_PADDING)
+      rank = 0;
+
+    group = group << 6 | rank;
+    if (++sextets == 4) {
+      /* Like g_base64_decode(), drop the bytes ending in padding */
+      *dst++ = group >> 16;
+      if (!(padding & 2))
+        *dst++ = group >> 8;
+      if (!(padding & 1))
+        *dst++ = group;
+      group = sextets = padding = 0;
+    }
+  }
+
+  b64->len = dst - b64->data;
+  b64->group = group;
+  b64->sextets = sextets;
+  b64->padding = padding;
+}
+
+/* Take the decoded data, if any, and leave the decoder empty. A group
+ * left incomplete is dropped. */
+GBytes *
+gst_ttml_base64_steal (GstTTMLBase64 *b64)
+{
+  GBytes *bytes = NULL;
+
+  if (b64->len) {
+    /* Give back the room that was kept for growing */
+    bytes = g_bytes_new_take (g_realloc (b64->data, b64->len), b64->len);
+    b64->data = NULL;
+  }
+
+  gst_ttml_base64_clear (b64);
+  return bytes;
+}
+
+/* Empty the decoder. Its memory is released too, as data nodes are few and
+ * big. */
+void
+gst_ttml_base64_clear (GstTTMLBase64 *b64)
+{
+  g_free (b64->data);
+  b64->data = NULL;
+  b64->size = 0;
+  b64->len = 0;
+  b64->group = 0;
+  b64->sextets = 0;
+  b64->padding = 0;
+}
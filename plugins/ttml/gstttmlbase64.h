@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_BASE64_H__
+#define __GST_TTML_BASE64_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+/* Decoder of the base64 character data of embedded data nodes, fed as the
+ * characters arrive, so the encoded text is never stored */
+struct _GstTTMLBase64
+{
+  guint8 *data;
+  gsize size;
+  gsize len;
+  gboolean enable;
+  /* Sextets of the group still incomplete, and which of the last two
+   * were padding */
+  guint32 group;
+  guint sextets;
+  guint padding;
+};
+
+void gst_ttml_base64_append (
+    GstTTMLBase64 *b64, const gchar *src, gsize len);
+
+GBytes *gst_ttml_base64_steal (GstTTMLBase64 *b64);
+
+void gst_ttml_base64_clear (GstTTMLBase64 *b64);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_BASE64_H__ */
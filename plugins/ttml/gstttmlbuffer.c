@@ -0,0 +1,341 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlbuffer.h"
+#include <string.h>
+
+/* GST_TTML_BUFFER_DISABLE_SIMD selects the scalar code on any target, which
+ * the tests use to check both versions */
+#if defined(GST_TTML_BUFFER_DISABLE_SIMD)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GST_TTML_BUFFER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GST_TTML_BUFFER_NEON
+#endif
+
+#if defined(GST_TTML_BUFFER_SSE2) || defined(GST_TTML_BUFFER_NEON)
+#define GST_TTML_BUFFER_SIMD
+#endif
+
+/* We dynamically allocate and reallocate a buffer for sax chars accumulation,
+ * minimizing reallocations.
+ * This is the minimum free size in the buffer before we reallocate more */
+#define TTML_SAX_BUFFER_MIN_FREE_SIZE 0x10
+#define TTML_SAX_BUFFER_GROW_SIZE 0x400
+
+/* check for white space as required for TTML & UTF-8 */
+#define is_whitespace(c) ((guchar) (c) <= 0x20)
+
+/* States of the UTF-8 validation, named after the bytes still expected.
+ * The accepted sequences are those of g_utf8_validate(). */
+enum
+{
+  GST_TTML_BUFFER_UTF8_ACCEPT,
+  GST_TTML_BUFFER_UTF8_REJECT,
+  /* 80..BF left */
+  GST_TTML_BUFFER_UTF8_TAIL_1,
+  GST_TTML_BUFFER_UTF8_TAIL_2,
+  GST_TTML_BUFFER_UTF8_TAIL_3,
+  /* Second byte after E0 (no overlongs), ED (no surrogates), F0 (no
+   * overlongs) and F4 (nothing above U+10FFFF) */
+  GST_TTML_BUFFER_UTF8_E0,
+  GST_TTML_BUFFER_UTF8_ED,
+  GST_TTML_BUFFER_UTF8_F0,
+  GST_TTML_BUFFER_UTF8_F4
+};
+
+/* Classes of bytes for the validation: ASCII, the ranges of continuation
+ * bytes which matter, the lead bytes and the bytes never valid, NUL
+ * included */
+static const guint8 gst_ttml_buffer_utf8_class[256] = {
+  11,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+   3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+   3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+  11, 11,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+   4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+   5,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  7,  6,  6,
+   8,  9,  9,  9, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11
+};
+
+#define A GST_TTML_BUFFER_UTF8_ACCEPT
+#define R GST_TTML_BUFFER_UTF8_REJECT
+#define T1 GST_TTML_BUFFER_UTF8_TAIL_1
+#define T2 GST_TTML_BUFFER_UTF8_TAIL_2
+#define T3 GST_TTML_BUFFER_UTF8_TAIL_3
+
+/* Next state, for each state and class */
+static const guint8 gst_ttml_buffer_utf8_next[9][12] = {
+  /* ASCII 80 90 A0 C2..DF E0 E1..EF ED F0 F1..F3 F4 invalid */
+  { A, R, R, R, T1, GST_TTML_BUFFER_UTF8_E0, T2, GST_TTML_BUFFER_UTF8_ED,
+      GST_TTML_BUFFER_UTF8_F0, T3, GST_TTML_BUFFER_UTF8_F4, R },
+  { R, R, R, R, R, R, R, R, R, R, R, R },
+  { R, A, A, A, R, R, R, R, R, R, R, R },
+  { R, T1, T1, T1, R, R, R, R, R, R, R, R },
+  { R, T2, T2, T2, R, R, R, R, R, R, R, R },
+  /* E0, ED, F0, F4 */
+  { R, R, R, T1, R, R, R, R, R, R, R, R },
+  { R, T1, T1, R, R, R, R, R, R, R, R, R },
+  { R, R, T2, T2, R, R, R, R, R, R, R, R },
+  { R, T2, R, R, R, R, R, R, R, R, R, R }
+};
+
+#undef A
+#undef R
+#undef T1
+#undef T2
+#undef T3
+
+#if defined(GST_TTML_BUFFER_SIMD)
+static guint
+gst_ttml_buffer_utf8_validate (guint state, const gchar *data, gsize len)
+{
+  const guchar *p = (const guchar *) data;
+  const guchar *end = p + len;
+
+  while (p < end && state != GST_TTML_BUFFER_UTF8_REJECT) {
+    /* ASCII and the complete 2 and 3-byte sequences with no special
+     * cases, the usual in captions, without going through the states */
+    if (state == GST_TTML_BUFFER_UTF8_ACCEPT) {
+      if (*p && *p < 0x80) {
+        p++;
+        continue;
+      }
+      if (*p >= 0xc2 && *p <= 0xdf && end - p >= 2 &&
+          (p[1] & 0xc0) == 0x80) {
+        p += 2;
+        continue;
+      }
+      if (*p >= 0xe1 && *p <= 0xef && *p != 0xed && end - p >= 3 &&
+          (p[1] & 0xc0) == 0x80 && (p[2] & 0xc0) == 0x80) {
+        p += 3;
+        continue;
+      }
+    }
+    state = gst_ttml_buffer_utf8_next[state][gst_ttml_buffer_utf8_class[*p++]];
+  }
+  return state;
+}
+
+/* Index of the lowest bit set in the mask, which must not be 0 */
+static inline guint
+gst_ttml_buffer_lowest_bit (guint32 mask)
+{
+#if defined(__GNUC__)
+  return (guint) __builtin_ctz (mask);
+#else
+  guint bit = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+#if defined(GST_TTML_BUFFER_NEON)
+/* One bit per byte set in 'bytes', as _mm_movemask_epi8() */
+static inline guint32
+gst_ttml_buffer_neon_mask (uint8x16_t bytes)
+{
+  static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4,
+    8, 16, 32, 64, 128 };
+  uint8x16_t bits = vandq_u8 (bytes, vld1q_u8 (weights));
+
+  return vaddv_u8 (vget_low_u8 (bits)) |
+         ((guint32) vaddv_u8 (vget_high_u8 (bits)) << 8);
+}
+#endif
+
+/* Copy 'n' bytes, 16 at most. When the input allows it, 16 bytes are
+ * copied, which is a single load and store. The buffer always has the
+ * room for them: whitespace collapsing only inserts one byte per call, and
+ * it keeps TTML_SAX_BUFFER_MIN_FREE_SIZE more. */
+static inline void
+gst_ttml_buffer_copy (gchar *dst, const gchar *src, gsize n, const gchar *end)
+{
+  if (end - src >= 16)
+    memcpy (dst, src, 16);
+  else
+    memcpy (dst, src, n);
+}
+
+/* Classify the next 'n' bytes (16 at most). Returns the mask of the
+ * whitespace to collapse, and sets 'utf8' to the mask of the bytes the
+ * UTF-8 validation has to look at: those of sequences and, when
+ * whitespace is preserved, NUL. */
+static inline guint32
+gst_ttml_buffer_classify (
+    const gchar *p, gsize n, gboolean collapse, guint32 *utf8)
+{
+  guint32 spaces = 0;
+  gsize i;
+
+  *utf8 = 0;
+  if (n == 16) {
+#if defined(GST_TTML_BUFFER_SSE2)
+    __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+
+    *utf8 = (guint32) _mm_movemask_epi8 (v);
+    if (collapse) {
+      /* Unsigned v <= 0x20 */
+      return (guint32) _mm_movemask_epi8 (
+          _mm_cmpeq_epi8 (_mm_min_epu8 (v, _mm_set1_epi8 (0x20)), v));
+    }
+    *utf8 |= (guint32) _mm_movemask_epi8 (
+        _mm_cmpeq_epi8 (v, _mm_setzero_si128 ()));
+    return 0;
+#elif defined(GST_TTML_BUFFER_NEON)
+    uint8x16_t v = vld1q_u8 ((const uint8_t *) p);
+
+    *utf8 = gst_ttml_buffer_neon_mask (vcgeq_u8 (v, vdupq_n_u8 (0x80)));
+    if (collapse)
+      return gst_ttml_buffer_neon_mask (vcleq_u8 (v, vdupq_n_u8 (0x20)));
+    *utf8 |= gst_ttml_buffer_neon_mask (vceqq_u8 (v, vdupq_n_u8 (0)));
+    return 0;
+#endif
+  }
+
+  for (i = 0; i < n; i++) {
+    guchar c = (guchar) p[i];
+
+    if (c >= 0x80 || (!collapse && !c))
+      *utf8 |= 1u << i;
+    else if (collapse && is_whitespace (c))
+      spaces |= 1u << i;
+  }
+  return spaces;
+}
+#endif
+
+/* Append character data to the buffer, collapsing whitespace unless it has
+ * to be preserved, and validating the UTF-8 of what is appended, in one
+ * pass. With SIMD, the input is classified 16 bytes at a time, the runs
+ * between whitespace are copied as they are, and only their non-ASCII
+ * bytes go through the validation. */
+void
+gst_ttml_buffer_append (GstTTMLBuffer *buf, const gchar *src, gsize len)
+{
+  const gchar *end = src + len;
+  gboolean collapse = !buf->preserve_whitespace;
+  guint state = buf->utf8_state;
+  gboolean collapsing = buf->collapsing;
+  gboolean line_has_chars = buf->line_has_chars;
+  gsize tlen;
+  gchar *dst;
+
+  /* allocate or reallocate buffer if needed */
+  tlen = buf->len + len;
+  if (tlen + TTML_SAX_BUFFER_MIN_FREE_SIZE >= buf->size) {
+    gsize size = tlen + TTML_SAX_BUFFER_GROW_SIZE;
+    if (!buf->size) {
+      buf->data = g_malloc (size);
+    } else {
+      buf->data = g_realloc (buf->data, size);
+    }
+    buf->size = size;
+  }
+
+  dst = buf->data + buf->len;
+#if defined(GST_TTML_BUFFER_SIMD)
+  while (src < end) {
+    gsize n = MIN ((gsize) (end - src), 16);
+    guint32 utf8;
+    /* Both with a sentinel bit after the block */
+    guint32 spaces = gst_ttml_buffer_classify (src, n, collapse, &utf8);
+    guint32 solid = ~spaces | (1u << n);
+    guint p = 0;
+
+    spaces |= 1u << n;
+    for (;;) {
+      guint q = gst_ttml_buffer_lowest_bit (spaces & (~0u << p));
+
+      if (q > p) {
+        guint32 run = utf8 & (~0u << p) & ((1u << q) - 1);
+
+        if (collapse) {
+          if (collapsing && line_has_chars && buf->insert_space) {
+            *dst++ = ' ';
+            state = gst_ttml_buffer_utf8_next[state][0];
+          }
+          collapsing = FALSE;
+          line_has_chars = TRUE;
+        }
+        gst_ttml_buffer_copy (dst, src + p, q - p, end);
+        dst += q - p;
+
+        /* Plain ASCII is only checked in the middle of a sequence */
+        if (state != GST_TTML_BUFFER_UTF8_ACCEPT)
+          state = gst_ttml_buffer_utf8_validate (state, src + p, q - p);
+        else if (run)
+          state = gst_ttml_buffer_utf8_validate (state,
+              src + gst_ttml_buffer_lowest_bit (run),
+              q - gst_ttml_buffer_lowest_bit (run));
+      }
+      if (q == n)
+        break;
+
+      /* Skip the whole run of whitespace */
+      collapsing = TRUE;
+      p = gst_ttml_buffer_lowest_bit (solid & (~0u << q));
+    }
+    src += n;
+  }
+#else
+  for (; src < end; src++) {
+    guchar c = (guchar) *src;
+
+    if (collapse) {
+      if (is_whitespace (c)) {
+        collapsing = TRUE;
+        continue;
+      }
+      if (collapsing && line_has_chars && buf->insert_space) {
+        *dst++ = ' ';
+        state = gst_ttml_buffer_utf8_next[state][0];
+      }
+      collapsing = FALSE;
+      line_has_chars = TRUE;
+    }
+    *dst++ = c;
+    if (c >= 0x80 || !c || state != GST_TTML_BUFFER_UTF8_ACCEPT)
+      state = gst_ttml_buffer_utf8_next[state][gst_ttml_buffer_utf8_class[c]];
+  }
+#endif
+
+  buf->len = dst - buf->data;
+  buf->utf8_state = state;
+  buf->collapsing = collapsing;
+  buf->line_has_chars = line_has_chars;
+}
+
+/* Empty the buffer */
+void
+gst_ttml_buffer_clear (GstTTMLBuffer *buf)
+{
+  buf->len = 0;
+  buf->utf8_state = GST_TTML_BUFFER_UTF8_ACCEPT;
+}
+
+/* Whether the content of the buffer is valid UTF-8 */
+gboolean
+gst_ttml_buffer_is_valid (const GstTTMLBuffer *buf)
+{
+  return buf->utf8_state == GST_TTML_BUFFER_UTF8_ACCEPT;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_BUFFER_H__
+#define __GST_TTML_BUFFER_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+/* Accumulator of the character data of the current span, with its
+ * whitespace already handled */
+struct _GstTTMLBuffer
+{
+  gchar *data;
+  gsize size;
+  gsize len;
+  gboolean enable;
+  gboolean preserve_whitespace;
+  gboolean insert_space;
+  gboolean collapsing;
+  gboolean line_has_chars;
+  /* Validation of the UTF-8 of 'data', which might have stopped in the
+   * middle of a sequence */
+  guint utf8_state;
+};
+
+void gst_ttml_buffer_append (
+    GstTTMLBuffer *buffer, const gchar *data, gsize len);
+
+void gst_ttml_buffer_clear (GstTTMLBuffer *buffer);
+
+gboolean gst_ttml_buffer_is_valid (const GstTTMLBuffer *buffer);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_BUFFER_H__ */
@@ -0,0 +1,300 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlcache.h"
+#include "gstttmlnamespace.h"
+#include "gstttmlspan.h"
+#include "gstttmlstate.h"
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+GstTTMLCache *
+gst_ttml_cache_new (void)
+{
+  GstTTMLCache *cache = g_new0 (GstTTMLCache, 1);
+
+  cache->events =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_ttml_event_free);
+  cache->times = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  cache->checkpoints =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+  cache->live = g_array_new (FALSE, FALSE, sizeof (guint));
+  return cache;
+}
+
+void
+gst_ttml_cache_free (GstTTMLCache *cache)
+{
+  if (!cache)
+    return;
+
+  g_free (cache->uri);
+  g_ptr_array_unref (cache->events);
+  g_array_unref (cache->times);
+  g_ptr_array_unref (cache->checkpoints);
+  g_array_unref (cache->live);
+  if (cache->saved_data)
+    g_hash_table_unref (cache->saved_data);
+  if (cache->saved_styling_attr_stacks)
+    g_hash_table_unref (cache->saved_styling_attr_stacks);
+  g_list_free_full (
+      cache->namespaces, (GDestroyNotify) gst_ttml_namespace_free);
+  g_free (cache);
+}
+
+/* Whether a live event belongs to the given span id or region id, and, if
+ * 'attr_type' is not UNKNOWN, whether it is an update of that attribute */
+static gboolean
+gst_ttml_cache_event_targets (const GstTTMLEvent *event, guint span_id,
+    const gchar *region_id, GstTTMLAttributeType attr_type)
+{
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      return !region_id && attr_type == GST_TTML_ATTR_UNKNOWN &&
+             event->data.span_begin.span->id == span_id;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      return !region_id && event->data.attr_update.id == span_id &&
+             (attr_type == GST_TTML_ATTR_UNKNOWN ||
+                 event->data.attr_update.attr->type == attr_type);
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      return region_id && attr_type == GST_TTML_ATTR_UNKNOWN &&
+             g_strcmp0 (event->data.region_begin.id, region_id) == 0;
+    case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
+      return region_id &&
+             g_strcmp0 (event->data.region_update.id, region_id) == 0 &&
+             (attr_type == GST_TTML_ATTR_UNKNOWN ||
+                 event->data.region_update.attr->type == attr_type);
+    default:
+      return FALSE;
+  }
+}
+
+/* Remove from the live set the events targeting a span or region. Returns
+ * whether any was found. */
+static gboolean
+gst_ttml_cache_live_remove (GstTTMLCache *cache, guint span_id,
+    const gchar *region_id, GstTTMLAttributeType attr_type)
+{
+  guint i = 0, n = 0;
+
+  for (i = 0; i < cache->live->len; i++) {
+    guint index = g_array_index (cache->live, guint, i);
+    const GstTTMLEvent *event = g_ptr_array_index (cache->events, index);
+
+    if (!gst_ttml_cache_event_targets (event, span_id, region_id, attr_type))
+      g_array_index (cache->live, guint, n++) = index;
+  }
+  if (n == cache->live->len)
+    return FALSE;
+
+  g_array_set_size (cache->live, n);
+  return TRUE;
+}
+
+/* Whether the span or region is live, i.e., it began and did not end yet */
+static gboolean
+gst_ttml_cache_live_find (
+    GstTTMLCache *cache, guint span_id, const gchar *region_id)
+{
+  guint i;
+
+  for (i = 0; i < cache->live->len; i++) {
+    const GstTTMLEvent *event = g_ptr_array_index (
+        cache->events, g_array_index (cache->live, guint, i));
+
+    if (gst_ttml_cache_event_targets (
+            event, span_id, region_id, GST_TTML_ATTR_UNKNOWN))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* Update the live set with the event which is about to be stored at 'index' */
+static void
+gst_ttml_cache_live_update (
+    GstTTMLCache *cache, const GstTTMLEvent *event, guint index)
+{
+  gboolean live = FALSE;
+
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      live = event->data.span_begin.span != NULL;
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_END:
+      gst_ttml_cache_live_remove (
+          cache, event->data.span_end.id, NULL, GST_TTML_ATTR_UNKNOWN);
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      /* Updates of spans which are not active are ignored when executed */
+      live =
+          gst_ttml_cache_live_find (cache, event->data.attr_update.id, NULL);
+      if (live)
+        gst_ttml_cache_live_remove (cache, event->data.attr_update.id, NULL,
+            event->data.attr_update.attr->type);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      /* A region with the same id is replaced. Regions are always
+       * identified, so NULL ids can be used to mean spans above. */
+      if (!event->data.region_begin.id)
+        break;
+      gst_ttml_cache_live_remove (
+          cache, 0, event->data.region_begin.id, GST_TTML_ATTR_UNKNOWN);
+      live = TRUE;
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_END:
+      if (event->data.region_end.id)
+        gst_ttml_cache_live_remove (
+            cache, 0, event->data.region_end.id, GST_TTML_ATTR_UNKNOWN);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
+      if (!event->data.region_update.id)
+        break;
+      live = gst_ttml_cache_live_find (cache, 0, event->data.region_update.id);
+      if (live)
+        gst_ttml_cache_live_remove (cache, 0, event->data.region_update.id,
+            event->data.region_update.attr->type);
+      break;
+    default:
+      break;
+  }
+
+  if (live)
+    g_array_append_val (cache->live, index);
+}
+
+/* Store a copy of an event which is about to be executed */
+void
+gst_ttml_cache_add_event (GstTTMLCache *cache, const GstTTMLEvent *event)
+{
+  guint index = cache->events->len;
+  GstClockTime time = event->timestamp;
+
+  if (index % GST_TTML_CACHE_CHECKPOINT_INTERVAL == 0) {
+    GArray *checkpoint =
+        g_array_sized_new (FALSE, FALSE, sizeof (guint), cache->live->len);
+
+    g_array_append_vals (checkpoint, cache->live->data, cache->live->len);
+    g_ptr_array_add (cache->checkpoints, checkpoint);
+  }
+
+  /* Late events take effect as soon as they are executed */
+  if (index > 0)
+    time = MAX (time, g_array_index (cache->times, GstClockTime, index - 1));
+
+  g_ptr_array_add (cache->events, gst_ttml_event_copy (event));
+  g_array_append_val (cache->times, time);
+  gst_ttml_cache_live_update (cache, event, index);
+}
+
+/* Mark the document as completely parsed, keeping what is needed to play it
+ * again besides the events */
+void
+gst_ttml_cache_complete (GstTTMLCache *cache, const gchar *uri,
+    const GstTTMLState *state, GList *namespaces)
+{
+  GList *link;
+
+  cache->uri = g_strdup (uri);
+  if (state->saved_data)
+    cache->saved_data = g_hash_table_ref (state->saved_data);
+  if (state->saved_styling_attr_stacks)
+    cache->saved_styling_attr_stacks =
+        g_hash_table_ref (state->saved_styling_attr_stacks);
+  for (link = namespaces; link; link = link->next) {
+    GstTTMLNamespace *ns = link->data;
+    cache->namespaces = g_list_prepend (
+        cache->namespaces, gst_ttml_namespace_new (ns->name, ns->value));
+  }
+  cache->namespaces = g_list_reverse (cache->namespaces);
+  cache->complete = TRUE;
+
+  GST_DEBUG ("Cached %u events of '%s' (%u checkpoints)", cache->events->len,
+      uri, cache->checkpoints->len);
+}
+
+/* Whether the cache holds the complete document at the given URI */
+gboolean
+gst_ttml_cache_is_valid (const GstTTMLCache *cache, const gchar *uri)
+{
+  return cache && cache->complete && uri && g_str_equal (cache->uri, uri);
+}
+
+/* Put back into a reset state the parsing results which are not part of the
+ * events */
+void
+gst_ttml_cache_restore (
+    const GstTTMLCache *cache, GstTTMLState *state, GList **namespaces)
+{
+  GList *link;
+
+  if (cache->saved_data && !state->saved_data)
+    state->saved_data = g_hash_table_ref (cache->saved_data);
+  if (cache->saved_styling_attr_stacks && !state->saved_styling_attr_stacks)
+    state->saved_styling_attr_stacks =
+        g_hash_table_ref (cache->saved_styling_attr_stacks);
+  for (link = g_list_last (cache->namespaces); link; link = link->prev) {
+    GstTTMLNamespace *ns = link->data;
+    *namespaces = g_list_prepend (
+        *namespaces, gst_ttml_namespace_new (ns->name, ns->value));
+  }
+}
+
+/* Execute, through 'func', copies of the events needed to reach the state
+ * the document has at the given time. Returns the index of the first event
+ * which takes effect after it. */
+guint
+gst_ttml_cache_seek (const GstTTMLCache *cache, GstClockTime time,
+    GstTTMLCacheEventFunc func, void *userdata)
+{
+  const GArray *checkpoint;
+  guint low = 0, high = cache->times->len, start, i;
+
+  if (!high)
+    return 0;
+
+  /* First event after 'time' */
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    if (g_array_index (cache->times, GstClockTime, mid) <= time)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  i = MIN (low / GST_TTML_CACHE_CHECKPOINT_INTERVAL,
+      cache->checkpoints->len - 1);
+  checkpoint = g_ptr_array_index (cache->checkpoints, i);
+  start = i * GST_TTML_CACHE_CHECKPOINT_INTERVAL;
+  GST_DEBUG ("Seeking to %" GST_TIME_FORMAT ": event %u, from checkpoint at "
+             "%u with %u live events",
+      GST_TIME_ARGS (time), low, start, checkpoint->len);
+
+  for (i = 0; i < checkpoint->len; i++)
+    func (gst_ttml_cache_get_event (
+              cache, g_array_index (checkpoint, guint, i)),
+        userdata);
+  for (i = start; i < low; i++)
+    func (gst_ttml_cache_get_event (cache, i), userdata);
+
+  return low;
+}
+
+guint
+gst_ttml_cache_get_length (const GstTTMLCache *cache)
+{
+  return cache->events->len;
+}
+
+/* Returns a copy of the event at the given index. Free after use. */
+GstTTMLEvent *
+gst_ttml_cache_get_event (const GstTTMLCache *cache, guint index)
+{
+  return gst_ttml_event_copy (g_ptr_array_index (cache->events, index));
+}
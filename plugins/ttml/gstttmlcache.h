@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_CACHE_H__
+#define __GST_TTML_CACHE_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+#include "gstttmlevent.h"
+
+G_BEGIN_DECLS
+
+/* A snapshot of the live events is stored every this many events */
+#define GST_TTML_CACHE_CHECKPOINT_INTERVAL 32
+
+/* The events of a fully parsed document, in the order they were executed,
+ * so it can be played again from any time without parsing it again.
+ * Besides the events, it keeps a time index: every few events, the list of
+ * "live" events, i.e., the ones whose effect is still visible at that point
+ * (BEGINs of active spans and regions, and the attribute updates applied to
+ * them). Restoring the state at any time then costs a binary search plus
+ * executing a bounded number of events. */
+struct _GstTTMLCache
+{
+  gchar *uri;
+  gboolean complete;
+
+  GPtrArray *events;
+  /* Time at which each event took effect. Never decreasing. */
+  GArray *times;
+  /* Arrays of live event indexes, one every CHECKPOINT_INTERVAL events */
+  GPtrArray *checkpoints;
+  /* Live event indexes after the last event, while recording */
+  GArray *live;
+
+  /* Parsing results which are not part of the events */
+  GHashTable *saved_data;
+  GHashTable *saved_styling_attr_stacks;
+  GList *namespaces;
+};
+
+typedef void (*GstTTMLCacheEventFunc) (GstTTMLEvent *event, void *userdata);
+
+GstTTMLCache *gst_ttml_cache_new (void);
+
+void gst_ttml_cache_free (GstTTMLCache *cache);
+
+void gst_ttml_cache_add_event (GstTTMLCache *cache, const GstTTMLEvent *event);
+
+void gst_ttml_cache_complete (GstTTMLCache *cache, const gchar *uri,
+    const GstTTMLState *state, GList *namespaces);
+
+gboolean gst_ttml_cache_is_valid (const GstTTMLCache *cache, const gchar *uri);
+
+void gst_ttml_cache_restore (
+    const GstTTMLCache *cache, GstTTMLState *state, GList **namespaces);
+
+guint gst_ttml_cache_seek (const GstTTMLCache *cache, GstClockTime time,
+    GstTTMLCacheEventFunc func, void *userdata);
+
+guint gst_ttml_cache_get_length (const GstTTMLCache *cache);
+
+GstTTMLEvent *gst_ttml_cache_get_event (
+    const GstTTMLCache *cache, guint index);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_CACHE_H__ */
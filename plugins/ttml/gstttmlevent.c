@@ -7,11 +7,10 @@
 #include "config.h"
 #endif
 
+#include "gstttmlarena.h"
 #include "gstttmlspan.h"
 #include "gstttmlevent.h"
 #include "gstttmlstate.h"
-#include "gstttmlutils.h"
-#include "gstttmlbase.h"
 
 GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
 #define GST_CAT_DEFAULT ttmlbase_debug
@@ -21,6 +20,8 @@ GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
 void
 gst_ttml_event_free (GstTTMLEvent *event)
 {
+  GstTTMLArena *arena = event->arena;
+
   switch (event->type) {
     case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
       if (event->data.span_begin.span)
@@ -31,47 +32,122 @@ gst_ttml_event_free (GstTTMLEvent *event)
         gst_ttml_attribute_free (event->data.attr_update.attr);
       break;
     case GST_TTML_EVENT_TYPE_REGION_BEGIN:
-      g_free (event->data.region_end.id);
+      gst_ttml_arena_strfree (arena, event->data.region_begin.id);
       gst_ttml_style_reset (&event->data.region_begin.style);
       break;
     case GST_TTML_EVENT_TYPE_REGION_END:
-      g_free (event->data.region_end.id);
+      gst_ttml_arena_strfree (arena, event->data.region_end.id);
       break;
     case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
-      g_free (event->data.region_end.id);
+      gst_ttml_arena_strfree (arena, event->data.region_update.id);
       gst_ttml_attribute_free (event->data.region_update.attr);
       break;
     default:
       break;
   }
-  g_free (event);
+  gst_ttml_arena_free (arena, event, sizeof (GstTTMLEvent));
 }
 
-/* Comparison function for events, using their timestamps */
-static gint
-gst_ttml_event_compare (GstTTMLEvent *a, GstTTMLEvent *b)
+/* Create a heap copy of an event, including the data it owns */
+GstTTMLEvent *
+gst_ttml_event_copy (const GstTTMLEvent *event)
 {
-  if (a->timestamp != b->timestamp)
-    return a->timestamp > b->timestamp ? 1 : -1;
+  GstTTMLEvent *copy = g_memdup (event, sizeof (GstTTMLEvent));
 
-  /* Special cases: We want REGIONS to enclose SPANS, even though their
-   * timestamps might be the same. */
-  if (a->type == GST_TTML_EVENT_TYPE_REGION_BEGIN)
-    return -1;
-  if (a->type == GST_TTML_EVENT_TYPE_REGION_END)
-    return 1;
-  if (b->type == GST_TTML_EVENT_TYPE_REGION_BEGIN)
-    return 1;
-  if (b->type == GST_TTML_EVENT_TYPE_REGION_END)
-    return -1;
-  return 0;
+  copy->arena = NULL;
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      if (event->data.span_begin.span)
+        copy->data.span_begin.span =
+            gst_ttml_span_copy (event->data.span_begin.span);
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      if (event->data.attr_update.attr)
+        copy->data.attr_update.attr = gst_ttml_attribute_copy (
+            NULL, event->data.attr_update.attr, FALSE);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      copy->data.region_begin.id = g_strdup (event->data.region_begin.id);
+      gst_ttml_style_init (&copy->data.region_begin.style);
+      gst_ttml_style_copy (&copy->data.region_begin.style,
+          &event->data.region_begin.style, FALSE);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_END:
+      copy->data.region_end.id = g_strdup (event->data.region_end.id);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
+      copy->data.region_update.id = g_strdup (event->data.region_update.id);
+      copy->data.region_update.attr = gst_ttml_attribute_copy (
+          NULL, event->data.region_update.attr, FALSE);
+      break;
+    default:
+      break;
+  }
+  return copy;
+}
+
+/* Create a heap copy of an event allocated from an arena, including the data
+ * it owns, so it outlives the arena, and free the original. Heap events are
+ * returned unchanged. */
+GstTTMLEvent *
+gst_ttml_event_promote (GstTTMLEvent *event)
+{
+  GstTTMLEvent *promoted;
+
+  if (!event->arena)
+    return event;
+
+  promoted = g_memdup (event, sizeof (GstTTMLEvent));
+  promoted->arena = NULL;
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      promoted->data.span_begin.span =
+          gst_ttml_span_promote (event->data.span_begin.span);
+      event->data.span_begin.span = NULL;
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      promoted->data.attr_update.attr =
+          gst_ttml_attribute_promote (event->data.attr_update.attr);
+      event->data.attr_update.attr = NULL;
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      /* The style already lives on the heap, it is moved */
+      promoted->data.region_begin.id = g_strdup (event->data.region_begin.id);
+      gst_ttml_style_init (&event->data.region_begin.style);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_END:
+      promoted->data.region_end.id = g_strdup (event->data.region_end.id);
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
+      promoted->data.region_update.id =
+          g_strdup (event->data.region_update.id);
+      promoted->data.region_update.attr =
+          gst_ttml_attribute_promote (event->data.region_update.attr);
+      event->data.region_update.attr = NULL;
+      break;
+    default:
+      break;
+  }
+  gst_ttml_event_free (event);
+  return promoted;
+}
+
+/* Allocate an empty event from the given arena, or from the heap if it is
+ * NULL */
+static GstTTMLEvent *
+gst_ttml_event_new (GstTTMLArena *arena)
+{
+  GstTTMLEvent *event = gst_ttml_arena_alloc (arena, sizeof (GstTTMLEvent));
+  event->arena = arena;
+  return event;
 }
 
 /* Creates a new SPAN BEGIN event */
 GstTTMLEvent *
-gst_ttml_event_new_span_begin (GstTTMLState *state, GstTTMLSpan *span)
+gst_ttml_event_new_span_begin (
+    GstTTMLArena *arena, GstTTMLState *state, GstTTMLSpan *span)
 {
-  GstTTMLEvent *event = g_new0 (GstTTMLEvent, 1);
+  GstTTMLEvent *event = gst_ttml_event_new (arena);
   if (GST_CLOCK_TIME_IS_VALID (state->begin))
     event->timestamp = state->begin;
   else
@@ -83,9 +159,10 @@ gst_ttml_event_new_span_begin (GstTTMLState *state, GstTTMLSpan *span)
 
 /* Creates a new SPAN END event */
 GstTTMLEvent *
-gst_ttml_event_new_span_end (GstTTMLState *state, guint id)
+gst_ttml_event_new_span_end (
+    GstTTMLArena *arena, GstTTMLState *state, guint id)
 {
-  GstTTMLEvent *event = g_new0 (GstTTMLEvent, 1);
+  GstTTMLEvent *event = gst_ttml_event_new (arena);
   /* Substracting one nanosecond is a cheap way of making intervals
    * open on the right */
   if (GST_CLOCK_TIME_IS_VALID (state->end))
@@ -99,38 +176,40 @@ gst_ttml_event_new_span_end (GstTTMLState *state, guint id)
 
 /* Creates a new ATTRIBUTE UPDATE event */
 GstTTMLEvent *
-gst_ttml_event_new_attr_update (
-    guint id, GstClockTime timestamp, GstTTMLAttribute *attr)
+gst_ttml_event_new_attr_update (GstTTMLArena *arena, guint id,
+    GstClockTime timestamp, GstTTMLAttribute *attr)
 {
-  GstTTMLEvent *event = g_new0 (GstTTMLEvent, 1);
+  GstTTMLEvent *event = gst_ttml_event_new (arena);
   event->timestamp = timestamp;
   event->type = GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE;
   event->data.attr_update.id = id;
-  event->data.attr_update.attr = gst_ttml_attribute_copy (attr, FALSE);
+  event->data.attr_update.attr = gst_ttml_attribute_copy (arena, attr, FALSE);
   return event;
 }
 
-/* Creates a new REGION BEGIN event */
+/* Creates a new REGION BEGIN event. The style is always copied to the heap,
+ * because it is later moved to the hash of regions. */
 GstTTMLEvent *
-gst_ttml_event_new_region_begin (
-    GstClockTime timestamp, const gchar *id, GstTTMLStyle *style)
+gst_ttml_event_new_region_begin (GstTTMLArena *arena, GstClockTime timestamp,
+    const gchar *id, GstTTMLStyle *style)
 {
   GstTTMLEvent *event;
 
   if (!GST_CLOCK_TIME_IS_VALID (timestamp))
     timestamp = 0;
 
-  event = g_new0 (GstTTMLEvent, 1);
+  event = gst_ttml_event_new (arena);
   event->timestamp = timestamp;
   event->type = GST_TTML_EVENT_TYPE_REGION_BEGIN;
-  event->data.region_begin.id = g_strdup (id);
+  event->data.region_begin.id = gst_ttml_arena_strdup (arena, id);
   gst_ttml_style_copy (&event->data.region_begin.style, style, FALSE);
   return event;
 }
 
 /* Creates a new REGION END event */
 GstTTMLEvent *
-gst_ttml_event_new_region_end (GstClockTime timestamp, const gchar *id)
+gst_ttml_event_new_region_end (
+    GstTTMLArena *arena, GstClockTime timestamp, const gchar *id)
 {
   GstTTMLEvent *event;
 
@@ -139,99 +218,27 @@ gst_ttml_event_new_region_end (GstClockTime timestamp, const gchar *id)
     return NULL;
   }
 
-  event = g_new0 (GstTTMLEvent, 1);
+  event = gst_ttml_event_new (arena);
   event->timestamp = timestamp;
   event->type = GST_TTML_EVENT_TYPE_REGION_END;
-  event->data.region_end.id = g_strdup (id);
+  event->data.region_end.id = gst_ttml_arena_strdup (arena, id);
   return event;
 }
 
 /* Creates a new REGION UPDATE event */
 GstTTMLEvent *
-gst_ttml_event_new_region_update (
+gst_ttml_event_new_region_update (GstTTMLArena *arena,
     GstClockTime timestamp, const gchar *id, GstTTMLAttribute *attr)
 {
-  GstTTMLEvent *event = g_new0 (GstTTMLEvent, 1);
+  GstTTMLEvent *event = gst_ttml_event_new (arena);
   event->timestamp = timestamp;
   event->type = GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE;
-  event->data.region_update.id = g_strdup (id);
-  event->data.region_update.attr = gst_ttml_attribute_copy (attr, FALSE);
+  event->data.region_update.id = gst_ttml_arena_strdup (arena, id);
+  event->data.region_update.attr =
+      gst_ttml_attribute_copy (arena, attr, FALSE);
   return event;
 }
 
-/* Insert an event into an event list (timeline), ordered by timestamp.
- * You lose ownership of the event. */
-GList *
-gst_ttml_event_list_insert (GList *timeline, GstTTMLEvent *event)
-{
-  if (!event)
-    return timeline;
-
-  GST_DEBUG ("Inserting event %s at %" GST_TIME_FORMAT,
-      gst_ttml_event_type_name (event->type),
-      GST_TIME_ARGS (event->timestamp));
-  switch (event->type) {
-    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
-      GST_DEBUG ("  span id %d, %d chars", event->data.span_begin.span->id,
-          event->data.span_begin.span->length);
-      break;
-    case GST_TTML_EVENT_TYPE_SPAN_END:
-      GST_DEBUG ("  span id %d", event->data.span_end.id);
-      break;
-    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
-      GST_DEBUG ("  %s for span id %d",
-          gst_ttml_utils_enum_name (
-              event->data.attr_update.attr->type, AttributeType),
-          event->data.attr_update.id);
-      break;
-    default:
-      break;
-  }
-  return g_list_insert_sorted (
-      timeline, event, (GCompareFunc) gst_ttml_event_compare);
-}
-
-/* Returns the first event in the timeline, i.e., the next one.
- * You are the owner of the returned event. */
-GList *
-gst_ttml_event_list_get_next (GList *timeline, GstTTMLEvent **event)
-{
-  *event = (GstTTMLEvent *) timeline->data;
-  GST_DEBUG ("Removing event %s at %" GST_TIME_FORMAT,
-      gst_ttml_event_type_name ((*event)->type),
-      GST_TIME_ARGS ((*event)->timestamp));
-  return g_list_delete_link (timeline, timeline);
-}
-
-/* Remove all events from the timeline, parse them and generate output
- * buffers */
-GList *
-gst_ttml_event_list_flush (GList *timeline, GstTTMLEventParseFunc parse,
-    GstTTMLEventGenBufferFunc gen_buffer, void *userdata)
-{
-  GstTTMLBase *base = userdata;
-  GstTTMLEvent *event;
-
-  while (timeline) {
-    timeline = gst_ttml_event_list_get_next (timeline, &event);
-
-    if (event->timestamp > base->input_buf_stop)
-      break;
-
-    /* if there's a gap since last buffer out, generate clear buffer */
-    if (event->timestamp > base->last_out_time) {
-      gen_buffer (base->last_out_time, event->timestamp, base);
-    }
-    timeline = parse (event, userdata, timeline);
-  }
-
-  if (base->last_out_time < base->input_buf_stop) {
-    gen_buffer (base->last_out_time, base->input_buf_stop, base);
-  }
-
-  return timeline;
-}
-
 /* Get the string representation of an event type (for debugging) */
 const gchar *
 gst_ttml_event_type_name (GstTTMLEventType type)
@@ -10,6 +10,7 @@
 #include "gstttmlforward.h"
 #include "gstttmlenums.h"
 #include "gstttmlattribute.h"
+#include "gstttmlstyle.h"
 
 G_BEGIN_DECLS
 
@@ -61,40 +62,33 @@ struct _GstTTMLEvent
     GstTTMLEventRegionEnd region_end;
     GstTTMLEventRegionUpdate region_update;
   } data;
+  GstTTMLArena *arena; /* Where it was allocated from, NULL for the heap */
 };
 
-typedef GList *(*GstTTMLEventParseFunc) (
-    GstTTMLEvent *event, void *userdata, GList *timeline);
+void gst_ttml_event_free (GstTTMLEvent *event);
 
-typedef void (*GstTTMLEventGenBufferFunc) (
-    GstClockTime begin, GstClockTime end, void *userdata);
+GstTTMLEvent *gst_ttml_event_copy (const GstTTMLEvent *event);
 
-void gst_ttml_event_free (GstTTMLEvent *event);
+GstTTMLEvent *gst_ttml_event_promote (GstTTMLEvent *event);
 
 GstTTMLEvent *gst_ttml_event_new_span_begin (
-    GstTTMLState *state, GstTTMLSpan *span);
+    GstTTMLArena *arena, GstTTMLState *state, GstTTMLSpan *span);
 
-GstTTMLEvent *gst_ttml_event_new_span_end (GstTTMLState *state, guint id);
+GstTTMLEvent *gst_ttml_event_new_span_end (
+    GstTTMLArena *arena, GstTTMLState *state, guint id);
 
-GstTTMLEvent *gst_ttml_event_new_attr_update (
-    guint id, GstClockTime timestamp, GstTTMLAttribute *attr);
+GstTTMLEvent *gst_ttml_event_new_attr_update (GstTTMLArena *arena, guint id,
+    GstClockTime timestamp, GstTTMLAttribute *attr);
 
-GstTTMLEvent *gst_ttml_event_new_region_begin (
+GstTTMLEvent *gst_ttml_event_new_region_begin (GstTTMLArena *arena,
     GstClockTime timestamp, const gchar *id, GstTTMLStyle *style);
 
 GstTTMLEvent *gst_ttml_event_new_region_end (
-    GstClockTime timestamp, const gchar *id);
+    GstTTMLArena *arena, GstClockTime timestamp, const gchar *id);
 
-GstTTMLEvent *gst_ttml_event_new_region_update (
+GstTTMLEvent *gst_ttml_event_new_region_update (GstTTMLArena *arena,
     GstClockTime timestamp, const gchar *id, GstTTMLAttribute *attr);
 
-GList *gst_ttml_event_list_insert (GList *timeline, GstTTMLEvent *event);
-
-GList *gst_ttml_event_list_get_next (GList *timeline, GstTTMLEvent **event);
-
-GList *gst_ttml_event_list_flush (GList *timeline, GstTTMLEventParseFunc parse,
-    GstTTMLEventGenBufferFunc gen_buffer, void *userdata);
-
 const gchar *gst_ttml_event_type_name (GstTTMLEventType type);
 
 G_END_DECLS
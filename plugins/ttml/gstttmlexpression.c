@@ -0,0 +1,459 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstttmlexpression.h"
+#include "gstttmlattribute.h"
+#include "gstttmlstate.h"
+#include "gstttmlutils.h"
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+#define MAKE_COLOR(r, g, b, a) ((r) << 24 | (g) << 16 | (b) << 8 | (a))
+
+static struct _GstTTMLNamedColor
+{
+  const gchar *name;
+  guint32 color;
+} GstTTMLNamedColors[] = { { "transparent", 0x00000000 },
+  { "black", 0x000000ff }, { "silver", 0xc0c0c0ff }, { "gray", 0x808080ff },
+  { "white", 0xffffffff }, { "maroon", 0x800000ff }, { "red", 0xff0000ff },
+  { "purple", 0x800080ff }, { "fuchsia", 0xff00ffff },
+  { "magenta", 0xff00ffff }, { "green", 0x008000ff }, { "lime", 0x00ff00ff },
+  { "olive", 0x808000ff }, { "yellow", 0xffff00ff }, { "navy", 0x000080ff },
+  { "blue", 0x0000ffff }, { "teal", 0x008080ff }, { "aqua", 0x00ffffff },
+  { "cyan", 0x00ffffff }, { NULL, 0x00000000 } };
+
+/* Powers of ten which are exact doubles */
+static const gdouble gst_ttml_expression_powers_of_ten[] = { 1e0, 1e1, 1e2,
+  1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+/* A decimal number, as mantissa * 10 ^ exponent */
+typedef struct
+{
+  const gchar *start;
+  guint64 mantissa;
+  gint exponent;
+  gboolean negative;
+  gboolean exact; /* FALSE when the mantissa did not fit all the digits */
+} GstTTMLExpressionNumber;
+
+/* Scan a number with the syntax strtod accepts for decimal numbers:
+ * optional sign, digits with an optional decimal point and an optional
+ * exponent, which is only consumed if it has digits. */
+static gboolean
+gst_ttml_expression_scan_number (
+    const gchar *expr, GstTTMLExpressionNumber *num, const gchar **end)
+{
+  const gchar *p = expr;
+  guint digits = 0;
+
+  while (g_ascii_isspace (*p))
+    p++;
+  num->start = p;
+  num->mantissa = 0;
+  num->exponent = 0;
+  num->negative = FALSE;
+  num->exact = TRUE;
+
+  if (*p == '+' || *p == '-')
+    num->negative = (*p++ == '-');
+
+  for (; g_ascii_isdigit (*p); p++, digits++) {
+    if (num->mantissa < G_GUINT64_CONSTANT (100000000000000000))
+      num->mantissa = num->mantissa * 10 + (*p - '0');
+    else
+      num->exact = FALSE;
+  }
+  if (*p == '.') {
+    for (p++; g_ascii_isdigit (*p); p++, digits++) {
+      if (num->mantissa < G_GUINT64_CONSTANT (100000000000000000)) {
+        num->mantissa = num->mantissa * 10 + (*p - '0');
+        num->exponent--;
+      } else {
+        num->exact = FALSE;
+      }
+    }
+  }
+  if (!digits)
+    return FALSE;
+
+  if (*p == 'e' || *p == 'E') {
+    const gchar *q = p + 1;
+    gboolean negative = FALSE;
+    gint exponent = 0;
+
+    if (*q == '+' || *q == '-')
+      negative = (*q++ == '-');
+    if (g_ascii_isdigit (*q)) {
+      for (; g_ascii_isdigit (*q); q++) {
+        if (exponent < 100000)
+          exponent = exponent * 10 + (*q - '0');
+      }
+      num->exponent += negative ? -exponent : exponent;
+      p = q;
+    }
+  }
+
+  if (end)
+    *end = p;
+  return TRUE;
+}
+
+/* When both the mantissa and the power of ten are exact doubles, a single
+ * multiplication or division gives the correctly rounded result, the same
+ * strtod would give. Anything else is rare enough to be left to
+ * g_ascii_strtod. */
+static gdouble
+gst_ttml_expression_number_to_double (const GstTTMLExpressionNumber *num)
+{
+  gdouble d;
+
+  if (!num->exact || num->mantissa > (G_GUINT64_CONSTANT (1) << 53) ||
+      num->exponent < -22 || num->exponent > 22)
+    return g_ascii_strtod (num->start, NULL);
+
+  d = (gdouble) num->mantissa;
+  if (num->exponent < 0)
+    d /= gst_ttml_expression_powers_of_ten[-num->exponent];
+  else
+    d *= gst_ttml_expression_powers_of_ten[num->exponent];
+  return num->negative ? -d : d;
+}
+
+/* Same as above, rounding directly to single precision when possible */
+static gfloat
+gst_ttml_expression_number_to_float (const GstTTMLExpressionNumber *num)
+{
+  gfloat f;
+
+  if (!num->exact || num->mantissa > (1 << 24) || num->exponent < -10 ||
+      num->exponent > 10)
+    return (gfloat) gst_ttml_expression_number_to_double (num);
+
+  f = (gfloat) num->mantissa;
+  if (num->exponent < 0)
+    f /= (gfloat) gst_ttml_expression_powers_of_ten[-num->exponent];
+  else
+    f *= (gfloat) gst_ttml_expression_powers_of_ten[num->exponent];
+  return num->negative ? -f : f;
+}
+
+/* Decimal integer with optional sign. Out of range values are clamped. */
+gboolean
+gst_ttml_expression_parse_int (
+    const gchar *expr, gint *value, const gchar **end)
+{
+  const gchar *p = expr;
+  gboolean negative = FALSE;
+  gint64 v = 0;
+
+  while (g_ascii_isspace (*p))
+    p++;
+  if (*p == '+' || *p == '-')
+    negative = (*p++ == '-');
+  if (!g_ascii_isdigit (*p))
+    return FALSE;
+
+  for (; g_ascii_isdigit (*p); p++) {
+    if (v <= G_MAXINT)
+      v = v * 10 + (*p - '0');
+  }
+  if (negative)
+    v = -v;
+
+  *value = (gint) CLAMP (v, G_MININT, G_MAXINT);
+  if (end)
+    *end = p;
+  return TRUE;
+}
+
+gboolean
+gst_ttml_expression_parse_double (
+    const gchar *expr, gdouble *value, const gchar **end)
+{
+  GstTTMLExpressionNumber num;
+
+  if (!gst_ttml_expression_scan_number (expr, &num, end))
+    return FALSE;
+  *value = gst_ttml_expression_number_to_double (&num);
+  return TRUE;
+}
+
+gboolean
+gst_ttml_expression_parse_float (
+    const gchar *expr, gfloat *value, const gchar **end)
+{
+  GstTTMLExpressionNumber num;
+
+  if (!gst_ttml_expression_scan_number (expr, &num, end))
+    return FALSE;
+  *value = gst_ttml_expression_number_to_float (&num);
+  return TRUE;
+}
+
+/* Parse both types of time expressions as specified in the TTML
+ * specification, be it in 00:00:00:00 or 00s forms.
+ * Returns GST_CLOCK_TIME_NONE if the expression is not understood. */
+GstClockTime
+gst_ttml_expression_parse_time (const GstTTMLState *state, const gchar *expr)
+{
+  gdouble h, m, s, count, scale;
+  gint f, subf;
+  const gchar *p;
+
+  if (!gst_ttml_expression_parse_double (expr, &h, &p))
+    return GST_CLOCK_TIME_NONE;
+
+  if (*p == ':') {
+    /* Clock time: hours:minutes:seconds[:frames[.sub-frames]] */
+    if (!gst_ttml_expression_parse_double (p + 1, &m, &p) || *p != ':' ||
+        !gst_ttml_expression_parse_double (p + 1, &s, &p))
+      return GST_CLOCK_TIME_NONE;
+
+    if (*p != ':' || !gst_ttml_expression_parse_int (p + 1, &f, &p))
+      return (GstClockTime) ((h * 3600 + m * 60 + s) * GST_SECOND);
+
+    if (*p != '.' || !gst_ttml_expression_parse_int (p + 1, &subf, NULL))
+      return (GstClockTime) ((h * 3600 + m * 60 + s +
+                                 f * state->frame_rate_den /
+                                     (state->frame_rate *
+                                         state->frame_rate_num)) *
+                             GST_SECOND);
+
+    return (GstClockTime) ((h * 3600 + m * 60 + s +
+                               (f + subf / (gdouble) state->sub_frame_rate) *
+                                   state->frame_rate_den /
+                                   (state->frame_rate *
+                                       state->frame_rate_num)) *
+                           GST_SECOND);
+  }
+
+  /* Offset time: a count followed by a metric */
+  count = h;
+  switch (*p) {
+    case 'h':
+      scale = 3600 * GST_SECOND;
+      break;
+    case 'm':
+      if (p[1] == 's')
+        scale = GST_MSECOND;
+      else
+        scale = 60 * GST_SECOND;
+      break;
+    case 's':
+      scale = GST_SECOND;
+      break;
+    case 't':
+      scale = 1.0 / state->tick_rate;
+      break;
+    case 'f':
+      scale = GST_SECOND * state->frame_rate_den /
+              (state->frame_rate * state->frame_rate_num);
+      break;
+    default:
+      return GST_CLOCK_TIME_NONE;
+  }
+  return (GstClockTime) (count * scale);
+}
+
+/* Up to two hex digits */
+static gboolean
+gst_ttml_expression_parse_hex_byte (const gchar **expr, guint *value)
+{
+  const gchar *p = *expr;
+
+  if (!g_ascii_isxdigit (*p))
+    return FALSE;
+  *value = g_ascii_xdigit_value (*p++);
+  if (g_ascii_isxdigit (*p))
+    *value = *value * 16 + g_ascii_xdigit_value (*p++);
+  *expr = p;
+  return TRUE;
+}
+
+/* Comma-separated list of n integers between parenthesis, the opening one
+ * already consumed. A missing closing one has always been tolerated, but
+ * then nothing is consumed. */
+static gboolean
+gst_ttml_expression_parse_components (
+    const gchar *expr, guint *c, gint n, gint *consumed)
+{
+  const gchar *p = expr;
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    if (i > 0 && *p++ != ',')
+      return FALSE;
+    if (!gst_ttml_expression_parse_int (p, (gint *) &c[i], &p))
+      return FALSE;
+  }
+  *consumed = *p == ')' ? p + 1 - expr : 0;
+  return TRUE;
+}
+
+/* Parse all color expressions as per the TTML specification:
+  : "#" rrggbb
+  | "#" rrggbbaa
+  | "rgb" "(" r-value "," g-value "," b-value ")"
+  | "rgba" "(" r-value "," g-value "," b-value "," a-value ")"
+  | <namedColor>
+ * On failure, color is set to opaque white. */
+gboolean
+gst_ttml_expression_parse_color (
+    const gchar *expr, guint32 *color, const gchar **end)
+{
+  guint c[4];
+  gint n = 0;
+
+  if (end)
+    *end = expr;
+
+  if (expr[0] == '#') {
+    const gchar *p = expr + 1;
+    gint i;
+
+    for (i = 0; i < 4 && gst_ttml_expression_parse_hex_byte (&p, &c[i]); i++)
+      ;
+    if (i >= 3) {
+      *color = MAKE_COLOR (c[0], c[1], c[2], i == 4 ? c[3] : 0xFF);
+      n = p - expr;
+      goto done;
+    }
+  } else if (!strncmp (expr, "rgb(", 4)) {
+    if (gst_ttml_expression_parse_components (expr + 4, c, 3, &n)) {
+      *color = MAKE_COLOR (c[0], c[1], c[2], 0xFF);
+      if (n)
+        n += 4;
+      goto done;
+    }
+  } else if (!strncmp (expr, "rgba(", 5)) {
+    if (gst_ttml_expression_parse_components (expr + 5, c, 4, &n)) {
+      *color = MAKE_COLOR (c[0], c[1], c[2], c[3]);
+      if (n)
+        n += 5;
+      goto done;
+    }
+  }
+
+  {
+    struct _GstTTMLNamedColor *named = GstTTMLNamedColors;
+    while (named->name) {
+      n = strlen (named->name);
+      if (!g_ascii_strncasecmp (expr, named->name, n)) {
+        *color = named->color;
+        break;
+      }
+      named++;
+    }
+    if (!named->name) {
+      *color = 0xFFFFFFFF;
+      return FALSE;
+    }
+  }
+
+done:
+  /* Skip trailing whitespace */
+  if (end) {
+    while (expr[n] != '\0' && g_ascii_isspace (expr[n]))
+      n++;
+    *end = expr + n;
+  }
+
+  return TRUE;
+}
+
+/* Parse <length> expressions as per the TTML specification.
+ * Returns FALSE on error, with value and unit set to whatever could be
+ * understood (1.0 relative, by default).
+<length>
+  : scalar
+  | percentage
+scalar
+  : number units
+percentage
+  : number "%"
+units
+  : "px"
+  | "em"
+  | "c"
+ */
+gboolean
+gst_ttml_expression_parse_length (const gchar *expr, gfloat *value,
+    GstTTMLLengthUnit *unit, const gchar **end)
+{
+  const gchar *p;
+  gsize len = 0;
+  gboolean ok = TRUE;
+
+  *value = 1.f;
+  *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
+  if (end)
+    *end = expr;
+
+  if (gst_ttml_expression_parse_float (expr, value, &p)) {
+    if (!g_ascii_strncasecmp (p, "px", 2)) {
+      *unit = GST_TTML_LENGTH_UNIT_PIXELS;
+      len = 2;
+    } else if (!g_ascii_strncasecmp (p, "em", 2)) {
+      *unit = GST_TTML_LENGTH_UNIT_EM;
+      len = 2;
+    } else if (!g_ascii_strncasecmp (p, "c", 1)) {
+      *unit = GST_TTML_LENGTH_UNIT_CELLS;
+      len = 1;
+    } else if (*p == '%') {
+      *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
+      *value /= 100.0;
+      len = 1;
+    } else {
+      ok = FALSE;
+    }
+    if (end)
+      *end = p + len;
+  } else {
+    ok = FALSE;
+  }
+
+  if (!ok) {
+    GST_WARNING ("Could not understand length expression '%s', using %g (%s)",
+        expr, *value, gst_ttml_utils_enum_name (*unit, LengthUnit));
+  }
+  return ok;
+}
+
+/* Reads a list of <length> expressions and returns the number of elements.
+ * The UNIT of elements not read is set to NOT_PRESENT.
+ */
+gint
+gst_ttml_expression_parse_lengths_list (
+    const gchar *expr, GstTTMLLength *length, gint max_elements)
+{
+  const gchar *next;
+  gint ndx = 0, i;
+  gboolean ok;
+
+  do {
+    ok = gst_ttml_expression_parse_length (
+        expr, &length[ndx].f, &length[ndx].unit, &next);
+    if (ok) {
+      expr = next;
+      ndx++;
+    }
+  } while (ok && *next != '\0' && ndx < max_elements);
+
+  /* Mark all other elements as NOT PRESENT */
+  for (i = ndx; i < max_elements; i++) {
+    length[i].unit = GST_TTML_LENGTH_UNIT_NOT_PRESENT;
+  }
+
+  return ndx;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_EXPRESSION_H__
+#define __GST_TTML_EXPRESSION_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+#include "gstttmlenums.h"
+
+G_BEGIN_DECLS
+
+/* Parsers for the numeric expressions found in TTML attribute values.
+ * They do not depend on the current locale, so they are safe to use from
+ * any thread, and they do not allocate memory. Leading white space is
+ * skipped and, on success, 'end' (if not NULL) points to the first char
+ * which was not consumed. */
+
+gboolean gst_ttml_expression_parse_int (
+    const gchar *expr, gint *value, const gchar **end);
+
+gboolean gst_ttml_expression_parse_double (
+    const gchar *expr, gdouble *value, const gchar **end);
+
+gboolean gst_ttml_expression_parse_float (
+    const gchar *expr, gfloat *value, const gchar **end);
+
+GstClockTime gst_ttml_expression_parse_time (
+    const GstTTMLState *state, const gchar *expr);
+
+gboolean gst_ttml_expression_parse_color (
+    const gchar *expr, guint32 *color, const gchar **end);
+
+gboolean gst_ttml_expression_parse_length (const gchar *expr, gfloat *value,
+    GstTTMLLengthUnit *unit, const gchar **end);
+
+gint gst_ttml_expression_parse_lengths_list (
+    const gchar *expr, GstTTMLLength *length, gint max_elements);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_EXPRESSION_H__ */
@@ -15,12 +15,22 @@ typedef struct _GstTTMLSpan GstTTMLSpan;
 typedef struct _GstTTMLAttribute GstTTMLAttribute;
 typedef struct _GstTTMLAttributeEvent GstTTMLAttributeEvent;
 typedef struct _GstTTMLEvent GstTTMLEvent;
+typedef struct _GstTTMLTimeline GstTTMLTimeline;
 typedef struct _GstTTMLStyle GstTTMLStyle;
 typedef struct _GstTTMLToken GstTTMLToken;
+typedef struct _GstTTMLTokenIndex GstTTMLTokenIndex;
 typedef struct _GstTTMLLength GstTTMLLength;
 typedef struct _GstTTMLFraction GstTTMLFraction;
 typedef struct _GstTTMLTextOutline GstTTMLTextOutline;
 typedef struct _GstTTMLDownloader GstTTMLDownloader;
+typedef struct _GstTTMLArena GstTTMLArena;
+typedef struct _GstTTMLCache GstTTMLCache;
+typedef struct _GstTTMLHeadCache GstTTMLHeadCache;
+typedef struct _GstTTMLScanner GstTTMLScanner;
+typedef struct _GstTTMLSaxLog GstTTMLSaxLog;
+typedef struct _GstTTMLTokenizer GstTTMLTokenizer;
+typedef struct _GstTTMLBuffer GstTTMLBuffer;
+typedef struct _GstTTMLBase64 GstTTMLBase64;
 
 G_END_DECLS
 
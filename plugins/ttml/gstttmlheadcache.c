@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlheadcache.h"
+#include "gstttmlevent.h"
+#include "gstttmlstate.h"
+#include "gstttmltimeline.h"
+#include <string.h>
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+/* Position right after the first occurrence of 'token' at or after 'pos',
+ * or 0 if not found */
+static gsize
+gst_ttml_head_cache_skip_past (
+    const gchar *data, gsize len, gsize pos, const gchar *token)
+{
+  const gchar *found;
+
+  if (pos >= len)
+    return 0;
+
+  found = g_strstr_len (data + pos, len - pos, token);
+  if (!found)
+    return 0;
+
+  return found - data + strlen (token);
+}
+
+/* Position right after the end of the tag starting at 'pos', taking quoted
+ * attribute values into account, or 0 if it is not complete. */
+static gsize
+gst_ttml_head_cache_skip_tag (
+    const gchar *data, gsize len, gsize pos, gboolean *empty)
+{
+  gchar quote = 0;
+
+  for (; pos < len; pos++) {
+    gchar c = data[pos];
+
+    if (quote) {
+      if (c == quote)
+        quote = 0;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '>') {
+      *empty = data[pos - 1] == '/';
+      return pos + 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Length of the qualified name starting at 'pos' */
+static gsize
+gst_ttml_head_cache_name_length (const gchar *data, gsize len, gsize pos)
+{
+  gsize start = pos;
+
+  while (pos < len && !g_ascii_isspace (data[pos]) && data[pos] != '>' &&
+         data[pos] != '/')
+    pos++;
+
+  return pos - start;
+}
+
+static gboolean
+gst_ttml_head_cache_local_name_is (
+    const gchar *name, gsize name_len, const gchar *local)
+{
+  const gchar *colon = memchr (name, ':', name_len);
+  gsize local_len = strlen (local);
+
+  if (colon) {
+    name_len -= colon + 1 - name;
+    name = colon + 1;
+  }
+
+  return name_len == local_len && memcmp (name, local, local_len) == 0;
+}
+
+/* Look for the head element of the document starting at 'data', and return
+ * the offsets of its start tag and of the end of its end tag.
+ * This is not a full XML parser: it only accepts the usual layout, where
+ * nothing but the XML declaration, processing instructions, comments and
+ * the tt start tag comes before the head, and gives up otherwise (document
+ * type declarations might define entities, for example). The head must be
+ * complete. Comments, CDATA sections and processing instructions inside it
+ * are skipped, so the end tag which is found is the one libxml will see. */
+gboolean
+gst_ttml_head_cache_find_head (
+    const gchar *data, gsize len, gsize *start, gsize *end)
+{
+  const gchar *name = NULL;
+  gsize name_len = 0, pos = 0, tag;
+  gboolean seen_tt = FALSE, empty = FALSE;
+  guint depth = 0;
+
+  while (pos < len) {
+    const gchar *lt = memchr (data + pos, '<', len - pos);
+
+    if (!lt)
+      return FALSE;
+    tag = lt - data;
+
+    if (len - tag >= 4 && memcmp (lt, "<!--", 4) == 0) {
+      pos = gst_ttml_head_cache_skip_past (data, len, tag + 4, "-->");
+    } else if (len - tag >= 9 && memcmp (lt, "<![CDATA[", 9) == 0) {
+      if (!depth)
+        return FALSE;
+      pos = gst_ttml_head_cache_skip_past (data, len, tag + 9, "]]>");
+    } else if (len - tag >= 2 && lt[1] == '?') {
+      pos = gst_ttml_head_cache_skip_past (data, len, tag + 2, "?>");
+    } else if (len - tag >= 2 && (lt[1] == '!' || lt[1] == '/')) {
+      gsize tag_name_len;
+
+      /* Document type declarations, or end tags before the head */
+      if (lt[1] == '!' || !depth)
+        return FALSE;
+      tag_name_len = gst_ttml_head_cache_name_length (data, len, tag + 2);
+      pos = gst_ttml_head_cache_skip_tag (data, len, tag + 2, &empty);
+      if (pos && tag_name_len == name_len &&
+          memcmp (lt + 2, name, name_len) == 0 && --depth == 0) {
+        *end = pos;
+        return TRUE;
+      }
+    } else {
+      const gchar *tag_name = lt + 1;
+      gsize tag_name_len =
+          gst_ttml_head_cache_name_length (data, len, tag + 1);
+
+      pos = gst_ttml_head_cache_skip_tag (data, len, tag + 1, &empty);
+      if (!pos)
+        return FALSE;
+
+      if (depth) {
+        /* Inside the head: just keep track of nested heads */
+        if (!empty && tag_name_len == name_len &&
+            memcmp (tag_name, name, name_len) == 0)
+          depth++;
+      } else if (!seen_tt && gst_ttml_head_cache_local_name_is (
+                                 tag_name, tag_name_len, "tt")) {
+        if (empty)
+          return FALSE;
+        seen_tt = TRUE;
+      } else if (seen_tt && !empty &&
+                 gst_ttml_head_cache_local_name_is (
+                     tag_name, tag_name_len, "head")) {
+        name = tag_name;
+        name_len = tag_name_len;
+        *start = tag;
+        depth = 1;
+      } else {
+        /* Anything else comes first, or the head is empty */
+        return FALSE;
+      }
+    }
+
+    if (!pos)
+      return FALSE;
+  }
+
+  return FALSE;
+}
+
+/* Create an empty entry for the document starting at 'data', whose head
+ * spans from 'head_start' to 'head_end'. Fill it with
+ * gst_ttml_head_cache_store(). */
+GstTTMLHeadCache *
+gst_ttml_head_cache_new (const gchar *data, gsize head_start, gsize head_end)
+{
+  GstTTMLHeadCache *cache = g_new0 (GstTTMLHeadCache, 1);
+
+  cache->key = g_bytes_new (data, head_end);
+  cache->head_start = head_start;
+  cache->events =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_ttml_event_free);
+  return cache;
+}
+
+void
+gst_ttml_head_cache_free (GstTTMLHeadCache *cache)
+{
+  if (!cache)
+    return;
+
+  g_bytes_unref (cache->key);
+  g_ptr_array_unref (cache->events);
+  if (cache->saved_styling_attr_stacks)
+    g_hash_table_unref (cache->saved_styling_attr_stacks);
+  if (cache->saved_data)
+    g_hash_table_unref (cache->saved_data);
+  g_free (cache);
+}
+
+/* Whether the document starting at 'data' begins with the same bytes as the
+ * one this entry was created for, up to the end of its head */
+gboolean
+gst_ttml_head_cache_matches (
+    const GstTTMLHeadCache *cache, const gchar *data, gsize len)
+{
+  gsize key_len;
+  gconstpointer key = g_bytes_get_data (cache->key, &key_len);
+
+  return len >= key_len && memcmp (data, key, key_len) == 0;
+}
+
+/* Keep copies of the parsing results of the head, once it is closed. The
+ * events were collected while parsing it. */
+void
+gst_ttml_head_cache_store (GstTTMLHeadCache *cache, const GstTTMLState *state)
+{
+  gst_ttml_state_copy_styles_table (
+      &cache->saved_styling_attr_stacks, state->saved_styling_attr_stacks);
+  gst_ttml_state_copy_data_table (&cache->saved_data, state->saved_data);
+  cache->last_zindex_micro = state->last_zindex_micro;
+  GST_DEBUG ("Stored head with %u events", cache->events->len);
+}
+
+/* Leave the state and the timeline as if the head had just been parsed */
+void
+gst_ttml_head_cache_apply (const GstTTMLHeadCache *cache,
+    GstTTMLState *state, GstTTMLTimeline *timeline)
+{
+  guint i;
+
+  GST_DEBUG ("Reusing parsed head with %u events", cache->events->len);
+  gst_ttml_state_copy_styles_table (
+      &state->saved_styling_attr_stacks, cache->saved_styling_attr_stacks);
+  gst_ttml_state_copy_data_table (&state->saved_data, cache->saved_data);
+  state->last_zindex_micro = cache->last_zindex_micro;
+
+  for (i = 0; i < cache->events->len; i++) {
+    gst_ttml_timeline_insert (
+        timeline, gst_ttml_event_copy (g_ptr_array_index (cache->events, i)));
+  }
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_HEAD_CACHE_H__
+#define __GST_TTML_HEAD_CACHE_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+/* The results of parsing the <head> of a document: the named styles, the
+ * embedded data and the region events it produced. Segmented streams
+ * repeat the same head in every document, so when the bytes of a document
+ * up to the end of its head match the ones of the previous document, these
+ * results are applied instead of parsing the head again. */
+struct _GstTTMLHeadCache
+{
+  /* Document bytes up to the end of the head. There is a single entry, so
+   * they are compared directly: hashing them would cost the same pass over
+   * the bytes and still need the comparison to rule out collisions. */
+  GBytes *key;
+  /* Offset of the head element inside the key */
+  gsize head_start;
+
+  /* Copies of the events inserted in the timeline, in insertion order */
+  GPtrArray *events;
+  GHashTable *saved_styling_attr_stacks;
+  GHashTable *saved_data;
+  guint last_zindex_micro;
+};
+
+gboolean gst_ttml_head_cache_find_head (
+    const gchar *data, gsize len, gsize *start, gsize *end);
+
+GstTTMLHeadCache *gst_ttml_head_cache_new (
+    const gchar *data, gsize head_start, gsize head_end);
+
+void gst_ttml_head_cache_free (GstTTMLHeadCache *cache);
+
+gboolean gst_ttml_head_cache_matches (
+    const GstTTMLHeadCache *cache, const gchar *data, gsize len);
+
+void gst_ttml_head_cache_store (
+    GstTTMLHeadCache *cache, const GstTTMLState *state);
+
+void gst_ttml_head_cache_apply (const GstTTMLHeadCache *cache,
+    GstTTMLState *state, GstTTMLTimeline *timeline);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_HEAD_CACHE_H__ */
@@ -586,6 +586,19 @@ gst_ttmlrender_shape_attr_data_free (GstTTMLRenderShapeAttrData *data)
   g_free (data);
 }
 
+/* Forget the final style of the last span. Pointers to span and region
+ * styles are only compared within a frame, since they can be freed or
+ * updated between frames. */
+static void
+gst_ttmlrender_reset_style_cache (GstTTMLRender *render)
+{
+  gst_ttml_style_reset (&render->last_final_style);
+  g_free (render->last_markup_head);
+  g_free (render->last_markup_tail);
+  render->last_markup_head = render->last_markup_tail = NULL;
+  render->last_span_style = render->last_region_style = NULL;
+}
+
 /* Adds this span to the current paragraph of the appropriate region.
  * When a line-break char is found, a new PangoLayout is created. */
 static void
@@ -598,46 +611,79 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
   GstTTMLRegion *region;
   gchar *frag_start = span->chars; /* NOT NULL-terminated! */
   int chars_left = span->length;
-  GstTTMLStyle final_style;
+  GstTTMLStyle *src_style = NULL;
+  GstTTMLStyle *final_style = &render->last_final_style;
+  gchar *markup_head, *markup_tail;
+  int markup_head_len, markup_tail_len;
 
   GST_MEMDUMP_OBJECT (
       render, "span chars:", (guint8 *) span->chars, span->length);
 
   /* Do nothing if the span is disabled */
-  attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_DISPLAY);
+  attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_DISPLAY);
   if (attr && attr->value.b == FALSE)
     return;
 
-  attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_REGION);
+  attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_REGION);
   region_id = attr ? attr->value.string : default_region_id;
 
   if (attr) {
     /* Expand region style into span's style if present */
     GstTTMLBase *base = GST_TTMLBASE (render);
-    GList *prev_attr_stack = span->style.attributes;
-    GstTTMLStyle src_style;
 
     /* Retrieve region style */
-    if (!g_hash_table_lookup_extended (base->state.saved_region_attr_stacks,
-            region_id, NULL, (gpointer *) &src_style.attributes)) {
+    if (base->state.saved_region_attr_stacks)
+      src_style = (GstTTMLStyle *) g_hash_table_lookup (
+          base->state.saved_region_attr_stacks, region_id);
+    if (!src_style) {
       /* This region does not exist, discard span */
       return;
     }
-    /* Apply span attributes OVER region attributes, since they have higher
-     * priority. */
-    gst_ttml_style_copy (&final_style, &src_style, FALSE);
-
-    while (prev_attr_stack) {
-      GstTTMLAttribute *prev;
-      prev = gst_ttml_style_set_attr (
-          &final_style, (GstTTMLAttribute *) prev_attr_stack->data);
-      gst_ttml_attribute_free (prev);
-      prev_attr_stack = prev_attr_stack->next;
+  }
+
+  /* Span styles are shared, so spans with the same style in the same region
+   * (typically, all the lines of a cue) reuse the final style and markup of
+   * the previous one. */
+  if (span->style != render->last_span_style ||
+      src_style != render->last_region_style) {
+    gchar *default_font_size = render->default_font_size;
+
+    gst_ttmlrender_reset_style_cache (render);
+    if (src_style) {
+      /* Apply span attributes OVER region attributes, since they have higher
+       * priority. */
+      gst_ttml_style_copy (final_style, src_style, FALSE);
+      gst_ttml_style_merge (final_style, span->style, TRUE);
+    } else {
+      /* No region attr to be expanded */
+      gst_ttml_style_copy (final_style, span->style, FALSE);
     }
-  } else {
-    /* No region attr to be expanded */
-    gst_ttml_style_copy (&final_style, &span->style, FALSE);
+
+    if (!default_font_size) {
+      /* According to the spec, when no font size is specified, use "1c" */
+      default_font_size =
+          g_strdup_printf (" %dpx ", render->base.state.frame_height /
+                                         render->base.state.cell_resolution_y);
+      GST_DEBUG_OBJECT (render, "No font size specified, using %d/%d =%s",
+          render->base.state.frame_height,
+          render->base.state.cell_resolution_y, default_font_size);
+    }
+
+    gst_ttml_style_gen_pango_markup (&render->base.state, final_style,
+        &render->last_markup_head, &render->last_markup_tail,
+        render->default_font_family, default_font_size);
+
+    if (!render->default_font_size) {
+      g_free (default_font_size);
+    }
+
+    render->last_span_style = span->style;
+    render->last_region_style = src_style;
   }
+  markup_head = render->last_markup_head;
+  markup_tail = render->last_markup_tail;
+  markup_head_len = strlen (markup_head);
+  markup_tail_len = strlen (markup_tail);
 
   /* Find or create region struct */
   region_link = g_list_find_custom (render->regions, region_id,
@@ -650,11 +696,11 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
        * the region, but we have some span attrs (like TextOutline) which
        * we are currently treating as region attrs, and this fixes the
        * Padding testsuite. */
-      gst_ttmlrender_setup_region_attrs (render, region, &final_style);
+      gst_ttmlrender_setup_region_attrs (render, region, final_style);
     }
   } else {
     region = gst_ttmlrender_new_region (region_id);
-    gst_ttmlrender_setup_region_attrs (render, region, &final_style);
+    gst_ttmlrender_setup_region_attrs (render, region, final_style);
 
     render->regions = g_list_insert_sorted (render->regions, region,
         (GCompareFunc) gst_ttmlrender_region_compare_zindex);
@@ -663,10 +709,8 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
   /* Add UTF8 chars from the span into the current paragraph, until a line
    * break is found.*/
   do {
-    gchar *markup_head, *markup_tail, *ptr;
-    int markup_head_len, markup_tail_len;
+    gchar *ptr;
     int frag_len, curr_len;
-    gchar *default_font_size = render->default_font_size;
     frag_len = chars_left;
     if (region->current_par_content) {
       curr_len = strlen (region->current_par_content);
@@ -674,26 +718,6 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
       curr_len = 0;
     }
 
-    if (!default_font_size) {
-      /* According to the spec, when no font size is specified, use "1c" */
-      default_font_size =
-          g_strdup_printf (" %dpx ", render->base.state.frame_height /
-                                         render->base.state.cell_resolution_y);
-      GST_DEBUG_OBJECT (render, "No font size specified, using %d/%d =%s",
-          render->base.state.frame_height,
-          render->base.state.cell_resolution_y, default_font_size);
-    }
-
-    gst_ttml_style_gen_pango_markup (&render->base.state, &final_style,
-        &markup_head, &markup_tail, render->default_font_family,
-        default_font_size);
-    markup_head_len = strlen (markup_head);
-    markup_tail_len = strlen (markup_tail);
-
-    if (!render->default_font_size) {
-      g_free (default_font_size);
-    }
-
     if (frag_len) {
       region->current_par_content =
           (gchar *) g_realloc (region->current_par_content,
@@ -708,15 +732,12 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
       *ptr = '\0';
     }
 
-    g_free (markup_head);
-    g_free (markup_tail);
-
-    if (region->current_par_style.attributes == NULL) {
-      gst_ttml_style_copy (&region->current_par_style, &final_style, FALSE);
+    if (!region->current_par_style.mask) {
+      gst_ttml_style_copy (&region->current_par_style, final_style, FALSE);
     }
 
     attr =
-        gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_TEXT_DECORATION);
+        gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_TEXT_DECORATION);
     if (attr &&
         (attr->value.text_decoration & GST_TTML_TEXT_DECORATION_OVERLINE)) {
       PangoAttribute *pattr = gst_ttmlrender_pango_attr_overline_new (TRUE);
@@ -727,7 +748,7 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
       }
       pango_attr_list_change (region->current_par_pango_attrs, pattr);
     }
-    attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_VISIBILITY);
+    attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_VISIBILITY);
     if (attr && (attr->value.b == FALSE)) {
       /* The TTML attribute is Visibility=visible|hidden, but for convenience,
        * I definde the Pango attribute as Invisibility, so it only appears when
@@ -742,7 +763,7 @@ gst_ttmlrender_build_layouts (GstTTMLSpan *span, GstTTMLRender *render)
       pango_attr_list_change (region->current_par_pango_attrs, pattr);
     }
 
-    attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_FONT_SIZE);
+    attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_FONT_SIZE);
     if (attr && (gst_ttml_attribute_is_length_present (attr, 1))) {
       /* Anamorphic font scaling attribute generation:
        * Found a non-uniformly-scaled (anamorphic) font size.
@@ -856,7 +877,7 @@ skip_font_size:
       pango_attr_list_unref (pango_attr_list);
     }
     attr =
-        gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_BACKGROUND_COLOR);
+        gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_BACKGROUND_COLOR);
     if (attr && ((attr->value.color & 0xFF) != 0)) {
       /* Background color has alpha, and pango markup does not support it.
        * Provide Pango attrs directly, passing the alpha in the LSB of the red
@@ -876,7 +897,7 @@ skip_font_size:
        */
       pango_attr_list_change (region->current_par_pango_attrs, pattr);
     }
-    attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_COLOR);
+    attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_COLOR);
     if (attr && ((attr->value.color & 0xFF) != 0)) {
       /* Foreground color has alpha, and pango markup does not support it.
        * Provide Pango attrs directly, passing the alpha in the LSB of the red
@@ -896,13 +917,13 @@ skip_font_size:
        */
       pango_attr_list_change (region->current_par_pango_attrs, pattr);
     }
-    attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_UNICODE_BIDI);
+    attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_UNICODE_BIDI);
     if (attr && (attr->value.unicode_bidi == GST_TTML_UNICODE_BIDI_OVERRIDE)) {
       /* If unicodeBidi == bidiOverride && direction == RTL, then we activate
        * the reverse mode.
        * FIXME: Fails for languages which are naturally RTL, which Pango
        * handles correctly on its own. */
-      attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_DIRECTION);
+      attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_DIRECTION);
       if (attr && (attr->value.direction == GST_TTML_DIRECTION_RTL)) {
         PangoAttribute *pattr = gst_ttmlrender_pango_attr_reverse_new (TRUE);
         pattr->start_index = region->current_par_content_plain_length;
@@ -913,7 +934,7 @@ skip_font_size:
         pango_attr_list_change (region->current_par_pango_attrs, pattr);
       }
     }
-    attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_FONT_STYLE);
+    attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_FONT_STYLE);
     if (attr && ((attr->value.font_style ==
                      GST_TTML_FONT_STYLE_REVERSE_OBLIQUE) != 0)) {
       /* Pango markup does not support reverse oblique. We use our own attr. */
@@ -935,7 +956,6 @@ skip_font_size:
 
   GST_DEBUG_OBJECT (
       render, "paragraph content:\n%s", region->current_par_content);
-  gst_ttml_style_reset (&final_style);
 }
 
 static void
@@ -1399,14 +1419,12 @@ gst_ttmlrender_free_region (GstTTMLRegion *region)
  * the background is rendered even when empty. */
 static void
 gst_ttmlrender_build_background_layout (
-    const gchar *id, GList *attr_list, GstTTMLRender *render)
+    const gchar *id, GstTTMLStyle *style, GstTTMLRender *render)
 {
-  GstTTMLStyle style;
   GstTTMLAttribute *attr;
   GList *region_link;
 
-  style.attributes = attr_list;
-  attr = gst_ttml_style_get_attr (&style, GST_TTML_ATTR_SHOW_BACKGROUND);
+  attr = gst_ttml_style_get_attr (style, GST_TTML_ATTR_SHOW_BACKGROUND);
   if (attr && attr->value.show_background != GST_TTML_SHOW_BACKGROUND_ALWAYS)
     return;
 
@@ -1418,7 +1436,7 @@ gst_ttmlrender_build_background_layout (
     GstTTMLRegion *region;
 
     region = gst_ttmlrender_new_region (id);
-    gst_ttmlrender_setup_region_attrs (render, region, &style);
+    gst_ttmlrender_setup_region_attrs (render, region, style);
     render->regions = g_list_insert_sorted (render->regions, region,
         (GCompareFunc) gst_ttmlrender_region_compare_zindex);
   }
@@ -1470,6 +1488,7 @@ gst_ttmlrender_gen_buffer (
   g_list_free_full (
       render->regions, (GDestroyNotify) gst_ttmlrender_free_region);
   render->regions = NULL;
+  gst_ttmlrender_reset_style_cache (render);
 
   gst_buffer_unmap (buffer, &map_info);
   cairo_surface_destroy (render->surface);
@@ -1634,6 +1653,7 @@ gst_ttmlrender_dispose (GObject *object)
         render->regions, (GDestroyNotify) gst_ttmlrender_free_region);
     render->regions = NULL;
   }
+  gst_ttmlrender_reset_style_cache (render);
 
   if (render->default_font_family) {
     g_free (render->default_font_family);
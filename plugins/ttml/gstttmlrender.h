@@ -35,6 +35,14 @@ typedef struct _GstTTMLRender
    * This is a temporal structure used to render each frame */
   GList *regions;
 
+  /* Final style and Pango markup of the last span added to the regions of
+   * the current frame, and the span and region styles it comes from */
+  const GstTTMLStyle *last_span_style;
+  const GstTTMLStyle *last_region_style;
+  GstTTMLStyle last_final_style;
+  gchar *last_markup_head;
+  gchar *last_markup_tail;
+
   /* Cache of ready-to-use Cairo surfaces, so they are not decoded each time
    * they are needed. */
   GHashTable *cached_images;
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlsaxlog.h"
+#include "gstttmltokenizer.h"
+#include <string.h>
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+static const xmlChar *
+gst_ttml_sax_log_intern (GstTTMLSaxLog *log, const xmlChar *str)
+{
+  if (!str)
+    return NULL;
+  return (const xmlChar *) g_string_chunk_insert_const (
+      log->strings, (const gchar *) str);
+}
+
+static GstTTMLSaxLogRecord *
+gst_ttml_sax_log_add (GstTTMLSaxLog *log, GstTTMLSaxLogRecordType type)
+{
+  GstTTMLSaxLogRecord record = { 0 };
+
+  record.type = type;
+  g_array_append_val (log->records, record);
+  return &g_array_index (log->records, GstTTMLSaxLogRecord,
+      log->records->len - 1);
+}
+
+static void
+gst_ttml_sax_log_document_start (void *ctx)
+{
+  gst_ttml_sax_log_add (ctx, GST_TTML_SAX_LOG_DOCUMENT_START);
+}
+
+static void
+gst_ttml_sax_log_document_end (void *ctx)
+{
+  gst_ttml_sax_log_add (ctx, GST_TTML_SAX_LOG_DOCUMENT_END);
+}
+
+static void
+gst_ttml_sax_log_element_start_ns (void *ctx, const xmlChar *name,
+    const xmlChar *prefix, const xmlChar *URI, int nb_namespaces,
+    const xmlChar **namespaces, int nb_attributes, int nb_defaulted,
+    const xmlChar **attributes)
+{
+  GstTTMLSaxLog *log = ctx;
+  GstTTMLSaxLogRecord *record;
+  int i;
+
+  record = gst_ttml_sax_log_add (log, GST_TTML_SAX_LOG_ELEMENT_START);
+  record->name = gst_ttml_sax_log_intern (log, name);
+  record->prefix = gst_ttml_sax_log_intern (log, prefix);
+  record->uri = gst_ttml_sax_log_intern (log, URI);
+  record->nb_namespaces = nb_namespaces;
+  record->nb_attributes = nb_attributes;
+  record->nb_defaulted = nb_defaulted;
+  record->args = log->args->len;
+
+  for (i = 0; i < nb_namespaces * 2; i++) {
+    g_ptr_array_add (
+        log->args, (gpointer) gst_ttml_sax_log_intern (log, namespaces[i]));
+  }
+
+  for (i = 0; i < nb_attributes; i++, attributes += 5) {
+    gsize len = attributes[4] - attributes[3];
+    gchar *value = g_string_chunk_insert_len (
+        log->strings, (const gchar *) attributes[3], len);
+
+    g_ptr_array_add (
+        log->args, (gpointer) gst_ttml_sax_log_intern (log, attributes[0]));
+    g_ptr_array_add (
+        log->args, (gpointer) gst_ttml_sax_log_intern (log, attributes[1]));
+    g_ptr_array_add (
+        log->args, (gpointer) gst_ttml_sax_log_intern (log, attributes[2]));
+    g_ptr_array_add (log->args, value);
+    g_ptr_array_add (log->args, value + len);
+  }
+}
+
+static void
+gst_ttml_sax_log_element_end_ns (
+    void *ctx, const xmlChar *name, const xmlChar *prefix, const xmlChar *URI)
+{
+  GstTTMLSaxLog *log = ctx;
+  GstTTMLSaxLogRecord *record;
+
+  record = gst_ttml_sax_log_add (log, GST_TTML_SAX_LOG_ELEMENT_END);
+  record->name = gst_ttml_sax_log_intern (log, name);
+  record->prefix = gst_ttml_sax_log_intern (log, prefix);
+  record->uri = gst_ttml_sax_log_intern (log, URI);
+}
+
+static void
+gst_ttml_sax_log_characters (void *ctx, const xmlChar *ch, int len)
+{
+  GstTTMLSaxLog *log = ctx;
+  GstTTMLSaxLogRecord *record;
+
+  record = gst_ttml_sax_log_add (log, GST_TTML_SAX_LOG_CHARACTERS);
+  record->name = (const xmlChar *) g_string_chunk_insert_len (
+      log->strings, (const gchar *) ch, len);
+  record->len = len;
+}
+
+/* Parse SAX warnings (simply shown as debug logs) */
+static void
+gst_ttml_sax_log_warning (void *ctx, const char *message, ...)
+{
+#ifndef GST_DISABLE_GST_DEBUG
+  va_list va;
+  va_start (va, message);
+  gst_debug_log_valist (GST_CAT_DEFAULT, GST_LEVEL_WARNING, __FILE__,
+      __FUNCTION__, __LINE__, NULL, message, va);
+  va_end (va);
+#endif /* GST_DISABLE_GST_DEBUG */
+}
+
+/* Parse SAX errors (simply shown as debug logs) */
+static void
+gst_ttml_sax_log_error (void *ctx, const char *message, ...)
+{
+#ifndef GST_DISABLE_GST_DEBUG
+  va_list va;
+  va_start (va, message);
+  gst_debug_log_valist (GST_CAT_DEFAULT, GST_LEVEL_ERROR, __FILE__,
+      __FUNCTION__, __LINE__, NULL, message, va);
+  va_end (va);
+#endif /* GST_DISABLE_GST_DEBUG */
+}
+
+/* Same entities as the parser of the element */
+static xmlEntityPtr
+gst_ttml_sax_log_get_entity (void *ctx, const xmlChar *name)
+{
+  return xmlGetPredefinedEntity (name);
+}
+
+static xmlSAXHandler gst_ttml_sax_log_handler = {
+  /* .internalSubset = */ NULL,
+  /* .isStandalone = */ NULL,
+  /* .hasInternalSubset = */ NULL,
+  /* .hasExternalSubset = */ NULL,
+  /* .resolveEntity = */ NULL,
+  /* .getEntity = */ gst_ttml_sax_log_get_entity,
+  /* .entityDecl = */ NULL,
+  /* .notationDecl = */ NULL,
+  /* .attributeDecl = */ NULL,
+  /* .elementDecl = */ NULL,
+  /* .unparsedEntityDecl = */ NULL,
+  /* .setDocumentLocator = */ NULL,
+  /* .startDocument = */ gst_ttml_sax_log_document_start,
+  /* .endDocument = */ gst_ttml_sax_log_document_end,
+  /* .startElement = */ NULL,
+  /* .endElement = */ NULL,
+  /* .reference = */ NULL,
+  /* .characters = */ gst_ttml_sax_log_characters,
+  /* .ignorableWhitespace = */ NULL,
+  /* .processingInstruction = */ NULL,
+  /* .comment = */ NULL,
+  /* .warning = */ gst_ttml_sax_log_warning,
+  /* .error = */ gst_ttml_sax_log_error,
+  /* .fatalError = */ gst_ttml_sax_log_error,
+  /* .getParameterEntity = */ NULL,
+  /* .cdataBlock = */ NULL,
+  /* .externalSubset = */ NULL,
+  /* .initialized = */ XML_SAX2_MAGIC,
+  /* ._private = */ NULL,
+  /* .startElementNs = */ gst_ttml_sax_log_element_start_ns,
+  /* .endElementNs = */ gst_ttml_sax_log_element_end_ns,
+  /* .xmlStructuredError = */ NULL
+};
+
+/* Create an empty log for the complete document in 'data', which must stay
+ * valid until the log is freed. Fill it with gst_ttml_sax_log_parse(). */
+GstTTMLSaxLog *
+gst_ttml_sax_log_new (const gchar *data, gsize len)
+{
+  GstTTMLSaxLog *log = g_new0 (GstTTMLSaxLog, 1);
+
+  log->data = data;
+  log->len = len;
+  log->records = g_array_new (FALSE, FALSE, sizeof (GstTTMLSaxLogRecord));
+  log->args = g_ptr_array_new ();
+  log->strings = g_string_chunk_new (MAX (len, 64));
+  g_mutex_init (&log->lock);
+  g_cond_init (&log->cond);
+  return log;
+}
+
+void
+gst_ttml_sax_log_free (GstTTMLSaxLog *log)
+{
+  if (!log)
+    return;
+
+  g_array_free (log->records, TRUE);
+  g_ptr_array_free (log->args, TRUE);
+  g_string_chunk_free (log->strings);
+  g_mutex_clear (&log->lock);
+  g_cond_clear (&log->cond);
+  g_free (log);
+}
+
+/* Parse the document, recording the callbacks, with libxml or with the
+ * built-in tokenizer. The parser is driven as the element drives its own
+ * for a document which arrives in one piece. Can be called from any
+ * thread. */
+void
+gst_ttml_sax_log_parse (GstTTMLSaxLog *log, gboolean builtin_tokenizer)
+{
+  xmlParserCtxtPtr parser;
+  gboolean failed = FALSE;
+
+  if (builtin_tokenizer) {
+    GstTTMLTokenizer *tokenizer =
+        gst_ttml_tokenizer_new (&gst_ttml_sax_log_handler, log);
+
+    if (!gst_ttml_tokenizer_feed (tokenizer, log->data, log->len))
+      GST_WARNING ("XML Parsing failed");
+    gst_ttml_tokenizer_finish (tokenizer);
+    gst_ttml_tokenizer_free (tokenizer);
+    goto done;
+  }
+
+  parser = xmlCreatePushParserCtxt (
+      &gst_ttml_sax_log_handler, log, log->data, (int) log->len, NULL);
+  if (parser) {
+    if (xmlParseChunk (parser, NULL, 0, 1) != 0)
+      GST_WARNING ("XML Parsing failed");
+    xmlFreeParserCtxt (parser);
+  } else {
+    GST_ERROR ("XML parser creation failed");
+    failed = TRUE;
+  }
+
+done:
+  g_mutex_lock (&log->lock);
+  log->failed = failed;
+  log->done = TRUE;
+  g_cond_signal (&log->cond);
+  g_mutex_unlock (&log->lock);
+}
+
+/* Wait for gst_ttml_sax_log_parse() to be done with the log. Returns FALSE
+ * if the document could not be parsed and must be parsed again. */
+gboolean
+gst_ttml_sax_log_wait (GstTTMLSaxLog *log)
+{
+  gboolean failed;
+
+  g_mutex_lock (&log->lock);
+  while (!log->done)
+    g_cond_wait (&log->cond, &log->lock);
+  failed = log->failed;
+  g_mutex_unlock (&log->lock);
+
+  return !failed;
+}
+
+/* Run the recorded callbacks on 'sax', in order */
+void
+gst_ttml_sax_log_replay (
+    const GstTTMLSaxLog *log, const xmlSAXHandler *sax, void *ctx)
+{
+  guint i;
+
+  for (i = 0; i < log->records->len; i++) {
+    const GstTTMLSaxLogRecord *record =
+        &g_array_index (log->records, GstTTMLSaxLogRecord, i);
+    const xmlChar **args;
+
+    switch (record->type) {
+      case GST_TTML_SAX_LOG_DOCUMENT_START:
+        sax->startDocument (ctx);
+        break;
+      case GST_TTML_SAX_LOG_DOCUMENT_END:
+        sax->endDocument (ctx);
+        break;
+      case GST_TTML_SAX_LOG_ELEMENT_START:
+        args = (const xmlChar **) log->args->pdata + record->args;
+        sax->startElementNs (ctx, record->name, record->prefix, record->uri,
+            record->nb_namespaces, args, record->nb_attributes,
+            record->nb_defaulted, args + record->nb_namespaces * 2);
+        break;
+      case GST_TTML_SAX_LOG_ELEMENT_END:
+        sax->endElementNs (ctx, record->name, record->prefix, record->uri);
+        break;
+      case GST_TTML_SAX_LOG_CHARACTERS:
+        sax->characters (ctx, record->name, record->len);
+        break;
+    }
+  }
+}
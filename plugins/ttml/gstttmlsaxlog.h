@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_SAX_LOG_H__
+#define __GST_TTML_SAX_LOG_H__
+
+#include <gst/gst.h>
+#include <libxml/parser.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_TTML_SAX_LOG_DOCUMENT_START,
+  GST_TTML_SAX_LOG_DOCUMENT_END,
+  GST_TTML_SAX_LOG_ELEMENT_START,
+  GST_TTML_SAX_LOG_ELEMENT_END,
+  GST_TTML_SAX_LOG_CHARACTERS
+} GstTTMLSaxLogRecordType;
+
+typedef struct
+{
+  GstTTMLSaxLogRecordType type;
+  /* Element name, or characters */
+  const xmlChar *name;
+  const xmlChar *prefix;
+  const xmlChar *uri;
+  /* Length of the characters */
+  gint len;
+  gint nb_namespaces;
+  gint nb_attributes;
+  gint nb_defaulted;
+  /* Index in 'args' of the namespace pairs, followed by the attribute
+   * tuples, in the layout of SAX2 */
+  guint args;
+} GstTTMLSaxLogRecord;
+
+/* The SAX2 callbacks that parsing a whole document produces, with copies of
+ * their arguments, so the document can be parsed in any thread and the
+ * callbacks of the element run later, in the streaming thread, exactly as
+ * if it was being parsed there. Names and URIs are interned, so the same
+ * string always comes with the same pointer, as with the dictionary of a
+ * parser. */
+struct _GstTTMLSaxLog
+{
+  /* The document, owned by the caller */
+  const gchar *data;
+  gsize len;
+
+  GArray *records;
+  GPtrArray *args;
+  GStringChunk *strings;
+  /* The parser could not be created */
+  gboolean failed;
+
+  /* Signalled when parsing is done */
+  GMutex lock;
+  GCond cond;
+  gboolean done;
+};
+
+GstTTMLSaxLog *gst_ttml_sax_log_new (const gchar *data, gsize len);
+
+void gst_ttml_sax_log_free (GstTTMLSaxLog *log);
+
+void gst_ttml_sax_log_parse (GstTTMLSaxLog *log, gboolean builtin_tokenizer);
+
+gboolean gst_ttml_sax_log_wait (GstTTMLSaxLog *log);
+
+void gst_ttml_sax_log_replay (
+    const GstTTMLSaxLog *log, const xmlSAXHandler *sax, void *ctx);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_SAX_LOG_H__ */
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmlscanner.h"
+#include <string.h>
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+void
+gst_ttml_scanner_init (GstTTMLScanner *scanner)
+{
+  memset (scanner, 0, sizeof (GstTTMLScanner));
+  scanner->markup = -1;
+}
+
+/* Skip data up to the end of 'terminator', which might have started in a
+ * previous buffer. Returns the position after it, or 'len' if it was not
+ * found. */
+static gsize
+gst_ttml_scanner_skip_until (GstTTMLScanner *scanner, const gchar *data,
+    gsize len, gsize pos, const gchar *terminator)
+{
+  while (pos < len) {
+    gchar c;
+
+    if (!scanner->matched) {
+      const gchar *first = memchr (data + pos, terminator[0], len - pos);
+
+      if (!first)
+        return len;
+      pos = first - data + 1;
+      scanner->matched = 1;
+      continue;
+    }
+
+    c = data[pos++];
+    if (c == terminator[scanner->matched]) {
+      if (!terminator[++scanner->matched]) {
+        scanner->matched = 0;
+        scanner->state = GST_TTML_SCANNER_STATE_TEXT;
+        return pos;
+      }
+    } else if (c == terminator[0]) {
+      /* In "--->" or "]]]>" the last two chars still match */
+      if (scanner->matched != 2 || terminator[1] != terminator[0])
+        scanner->matched = 1;
+    } else {
+      scanner->matched = 0;
+    }
+  }
+
+  return pos;
+}
+
+/* Skip a document type declaration, whose internal subset may contain
+ * quoted strings and '>' chars. */
+static gsize
+gst_ttml_scanner_skip_declaration (
+    GstTTMLScanner *scanner, const gchar *data, gsize len, gsize pos)
+{
+  for (; pos < len; pos++) {
+    gchar c = data[pos];
+
+    if (scanner->quote) {
+      if (c == scanner->quote)
+        scanner->quote = 0;
+    } else if (c == '"' || c == '\'') {
+      scanner->quote = c;
+    } else if (c == '[') {
+      scanner->brackets++;
+    } else if (c == ']' && scanner->brackets) {
+      scanner->brackets--;
+    } else if (c == '>' && !scanner->brackets) {
+      scanner->state = GST_TTML_SCANNER_STATE_TEXT;
+      return pos + 1;
+    }
+  }
+
+  return len;
+}
+
+/* Skip the rest of a start or end tag. Returns the position after it, and
+ * whether the document is over, or 'len' if the tag continues in the next
+ * buffer. */
+static gsize
+gst_ttml_scanner_skip_tag (GstTTMLScanner *scanner, const gchar *data,
+    gsize len, gsize pos, gboolean *document_end)
+{
+  while (pos < len) {
+    const gchar *gt, *quote, *double_quote, *limit;
+
+    if (scanner->quote) {
+      quote = memchr (data + pos, scanner->quote, len - pos);
+      if (!quote)
+        return len;
+      scanner->last = scanner->quote;
+      scanner->quote = 0;
+      pos = quote - data + 1;
+      continue;
+    }
+
+    /* Attribute values may contain '>' chars */
+    gt = memchr (data + pos, '>', len - pos);
+    limit = gt ? gt : data + len;
+    double_quote = memchr (data + pos, '"', limit - (data + pos));
+    if (double_quote)
+      limit = double_quote;
+    quote = memchr (data + pos, '\'', limit - (data + pos));
+    if (!quote)
+      quote = double_quote;
+    if (quote) {
+      scanner->quote = *quote;
+      pos = quote - data + 1;
+      continue;
+    }
+
+    if (!gt) {
+      scanner->last = data[len - 1];
+      return len;
+    }
+
+    if (gt > data + pos)
+      scanner->last = gt[-1];
+    pos = gt - data + 1;
+
+    if (scanner->state == GST_TTML_SCANNER_STATE_END_TAG) {
+      if (scanner->depth && --scanner->depth == 0)
+        *document_end = TRUE;
+    } else if (scanner->last != '/') {
+      scanner->depth++;
+    } else if (!scanner->depth) {
+      /* An empty root element */
+      *document_end = TRUE;
+    }
+    scanner->state = GST_TTML_SCANNER_STATE_TEXT;
+    return pos;
+  }
+
+  return len;
+}
+
+/* Scan 'len' bytes of the stream. If a document boundary is found in them,
+ * returns its offset: after the end of the root element for
+ * GST_TTML_SCANNER_BOUNDARY_END, or at the XML declaration of the new
+ * document for GST_TTML_SCANNER_BOUNDARY_RESTART. The scanner is then ready
+ * for the next document, starting at that offset. Otherwise, returns 'len'.
+ * If the XML declaration of a RESTART started in a previous buffer, the
+ * 'carried' first chars of "<?xml" belong to the new document too. */
+gsize
+gst_ttml_scanner_scan (GstTTMLScanner *scanner, const gchar *data, gsize len,
+    GstTTMLScannerBoundary *boundary)
+{
+  gboolean document_end = FALSE;
+  const gchar *declaration;
+  gsize pos = 0;
+
+  *boundary = GST_TTML_SCANNER_BOUNDARY_NONE;
+  scanner->markup = -1;
+  scanner->carried = 0;
+
+  while (pos < len) {
+    gchar c;
+
+    switch (scanner->state) {
+      case GST_TTML_SCANNER_STATE_TEXT: {
+        const gchar *lt = memchr (data + pos, '<', len - pos);
+
+        if (!lt)
+          return len;
+        pos = lt - data;
+        scanner->markup = pos++;
+        scanner->state = GST_TTML_SCANNER_STATE_MARKUP;
+        break;
+      }
+      case GST_TTML_SCANNER_STATE_MARKUP:
+        c = data[pos];
+        scanner->matched = 0;
+        scanner->quote = 0;
+        scanner->last = 0;
+        if (c == '!') {
+          scanner->state = GST_TTML_SCANNER_STATE_BANG;
+          pos++;
+        } else if (c == '?') {
+          scanner->state = GST_TTML_SCANNER_STATE_QUESTION;
+          pos++;
+        } else if (c == '/') {
+          scanner->state = GST_TTML_SCANNER_STATE_END_TAG;
+          pos++;
+        } else {
+          scanner->state = GST_TTML_SCANNER_STATE_START_TAG;
+        }
+        break;
+      case GST_TTML_SCANNER_STATE_BANG: {
+        /* Tell "<!--" and "<![CDATA[" apart from declarations. The first
+         * char of the prefix is kept in 'quote' meanwhile. */
+        const gchar *prefix;
+
+        c = data[pos];
+        if (!scanner->matched) {
+          if (c == '-' || c == '[') {
+            scanner->quote = c;
+            scanner->matched = 1;
+            pos++;
+          } else {
+            scanner->state = GST_TTML_SCANNER_STATE_DECLARATION;
+            scanner->brackets = 0;
+          }
+          break;
+        }
+
+        prefix = scanner->quote == '-' ? "--" : "[CDATA[";
+        if (c != prefix[scanner->matched]) {
+          scanner->state = GST_TTML_SCANNER_STATE_DECLARATION;
+          scanner->brackets = scanner->quote == '[';
+          scanner->quote = 0;
+          break;
+        }
+        pos++;
+        if (!prefix[++scanner->matched]) {
+          scanner->state = scanner->quote == '-'
+                               ? GST_TTML_SCANNER_STATE_COMMENT
+                               : GST_TTML_SCANNER_STATE_CDATA;
+          scanner->matched = 0;
+          scanner->quote = 0;
+        }
+        break;
+      }
+      case GST_TTML_SCANNER_STATE_QUESTION:
+        /* An XML declaration inside a document means that it was truncated
+         * and a new one started */
+        c = data[pos];
+        declaration = GST_TTML_SCANNER_XML_DECLARATION + 2;
+        if (declaration[scanner->matched] &&
+            c == declaration[scanner->matched]) {
+          scanner->matched++;
+          pos++;
+          break;
+        }
+        if (!declaration[scanner->matched] && g_ascii_isspace (c) &&
+            scanner->depth) {
+          gsize start = scanner->markup >= 0 ? scanner->markup : 0;
+          gsize size = strlen (GST_TTML_SCANNER_XML_DECLARATION);
+
+          gst_ttml_scanner_init (scanner);
+          if (start == 0 && pos < size) {
+            scanner->carried = size - pos;
+            scanner->state = GST_TTML_SCANNER_STATE_PI;
+          }
+          *boundary = GST_TTML_SCANNER_BOUNDARY_RESTART;
+          return start;
+        }
+        scanner->state = GST_TTML_SCANNER_STATE_PI;
+        scanner->matched = 0;
+        break;
+      case GST_TTML_SCANNER_STATE_COMMENT:
+        pos = gst_ttml_scanner_skip_until (scanner, data, len, pos, "-->");
+        break;
+      case GST_TTML_SCANNER_STATE_CDATA:
+        pos = gst_ttml_scanner_skip_until (scanner, data, len, pos, "]]>");
+        break;
+      case GST_TTML_SCANNER_STATE_PI:
+        pos = gst_ttml_scanner_skip_until (scanner, data, len, pos, "?>");
+        break;
+      case GST_TTML_SCANNER_STATE_DECLARATION:
+        pos = gst_ttml_scanner_skip_declaration (scanner, data, len, pos);
+        break;
+      case GST_TTML_SCANNER_STATE_START_TAG:
+      case GST_TTML_SCANNER_STATE_END_TAG:
+        pos = gst_ttml_scanner_skip_tag (
+            scanner, data, len, pos, &document_end);
+        if (document_end) {
+          GST_LOG ("Document end at offset %" G_GSIZE_FORMAT, pos);
+          gst_ttml_scanner_init (scanner);
+          *boundary = GST_TTML_SCANNER_BOUNDARY_END;
+          return pos;
+        }
+        break;
+    }
+  }
+
+  return len;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_SCANNER_H__
+#define __GST_TTML_SCANNER_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_TTML_SCANNER_STATE_TEXT,
+  /* After a '<' */
+  GST_TTML_SCANNER_STATE_MARKUP,
+  /* After "<!" and "<?" */
+  GST_TTML_SCANNER_STATE_BANG,
+  GST_TTML_SCANNER_STATE_QUESTION,
+  /* Looking for the terminator of these */
+  GST_TTML_SCANNER_STATE_COMMENT,
+  GST_TTML_SCANNER_STATE_CDATA,
+  GST_TTML_SCANNER_STATE_PI,
+  /* Document type declaration, up to a '>' outside of brackets */
+  GST_TTML_SCANNER_STATE_DECLARATION,
+  /* Start and end tags, up to a '>' outside of quotes */
+  GST_TTML_SCANNER_STATE_START_TAG,
+  GST_TTML_SCANNER_STATE_END_TAG
+} GstTTMLScannerState;
+
+typedef enum
+{
+  GST_TTML_SCANNER_BOUNDARY_NONE,
+  /* The root element of the document has been closed */
+  GST_TTML_SCANNER_BOUNDARY_END,
+  /* A new document starts before the current one was closed */
+  GST_TTML_SCANNER_BOUNDARY_RESTART
+} GstTTMLScannerBoundary;
+
+/* Finds where each document ends in a stream of concatenated XML documents,
+ * which may be split at any point across buffers. It is not a parser: it
+ * only follows the nesting of elements, skipping comments, CDATA sections,
+ * processing instructions and quoted attribute values, so the end of the
+ * root element is found whatever its name is (</tt>, </tt:tt>, <tt/>...).
+ * Text is skipped with memchr(), which the C library vectorizes.
+ * A zero-filled scanner is ready to use. */
+struct _GstTTMLScanner
+{
+  GstTTMLScannerState state;
+  /* Open elements */
+  guint depth;
+  /* Chars of the terminator of a comment, CDATA section, processing
+   * instruction or "<!" prefix matched so far */
+  guint matched;
+  /* Quote char of the attribute value, or bracket nesting, being skipped */
+  gchar quote;
+  guint brackets;
+  /* Last char of the current tag */
+  gchar last;
+  /* Offset of the last '<' inside the current data, -1 if it came in a
+   * previous buffer */
+  gssize markup;
+  /* Chars of "<?xml" which came in previous buffers, after a RESTART */
+  guint carried;
+};
+
+/* Start of the XML declaration, which is only allowed at document start */
+#define GST_TTML_SCANNER_XML_DECLARATION "<?xml"
+
+void gst_ttml_scanner_init (GstTTMLScanner *scanner);
+
+gsize gst_ttml_scanner_scan (GstTTMLScanner *scanner, const gchar *data,
+    gsize len, GstTTMLScannerBoundary *boundary);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_SCANNER_H__ */
@@ -112,14 +112,14 @@ gst_ttmlsegmentedparse_spans_dump (GstTTMLBase *base, xmlTextWriterPtr writer,
             writer, LIBXML_CHAR "begin", LIBXML_CHAR begin);
         xmlTextWriterWriteAttribute (
             writer, LIBXML_CHAR "end", LIBXML_CHAR end);
-        g_list_foreach (span->style.attributes,
+        gst_ttml_style_foreach (span->style,
             (GFunc) gst_ttmlsegmentedparse_paragraph_attr_dump, writer);
       }
 
       if (frag_len) {
         /* <span> */
         xmlTextWriterStartElement (writer, LIBXML_CHAR "span");
-        g_list_foreach (span->style.attributes,
+        gst_ttml_style_foreach (span->style,
             (GFunc) gst_ttmlsegmentedparse_attr_dump, writer);
         xmlTextWriterWriteFormatString (writer, "%.*s", frag_len, frag_start);
         /* </span> */
@@ -149,24 +149,26 @@ gst_ttmlsegmentedparse_spans_dump (GstTTMLBase *base, xmlTextWriterPtr writer,
 
 static void
 gst_ttmlsegmentedparse_region_dump (
-    gchar *id, GList *attrs, xmlTextWriterPtr writer)
+    gchar *id, GstTTMLStyle *style, xmlTextWriterPtr writer)
 {
   /* <region> */
   xmlTextWriterStartElement (writer, LIBXML_CHAR "region");
   xmlTextWriterWriteAttribute (writer, LIBXML_CHAR "xml:id", LIBXML_CHAR id);
-  g_list_foreach (attrs, (GFunc) gst_ttmlsegmentedparse_attr_dump, writer);
+  gst_ttml_style_foreach (
+      style, (GFunc) gst_ttmlsegmentedparse_attr_dump, writer);
   /* </region> */
   xmlTextWriterEndElement (writer);
 }
 
 static void
 gst_ttmlsegmentedparse_style_dump (
-    gchar *id, GList *attrs, xmlTextWriterPtr writer)
+    gchar *id, GstTTMLStyle *style, xmlTextWriterPtr writer)
 {
   /* <style> */
   xmlTextWriterStartElement (writer, LIBXML_CHAR "style");
   xmlTextWriterWriteAttribute (writer, LIBXML_CHAR "xml:id", LIBXML_CHAR id);
-  g_list_foreach (attrs, (GFunc) gst_ttmlsegmentedparse_attr_dump, writer);
+  gst_ttml_style_foreach (
+      style, (GFunc) gst_ttmlsegmentedparse_attr_dump, writer);
   /* </style> */
   xmlTextWriterEndElement (writer);
 }
@@ -216,7 +218,7 @@ gst_ttmlsegmentedparse_gen_buffer (
     xmlTextWriterWriteAttribute (
         writer, LIBXML_CHAR "cellResolution", LIBXML_CHAR value);
     g_free (value);
-    g_free (attr);
+    gst_ttml_attribute_free (attr);
   }
 
   /* <head> */
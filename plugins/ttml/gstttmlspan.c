@@ -8,6 +8,7 @@
 #endif
 
 #include <string.h>
+#include "gstttmlarena.h"
 #include "gstttmlspan.h"
 #include "gstttmlstyle.h"
 #include "gstttmlattribute.h"
@@ -29,12 +30,12 @@ gst_ttml_span_compose (GstTTMLSpan *span, GstTTMLSpan *output_span)
   const GstTTMLAttribute *attr;
 
   /* Do nothing if the span is disabled */
-  attr = gst_ttml_style_get_attr (&span->style, GST_TTML_ATTR_DISPLAY);
+  attr = gst_ttml_style_get_attr (span->style, GST_TTML_ATTR_DISPLAY);
   if (attr && attr->value.b == FALSE)
     return;
 
   gst_ttml_style_gen_pango_markup (
-      NULL, &span->style, &head, &tail, NULL, NULL);
+      NULL, span->style, &head, &tail, NULL, NULL);
   head_len = strlen (head);
   tail_len = strlen (tail);
 
@@ -58,29 +59,62 @@ gst_ttml_span_compose (GstTTMLSpan *span, GstTTMLSpan *output_span)
 void
 gst_ttml_span_free (GstTTMLSpan *span)
 {
-  g_free (span->chars);
-  gst_ttml_style_reset (&span->style);
-  g_free (span);
+  gst_ttml_arena_free (span->arena, span->chars, span->length);
+  gst_ttml_style_unref (span->style);
+  gst_ttml_arena_free (span->arena, span, sizeof (GstTTMLSpan));
 }
 
-/* Create a new text span. Timing information does not belong to the span
- * but to the event that contains it. */
+/* Create a new text span, allocated from the given arena (or the heap, if it
+ * is NULL). Timing information does not belong to the span but to the event
+ * that contains it. */
 GstTTMLSpan *
-gst_ttml_span_new (
-    guint id, guint length, const gchar *chars, const GstTTMLStyle *style)
+gst_ttml_span_new (GstTTMLArena *arena, guint id, guint length,
+    const gchar *chars, const GstTTMLStyle *style)
 {
   if (length == 0)
     return NULL;
 
-  GstTTMLSpan *span = g_new (GstTTMLSpan, 1);
+  GstTTMLSpan *span = gst_ttml_arena_alloc (arena, sizeof (GstTTMLSpan));
   span->id = id;
   span->length = length;
-  span->chars = (gchar *) g_memdup (chars, length);
-  gst_ttml_style_copy (&span->style, style, FALSE);
+  span->chars = (gchar *) gst_ttml_arena_memdup (arena, chars, length);
+  span->style = gst_ttml_style_intern (style);
+  span->arena = arena;
 
   return span;
 }
 
+/* Create a heap copy of a span. The style is shared with the original. */
+GstTTMLSpan *
+gst_ttml_span_copy (const GstTTMLSpan *span)
+{
+  GstTTMLSpan *copy = g_memdup (span, sizeof (GstTTMLSpan));
+
+  copy->chars = (gchar *) g_memdup (span->chars, span->length);
+  copy->style = gst_ttml_style_ref (span->style);
+  copy->arena = NULL;
+  return copy;
+}
+
+/* Create a heap copy of a span allocated from an arena, so it outlives it,
+ * and free the original. Heap spans are returned unchanged. */
+GstTTMLSpan *
+gst_ttml_span_promote (GstTTMLSpan *span)
+{
+  GstTTMLSpan *promoted;
+
+  if (!span || !span->arena)
+    return span;
+
+  /* The reference to the shared style is moved to the copy */
+  promoted = g_memdup (span, sizeof (GstTTMLSpan));
+  promoted->chars = (gchar *) g_memdup (span->chars, span->length);
+  promoted->arena = NULL;
+  gst_ttml_arena_free (span->arena, span->chars, span->length);
+  gst_ttml_arena_free (span->arena, span, sizeof (GstTTMLSpan));
+  return promoted;
+}
+
 /* Comparison function for spans */
 static gint
 gst_ttml_span_compare_id (GstTTMLSpan *a, guint *id)
@@ -118,13 +152,27 @@ gst_ttml_span_list_remove (GList *active_spans, guint id)
   return g_list_delete_link (active_spans, link);
 }
 
-/* Update the value of the specified attribute of the specified span id */
+/* Replace the spans of the list allocated from an arena by heap copies, so
+ * they survive the clearing of the arena */
+void
+gst_ttml_span_list_promote (GList *active_spans)
+{
+  GList *link;
+
+  for (link = active_spans; link; link = link->next)
+    link->data = gst_ttml_span_promote (link->data);
+}
+
+/* Update the value of the specified attribute of the specified span id.
+ * The style of the span is shared, so a new one is interned instead of
+ * modifying it. */
 void
 gst_ttml_span_list_update_attr (
     GList *active_spans, guint id, GstTTMLAttribute *attr)
 {
   GList *link = NULL;
   GstTTMLSpan *span;
+  GstTTMLStyle style;
   GstTTMLAttribute *prev_attr;
 
   GST_DEBUG ("Updating span with id %d, attr %s", id,
@@ -138,6 +186,12 @@ gst_ttml_span_list_update_attr (
     return;
   }
   span = (GstTTMLSpan *) link->data;
-  prev_attr = gst_ttml_style_set_attr (&span->style, attr);
+  gst_ttml_style_init (&style);
+  gst_ttml_style_copy (&style, span->style, FALSE);
+  prev_attr = gst_ttml_style_set_attr (&style, attr);
   gst_ttml_attribute_free (prev_attr);
+
+  gst_ttml_style_unref (span->style);
+  span->style = gst_ttml_style_intern (&style);
+  gst_ttml_style_reset (&style);
 }
@@ -19,20 +19,27 @@ struct _GstTTMLSpan
   guint id;
   guint length;
   gchar *chars;
-  GstTTMLStyle style;
+  GstTTMLStyle *style; /* Shared, see gst_ttml_style_intern */
+  GstTTMLArena *arena; /* Where it was allocated from, NULL for the heap */
 };
 
 void gst_ttml_span_compose (GstTTMLSpan *span, GstTTMLSpan *output_span);
 
-GstTTMLSpan *gst_ttml_span_new (
-    guint id, guint length, const gchar *chars, const GstTTMLStyle *style);
+GstTTMLSpan *gst_ttml_span_new (GstTTMLArena *arena, guint id, guint length,
+    const gchar *chars, const GstTTMLStyle *style);
 
 void gst_ttml_span_free (GstTTMLSpan *span);
 
+GstTTMLSpan *gst_ttml_span_copy (const GstTTMLSpan *span);
+
+GstTTMLSpan *gst_ttml_span_promote (GstTTMLSpan *span);
+
 GList *gst_ttml_span_list_add (GList *active_spans, GstTTMLSpan *span);
 
 GList *gst_ttml_span_list_remove (GList *active_spans, guint id);
 
+void gst_ttml_span_list_promote (GList *active_spans);
+
 void gst_ttml_span_list_update_attr (
     GList *active_spans, guint id, GstTTMLAttribute *attr);
 
@@ -7,6 +7,7 @@
 #include "config.h"
 #endif
 
+#include "gstttmlarena.h"
 #include "gstttmlattribute.h"
 #include "gstttmlstate.h"
 #include "gstttmlutils.h"
@@ -28,15 +29,10 @@ void
 gst_ttml_state_free (GstTTMLState *state)
 {
   gst_ttml_state_free_content (state);
+  gst_ttml_arena_release (&state->arena);
   g_free (state);
 }
 
-static void
-gst_ttml_state_free_attr_stack (GList *stack)
-{
-  g_list_free_full (stack, (GDestroyNotify) gst_ttml_attribute_free);
-}
-
 /* Set the state to default values */
 void
 gst_ttml_state_reset (GstTTMLState *state)
@@ -64,7 +60,7 @@ gst_ttml_state_reset (GstTTMLState *state)
 
   if (state->attribute_stack) {
     GST_WARNING ("Attribute stack should have been empty");
-    gst_ttml_state_free_attr_stack (state->attribute_stack);
+    /* Its attributes and links belong to the arena, cleared below */
     state->attribute_stack = NULL;
   }
 
@@ -82,6 +78,10 @@ gst_ttml_state_reset (GstTTMLState *state)
     g_hash_table_unref (state->saved_data);
     state->saved_data = NULL;
   }
+
+  /* Everything allocated while parsing the previous document is released
+   * at once. Whatever had to outlive it has already been promoted. */
+  gst_ttml_arena_clear (&state->arena);
 }
 
 /* Puts the given GstTTMLAttribute into the state, overwritting the current
@@ -206,35 +206,39 @@ gst_ttml_state_get_attribute (GstTTMLState *state, GstTTMLAttributeType type)
 
   switch (type) {
     case GST_TTML_ATTR_NODE_TYPE:
-      attr = gst_ttml_attribute_new_node (state->node_type);
+      attr = gst_ttml_attribute_new_node (&state->arena, state->node_type);
       break;
     case GST_TTML_ATTR_ID:
-      attr = gst_ttml_attribute_new_string (type, state->id);
+      attr = gst_ttml_attribute_new_string (&state->arena, type, state->id);
       break;
     case GST_TTML_ATTR_BEGIN:
-      attr = gst_ttml_attribute_new_time (type, state->begin);
+      attr = gst_ttml_attribute_new_time (&state->arena, type, state->begin);
       break;
     case GST_TTML_ATTR_END:
-      attr = gst_ttml_attribute_new_time (type, state->end);
+      attr = gst_ttml_attribute_new_time (&state->arena, type, state->end);
       break;
     case GST_TTML_ATTR_DUR:
-      attr = gst_ttml_attribute_new_time (type, state->end - state->begin);
+      attr = gst_ttml_attribute_new_time (
+          &state->arena, type, state->end - state->begin);
       break;
     case GST_TTML_ATTR_TICK_RATE:
-      attr = gst_ttml_attribute_new_double (type, state->tick_rate);
+      attr = gst_ttml_attribute_new_double (
+          &state->arena, type, state->tick_rate);
       break;
     case GST_TTML_ATTR_FRAME_RATE:
-      attr = gst_ttml_attribute_new_double (type, state->frame_rate);
+      attr = gst_ttml_attribute_new_double (
+          &state->arena, type, state->frame_rate);
       break;
     case GST_TTML_ATTR_FRAME_RATE_MULTIPLIER:
       attr = gst_ttml_attribute_new_fraction (
-          type, state->frame_rate_num, state->frame_rate_den);
+          &state->arena, type, state->frame_rate_num, state->frame_rate_den);
       break;
     case GST_TTML_ATTR_SUB_FRAME_RATE:
-      attr = gst_ttml_attribute_new_int (type, state->sub_frame_rate);
+      attr = gst_ttml_attribute_new_int (
+          &state->arena, type, state->sub_frame_rate);
       break;
     case GST_TTML_ATTR_CELLRESOLUTION:
-      attr = g_new0 (GstTTMLAttribute, 1);
+      attr = gst_ttml_attribute_new (&state->arena);
       attr->type = type;
       attr->value.raw_length[0].f = (float) state->cell_resolution_x;
       attr->value.raw_length[0].unit = GST_TTML_LENGTH_UNIT_CELLS;
@@ -242,34 +246,37 @@ gst_ttml_state_get_attribute (GstTTMLState *state, GstTTMLAttributeType type)
       attr->value.raw_length[1].unit = GST_TTML_LENGTH_UNIT_CELLS;
       break;
     case GST_TTML_ATTR_WHITESPACE_PRESERVE:
-      attr = gst_ttml_attribute_new_boolean (type, state->whitespace_preserve);
+      attr = gst_ttml_attribute_new_boolean (
+          &state->arena, type, state->whitespace_preserve);
       break;
     case GST_TTML_ATTR_SEQUENTIAL_TIME_CONTAINER:
       attr = gst_ttml_attribute_new_boolean (
-          type, state->sequential_time_container);
+          &state->arena, type, state->sequential_time_container);
       break;
     case GST_TTML_ATTR_TIME_BASE:
-      attr = gst_ttml_attribute_new_int (type, state->time_base);
+      attr = gst_ttml_attribute_new_int (
+          &state->arena, type, state->time_base);
       break;
     case GST_TTML_ATTR_CLOCK_MODE:
-      attr = gst_ttml_attribute_new_int (type, state->clock_mode);
+      attr = gst_ttml_attribute_new_int (
+          &state->arena, type, state->clock_mode);
       break;
     case GST_TTML_ATTR_PIXEL_ASPECT_RATIO:
       attr = gst_ttml_attribute_new_fraction (
-          type, state->par_num, state->par_den);
+          &state->arena, type, state->par_num, state->par_den);
       break;
     case GST_TTML_ATTR_STYLE:
       /* Nothing to do here: The style attribute is expanded
        * into multiple other attributes when set.
        * The region attribute is also expanded elsewhere, but we want the
        * region ID to be stored. */
-      attr = gst_ttml_attribute_new_string (type, NULL);
+      attr = gst_ttml_attribute_new_string (&state->arena, type, NULL);
       break;
     default:
       /* All Styling attributes are handled here */
       curr_attr = gst_ttml_style_get_attr (&state->style, type);
       if (curr_attr) {
-        attr = gst_ttml_attribute_copy (curr_attr, TRUE);
+        attr = gst_ttml_attribute_copy (&state->arena, curr_attr, TRUE);
       } else {
         attr = NULL;
       }
@@ -307,10 +314,12 @@ gst_ttml_state_push_attribute (GstTTMLState *state, GstTTMLAttribute *new_attr)
     /* There was no previous value for this attribute. Store in the stack a
      * special attribute which will remove this one (instead of replacing it
      * by some default value) */
-    old_attr = gst_ttml_attribute_new_style_removal (new_attr->type);
+    old_attr =
+        gst_ttml_attribute_new_style_removal (&state->arena, new_attr->type);
   }
 
-  state->attribute_stack = g_list_prepend (state->attribute_stack, old_attr);
+  state->attribute_stack = gst_ttml_arena_list_prepend (
+      &state->arena, state->attribute_stack, old_attr);
   GST_LOG ("Pushed attribute 0x%p (type %s)", old_attr,
       gst_ttml_utils_enum_name (old_attr->type, AttributeType));
   gst_ttml_state_merge_attribute (state, new_attr);
@@ -332,8 +341,8 @@ gst_ttml_state_pop_attribute (
   }
   attr = (GstTTMLAttribute *) state->attribute_stack->data;
   type = attr->type;
-  state->attribute_stack =
-      g_list_delete_link (state->attribute_stack, state->attribute_stack);
+  state->attribute_stack = gst_ttml_arena_list_delete_link (
+      &state->arena, state->attribute_stack, state->attribute_stack);
 
   GST_LOG ("Popped attribute 0x%p (type %s)", attr,
       gst_ttml_utils_enum_name (type, AttributeType));
@@ -356,6 +365,20 @@ gst_ttml_state_pop_attribute (
   return type;
 }
 
+static GHashTable *
+gst_ttml_state_new_styles_table (void)
+{
+  return g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free, (GDestroyNotify) gst_ttml_style_free);
+}
+
+static GHashTable *
+gst_ttml_state_new_data_table (void)
+{
+  return g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_bytes_unref);
+}
+
 /* Create a copy of the current attribute stack and store it in a hash table
  * with the specified ID string.
  * Create the hash table if necessary. Used for referential styling.
@@ -364,32 +387,39 @@ void
 gst_ttml_state_save_attr_stack (
     GstTTMLState *state, GHashTable **table, const gchar *id)
 {
-  GstTTMLStyle style_copy = { 0 };
-
-  if (!*table) {
-    *table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-        (GDestroyNotify) gst_ttml_state_free_attr_stack);
-  }
+  if (!*table)
+    *table = gst_ttml_state_new_styles_table ();
 
-  gst_ttml_style_copy (&style_copy, &state->style, TRUE);
-
-  if (style_copy.attributes) {
-    gchar *id_copy = g_strdup (id);
+  if (state->style.mask) {
+    GstTTMLStyle *style_copy = gst_ttml_style_new ();
 
+    gst_ttml_style_copy (style_copy, &state->style, TRUE);
     GST_DEBUG ("Storing style or region '%s'", id);
-    g_hash_table_insert (*table, id_copy, style_copy.attributes);
+    g_hash_table_insert (*table, g_strdup (id), style_copy);
   } else {
     GST_WARNING ("Trying to store empty style or region definition '%s'", id);
   }
 }
 
-/* Retrieve the attribute stack with the given id from the hash table and
- * apply it. Used for referential and region styling. */
+/* Push a copy of a styling attribute of a named style or region */
+static void
+gst_ttml_state_push_styling_attribute (
+    GstTTMLAttribute *attr, GstTTMLState *state)
+{
+  if (attr->type > GST_TTML_ATTR_STYLE) {
+    GstTTMLAttribute *attr_copy =
+        gst_ttml_attribute_copy (&state->arena, attr, TRUE);
+    gst_ttml_state_push_attribute (state, attr_copy);
+  }
+}
+
+/* Retrieve the style with the given id from the hash table and apply it.
+ * Used for referential and region styling. */
 void
 gst_ttml_state_restore_attr_stack (
     GstTTMLState *state, GHashTable *table, const gchar *id)
 {
-  GList *attr_link = NULL;
+  GstTTMLStyle *style = NULL;
 
   /* When a Style or Region attribute is found, the previous style or region
    * is pushed onto the stack.
@@ -399,47 +429,34 @@ gst_ttml_state_restore_attr_stack (
     return;
 
   if (table) {
-    g_hash_table_lookup_extended (table, id, NULL, (gpointer *) &attr_link);
+    style = (GstTTMLStyle *) g_hash_table_lookup (table, id);
   }
 
-  if (!attr_link) {
+  if (!style) {
     GST_WARNING ("Undefined style or region '%s'", id);
     return;
   }
 
   GST_DEBUG ("Applying style or region '%s'", id);
 
-  while (attr_link) {
-    GstTTMLAttribute *attr = (GstTTMLAttribute *) attr_link->data;
-    if (attr->type > GST_TTML_ATTR_STYLE) {
-      GstTTMLAttribute *attr_copy = gst_ttml_attribute_copy (attr, TRUE);
-      gst_ttml_state_push_attribute (state, attr_copy);
-    }
-
-    attr_link = attr_link->next;
-  }
+  gst_ttml_style_foreach (
+      style, (GFunc) gst_ttml_state_push_styling_attribute, state);
 }
 
 /* Store the current data in the saved_data hash table with the specified ID
  * string. Create the hash table if necessary. Data is fully transferred, do
- * not free.
+ * not unref.
  */
 void
-gst_ttml_state_save_data (
-    GstTTMLState *state, guint8 *data, gint length, const gchar *id)
+gst_ttml_state_save_data (GstTTMLState *state, GBytes *data, const gchar *id)
 {
   gchar *id_copy = g_strdup (id);
 
-  if (!state->saved_data) {
-    state->saved_data =
-        g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-  }
+  if (!state->saved_data)
+    state->saved_data = gst_ttml_state_new_data_table ();
 
-  /* Add a little header stating the data size */
-  GST_DEBUG ("Storing image '%s' (raw length is %d bytes)", id, length);
-  data = (guint8 *) g_realloc (data, length + 4);
-  memmove (data + 4, data, length);
-  *(gint32 *) data = length;
+  GST_DEBUG ("Storing image '%s' (raw length is %" G_GSIZE_FORMAT " bytes)",
+      id, g_bytes_get_size (data));
   g_hash_table_insert (state->saved_data, id_copy, data);
 }
 
@@ -447,7 +464,8 @@ void
 gst_ttml_state_restore_data (
     const GstTTMLState *state, const gchar *id, guint8 **data, gint *length)
 {
-  guint8 *rawdata;
+  GBytes *bytes;
+  gsize size;
 
   *data = NULL;
   *length = 0;
@@ -458,33 +476,78 @@ gst_ttml_state_restore_data (
   if (!state->saved_data)
     return;
 
-  rawdata = (guint8 *) g_hash_table_lookup (state->saved_data, id);
+  bytes = (GBytes *) g_hash_table_lookup (state->saved_data, id);
+
+  if (bytes) {
+    *data = (guint8 *) g_bytes_get_data (bytes, &size);
+    *length = size;
+  }
+}
+
+/* Add copies of the entries of a table of named styles, like
+ * saved_styling_attr_stacks, to another one. Create it if necessary. */
+void
+gst_ttml_state_copy_styles_table (GHashTable **dest, GHashTable *src)
+{
+  GHashTableIter iter;
+  gpointer id, style;
+
+  if (!src)
+    return;
+
+  if (!*dest)
+    *dest = gst_ttml_state_new_styles_table ();
+
+  g_hash_table_iter_init (&iter, src);
+  while (g_hash_table_iter_next (&iter, &id, &style)) {
+    GstTTMLStyle *style_copy = gst_ttml_style_new ();
+
+    gst_ttml_style_copy (style_copy, (GstTTMLStyle *) style, TRUE);
+    g_hash_table_insert (*dest, g_strdup ((gchar *) id), style_copy);
+  }
+}
+
+/* Add the entries of a table of saved data, like saved_data, to another
+ * one. Create it if necessary. The data is immutable, so it is shared. */
+void
+gst_ttml_state_copy_data_table (GHashTable **dest, GHashTable *src)
+{
+  GHashTableIter iter;
+  gpointer id, data;
+
+  if (!src)
+    return;
+
+  if (!*dest)
+    *dest = gst_ttml_state_new_data_table ();
 
-  if (rawdata) {
-    *length = *(gint32 *) rawdata;
-    *data = rawdata + 4;
+  g_hash_table_iter_init (&iter, src);
+  while (g_hash_table_iter_next (&iter, &id, &data)) {
+    g_hash_table_insert (
+        *dest, g_strdup ((gchar *) id), g_bytes_ref ((GBytes *) data));
   }
 }
 
-/* Create a new region in the hash of regions of the state. The ID is taken
- * from the style (it must be one of its attributes). The style ptr is stored
- * in the hash, so the caller must not free it. */
+/* Create a new region in the hash of regions of the state. The attributes
+ * of the style are moved to the hash, leaving it empty. */
 void
 gst_ttml_state_new_region (
     GstTTMLState *state, const gchar *id, GstTTMLStyle *style)
 {
-  gchar *id_copy;
+  GstTTMLStyle *region_style;
 
   if (!state->saved_region_attr_stacks) {
     state->saved_region_attr_stacks = g_hash_table_new_full (g_str_hash,
-        g_str_equal, g_free, (GDestroyNotify) gst_ttml_state_free_attr_stack);
+        g_str_equal, g_free, (GDestroyNotify) gst_ttml_style_free);
   }
 
-  id_copy = g_strdup (id);
+  region_style = g_new (GstTTMLStyle, 1);
+  *region_style = *style;
+  gst_ttml_style_init (style);
 
-  GST_DEBUG ("Storing region '%s'", id_copy);
+  GST_DEBUG ("Storing region '%s'", id);
   g_hash_table_insert (
-      state->saved_region_attr_stacks, id_copy, style->attributes);
+      state->saved_region_attr_stacks, g_strdup (id), region_style);
 }
 
 /* Remove region from hash table */
@@ -512,16 +575,16 @@ gst_ttml_state_update_region_attr (
     GstTTMLState *state, const gchar *id, GstTTMLAttribute *attr)
 {
   GstTTMLAttribute *prev_attr;
-  GstTTMLStyle style;
+  GstTTMLStyle *style;
 
   GST_DEBUG ("Updating region with id %s, attr %s", id,
       gst_ttml_utils_enum_name (attr->type, AttributeType));
-  style.attributes =
-      (GList *) g_hash_table_lookup (state->saved_region_attr_stacks, id);
-  if (!style.attributes) {
+  style = (GstTTMLStyle *) g_hash_table_lookup (
+      state->saved_region_attr_stacks, id);
+  if (!style) {
     GST_WARNING ("Could not find region with id %s", id);
     return;
   }
-  prev_attr = gst_ttml_style_set_attr (&style, attr);
+  prev_attr = gst_ttml_style_set_attr (style, attr);
   gst_ttml_attribute_free (prev_attr);
 }
@@ -10,6 +10,7 @@
 #include "gstttmlforward.h"
 #include "gstttmlenums.h"
 #include "gstttmlstyle.h"
+#include "gstttmlarena.h"
 
 G_BEGIN_DECLS
 
@@ -48,12 +49,16 @@ struct _GstTTMLState
    */
   GList *attribute_stack;
 
+  /* Memory for the objects created while parsing a document: attributes,
+   * events, spans and the attribute stack. Cleared on reset. */
+  GstTTMLArena arena;
+
   /* These are named styles used for referential styling.
-   * Each entry in the HashTable is an attribute stack. */
+   * Each entry in the HashTable is a GstTTMLStyle. */
   GHashTable *saved_styling_attr_stacks;
 
   /* These are named styles used for regions.
-   * Each entry in the HashTable is an attribute stack. */
+   * Each entry in the HashTable is a GstTTMLStyle. */
   GHashTable *saved_region_attr_stacks;
 
   /* These are named pieces of data, generally, PNG-encoded images. */
@@ -83,11 +88,15 @@ void gst_ttml_state_restore_attr_stack (
     GstTTMLState *state, GHashTable *table, const gchar *id);
 
 void gst_ttml_state_save_data (
-    GstTTMLState *state, guint8 *data, gint length, const gchar *id);
+    GstTTMLState *state, GBytes *data, const gchar *id);
 
 void gst_ttml_state_restore_data (
     const GstTTMLState *state, const gchar *id, guint8 **data, gint *length);
 
+void gst_ttml_state_copy_styles_table (GHashTable **dest, GHashTable *src);
+
+void gst_ttml_state_copy_data_table (GHashTable **dest, GHashTable *src);
+
 void gst_ttml_state_new_region (
     GstTTMLState *state, const gchar *id, GstTTMLStyle *style);
 
@@ -12,18 +12,156 @@
 #include "gstttmlstate.h"
 #include "gstttmlattribute.h"
 #include "gstttmlevent.h"
+#include "gstttmltimeline.h"
 #include "gstttmlutils.h"
 
 GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
 #define GST_CAT_DEFAULT ttmlbase_debug
 
+G_STATIC_ASSERT (GST_TTML_ATTR_UNKNOWN <= 64);
+
+/* Shared styles, see gst_ttml_style_intern. They are shared among all
+ * elements, so the table is protected by its lock. */
+static GHashTable *interned_styles = NULL;
+G_LOCK_DEFINE_STATIC (interned_styles);
+
+/* Type of the lowest attribute present in the mask, which must not be 0 */
+static inline GstTTMLAttributeType
+gst_ttml_style_lowest_type (guint64 mask)
+{
+#if defined(__GNUC__)
+  return (GstTTMLAttributeType) __builtin_ctzll (mask);
+#else
+  guint type = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    type++;
+  }
+  return (GstTTMLAttributeType) type;
+#endif
+}
+
+/* Set the style to empty */
+void
+gst_ttml_style_init (GstTTMLStyle *style)
+{
+  style->mask = 0;
+  style->ref_count = 0;
+}
+
+/* Allocate an empty style, for the hash tables of named styles */
+GstTTMLStyle *
+gst_ttml_style_new (void)
+{
+  return g_new0 (GstTTMLStyle, 1);
+}
+
+void
+gst_ttml_style_free (GstTTMLStyle *style)
+{
+  gst_ttml_style_reset (style);
+  g_free (style);
+}
+
+static guint
+gst_ttml_style_hash (const GstTTMLStyle *style)
+{
+  guint hash = (guint) (style->mask ^ (style->mask >> 32));
+  guint64 it;
+
+  for (it = style->mask; it; it &= it - 1)
+    hash = hash * 31 + gst_ttml_attribute_hash (
+                           style->attributes[gst_ttml_style_lowest_type (it)]);
+  return hash;
+}
+
+static gboolean
+gst_ttml_style_equal (const GstTTMLStyle *a, const GstTTMLStyle *b)
+{
+  guint64 it;
+
+  if (a->mask != b->mask)
+    return FALSE;
+  for (it = a->mask; it; it &= it - 1) {
+    GstTTMLAttributeType type = gst_ttml_style_lowest_type (it);
+    if (!gst_ttml_attribute_equal (a->attributes[type], b->attributes[type]))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* Return the shared style with the same attributes as the given one,
+ * creating it if it did not exist yet. Attribute timelines are not part of
+ * shared styles. The returned style must not be modified, release it with
+ * gst_ttml_style_unref. */
+GstTTMLStyle *
+gst_ttml_style_intern (const GstTTMLStyle *style)
+{
+  GstTTMLStyle *shared;
+
+  G_LOCK (interned_styles);
+  if (!interned_styles)
+    interned_styles = g_hash_table_new (
+        (GHashFunc) gst_ttml_style_hash, (GEqualFunc) gst_ttml_style_equal);
+
+  shared = g_hash_table_lookup (interned_styles, style);
+  if (shared) {
+    g_atomic_int_inc (&shared->ref_count);
+  } else {
+    shared = gst_ttml_style_new ();
+    gst_ttml_style_copy (shared, style, FALSE);
+    shared->ref_count = 1;
+    g_hash_table_add (interned_styles, shared);
+  }
+  G_UNLOCK (interned_styles);
+
+  return shared;
+}
+
+GstTTMLStyle *
+gst_ttml_style_ref (GstTTMLStyle *style)
+{
+  g_return_val_if_fail (style->ref_count > 0, NULL);
+
+  g_atomic_int_inc (&style->ref_count);
+  return style;
+}
+
+/* Release a shared style, which is freed with its last reference. */
+void
+gst_ttml_style_unref (GstTTMLStyle *style)
+{
+  gboolean last;
+
+  g_return_if_fail (style->ref_count > 0);
+
+  /* Under the lock, so gst_ttml_style_intern cannot find it in the table
+   * while its last reference is being dropped */
+  G_LOCK (interned_styles);
+  last = g_atomic_int_dec_and_test (&style->ref_count);
+  if (last) {
+    g_hash_table_remove (interned_styles, style);
+    if (!g_hash_table_size (interned_styles)) {
+      g_hash_table_unref (interned_styles);
+      interned_styles = NULL;
+    }
+  }
+  G_UNLOCK (interned_styles);
+
+  if (last)
+    gst_ttml_style_free (style);
+}
+
 /* Set the state to default TTML values */
 void
 gst_ttml_style_reset (GstTTMLStyle *style)
 {
-  g_list_free_full (
-      style->attributes, (GDestroyNotify) gst_ttml_attribute_free);
-  style->attributes = NULL;
+  guint64 it;
+
+  for (it = style->mask; it; it &= it - 1)
+    gst_ttml_attribute_free (
+        style->attributes[gst_ttml_style_lowest_type (it)]);
+  style->mask = 0;
 }
 
 /* Make a deep copy of the style, overwritting dest_style */
@@ -31,77 +169,103 @@ void
 gst_ttml_style_copy (GstTTMLStyle *dest_style, const GstTTMLStyle *org_style,
     gboolean include_timeline)
 {
-  GList *link;
-  dest_style->attributes = g_list_copy (org_style->attributes);
-  link = dest_style->attributes;
-  while (link) {
-    link->data = gst_ttml_attribute_copy (
-        (GstTTMLAttribute *) link->data, include_timeline);
-    link = link->next;
+  guint64 it;
+
+  dest_style->mask = org_style->mask;
+  for (it = org_style->mask; it; it &= it - 1) {
+    GstTTMLAttributeType type = gst_ttml_style_lowest_type (it);
+    dest_style->attributes[type] = gst_ttml_attribute_copy (
+        NULL, org_style->attributes[type], include_timeline);
+  }
+}
+
+/* Copy all the attributes of org_style into dest_style, replacing the ones
+ * of the same type it already had */
+void
+gst_ttml_style_merge (GstTTMLStyle *dest_style, const GstTTMLStyle *org_style,
+    gboolean include_timeline)
+{
+  guint64 it;
+
+  for (it = org_style->mask & dest_style->mask; it; it &= it - 1)
+    gst_ttml_attribute_free (
+        dest_style->attributes[gst_ttml_style_lowest_type (it)]);
+
+  dest_style->mask |= org_style->mask;
+  for (it = org_style->mask; it; it &= it - 1) {
+    GstTTMLAttributeType type = gst_ttml_style_lowest_type (it);
+    dest_style->attributes[type] = gst_ttml_attribute_copy (
+        NULL, org_style->attributes[type], include_timeline);
   }
 }
 
+/* Call func for every attribute of the style, in type order */
+void
+gst_ttml_style_foreach (
+    const GstTTMLStyle *style, GFunc func, gpointer user_data)
+{
+  guint64 it;
+
+  for (it = style->mask; it; it &= it - 1)
+    func (style->attributes[gst_ttml_style_lowest_type (it)], user_data);
+}
+
 /* Retrieve the given attribute type. It belongs to the style, do not free. */
 GstTTMLAttribute *
 gst_ttml_style_get_attr (const GstTTMLStyle *style, GstTTMLAttributeType type)
 {
-  GList *link;
+  if (type >= GST_TTML_ATTR_UNKNOWN ||
+      !(style->mask & GST_TTML_STYLE_MASK (type)))
+    return NULL;
+  return style->attributes[type];
+}
+
+/* Put the given attribute into the style, taking ownership. If that type
+ * already exists, it is replaced. The previous value is returned, do not
+ * forget to free it! */
+GstTTMLAttribute *
+gst_ttml_style_take_attr (GstTTMLStyle *style, GstTTMLAttribute *attr)
+{
+  GstTTMLAttribute *ret_attr;
+
+  g_return_val_if_fail (attr->type < GST_TTML_ATTR_UNKNOWN, NULL);
 
-  link = g_list_find_custom (style->attributes, (gconstpointer) type,
-      (GCompareFunc) gst_ttml_attribute_compare_type_func);
+  ret_attr = gst_ttml_style_get_attr (style, attr->type);
+  style->attributes[attr->type] = attr;
+  style->mask |= GST_TTML_STYLE_MASK (attr->type);
 
-  if (link)
-    return (GstTTMLAttribute *) link->data;
-  return NULL;
+  return ret_attr;
 }
 
-/* Put the given attribute into the list (making a copy). If that type
+/* Put the given attribute into the style (making a copy). If that type
  * already exists, it is replaced. The previous value is returned, do not
  * forget to free it! */
 GstTTMLAttribute *
 gst_ttml_style_set_attr (GstTTMLStyle *style, const GstTTMLAttribute *attr)
 {
   GstTTMLAttribute *ret_attr;
-  GstTTMLAttribute *new_attr;
-  GList *prev_link;
+  GstTTMLAttributeType type;
 
   /* Special attribute: It does not represent an actual attr. It is a command
    * to remove another attr, hence restoring it to its default value. */
   if (attr->type == GST_TTML_ATTR_STYLE_REMOVAL) {
-    prev_link = g_list_find_custom (style->attributes,
-        (gconstpointer) attr->value.removed_attribute_type,
-        (GCompareFunc) gst_ttml_attribute_compare_type_func);
+    type = attr->value.removed_attribute_type;
+    ret_attr = gst_ttml_style_get_attr (style, type);
 
-    if (!prev_link) {
+    if (!ret_attr) {
       GST_WARNING ("Cannot remove style %s: not present",
-          gst_ttml_utils_enum_name (
-              attr->value.removed_attribute_type, AttributeType));
+          gst_ttml_utils_enum_name (type, AttributeType));
       return NULL;
     }
     /* Remove attribute from style */
     GST_DEBUG ("Removing attribute '%s'",
-        gst_ttml_utils_enum_name (
-            attr->value.removed_attribute_type, AttributeType));
-    ret_attr = (GstTTMLAttribute *) prev_link->data;
-    style->attributes = g_list_delete_link (style->attributes, prev_link);
+        gst_ttml_utils_enum_name (type, AttributeType));
+    style->mask &= ~GST_TTML_STYLE_MASK (type);
     return ret_attr;
   }
 
-  prev_link =
-      g_list_find_custom (style->attributes, (gconstpointer) attr->type,
-          (GCompareFunc) gst_ttml_attribute_compare_type_func);
-
-  new_attr = gst_ttml_attribute_copy (attr, TRUE);
-
-  if (prev_link) {
-    ret_attr = (GstTTMLAttribute *) prev_link->data;
-    prev_link->data = new_attr;
-  } else {
-    ret_attr = NULL;
-    style->attributes = g_list_prepend (style->attributes, new_attr);
-  }
-
-  return ret_attr;
+  return gst_ttml_style_take_attr (
+      style, gst_ttml_attribute_copy (NULL, attr, TRUE));
 }
 
 /* Helper function that simply concatenates two strings */
@@ -142,8 +306,8 @@ gst_ttml_style_gen_pango_markup (const GstTTMLState *state,
     const gchar *default_font_family, const gchar *default_font_size)
 {
   gchar *attrs = g_strdup ("");
-  GList *link =
-      style_override ? style_override->attributes : state->style.attributes;
+  const GstTTMLStyle *style = style_override ? style_override : &state->style;
+  guint64 it;
   gchar *font_family = g_strdup (default_font_family);
   gchar *font_size = g_strdup (default_font_size);
   gboolean font_size_is_relative = FALSE;
@@ -154,8 +318,9 @@ gst_ttml_style_gen_pango_markup (const GstTTMLState *state,
    * Transparency is lost in the Pango Markup.
    * FIXME: A little-endian machine is currently assumed for colors */
 
-  while (link) {
-    GstTTMLAttribute *attr = (GstTTMLAttribute *) link->data;
+  for (it = style->mask; it; it &= it - 1) {
+    GstTTMLAttribute *attr =
+        style->attributes[gst_ttml_style_lowest_type (it)];
     switch (attr->type) {
       case GST_TTML_ATTR_COLOR:
         if (attr->value.color >> 8 != 0xFFFFFF)
@@ -231,7 +396,6 @@ gst_ttml_style_gen_pango_markup (const GstTTMLState *state,
         /* Ignore all other attributes, as they have no effect on the style */
         break;
     }
-    link = link->next;
   }
 
   if (font_family != NULL || font_size != NULL) {
@@ -282,52 +446,48 @@ gst_ttml_style_gen_pango_markup (const GstTTMLState *state,
 
 /* Generate events for each animated attribute in a span,
  * and add them to the timeline */
-GList *
+void
 gst_ttml_style_gen_span_events (
-    guint span_id, GstTTMLStyle *style, GList *timeline)
+    guint span_id, GstTTMLStyle *style, GstTTMLTimeline *timeline)
 {
-  GList *attr_link = style->attributes;
+  guint64 it;
 
-  while (attr_link) {
-    GstTTMLAttribute *attr = (GstTTMLAttribute *) attr_link->data;
+  for (it = style->mask; it; it &= it - 1) {
+    GstTTMLAttribute *attr =
+        style->attributes[gst_ttml_style_lowest_type (it)];
     GList *event_link = attr->timeline;
     while (event_link) {
       GstTTMLAttributeEvent *event =
           (GstTTMLAttributeEvent *) event_link->data;
       GstTTMLEvent *new_event = gst_ttml_event_new_attr_update (
-          span_id, event->timestamp, event->attr);
-      timeline = gst_ttml_event_list_insert (timeline, new_event);
+          NULL, span_id, event->timestamp, event->attr);
+      gst_ttml_timeline_insert (timeline, new_event);
 
       event_link = event_link->next;
     }
-
-    attr_link = attr_link->next;
   }
-  return timeline;
 }
 
 /* Generate events for each animated attribute in a region,
  * and add them to the timeline */
-GList *
+void
 gst_ttml_style_gen_region_events (
-    const gchar *id, GstTTMLStyle *style, GList *timeline)
+    const gchar *id, GstTTMLStyle *style, GstTTMLTimeline *timeline)
 {
-  GList *attr_link = style->attributes;
+  guint64 it;
 
-  while (attr_link) {
-    GstTTMLAttribute *attr = (GstTTMLAttribute *) attr_link->data;
+  for (it = style->mask; it; it &= it - 1) {
+    GstTTMLAttribute *attr =
+        style->attributes[gst_ttml_style_lowest_type (it)];
     GList *event_link = attr->timeline;
     while (event_link) {
       GstTTMLAttributeEvent *event =
           (GstTTMLAttributeEvent *) event_link->data;
-      GstTTMLEvent *new_event =
-          gst_ttml_event_new_region_update (event->timestamp, id, event->attr);
-      timeline = gst_ttml_event_list_insert (timeline, new_event);
+      GstTTMLEvent *new_event = gst_ttml_event_new_region_update (
+          NULL, event->timestamp, id, event->attr);
+      gst_ttml_timeline_insert (timeline, new_event);
 
       event_link = event_link->next;
     }
-
-    attr_link = attr_link->next;
   }
-  return timeline;
 }
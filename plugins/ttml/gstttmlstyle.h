@@ -12,12 +12,35 @@
 
 G_BEGIN_DECLS
 
-/* A style is nothing but a list of attributes */
+/* A style is nothing but a set of attributes, at most one of each type.
+ * They are stored in a table indexed by type, and the bits of 'mask' tell
+ * which entries are present, so lookups are O(1) and copies and merges only
+ * visit the present attributes. Entries whose bit is not set are undefined.
+ * A zero-filled style is a valid empty style.
+ * Styles obtained from gst_ttml_style_intern are shared: identical attribute
+ * sets map to the same refcounted object, which must never be modified, so
+ * two shared styles are equal if and only if they are the same pointer. */
 struct _GstTTMLStyle
 {
-  GList *attributes;
+  guint64 mask;
+  GstTTMLAttribute *attributes[GST_TTML_ATTR_UNKNOWN];
+  gint ref_count; /* 0 for styles which are not shared */
 };
 
+#define GST_TTML_STYLE_MASK(type) (G_GUINT64_CONSTANT (1) << (type))
+
+void gst_ttml_style_init (GstTTMLStyle *style);
+
+GstTTMLStyle *gst_ttml_style_new (void);
+
+void gst_ttml_style_free (GstTTMLStyle *style);
+
+GstTTMLStyle *gst_ttml_style_intern (const GstTTMLStyle *style);
+
+GstTTMLStyle *gst_ttml_style_ref (GstTTMLStyle *style);
+
+void gst_ttml_style_unref (GstTTMLStyle *style);
+
 void gst_ttml_style_reset (GstTTMLStyle *style);
 
 void gst_ttml_style_copy (GstTTMLStyle *dest_style,
@@ -29,15 +52,24 @@ GstTTMLAttribute *gst_ttml_style_get_attr (
 GstTTMLAttribute *gst_ttml_style_set_attr (
     GstTTMLStyle *style, const GstTTMLAttribute *attr);
 
+GstTTMLAttribute *gst_ttml_style_take_attr (
+    GstTTMLStyle *style, GstTTMLAttribute *attr);
+
+void gst_ttml_style_merge (GstTTMLStyle *dest_style,
+    const GstTTMLStyle *org_style, gboolean include_timeline);
+
+void gst_ttml_style_foreach (
+    const GstTTMLStyle *style, GFunc func, gpointer user_data);
+
 void gst_ttml_style_gen_pango_markup (const GstTTMLState *state,
     const GstTTMLStyle *style_override, gchar **head, gchar **tail,
     const gchar *default_font_family, const gchar *default_font_size);
 
-GList *gst_ttml_style_gen_span_events (
-    guint span_id, GstTTMLStyle *style, GList *timeline);
+void gst_ttml_style_gen_span_events (
+    guint span_id, GstTTMLStyle *style, GstTTMLTimeline *timeline);
 
-GList *gst_ttml_style_gen_region_events (
-    const gchar *id, GstTTMLStyle *style, GList *timeline);
+void gst_ttml_style_gen_region_events (
+    const gchar *id, GstTTMLStyle *style, GstTTMLTimeline *timeline);
 
 G_END_DECLS
 
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstttmltimeline.h"
+#include "gstttmlspan.h"
+#include "gstttmlutils.h"
+#include "gstttmlbase.h"
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+/* Events with the same timestamp are grouped in three classes: REGION BEGINs
+ * first and REGION ENDs last, so regions enclose the spans, and everything
+ * else in between. Inside a class, the order is the one the timeline always
+ * had when it was a sorted GList: newest first, except for REGION ENDs,
+ * which keep their insertion order. */
+typedef enum
+{
+  GST_TTML_TIMELINE_CLASS_OPEN,
+  GST_TTML_TIMELINE_CLASS_CONTENT,
+  GST_TTML_TIMELINE_CLASS_CLOSE
+} GstTTMLTimelineClass;
+
+struct _GstTTMLTimelineNode
+{
+  GstTTMLEvent *event;
+  GstTTMLTimelineClass klass;
+  gint64 order;
+  guint level;
+  GstTTMLTimelineNode *next[];
+};
+
+static gboolean
+gst_ttml_timeline_node_before (
+    const GstTTMLTimelineNode *a, const GstTTMLTimelineNode *b)
+{
+  if (a->event->timestamp != b->event->timestamp)
+    return a->event->timestamp < b->event->timestamp;
+  if (a->klass != b->klass)
+    return a->klass < b->klass;
+  return a->order < b->order;
+}
+
+/* Each level holds a quarter of the nodes of the one below */
+static guint
+gst_ttml_timeline_random_level (GstTTMLTimeline *timeline)
+{
+  guint32 r = timeline->random;
+  guint level = 1;
+
+  /* xorshift32, deterministic so runs are reproducible */
+  r ^= r << 13;
+  r ^= r >> 17;
+  r ^= r << 5;
+  timeline->random = r;
+
+  while ((r & 3) == 0 && level < GST_TTML_TIMELINE_MAX_LEVEL) {
+    level++;
+    r >>= 2;
+  }
+  return level;
+}
+
+static void
+gst_ttml_timeline_debug_event (GstTTMLEvent *event)
+{
+  GST_DEBUG ("Inserting event %s at %" GST_TIME_FORMAT,
+      gst_ttml_event_type_name (event->type),
+      GST_TIME_ARGS (event->timestamp));
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      GST_DEBUG ("  span id %d, %d chars", event->data.span_begin.span->id,
+          event->data.span_begin.span->length);
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_END:
+      GST_DEBUG ("  span id %d", event->data.span_end.id);
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      GST_DEBUG ("  %s for span id %d",
+          gst_ttml_utils_enum_name (
+              event->data.attr_update.attr->type, AttributeType),
+          event->data.attr_update.id);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Prepare an empty timeline */
+void
+gst_ttml_timeline_init (GstTTMLTimeline *timeline)
+{
+  memset (timeline, 0, sizeof (GstTTMLTimeline));
+  timeline->random = 0x2545f491;
+}
+
+/* Free all the events in the timeline. It can be used again afterwards. */
+void
+gst_ttml_timeline_clear (GstTTMLTimeline *timeline)
+{
+  GstTTMLEvent *event;
+
+  while ((event = gst_ttml_timeline_pop (timeline)))
+    gst_ttml_event_free (event);
+  timeline->seqnum = 0;
+}
+
+/* Replace the events which were allocated from an arena by heap copies, so
+ * they survive the clearing of the arena */
+void
+gst_ttml_timeline_promote (GstTTMLTimeline *timeline)
+{
+  GstTTMLTimelineNode *node;
+
+  for (node = timeline->head[0]; node; node = node->next[0])
+    node->event = gst_ttml_event_promote (node->event);
+}
+
+gboolean
+gst_ttml_timeline_is_empty (const GstTTMLTimeline *timeline)
+{
+  return timeline->head[0] == NULL;
+}
+
+guint
+gst_ttml_timeline_get_length (const GstTTMLTimeline *timeline)
+{
+  return timeline->length;
+}
+
+/* Insert an event into the timeline, ordered by timestamp.
+ * You lose ownership of the event. */
+void
+gst_ttml_timeline_insert (GstTTMLTimeline *timeline, GstTTMLEvent *event)
+{
+  GstTTMLTimelineNode **update[GST_TTML_TIMELINE_MAX_LEVEL];
+  GstTTMLTimelineNode **links = timeline->head;
+  GstTTMLTimelineNode *node;
+  guint level, i;
+  gint64 seqnum;
+
+  if (!event)
+    return;
+
+  gst_ttml_timeline_debug_event (event);
+
+  if (timeline->capture)
+    g_ptr_array_add (timeline->capture, gst_ttml_event_copy (event));
+
+  level = gst_ttml_timeline_random_level (timeline);
+  node = g_malloc (
+      sizeof (GstTTMLTimelineNode) + level * sizeof (GstTTMLTimelineNode *));
+  node->event = event;
+  node->level = level;
+
+  seqnum = ++timeline->seqnum;
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      node->klass = GST_TTML_TIMELINE_CLASS_OPEN;
+      node->order = -seqnum;
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_END:
+      node->klass = GST_TTML_TIMELINE_CLASS_CLOSE;
+      node->order = seqnum;
+      break;
+    default:
+      node->klass = GST_TTML_TIMELINE_CLASS_CONTENT;
+      node->order = -seqnum;
+      break;
+  }
+
+  /* Find the last link before the new node on every level */
+  for (i = MAX (timeline->level, level); i-- > 0;) {
+    while (links[i] && gst_ttml_timeline_node_before (links[i], node))
+      links = links[i]->next;
+    update[i] = &links[i];
+  }
+
+  for (i = 0; i < level; i++) {
+    node->next[i] = *update[i];
+    *update[i] = node;
+  }
+
+  timeline->level = MAX (timeline->level, level);
+  timeline->length++;
+}
+
+/* Returns the first event in the timeline, i.e., the next one, without
+ * removing it. */
+GstTTMLEvent *
+gst_ttml_timeline_peek (const GstTTMLTimeline *timeline)
+{
+  return timeline->head[0] ? timeline->head[0]->event : NULL;
+}
+
+/* Removes the first event in the timeline, i.e., the next one.
+ * You are the owner of the returned event. */
+GstTTMLEvent *
+gst_ttml_timeline_pop (GstTTMLTimeline *timeline)
+{
+  GstTTMLTimelineNode *node = timeline->head[0];
+  GstTTMLEvent *event;
+  guint i;
+
+  if (!node)
+    return NULL;
+
+  /* Being the first one, it is the head of every level it is in */
+  for (i = 0; i < node->level; i++)
+    timeline->head[i] = node->next[i];
+  while (timeline->level && !timeline->head[timeline->level - 1])
+    timeline->level--;
+  timeline->length--;
+
+  event = node->event;
+  g_free (node);
+
+  GST_DEBUG ("Removing event %s at %" GST_TIME_FORMAT,
+      gst_ttml_event_type_name (event->type),
+      GST_TIME_ARGS (event->timestamp));
+  return event;
+}
+
+/* Remove all events from the timeline, parse them and generate output
+ * buffers */
+void
+gst_ttml_timeline_flush (GstTTMLTimeline *timeline,
+    GstTTMLTimelineParseFunc parse, GstTTMLTimelineGenBufferFunc gen_buffer,
+    void *userdata)
+{
+  GstTTMLBase *base = userdata;
+  GstTTMLEvent *event;
+
+  while ((event = gst_ttml_timeline_pop (timeline))) {
+    if (event->timestamp > base->input_buf_stop) {
+      /* Beyond the input buffer, it is dropped */
+      gst_ttml_event_free (event);
+      break;
+    }
+
+    /* if there's a gap since last buffer out, generate clear buffer */
+    if (event->timestamp > base->last_out_time) {
+      gen_buffer (base->last_out_time, event->timestamp, base);
+    }
+    parse (event, userdata);
+  }
+
+  if (base->last_out_time < base->input_buf_stop) {
+    gen_buffer (base->last_out_time, base->input_buf_stop, base);
+  }
+}
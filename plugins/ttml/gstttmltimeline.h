@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_TIMELINE_H__
+#define __GST_TTML_TIMELINE_H__
+
+#include <gst/gst.h>
+#include "gstttmlforward.h"
+#include "gstttmlevent.h"
+
+G_BEGIN_DECLS
+
+/* Enough for 4^16 events with the level probability we use */
+#define GST_TTML_TIMELINE_MAX_LEVEL 16
+
+typedef struct _GstTTMLTimelineNode GstTTMLTimelineNode;
+
+/* Events ordered by time. It is a skip list: inserting costs O(log n) and
+ * taking the next event O(1), so parsing a document is no longer quadratic
+ * in the number of cues. */
+struct _GstTTMLTimeline
+{
+  GstTTMLTimelineNode *head[GST_TTML_TIMELINE_MAX_LEVEL];
+  guint level;
+  guint length;
+  gint64 seqnum;
+  guint32 random;
+  /* When not NULL, a copy of every inserted event is appended to it */
+  GPtrArray *capture;
+};
+
+typedef void (*GstTTMLTimelineParseFunc) (
+    GstTTMLEvent *event, void *userdata);
+
+typedef void (*GstTTMLTimelineGenBufferFunc) (
+    GstClockTime begin, GstClockTime end, void *userdata);
+
+void gst_ttml_timeline_init (GstTTMLTimeline *timeline);
+
+void gst_ttml_timeline_clear (GstTTMLTimeline *timeline);
+
+void gst_ttml_timeline_promote (GstTTMLTimeline *timeline);
+
+gboolean gst_ttml_timeline_is_empty (const GstTTMLTimeline *timeline);
+
+guint gst_ttml_timeline_get_length (const GstTTMLTimeline *timeline);
+
+void gst_ttml_timeline_insert (
+    GstTTMLTimeline *timeline, GstTTMLEvent *event);
+
+GstTTMLEvent *gst_ttml_timeline_peek (const GstTTMLTimeline *timeline);
+
+GstTTMLEvent *gst_ttml_timeline_pop (GstTTMLTimeline *timeline);
+
+void gst_ttml_timeline_flush (GstTTMLTimeline *timeline,
+    GstTTMLTimelineParseFunc parse, GstTTMLTimelineGenBufferFunc gen_buffer,
+    void *userdata);
+
+G_END_DECLS
+#endif /* __GST_TTML_TIMELINE_H__ */
@@ -0,0 +1,928 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstttmltokenizer.h"
+#include <string.h>
+
+GST_DEBUG_CATEGORY_EXTERN (ttmlbase_debug);
+#define GST_CAT_DEFAULT ttmlbase_debug
+
+/* Longest entity name or character reference accepted */
+#define GST_TTML_TOKENIZER_MAX_REFERENCE 16
+
+typedef enum
+{
+  GST_TTML_TOKENIZER_PREFIX_MISMATCH,
+  GST_TTML_TOKENIZER_PREFIX_PARTIAL,
+  GST_TTML_TOKENIZER_PREFIX_MATCH
+} GstTTMLTokenizerPrefix;
+
+static const struct
+{
+  const gchar *name;
+  gchar value;
+} gst_ttml_tokenizer_entities[] = {
+  { "lt", '<' },
+  { "gt", '>' },
+  { "amp", '&' },
+  { "apos", '\'' },
+  { "quot", '"' },
+};
+
+/* Initial size of the table of interned strings */
+#define GST_TTML_TOKENIZER_DICT_SIZE 64
+
+#define is_space(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/* Chars which end a name inside a tag */
+static const guint8 gst_ttml_tokenizer_name_end[256] = {
+  [' '] = 1, ['\t'] = 1, ['\n'] = 1, ['\r'] = 1, ['/'] = 1, ['>'] = 1,
+  ['='] = 1, ['<'] = 1, ['"'] = 1, ['\''] = 1
+};
+
+/* Chars which an attribute value cannot hold as they are */
+static const guint8 gst_ttml_tokenizer_value_special[256] = {
+  ['\t'] = 1, ['\n'] = 1, ['\r'] = 1, ['&'] = 1, ['<'] = 1
+};
+
+#define is_name_end(c) gst_ttml_tokenizer_name_end[(guchar) (c)]
+
+static void
+gst_ttml_tokenizer_error (GstTTMLTokenizer *tok, const gchar *message)
+{
+  if (tok->sax->error)
+    tok->sax->error (tok->ctx, "%s\n", message);
+}
+
+/* Report an error after which the document cannot be parsed any further */
+static void
+gst_ttml_tokenizer_fatal (GstTTMLTokenizer *tok, const gchar *message)
+{
+  if (tok->sax->fatalError)
+    tok->sax->fatalError (tok->ctx, "%s\n", message);
+  tok->halted = TRUE;
+}
+
+static void
+gst_ttml_tokenizer_dict_grow (GstTTMLTokenizer *tok)
+{
+  GstTTMLTokenizerName *old = tok->dict;
+  guint old_size = tok->dict_size, i;
+
+  tok->dict_size = old_size ? old_size * 2 : GST_TTML_TOKENIZER_DICT_SIZE;
+  tok->dict = g_new0 (GstTTMLTokenizerName, tok->dict_size);
+
+  for (i = 0; i < old_size; i++) {
+    guint j = old[i].hash & (tok->dict_size - 1);
+
+    if (!old[i].str)
+      continue;
+    while (tok->dict[j].str)
+      j = (j + 1) & (tok->dict_size - 1);
+    tok->dict[j] = old[i];
+  }
+  g_free (old);
+}
+
+static const xmlChar *
+gst_ttml_tokenizer_intern (GstTTMLTokenizer *tok, const gchar *str, gsize len)
+{
+  GstTTMLTokenizerName *entry, *recent = NULL;
+  guint hash = 2166136261u, i;
+  gsize j;
+
+  /* The same few names are found over and over */
+  if (len) {
+    recent = &tok->recent[(len * 31 + (guchar) str[0] * 7 +
+                              (guchar) str[len - 1]) &
+                          (GST_TTML_TOKENIZER_RECENT_SIZE - 1)];
+    if (recent->len == len && recent->str &&
+        memcmp (recent->str, str, len) == 0)
+      return (const xmlChar *) recent->str;
+  }
+
+  /* FNV-1a, names are short */
+  for (j = 0; j < len; j++)
+    hash = (hash ^ (guchar) str[j]) * 16777619u;
+
+  for (i = hash & (tok->dict_size - 1); tok->dict[i].str;
+       i = (i + 1) & (tok->dict_size - 1)) {
+    entry = &tok->dict[i];
+    if (entry->hash == hash && entry->len == len &&
+        memcmp (entry->str, str, len) == 0)
+      goto found;
+  }
+
+  if ((tok->dict_used + 1) * 2 > tok->dict_size) {
+    gst_ttml_tokenizer_dict_grow (tok);
+    for (i = hash & (tok->dict_size - 1); tok->dict[i].str;
+         i = (i + 1) & (tok->dict_size - 1))
+      ;
+  }
+
+  entry = &tok->dict[i];
+  entry->str = g_string_chunk_insert_len (tok->strings, str, len);
+  entry->len = len;
+  entry->hash = hash;
+  tok->dict_used++;
+
+found:
+  if (recent)
+    *recent = *entry;
+  return (const xmlChar *) entry->str;
+}
+
+/* Split a qualified name into its prefix and local name, interned */
+static void
+gst_ttml_tokenizer_qname (GstTTMLTokenizer *tok, const gchar *qname,
+    gsize len, const xmlChar **prefix, const xmlChar **name)
+{
+  const gchar *colon = memchr (qname, ':', len);
+
+  if (colon && colon > qname && colon < qname + len - 1) {
+    *prefix = gst_ttml_tokenizer_intern (tok, qname, colon - qname);
+    *name = gst_ttml_tokenizer_intern (
+        tok, colon + 1, qname + len - (colon + 1));
+  } else {
+    *prefix = NULL;
+    *name = gst_ttml_tokenizer_intern (tok, qname, len);
+  }
+}
+
+/* URI bound to 'prefix' (the default namespace when NULL), or NULL */
+static const xmlChar *
+gst_ttml_tokenizer_resolve (GstTTMLTokenizer *tok, const xmlChar *prefix)
+{
+  guint i = tok->namespaces->len;
+
+  while (i--) {
+    GstTTMLTokenizerNamespace *ns =
+        &g_array_index (tok->namespaces, GstTTMLTokenizerNamespace, i);
+
+    if (ns->prefix == prefix)
+      return ns->uri && *ns->uri ? ns->uri : NULL;
+  }
+
+  if (prefix)
+    gst_ttml_tokenizer_error (tok, "Namespace prefix is not defined");
+  return NULL;
+}
+
+static gsize
+gst_ttml_tokenizer_name_length (const gchar *p, gsize len, gsize pos)
+{
+  gsize start = pos;
+
+  while (pos < len && !is_name_end (p[pos]))
+    pos++;
+
+  return pos - start;
+}
+
+/* Decode the entity or character reference at 'p' into 'out', which must
+ * hold 6 bytes. Returns its length, or 0 if it is not complete, or not
+ * valid, in which case the tokenizer is halted. */
+static gsize
+gst_ttml_tokenizer_reference (GstTTMLTokenizer *tok, const gchar *p,
+    gsize len, gchar *out, gsize *out_len)
+{
+  const gchar *name = p + 1;
+  gsize i, name_len;
+
+  for (i = 1; i < len && p[i] != ';'; i++) {
+    if (i > GST_TTML_TOKENIZER_MAX_REFERENCE || is_name_end (p[i]) ||
+        p[i] == '&') {
+      gst_ttml_tokenizer_fatal (tok, "Invalid entity reference");
+      return 0;
+    }
+  }
+  if (i == len)
+    return 0;
+  name_len = i - 1;
+
+  if (name_len > 1 && name[0] == '#') {
+    gboolean hex = name[1] == 'x';
+    gunichar c = 0;
+    gsize j = hex ? 2 : 1;
+
+    if (j == name_len)
+      goto invalid;
+    for (; j < name_len; j++) {
+      gint digit = hex ? g_ascii_xdigit_value (name[j])
+                       : g_ascii_digit_value (name[j]);
+
+      if (digit < 0 || c > 0x10FFFF)
+        goto invalid;
+      c = c * (hex ? 16 : 10) + digit;
+    }
+    if (!c || !g_unichar_validate (c))
+      goto invalid;
+    *out_len = g_unichar_to_utf8 (c, out);
+    return i + 1;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (gst_ttml_tokenizer_entities); i++) {
+    const gchar *entity = gst_ttml_tokenizer_entities[i].name;
+
+    if (strlen (entity) == name_len && memcmp (name, entity, name_len) == 0) {
+      out[0] = gst_ttml_tokenizer_entities[i].value;
+      *out_len = 1;
+      return name_len + 2;
+    }
+  }
+  gst_ttml_tokenizer_fatal (tok, "Entity not defined");
+  return 0;
+
+invalid:
+  gst_ttml_tokenizer_fatal (tok, "Invalid character reference");
+  return 0;
+}
+
+/* Report content outside of the root element. After it, the end of the
+ * document is still reported. */
+static void
+gst_ttml_tokenizer_outside (GstTTMLTokenizer *tok)
+{
+  if (tok->root_closed)
+    gst_ttml_tokenizer_fatal (tok, "Extra content at the end of the document");
+  else
+    gst_ttml_tokenizer_fatal (tok, "Content outside of the root element");
+  tok->trailing = tok->root_closed;
+}
+
+/* Hand text out. Outside of the root element, only whitespace is
+ * allowed. */
+static void
+gst_ttml_tokenizer_characters (
+    GstTTMLTokenizer *tok, const gchar *data, gsize len)
+{
+  gsize i;
+
+  if (!len)
+    return;
+
+  if (tok->elements->len) {
+    if (tok->sax->characters)
+      tok->sax->characters (tok->ctx, (const xmlChar *) data, (int) len);
+    return;
+  }
+
+  for (i = 0; i < len; i++) {
+    if (!is_space (data[i])) {
+      gst_ttml_tokenizer_outside (tok);
+      return;
+    }
+  }
+}
+
+/* Keep the incomplete markup or reference at 'p' until more data comes */
+static void
+gst_ttml_tokenizer_carry (
+    GstTTMLTokenizer *tok, const gchar *p, gsize len, gchar end)
+{
+  g_string_append_len (tok->pending, p, len);
+  tok->pending_end = end;
+}
+
+/* First reference or carriage return in the text, or 'end' */
+static const gchar *
+gst_ttml_tokenizer_find_special (const gchar *p, const gchar *end)
+{
+  const gchar *amp = memchr (p, '&', end - p);
+  const gchar *cr;
+
+  if (amp)
+    end = amp;
+  cr = memchr (p, '\r', end - p);
+  return cr ? cr : end;
+}
+
+/* Hand out the text starting at 'p', up to the next markup. Line ends are
+ * normalized and references decoded. Returns where it stopped. */
+static const gchar *
+gst_ttml_tokenizer_text (
+    GstTTMLTokenizer *tok, const gchar *p, const gchar *end)
+{
+  const gchar *lt = memchr (p, '<', end - p);
+  const gchar *stop = lt ? lt : end;
+
+  while (p < stop && !tok->halted) {
+    const gchar *run = p;
+    gchar out[8];
+    gsize out_len, n;
+
+    p = gst_ttml_tokenizer_find_special (p, stop);
+    gst_ttml_tokenizer_characters (tok, run, p - run);
+    if (p == stop || tok->halted)
+      break;
+
+    if (*p == '\r') {
+      gst_ttml_tokenizer_characters (tok, "\n", 1);
+      if (++p == end)
+        tok->skip_lf = TRUE;
+      else if (*p == '\n')
+        p++;
+      continue;
+    }
+
+    /* An unterminated reference is not valid before the next markup */
+    n = gst_ttml_tokenizer_reference (tok, p, end - p, out, &out_len);
+    if (!n) {
+      if (!tok->halted)
+        gst_ttml_tokenizer_carry (tok, p, end - p, ';');
+      return end;
+    }
+    gst_ttml_tokenizer_characters (tok, out, out_len);
+    p += n;
+  }
+
+  return stop;
+}
+
+/* Length up to the end of 'terminator', searched from 'pos', or 0 if it is
+ * not found */
+static gsize
+gst_ttml_tokenizer_find_end (
+    const gchar *p, gsize len, gsize pos, const gchar *terminator)
+{
+  gsize terminator_len = strlen (terminator);
+
+  while (pos + terminator_len <= len) {
+    const gchar *c = memchr (
+        p + pos, terminator[0], len - pos - terminator_len + 1);
+
+    if (!c)
+      return 0;
+    if (memcmp (c, terminator, terminator_len) == 0)
+      return c - p + terminator_len;
+    pos = c - p + 1;
+  }
+
+  return 0;
+}
+
+static GstTTMLTokenizerPrefix
+gst_ttml_tokenizer_prefix (const gchar *p, gsize len, const gchar *prefix)
+{
+  gsize prefix_len = strlen (prefix);
+
+  if (memcmp (p, prefix, MIN (len, prefix_len)) != 0)
+    return GST_TTML_TOKENIZER_PREFIX_MISMATCH;
+  return len < prefix_len ? GST_TTML_TOKENIZER_PREFIX_PARTIAL
+                          : GST_TTML_TOKENIZER_PREFIX_MATCH;
+}
+
+/* Length of the document type declaration at 'p', whose internal subset may
+ * contain quoted strings and '>' chars, or 0 if it is not complete */
+static gsize
+gst_ttml_tokenizer_declaration (const gchar *p, gsize len, gsize pos)
+{
+  guint brackets = 0;
+  gchar quote = 0;
+
+  for (; pos < len; pos++) {
+    gchar c = p[pos];
+
+    if (quote) {
+      if (c == quote)
+        quote = 0;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '[') {
+      brackets++;
+    } else if (c == ']' && brackets) {
+      brackets--;
+    } else if (c == '>' && !brackets) {
+      return pos + 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Comments, CDATA sections and document type declarations */
+static gsize
+gst_ttml_tokenizer_bang (GstTTMLTokenizer *tok, const gchar *p, gsize len)
+{
+  GstTTMLTokenizerPrefix comment, cdata, doctype;
+  gsize n;
+
+  comment = gst_ttml_tokenizer_prefix (p, len, "<!--");
+  if (comment == GST_TTML_TOKENIZER_PREFIX_MATCH) {
+    n = gst_ttml_tokenizer_find_end (p, len, 4, "-->");
+    if (n && tok->sax->comment) {
+      g_string_truncate (tok->values, 0);
+      g_string_append_len (tok->values, p + 4, n - 7);
+      tok->sax->comment (tok->ctx, (const xmlChar *) tok->values->str);
+    }
+    return n;
+  }
+
+  cdata = gst_ttml_tokenizer_prefix (p, len, "<![CDATA[");
+  if (cdata == GST_TTML_TOKENIZER_PREFIX_MATCH) {
+    n = gst_ttml_tokenizer_find_end (p, len, 9, "]]>");
+    if (n)
+      gst_ttml_tokenizer_characters (tok, p + 9, n - 12);
+    return tok->halted ? 0 : n;
+  }
+
+  doctype = gst_ttml_tokenizer_prefix (p, len, "<!DOCTYPE");
+  if (doctype == GST_TTML_TOKENIZER_PREFIX_MATCH)
+    return gst_ttml_tokenizer_declaration (p, len, 9);
+
+  if (comment == GST_TTML_TOKENIZER_PREFIX_MISMATCH &&
+      cdata == GST_TTML_TOKENIZER_PREFIX_MISMATCH &&
+      doctype == GST_TTML_TOKENIZER_PREFIX_MISMATCH)
+    gst_ttml_tokenizer_fatal (tok, "Invalid markup");
+  return 0;
+}
+
+/* Normalize the value of an attribute, between 'start' and 'end', into
+ * 'values' and add the attribute to the list. Returns FALSE if it is not
+ * valid. */
+static gboolean
+gst_ttml_tokenizer_attribute (GstTTMLTokenizer *tok, const gchar *qname,
+    gsize qname_len, const gchar *start, const gchar *end)
+{
+  GstTTMLTokenizerAttribute attr;
+  const gchar *q = start;
+
+  gst_ttml_tokenizer_qname (tok, qname, qname_len, &attr.prefix, &attr.name);
+  attr.value = tok->values->len;
+
+  while (q < end) {
+    const gchar *run = q;
+    gchar out[8];
+    gsize out_len, n;
+
+    while (q < end && !gst_ttml_tokenizer_value_special[(guchar) *q])
+      q++;
+    g_string_append_len (tok->values, run, q - run);
+    if (q == end)
+      break;
+
+    switch (*q) {
+      case '<':
+        gst_ttml_tokenizer_fatal (tok, "'<' in attribute value");
+        return FALSE;
+      case '&':
+        n = gst_ttml_tokenizer_reference (tok, q, end - q, out, &out_len);
+        if (!n) {
+          if (!tok->halted)
+            gst_ttml_tokenizer_fatal (tok, "Unterminated entity reference");
+          return FALSE;
+        }
+        /* Like libxml2 when it does not substitute entities, a '&' is
+         * handed out as a character reference */
+        if (out_len == 1 && out[0] == '&')
+          g_string_append_len (tok->values, "&#38;", 5);
+        else
+          g_string_append_len (tok->values, out, out_len);
+        q += n;
+        break;
+      case '\r':
+        /* A line end is a single space */
+        if (q + 1 < end && q[1] == '\n')
+          q++;
+        /* fall through */
+      default:
+        g_string_append_c (tok->values, ' ');
+        q++;
+        break;
+    }
+  }
+
+  attr.value_len = tok->values->len - attr.value;
+  g_string_append_c (tok->values, '\0');
+  g_array_append_val (tok->attributes, attr);
+  return TRUE;
+}
+
+static void
+gst_ttml_tokenizer_end_element (GstTTMLTokenizer *tok)
+{
+  GstTTMLTokenizerElement element = g_array_index (tok->elements,
+      GstTTMLTokenizerElement, tok->elements->len - 1);
+
+  g_array_set_size (tok->elements, tok->elements->len - 1);
+  if (tok->sax->endElementNs)
+    tok->sax->endElementNs (
+        tok->ctx, element.name, element.prefix, element.uri);
+  g_array_set_size (tok->namespaces, element.namespaces);
+  if (!tok->elements->len)
+    tok->root_closed = TRUE;
+}
+
+/* Call the callbacks of a start tag, once it has been read */
+static void
+gst_ttml_tokenizer_start_element (GstTTMLTokenizer *tok,
+    const xmlChar *prefix, const xmlChar *name, gboolean empty)
+{
+  GstTTMLTokenizerElement element;
+  guint i, nb_namespaces, nb_attributes = 0;
+
+  element.name = name;
+  element.prefix = prefix;
+  element.name_len = strlen ((const gchar *) name);
+  element.prefix_len = prefix ? strlen ((const gchar *) prefix) : 0;
+  element.namespaces = tok->namespaces->len;
+
+  /* Namespace declarations apply to the element and all its attributes */
+  for (i = 0; i < tok->attributes->len; i++) {
+    GstTTMLTokenizerAttribute *attr =
+        &g_array_index (tok->attributes, GstTTMLTokenizerAttribute, i);
+    GstTTMLTokenizerNamespace ns;
+
+    if (!attr->prefix && attr->name == tok->xmlns)
+      ns.prefix = NULL;
+    else if (attr->prefix == tok->xmlns)
+      ns.prefix = attr->name;
+    else
+      continue;
+    ns.uri = gst_ttml_tokenizer_intern (
+        tok, tok->values->str + attr->value, attr->value_len);
+    g_array_append_val (tok->namespaces, ns);
+  }
+  nb_namespaces = tok->namespaces->len - element.namespaces;
+  element.uri = gst_ttml_tokenizer_resolve (tok, prefix);
+
+  g_ptr_array_set_size (tok->args, 0);
+  for (i = element.namespaces; i < tok->namespaces->len; i++) {
+    GstTTMLTokenizerNamespace *ns =
+        &g_array_index (tok->namespaces, GstTTMLTokenizerNamespace, i);
+
+    g_ptr_array_add (tok->args, (gpointer) ns->prefix);
+    g_ptr_array_add (tok->args, (gpointer) ns->uri);
+  }
+  for (i = 0; i < tok->attributes->len; i++) {
+    GstTTMLTokenizerAttribute *attr =
+        &g_array_index (tok->attributes, GstTTMLTokenizerAttribute, i);
+    gchar *value = tok->values->str + attr->value;
+
+    if ((!attr->prefix && attr->name == tok->xmlns) ||
+        attr->prefix == tok->xmlns)
+      continue;
+    g_ptr_array_add (tok->args, (gpointer) attr->name);
+    g_ptr_array_add (tok->args, (gpointer) attr->prefix);
+    g_ptr_array_add (tok->args,
+        (gpointer) (attr->prefix ? gst_ttml_tokenizer_resolve (
+                                       tok, attr->prefix)
+                                 : NULL));
+    g_ptr_array_add (tok->args, value);
+    g_ptr_array_add (tok->args, value + attr->value_len);
+    nb_attributes++;
+  }
+
+  g_array_append_val (tok->elements, element);
+  if (tok->sax->startElementNs) {
+    const xmlChar **args = (const xmlChar **) tok->args->pdata;
+
+    tok->sax->startElementNs (tok->ctx, name, prefix, element.uri,
+        (int) nb_namespaces, args, (int) nb_attributes, 0,
+        args + nb_namespaces * 2);
+  }
+  if (empty)
+    gst_ttml_tokenizer_end_element (tok);
+}
+
+/* Length of the start tag at 'p', or 0 if it is not complete */
+static gsize
+gst_ttml_tokenizer_start_tag (
+    GstTTMLTokenizer *tok, const gchar *p, gsize len)
+{
+  const xmlChar *prefix, *name;
+  gsize pos = 1, n;
+  gboolean empty = FALSE;
+
+  g_array_set_size (tok->attributes, 0);
+  g_string_truncate (tok->values, 0);
+
+  n = gst_ttml_tokenizer_name_length (p, len, pos);
+  if (pos + n == len)
+    return 0;
+  if (!n)
+    goto invalid;
+  gst_ttml_tokenizer_qname (tok, p + pos, n, &prefix, &name);
+  pos += n;
+
+  for (;;) {
+    gsize space = pos;
+    const gchar *attr_name, *close;
+    gchar quote;
+
+    while (pos < len && is_space (p[pos]))
+      pos++;
+    if (pos == len)
+      return 0;
+    if (p[pos] == '>') {
+      pos++;
+      break;
+    }
+    if (p[pos] == '/') {
+      if (pos + 1 == len)
+        return 0;
+      if (p[pos + 1] != '>')
+        goto invalid;
+      pos += 2;
+      empty = TRUE;
+      break;
+    }
+    if (space == pos)
+      goto invalid;
+
+    attr_name = p + pos;
+    n = gst_ttml_tokenizer_name_length (p, len, pos);
+    if (pos + n == len)
+      return 0;
+    if (!n)
+      goto invalid;
+    pos += n;
+    while (pos < len && is_space (p[pos]))
+      pos++;
+    if (pos == len)
+      return 0;
+    if (p[pos++] != '=')
+      goto invalid;
+    while (pos < len && is_space (p[pos]))
+      pos++;
+    if (pos == len)
+      return 0;
+    quote = p[pos++];
+    if (quote != '"' && quote != '\'')
+      goto invalid;
+    close = memchr (p + pos, quote, len - pos);
+    if (!close)
+      return 0;
+    if (!gst_ttml_tokenizer_attribute (tok, attr_name, n, p + pos, close))
+      return 0;
+    pos = close - p + 1;
+  }
+
+  if (tok->root_closed) {
+    gst_ttml_tokenizer_outside (tok);
+    return 0;
+  }
+  gst_ttml_tokenizer_start_element (tok, prefix, name, empty);
+  return pos;
+
+invalid:
+  gst_ttml_tokenizer_fatal (tok, "Invalid start tag");
+  return 0;
+}
+
+/* Length of the end tag at 'p', or 0 if it is not complete */
+static gsize
+gst_ttml_tokenizer_end_tag (GstTTMLTokenizer *tok, const gchar *p, gsize len)
+{
+  const GstTTMLTokenizerElement *element;
+  const gchar *qname = p + 2;
+  gsize pos = 2, n;
+
+  n = gst_ttml_tokenizer_name_length (p, len, pos);
+  if (pos + n == len)
+    return 0;
+  if (!n) {
+    gst_ttml_tokenizer_fatal (tok, "Invalid end tag");
+    return 0;
+  }
+  pos += n;
+  while (pos < len && is_space (p[pos]))
+    pos++;
+  if (pos == len)
+    return 0;
+  if (p[pos++] != '>') {
+    gst_ttml_tokenizer_fatal (tok, "Invalid end tag");
+    return 0;
+  }
+
+  if (!tok->elements->len) {
+    gst_ttml_tokenizer_fatal (tok, "End tag without start tag");
+    return 0;
+  }
+  element = &g_array_index (
+      tok->elements, GstTTMLTokenizerElement, tok->elements->len - 1);
+  /* Compared as they are, names are only interned for start tags */
+  if (element->prefix
+          ? n != element->prefix_len + 1 + element->name_len ||
+                memcmp (qname, element->prefix, element->prefix_len) != 0 ||
+                qname[element->prefix_len] != ':' ||
+                memcmp (qname + element->prefix_len + 1, element->name,
+                    element->name_len) != 0
+          : n != element->name_len ||
+                memcmp (qname, element->name, n) != 0) {
+    gst_ttml_tokenizer_fatal (tok, "Opening and ending tag mismatch");
+    return 0;
+  }
+
+  gst_ttml_tokenizer_end_element (tok);
+  return pos;
+}
+
+/* Length of the markup at 'p', or 0 if it is not complete or not valid */
+static gsize
+gst_ttml_tokenizer_markup (GstTTMLTokenizer *tok, const gchar *p, gsize len)
+{
+  if (len < 2)
+    return 0;
+
+  switch (p[1]) {
+    case '?':
+      /* The XML declaration and processing instructions are skipped */
+      return gst_ttml_tokenizer_find_end (p, len, 2, "?>");
+    case '!':
+      return gst_ttml_tokenizer_bang (tok, p, len);
+    case '/':
+      return gst_ttml_tokenizer_end_tag (tok, p, len);
+    default:
+      return gst_ttml_tokenizer_start_tag (tok, p, len);
+  }
+}
+
+/* Add data to the carried markup or reference, up to the char which might
+ * complete it, until it is complete. All of them end with that char.
+ * Returns where to go on, or NULL if all the data was used. */
+static const gchar *
+gst_ttml_tokenizer_complete_pending (
+    GstTTMLTokenizer *tok, const gchar *p, const gchar *end)
+{
+  while (p < end) {
+    const gchar *stop = memchr (p, tok->pending_end, end - p);
+    gchar out[8];
+    gsize out_len, n;
+
+    if (!stop) {
+      g_string_append_len (tok->pending, p, end - p);
+      /* A reference is known to be invalid before its end */
+      if (tok->pending->str[0] == '&')
+        gst_ttml_tokenizer_reference (
+            tok, tok->pending->str, tok->pending->len, out, &out_len);
+      return NULL;
+    }
+    g_string_append_len (tok->pending, p, stop + 1 - p);
+    p = stop + 1;
+
+    if (tok->pending->str[0] == '<') {
+      n = gst_ttml_tokenizer_markup (
+          tok, tok->pending->str, tok->pending->len);
+    } else {
+      n = gst_ttml_tokenizer_reference (
+          tok, tok->pending->str, tok->pending->len, out, &out_len);
+      if (n)
+        gst_ttml_tokenizer_characters (tok, out, out_len);
+    }
+
+    if (n || tok->halted) {
+      g_string_truncate (tok->pending, 0);
+      return tok->halted ? NULL : p;
+    }
+  }
+
+  return NULL;
+}
+
+GstTTMLTokenizer *
+gst_ttml_tokenizer_new (const xmlSAXHandler *sax, void *ctx)
+{
+  GstTTMLTokenizer *tok = g_new0 (GstTTMLTokenizer, 1);
+  GstTTMLTokenizerNamespace xml;
+
+  tok->sax = sax;
+  tok->ctx = ctx;
+  tok->elements = g_array_new (FALSE, FALSE, sizeof (GstTTMLTokenizerElement));
+  tok->namespaces =
+      g_array_new (FALSE, FALSE, sizeof (GstTTMLTokenizerNamespace));
+  gst_ttml_tokenizer_dict_grow (tok);
+  tok->strings = g_string_chunk_new (1024);
+  tok->pending = g_string_new (NULL);
+  tok->attributes =
+      g_array_new (FALSE, FALSE, sizeof (GstTTMLTokenizerAttribute));
+  tok->values = g_string_new (NULL);
+  tok->args = g_ptr_array_new ();
+
+  tok->xmlns = gst_ttml_tokenizer_intern (tok, "xmlns", 5);
+  /* The xml prefix is always bound */
+  xml.prefix = gst_ttml_tokenizer_intern (tok, "xml", 3);
+  xml.uri = gst_ttml_tokenizer_intern (tok, (const gchar *) XML_XML_NAMESPACE,
+      strlen ((const gchar *) XML_XML_NAMESPACE));
+  g_array_append_val (tok->namespaces, xml);
+
+  return tok;
+}
+
+void
+gst_ttml_tokenizer_free (GstTTMLTokenizer *tok)
+{
+  if (!tok)
+    return;
+
+  g_array_free (tok->elements, TRUE);
+  g_array_free (tok->namespaces, TRUE);
+  g_free (tok->dict);
+  g_string_chunk_free (tok->strings);
+  g_string_free (tok->pending, TRUE);
+  g_array_free (tok->attributes, TRUE);
+  g_string_free (tok->values, TRUE);
+  g_ptr_array_free (tok->args, TRUE);
+  g_free (tok);
+}
+
+/* Get ready for a new document. The interned strings are kept, so names
+ * keep their pointers from one document to the next. */
+void
+gst_ttml_tokenizer_reset (GstTTMLTokenizer *tok)
+{
+  tok->started = FALSE;
+  tok->bom = 0;
+  tok->halted = FALSE;
+  tok->trailing = FALSE;
+  tok->root_closed = FALSE;
+  tok->skip_lf = FALSE;
+  g_array_set_size (tok->elements, 0);
+  /* Only the binding of the xml prefix remains */
+  g_array_set_size (tok->namespaces, 1);
+  g_string_truncate (tok->pending, 0);
+  tok->pending_end = '\0';
+}
+
+/* Tokenize the next 'len' bytes of the document, calling the callbacks for
+ * what they complete. Returns FALSE if the document is not valid, after
+ * which no more callbacks are called. */
+gboolean
+gst_ttml_tokenizer_feed (GstTTMLTokenizer *tok, const gchar *data, gsize len)
+{
+  const gchar *p = data, *end = data + len;
+
+  if (tok->halted)
+    return FALSE;
+
+  if (!tok->started) {
+    tok->started = TRUE;
+    if (tok->sax->startDocument)
+      tok->sax->startDocument (tok->ctx);
+  }
+
+  /* UTF-8 byte order mark, which might be split too */
+  while (tok->bom < 3 && p < end && *p == "\xef\xbb\xbf"[tok->bom]) {
+    tok->bom++;
+    p++;
+  }
+  if (p < end)
+    tok->bom = 3;
+
+  if (tok->skip_lf && p < end) {
+    if (*p == '\n')
+      p++;
+    tok->skip_lf = FALSE;
+  }
+
+  if (tok->pending->len) {
+    p = gst_ttml_tokenizer_complete_pending (tok, p, end);
+    if (!p)
+      return !tok->halted;
+  }
+
+  while (p < end && !tok->halted) {
+    if (*p == '<') {
+      gsize n = gst_ttml_tokenizer_markup (tok, p, end - p);
+
+      if (!n) {
+        if (!tok->halted)
+          gst_ttml_tokenizer_carry (tok, p, end - p, '>');
+        break;
+      }
+      p += n;
+    } else {
+      p = gst_ttml_tokenizer_text (tok, p, end);
+    }
+  }
+
+  return !tok->halted;
+}
+
+/* The document is over. As libxml does, the end of the document is
+ * reported even if it was truncated, unless an error was found before.
+ * Returns FALSE if the document was not complete or not valid. */
+gboolean
+gst_ttml_tokenizer_finish (GstTTMLTokenizer *tok)
+{
+  gboolean complete = !tok->pending->len && tok->root_closed;
+
+  if (tok->halted && !tok->trailing)
+    return FALSE;
+  complete = complete && !tok->trailing;
+
+  if (!complete && !tok->halted && tok->sax->fatalError)
+    tok->sax->fatalError (tok->ctx, "%s\n", "Premature end of document");
+  if (tok->started && tok->sax->endDocument)
+    tok->sax->endDocument (tok->ctx);
+
+  /* Nothing else can be fed */
+  tok->halted = TRUE;
+  return complete;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+#ifndef __GST_TTML_TOKENIZER_H__
+#define __GST_TTML_TOKENIZER_H__
+
+#include <gst/gst.h>
+#include <libxml/parser.h>
+#include "gstttmlforward.h"
+
+G_BEGIN_DECLS
+
+/* Slots of the cache of recently interned strings */
+#define GST_TTML_TOKENIZER_RECENT_SIZE 64
+
+/* Interned string */
+typedef struct
+{
+  const gchar *str;
+  gsize len;
+  guint hash;
+} GstTTMLTokenizerName;
+
+/* Namespace declaration in scope */
+typedef struct
+{
+  const xmlChar *prefix;
+  const xmlChar *uri;
+} GstTTMLTokenizerNamespace;
+
+/* Open element, and how many namespace declarations were in scope before
+ * its own */
+typedef struct
+{
+  const xmlChar *name;
+  const xmlChar *prefix;
+  const xmlChar *uri;
+  gsize name_len;
+  gsize prefix_len;
+  guint namespaces;
+} GstTTMLTokenizerElement;
+
+/* Attribute of the start tag being parsed. Its value is kept in 'values'
+ * until the whole tag has been read. */
+typedef struct
+{
+  const xmlChar *name;
+  const xmlChar *prefix;
+  gsize value;
+  gsize value_len;
+} GstTTMLTokenizerAttribute;
+
+/* Streaming tokenizer for the XML used by TTML documents, which calls the
+ * same SAX2 callbacks libxml's push parser does: startDocument,
+ * endDocument, startElementNs, endElementNs, characters, comment, error
+ * and fatalError. Namespaces, the predefined entities, character
+ * references, CDATA sections and documents split at any point across
+ * chunks are supported. The input must be UTF-8, document type
+ * declarations are skipped, so the entities they declare are unknown, and
+ * validity is not checked beyond the nesting of elements.
+ * Text is handed out as views into the input. Names and URIs are interned,
+ * so the same string always comes with the same pointer. Attribute values
+ * are normalized into a buffer which is reused for every tag, and are
+ * NUL-terminated. As in libxml2, a '&' written as a reference in them is
+ * handed out as "&#38;". Once its buffers have grown, nothing is allocated
+ * per element or attribute. */
+struct _GstTTMLTokenizer
+{
+  const xmlSAXHandler *sax;
+  void *ctx;
+
+  gboolean started;
+  /* Bytes of the UTF-8 byte order mark skipped, 3 once past it */
+  guint bom;
+  /* A fatal error was found, no more callbacks are called */
+  gboolean halted;
+  /* There was content after the root element, the rest is ignored */
+  gboolean trailing;
+  /* The root element has been closed */
+  gboolean root_closed;
+  /* A '\r' ended the previous chunk, a '\n' starting this one belongs to
+   * it */
+  gboolean skip_lf;
+
+  GArray *elements;
+  GArray *namespaces;
+
+  /* Interned strings, in an open addressing table whose size is a power
+   * of 2, so names are looked up without copying them first */
+  GstTTMLTokenizerName *dict;
+  guint dict_size;
+  guint dict_used;
+  /* Last string interned for each slot, indexed by length and ends */
+  GstTTMLTokenizerName recent[GST_TTML_TOKENIZER_RECENT_SIZE];
+  GStringChunk *strings;
+  const xmlChar *xmlns;
+
+  /* Incomplete markup or reference carried from the previous chunk, and
+   * the char which might complete it */
+  GString *pending;
+  gchar pending_end;
+
+  /* Start tag being parsed */
+  GArray *attributes;
+  GString *values;
+  GPtrArray *args;
+};
+
+GstTTMLTokenizer *gst_ttml_tokenizer_new (
+    const xmlSAXHandler *sax, void *ctx);
+
+void gst_ttml_tokenizer_free (GstTTMLTokenizer *tokenizer);
+
+void gst_ttml_tokenizer_reset (GstTTMLTokenizer *tokenizer);
+
+gboolean gst_ttml_tokenizer_feed (
+    GstTTMLTokenizer *tokenizer, const gchar *data, gsize len);
+
+gboolean gst_ttml_tokenizer_finish (GstTTMLTokenizer *tokenizer);
+
+G_END_DECLS
+
+#endif /* __GST_TTML_TOKENIZER_H__ */
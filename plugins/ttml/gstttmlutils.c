@@ -235,6 +235,157 @@ const GstTTMLToken GstTTMLUtilsTokensSMPTEEncodingInternal[] = {
 const GstTTMLToken *GstTTMLUtilsTokensSMPTEEncoding =
     GstTTMLUtilsTokensSMPTEEncodingInternal;
 
+GstTTMLTokenIndex GstTTMLUtilsIndexNodeType = {
+  GstTTMLUtilsTokensNodeTypeInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexAttributeType = {
+  GstTTMLUtilsTokensAttributeTypeInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexLengthUnit = {
+  GstTTMLUtilsTokensLengthUnitInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexFontStyle = {
+  GstTTMLUtilsTokensFontStyleInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexFontWeight = {
+  GstTTMLUtilsTokensFontWeightInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexTextDecoration = {
+  GstTTMLUtilsTokensTextDecorationInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexTextAlign = {
+  GstTTMLUtilsTokensTextAlignInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexDisplayAlign = {
+  GstTTMLUtilsTokensDisplayAlignInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexWrapOption = {
+  GstTTMLUtilsTokensWrapOptionInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexShowBackground = {
+  GstTTMLUtilsTokensShowBackgroundInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexTimeBase = {
+  GstTTMLUtilsTokensTimeBaseInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexClockMode = {
+  GstTTMLUtilsTokensClockModeInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexUnicodeBIDI = {
+  GstTTMLUtilsTokensUnicodeBIDIInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexDirection = {
+  GstTTMLUtilsTokensDirectionInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexWritingMode = {
+  GstTTMLUtilsTokensWritingModeInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexSMPTEImageType = {
+  GstTTMLUtilsTokensSMPTEImageTypeInternal
+};
+
+GstTTMLTokenIndex GstTTMLUtilsIndexSMPTEEncoding = {
+  GstTTMLUtilsTokensSMPTEEncodingInternal
+};
+
+/* Case-insensitive hash of the first len chars of str */
+static guint32
+gst_ttml_utils_token_hash (const gchar *str, gsize len, guint32 seed)
+{
+  guint32 hash = 2166136261u ^ seed;
+
+  /* FNV-1a, with a final mix so the lowest bits can be used directly */
+  while (len--)
+    hash = (hash ^ (guint8) g_ascii_tolower (*str++)) * 16777619u;
+  hash ^= hash >> 16;
+  hash *= 0x7feb352du;
+  hash ^= hash >> 15;
+  return hash;
+}
+
+/* Look for a seed which puts every token of the list into a different slot
+ * of the index, growing it when no seed is found. Tokens with the same name
+ * as a previous one are left out, the first one always won the search. */
+static const GstTTMLToken **
+gst_ttml_utils_token_index_build (GstTTMLTokenIndex *index)
+{
+  const GstTTMLToken *token;
+  const GstTTMLToken **slots = NULL;
+  guint n = 0, size = 4, attempt;
+
+  for (token = index->list; token->name; token++)
+    n++;
+  index->unknown = token->val;
+  while (size < 2 * n)
+    size *= 2;
+
+  for (;; size *= 2) {
+    slots = g_renew (const GstTTMLToken *, slots, size);
+    for (attempt = 0; attempt < 256; attempt++) {
+      memset (slots, 0, size * sizeof (GstTTMLToken *));
+      for (token = index->list; token->name; token++) {
+        gsize len = strlen (token->name);
+        guint32 slot =
+            gst_ttml_utils_token_hash (token->name, len, attempt) & (size - 1);
+
+        if (!slots[slot])
+          slots[slot] = token;
+        else if (g_ascii_strcasecmp (slots[slot]->name, token->name))
+          break;
+      }
+      if (!token->name) {
+        index->seed = attempt;
+        index->mask = size - 1;
+        return slots;
+      }
+    }
+  }
+}
+
+/* Searches for the given name inside an enum's token list and returns its
+ * value, with a single hash and string comparison. Heading and trailing
+ * white spaces and case are disregarded, as gst_ttml_utils_attr_value_is
+ * does. */
+int
+gst_ttml_utils_enum_lookup_func (const gchar *name, GstTTMLTokenIndex *index)
+{
+  const GstTTMLToken *token;
+  const gchar *end;
+  gsize len;
+
+  if (g_once_init_enter (&index->slots))
+    g_once_init_leave (&index->slots, gst_ttml_utils_token_index_build (index));
+
+  while (g_ascii_isspace (*name))
+    name++;
+  end = name + strlen (name);
+  while (end > name && g_ascii_isspace (end[-1]))
+    end--;
+  len = end - name;
+
+  token = index->slots[gst_ttml_utils_token_hash (name, len, index->seed) &
+                       index->mask];
+  if (token && !g_ascii_strncasecmp (name, token->name, len) &&
+      token->name[len] == '\0')
+    return token->val;
+  return index->unknown;
+}
+
 /* Searches for the given name inside an enum's token list and returns its
  * value. This replaces long, cumbersome if-elses with strcmps. */
 int
@@ -256,6 +407,14 @@ gst_ttml_utils_enum_name_func (int val, const GstTTMLToken *list)
   return list->name != NULL ? list->name : "Unknown";
 }
 
+void
+gst_ttml_utils_enum_foreach_name_func (
+    const GstTTMLToken *list, GFunc func, gpointer user_data)
+{
+  for (; list->name != NULL; list++)
+    func ((gpointer) list->name, user_data);
+}
+
 /* Checks if any of the possible names of the enum is present in the given
  * string, and returns all present values, OR-ed together. Useful for parsing
  * flags. This replaces long, cumbersome if-elses with strcmps. */
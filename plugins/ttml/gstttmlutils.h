@@ -31,15 +31,48 @@ extern const GstTTMLToken *GstTTMLUtilsTokensWritingMode;
 extern const GstTTMLToken *GstTTMLUtilsTokensSMPTEImageType;
 extern const GstTTMLToken *GstTTMLUtilsTokensSMPTEEncoding;
 
+/* Perfect hash indexes of the token arrays, built on first use */
+struct _GstTTMLTokenIndex
+{
+  const GstTTMLToken *list;
+  const GstTTMLToken **slots;
+  guint32 seed;
+  guint mask;
+  int unknown;
+};
+
+extern GstTTMLTokenIndex GstTTMLUtilsIndexNodeType;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexAttributeType;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexLengthUnit;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexFontStyle;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexFontWeight;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexTextDecoration;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexTextAlign;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexDisplayAlign;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexWrapOption;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexShowBackground;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexTimeBase;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexClockMode;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexUnicodeBIDI;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexDirection;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexWritingMode;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexSMPTEImageType;
+extern GstTTMLTokenIndex GstTTMLUtilsIndexSMPTEEncoding;
+
 /* Enum name -> value */
 #define gst_ttml_utils_enum_parse(name, type)                                 \
   (GstTTML##type)                                                             \
-      gst_ttml_utils_enum_parse_func (name, GstTTMLUtilsTokens##type)
+      gst_ttml_utils_enum_lookup_func (name, &GstTTMLUtilsIndex##type)
 
 /* Enum value -> name (For debugging purposes) */
 #define gst_ttml_utils_enum_name(val, type)                                   \
   gst_ttml_utils_enum_name_func ((int) val, GstTTMLUtilsTokens##type)
 
+/* Call func (name, user_data) for every name of the enum */
+#define gst_ttml_utils_enum_foreach_name(type, func, user_data)               \
+  gst_ttml_utils_enum_foreach_name_func (                                     \
+      GstTTMLUtilsTokens##type, func, user_data)
+
 /* Flags list -> value (like enums, but allows merging multiple values in one
  * line */
 #define gst_ttml_utils_flags_parse(name, type)                                \
@@ -53,7 +86,11 @@ extern const GstTTMLToken *GstTTMLUtilsTokensSMPTEEncoding;
 /* Internal use. Required by the macros above. */
 int gst_ttml_utils_enum_parse_func (
     const gchar *name, const GstTTMLToken *list);
+int gst_ttml_utils_enum_lookup_func (
+    const gchar *name, GstTTMLTokenIndex *index);
 const gchar *gst_ttml_utils_enum_name_func (int val, const GstTTMLToken *list);
+void gst_ttml_utils_enum_foreach_name_func (
+    const GstTTMLToken *list, GFunc func, gpointer user_data);
 int gst_ttml_utils_flags_parse_func (
     const gchar *name, const GstTTMLToken *list);
 const gchar *gst_ttml_utils_flags_name_func (
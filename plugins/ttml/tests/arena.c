@@ -0,0 +1,304 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the arena: blocks are recycled by size class, every allocation is
+ * zero-filled, clearing and releasing give the memory back, and events and
+ * spans promoted before a clear stay valid while the memory of the arena is
+ * reused. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlarena.h"
+#include "gstttmlattribute.h"
+#include "gstttmlevent.h"
+#include "gstttmlspan.h"
+#include "gstttmlstate.h"
+#include "gstttmlstyle.h"
+#include "gstttmltimeline.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+/* Largest size with a free list */
+#define MAX_CLASS_SIZE (GST_TTML_ARENA_CLASSES * GST_TTML_ARENA_ALIGN)
+
+static gboolean
+is_zero (const guint8 *mem, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    if (mem[i])
+      return FALSE;
+  return TRUE;
+}
+
+/* Overwrites the memory the arena has after a clear, and some more */
+static void
+scribble (GstTTMLArena *arena)
+{
+  guint i;
+
+  for (i = 0; i < 4096; i++)
+    memset (gst_ttml_arena_alloc (arena, 64), 0xff, 64);
+}
+
+GST_START_TEST (test_free_lists)
+{
+  GstTTMLArena arena = { 0 };
+  gpointer a, b, c;
+  gsize size;
+
+  for (size = 1; size <= MAX_CLASS_SIZE; size++) {
+    a = gst_ttml_arena_alloc (&arena, size);
+    b = gst_ttml_arena_alloc (&arena, size);
+
+    /* Last freed, first reused */
+    gst_ttml_arena_free (&arena, a, size);
+    gst_ttml_arena_free (&arena, b, size);
+    fail_unless (gst_ttml_arena_alloc (&arena, size) == b);
+    fail_unless (gst_ttml_arena_alloc (&arena, size) == a);
+
+    /* Any size rounding to the same class */
+    gst_ttml_arena_free (&arena, a, size);
+    c = gst_ttml_arena_alloc (&arena,
+        GST_TTML_ARENA_ALIGN * ((size + GST_TTML_ARENA_ALIGN - 1) /
+                                   GST_TTML_ARENA_ALIGN));
+    fail_unless (c == a, "Block of size %" G_GSIZE_FORMAT " not reused", size);
+
+    /* But not another one */
+    gst_ttml_arena_free (&arena, a, size);
+    c = gst_ttml_arena_alloc (&arena, size + GST_TTML_ARENA_ALIGN);
+    fail_if (c == a);
+    fail_unless (gst_ttml_arena_alloc (&arena, size) == a);
+  }
+
+  /* Bigger blocks are not recycled */
+  a = gst_ttml_arena_alloc (&arena, MAX_CLASS_SIZE + 1);
+  gst_ttml_arena_free (&arena, a, MAX_CLASS_SIZE + 1);
+  fail_if (gst_ttml_arena_alloc (&arena, MAX_CLASS_SIZE + 1) == a);
+
+  /* Lists give their links back */
+  a = gst_ttml_arena_list_prepend (&arena, NULL, &arena);
+  b = gst_ttml_arena_list_delete_link (&arena, a, a);
+  fail_unless (b == NULL);
+  fail_unless (gst_ttml_arena_list_prepend (&arena, NULL, &arena) == a);
+
+  gst_ttml_arena_release (&arena);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_zero_fill)
+{
+  GstTTMLArena arena = { 0 };
+  gsize sizes[] = { 1, 8, 16, 17, 100, MAX_CLASS_SIZE, MAX_CLASS_SIZE + 1,
+    4000, 20000 };
+  guint8 *mem[G_N_ELEMENTS (sizes)];
+  guint i, round;
+
+  /* New blocks, recycled blocks, and blocks in chunks kept by a clear */
+  for (round = 0; round < 3; round++) {
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+      mem[i] = gst_ttml_arena_alloc (&arena, sizes[i]);
+      fail_unless (is_zero (mem[i], sizes[i]),
+          "Block of size %" G_GSIZE_FORMAT " not zero-filled in round %u",
+          sizes[i], round);
+      memset (mem[i], 0xaa, sizes[i]);
+    }
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+      gst_ttml_arena_free (&arena, mem[i], sizes[i]);
+    if (round == 1) {
+      scribble (&arena);
+      gst_ttml_arena_clear (&arena);
+    }
+  }
+
+  /* Without an arena, from the heap */
+  mem[0] = gst_ttml_arena_alloc (NULL, 32);
+  fail_unless (is_zero (mem[0], 32));
+  gst_ttml_arena_free (NULL, mem[0], 32);
+
+  gst_ttml_arena_release (&arena);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_clear)
+{
+  GstTTMLArena arena = { 0 };
+  gpointer first, freed;
+  guint i;
+
+  /* A zero-filled arena is empty, and can be cleared and released */
+  gst_ttml_arena_clear (&arena);
+  gst_ttml_arena_release (&arena);
+  fail_unless (arena.chunks == NULL);
+
+  first = gst_ttml_arena_alloc (&arena, 32);
+  freed = gst_ttml_arena_alloc (&arena, 48);
+  gst_ttml_arena_free (&arena, freed, 48);
+  for (i = 0; i < 10; i++)
+    gst_ttml_arena_alloc (&arena, 20000);
+  scribble (&arena);
+
+  /* Everything is given back at once, the first chunks are kept */
+  gst_ttml_arena_clear (&arena);
+  fail_unless (arena.large == NULL);
+  fail_unless (arena.chunks != NULL);
+  fail_unless (arena.current == arena.chunks);
+  fail_unless_equals_int (arena.offset, 0);
+  for (i = 0; i < GST_TTML_ARENA_CLASSES; i++)
+    fail_unless (arena.free_lists[i] == NULL);
+
+  /* And used again from the start */
+  fail_unless (gst_ttml_arena_alloc (&arena, 48) == first);
+  scribble (&arena);
+  gst_ttml_arena_clear (&arena);
+  fail_unless (gst_ttml_arena_alloc (&arena, 16) == first);
+
+  gst_ttml_arena_release (&arena);
+  fail_unless (arena.chunks == NULL);
+  fail_unless (arena.current == NULL);
+  fail_unless (arena.large == NULL);
+
+  /* Released, it can still be used */
+  first = gst_ttml_arena_alloc (&arena, 16);
+  fail_unless (first != NULL);
+  gst_ttml_arena_release (&arena);
+}
+
+GST_END_TEST;
+
+/* Events of every type and active spans allocated from the arena, promoted
+ * as at the start of a document, survive the clearing of the arena */
+GST_START_TEST (test_promote)
+{
+  GstTTMLArena arena = { 0 };
+  GstTTMLTimeline timeline;
+  GstTTMLState state;
+  GstTTMLStyle style;
+  GstTTMLAttribute *attr;
+  GstTTMLEvent *event;
+  GList *spans = NULL, *link;
+  guint i;
+
+  memset (&state, 0, sizeof (state));
+  state.begin = GST_SECOND;
+  state.end = 2 * GST_SECOND;
+  gst_ttml_style_init (&style);
+  attr = gst_ttml_attribute_new_int (&arena, GST_TTML_ATTR_ZINDEX, 42);
+
+  gst_ttml_timeline_init (&timeline);
+  gst_ttml_timeline_insert (&timeline,
+      gst_ttml_event_new_span_begin (&arena, &state,
+          gst_ttml_span_new (&arena, 1, 5, "hello", &style)));
+  gst_ttml_timeline_insert (
+      &timeline, gst_ttml_event_new_span_end (&arena, &state, 1));
+  gst_ttml_timeline_insert (&timeline,
+      gst_ttml_event_new_attr_update (&arena, 1, 3 * GST_SECOND, attr));
+  gst_ttml_timeline_insert (&timeline,
+      gst_ttml_event_new_region_begin (&arena, 4 * GST_SECOND, "r1", &style));
+  gst_ttml_timeline_insert (&timeline,
+      gst_ttml_event_new_region_update (&arena, 5 * GST_SECOND, "r2", attr));
+  gst_ttml_timeline_insert (&timeline,
+      gst_ttml_event_new_region_end (&arena, 6 * GST_SECOND, "r3"));
+  gst_ttml_attribute_free (attr);
+
+  for (i = 0; i < 3; i++)
+    spans = gst_ttml_span_list_add (
+        spans, gst_ttml_span_new (&arena, i, 4, "span", &style));
+
+  gst_ttml_timeline_promote (&timeline);
+  gst_ttml_span_list_promote (spans);
+  gst_ttml_arena_clear (&arena);
+  scribble (&arena);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (event->type, GST_TTML_EVENT_TYPE_SPAN_BEGIN);
+  fail_unless (event->timestamp == GST_SECOND);
+  fail_unless (event->data.span_begin.span->arena == NULL);
+  fail_unless_equals_int (event->data.span_begin.span->id, 1);
+  fail_unless_equals_int (event->data.span_begin.span->length, 5);
+  fail_unless (memcmp (event->data.span_begin.span->chars, "hello", 5) == 0);
+  gst_ttml_event_free (event);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (event->type, GST_TTML_EVENT_TYPE_SPAN_END);
+  fail_unless (event->timestamp == 2 * GST_SECOND);
+  fail_unless_equals_int (event->data.span_end.id, 1);
+  gst_ttml_event_free (event);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (event->type, GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE);
+  fail_unless (event->data.attr_update.attr->arena == NULL);
+  fail_unless_equals_int (event->data.attr_update.attr->value.i, 42);
+  gst_ttml_event_free (event);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (event->type, GST_TTML_EVENT_TYPE_REGION_BEGIN);
+  fail_unless_equals_string (event->data.region_begin.id, "r1");
+  gst_ttml_event_free (event);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (
+      event->type, GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE);
+  fail_unless_equals_string (event->data.region_update.id, "r2");
+  fail_unless (event->data.region_update.attr->arena == NULL);
+  fail_unless_equals_int (event->data.region_update.attr->value.i, 42);
+  gst_ttml_event_free (event);
+
+  event = gst_ttml_timeline_pop (&timeline);
+  fail_unless (event->arena == NULL);
+  fail_unless_equals_int (event->type, GST_TTML_EVENT_TYPE_REGION_END);
+  fail_unless_equals_string (event->data.region_end.id, "r3");
+  gst_ttml_event_free (event);
+  fail_unless (gst_ttml_timeline_is_empty (&timeline));
+
+  for (link = spans, i = 0; link; link = link->next, i++) {
+    GstTTMLSpan *span = link->data;
+
+    fail_unless (span->arena == NULL);
+    fail_unless_equals_int (span->id, i);
+    fail_unless (memcmp (span->chars, "span", 4) == 0);
+  }
+  fail_unless_equals_int (i, 3);
+  g_list_free_full (spans, (GDestroyNotify) gst_ttml_span_free);
+
+  gst_ttml_style_reset (&style);
+  gst_ttml_arena_release (&arena);
+}
+
+GST_END_TEST;
+
+static Suite *
+arena_suite (void)
+{
+  Suite *s = suite_create ("ttml_arena");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_free_lists);
+  tcase_add_test (tc, test_zero_fill);
+  tcase_add_test (tc, test_clear);
+  tcase_add_test (tc, test_promote);
+
+  return s;
+}
+
+GST_CHECK_MAIN (arena);
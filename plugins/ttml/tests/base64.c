@@ -0,0 +1,217 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the streaming base64 decoder against g_base64_decode() on the
+ * whole text, with the text split into chunks at random or at every offset:
+ * random text with whitespace and bytes outside the alphabet, every form of
+ * padding, and lengths around the blocks of the SIMD code. It is built
+ * twice, with and without GST_TTML_BASE64_DISABLE_SIMD, so the SIMD and the
+ * scalar code are both checked. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlbase64.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define ITERATIONS 20000
+#define MAX_TEXT 300
+
+static const gchar alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Decodes the text split at 'splits' and compares it with the text
+ * decoded at once */
+static void
+check_decode (const gchar *text, const gsize *splits, guint n_splits)
+{
+  GstTTMLBase64 b64 = { 0 };
+  GBytes *bytes;
+  guint8 *expected;
+  gsize expected_len, len = 0, start = 0;
+  const guint8 *data = NULL;
+  guint i;
+
+  for (i = 0; i <= n_splits; i++) {
+    gsize end = i < n_splits ? splits[i] : strlen (text);
+
+    gst_ttml_base64_append (&b64, text + start, end - start);
+    start = end;
+  }
+  bytes = gst_ttml_base64_steal (&b64);
+  if (bytes)
+    data = g_bytes_get_data (bytes, &len);
+
+  expected = g_base64_decode (text, &expected_len);
+  fail_unless (len == expected_len, "'%s' decoded to %" G_GSIZE_FORMAT
+      " bytes instead of %" G_GSIZE_FORMAT, text, len, expected_len);
+  fail_unless (len == 0 || memcmp (data, expected, len) == 0,
+      "'%s' decoded wrong", text);
+
+  g_free (expected);
+  if (bytes)
+    g_bytes_unref (bytes);
+  fail_unless (b64.data == NULL);
+}
+
+/* In one chunk, in two split at every offset, and one byte per chunk */
+static void
+check_every_split (const gchar *text)
+{
+  gsize len = strlen (text);
+  gsize *splits = g_new (gsize, len + 1);
+  gsize i;
+
+  check_decode (text, NULL, 0);
+  for (i = 1; i < len; i++)
+    check_decode (text, &i, 1);
+
+  for (i = 1; i < len; i++)
+    splits[i - 1] = i;
+  check_decode (text, splits, len ? len - 1 : 0);
+
+  g_free (splits);
+}
+
+GST_START_TEST (test_random)
+{
+  GRand *rand = g_rand_new_with_seed (0xba5e64);
+  gchar text[MAX_TEXT + 1];
+  gsize splits[MAX_TEXT];
+  guint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    gsize len = g_rand_int_range (rand, 0, MAX_TEXT + 1), pos = 0, j;
+    /* Plain, with whitespace, with padding, with any byte */
+    gint mode = g_rand_int_range (rand, 0, 4);
+    guint n_splits = 0;
+
+    for (j = 0; j < len; j++) {
+      gint r = g_rand_int_range (rand, 0, 100);
+
+      if (mode == 0 || r < 90)
+        text[j] = alphabet[g_rand_int_range (rand, 0, 64)];
+      else if (r < 95)
+        text[j] = " \n\t\r"[g_rand_int_range (rand, 0, 4)];
+      else if (r < 98 && mode >= 2)
+        text[j] = '=';
+      else if (mode == 3)
+        text[j] = g_rand_int_range (rand, 1, 256);
+      else
+        text[j] = '\n';
+    }
+    text[len] = '\0';
+
+    /* Small chunks mostly, as the characters callback hands them */
+    while (len - pos > 1 && g_rand_int_range (rand, 0, 8)) {
+      gsize max = g_rand_int_range (rand, 0, 3) ? 40 : MAX_TEXT;
+      gsize size = g_rand_int_range (rand, 1, max + 1);
+
+      pos += MIN (size, len - pos - 1);
+      splits[n_splits++] = pos;
+    }
+    check_decode (text, splits, n_splits);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_padding)
+{
+  const gchar *texts[] = {
+    /* The usual forms */
+    "", "QQ==", "QUI=", "QUJD", "QUJDRA==", "QUJDREU=",
+    /* Spread by whitespace */
+    "QQ\n=\n=", "QUI\r\n=", " Q U I = ",
+    /* Missing, partial or extra */
+    "QQ", "QQ=", "QUI", "QQ===", "QUI==", "QUJD=", "QUJD====",
+    /* In the middle, and where no data was */
+    "QQ==QUI=", "QQ==QUJD", "QUI=QQ==QUJD", "=QUJD", "A===", "====", "=",
+    "Q=Q=", "QU=I", "Q===QUJD",
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (texts); i++)
+    check_every_split (texts[i]);
+}
+
+GST_END_TEST;
+
+/* Each byte outside the alphabet at each position of a text of two SIMD
+ * blocks */
+GST_START_TEST (test_outside_alphabet)
+{
+  gchar text[66];
+  guint c, pos;
+
+  for (c = 1; c < 256; c++) {
+    if (strchr (alphabet, c) || c == '=')
+      continue;
+    for (pos = 0; pos <= 64; pos++) {
+      gsize split = pos + 1;
+
+      memcpy (text, alphabet, pos);
+      text[pos] = c;
+      memcpy (text + pos + 1, alphabet + pos, 64 - pos);
+      text[65] = '\0';
+
+      check_decode (text, NULL, 0);
+      check_decode (text, &split, 1);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* Texts of 4 to 72 characters, around one and two blocks of 16 and 32,
+ * with and without padding */
+GST_START_TEST (test_lengths)
+{
+  GRand *rand = g_rand_new_with_seed (0xba5e65);
+  guint8 data[54];
+  gsize len, i;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = g_rand_int (rand);
+
+  for (len = 1; len <= sizeof (data); len++) {
+    gchar *text = g_base64_encode (data, len);
+
+    check_every_split (text);
+    g_free (text);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static Suite *
+base64_suite (void)
+{
+  Suite *s = suite_create ("ttml_base64");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_random);
+  tcase_add_test (tc, test_padding);
+  tcase_add_test (tc, test_outside_alphabet);
+  tcase_add_test (tc, test_lengths);
+
+  return s;
+}
+
+GST_CHECK_MAIN (base64);
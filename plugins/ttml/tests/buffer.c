@@ -0,0 +1,306 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the character data accumulator against a byte by byte model of
+ * the whitespace collapsing and against g_utf8_validate(), on random and
+ * adversarial input appended in random pieces. It is built twice, with and
+ * without GST_TTML_BUFFER_DISABLE_SIMD, so the SIMD and the scalar code are
+ * both checked against the same model. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlbuffer.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define ITERATIONS 20000
+#define MAX_INPUT 512
+
+/* Fragments mixing ASCII, whitespace, valid sequences, invalid ones
+ * (surrogates, overlongs, above U+10FFFF, lone lead and continuation
+ * bytes) and sequences split in two */
+static const gchar *pieces[] = { "hello", "world", " ", "\t\n  ", "\xc3\xa9",
+  "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\xa0\x80", "\xc0\xaf",
+  "\xe0\x80\xaf", "\xf4\x90\x80\x80", "\xc3", "\xa9", "\x80", "\xff", "x",
+  "abcdefghijklmnopqrstuvwxyz0123456789", "\xf0\x9f", "\x98\x80",
+  "\xef\xbf\xbe", "\r\n", "\x1f", "\x7f" };
+
+/* Model of the accumulator, one byte at a time */
+typedef struct
+{
+  GString *data;
+  gboolean preserve_whitespace;
+  gboolean insert_space;
+  gboolean collapsing;
+  gboolean line_has_chars;
+} Model;
+
+static void
+model_append (Model *model, const gchar *data, gsize len)
+{
+  gsize i;
+
+  if (model->preserve_whitespace) {
+    g_string_append_len (model->data, data, len);
+    return;
+  }
+
+  for (i = 0; i < len; i++) {
+    if ((guchar) data[i] <= 0x20) {
+      model->collapsing = TRUE;
+      continue;
+    }
+    if (model->collapsing && model->line_has_chars && model->insert_space)
+      g_string_append_c (model->data, ' ');
+    g_string_append_c (model->data, data[i]);
+    model->collapsing = FALSE;
+    model->line_has_chars = TRUE;
+  }
+}
+
+/* Appends the input to both in the same pieces, given by 'splits', and
+ * compares them */
+static void
+check_append (const gchar *input, gsize len, const gsize *splits,
+    guint n_splits, gboolean preserve_whitespace, gboolean insert_space,
+    gboolean line_has_chars, gboolean collapsing)
+{
+  GstTTMLBuffer buffer = { 0 };
+  Model model = { g_string_new (NULL) };
+  gsize start = 0;
+  guint i;
+
+  buffer.preserve_whitespace = model.preserve_whitespace =
+      preserve_whitespace;
+  buffer.insert_space = model.insert_space = insert_space;
+  buffer.line_has_chars = model.line_has_chars = line_has_chars;
+  buffer.collapsing = model.collapsing = collapsing;
+
+  for (i = 0; i <= n_splits; i++) {
+    gsize end = i < n_splits ? splits[i] : len;
+
+    gst_ttml_buffer_append (&buffer, input + start, end - start);
+    model_append (&model, input + start, end - start);
+    start = end;
+  }
+
+  fail_unless (buffer.len == model.data->len);
+  fail_unless (memcmp (buffer.data, model.data->str, buffer.len) == 0);
+  fail_unless_equals_int (buffer.collapsing, model.collapsing);
+  fail_unless_equals_int (buffer.line_has_chars, model.line_has_chars);
+  fail_unless_equals_int (gst_ttml_buffer_is_valid (&buffer),
+      g_utf8_validate (model.data->str, model.data->len, NULL));
+
+  g_string_free (model.data, TRUE);
+  g_free (buffer.data);
+}
+
+/* Random splits of 'len' bytes, in increasing order */
+static guint
+random_splits (GRand *rand, gsize len, gsize *splits)
+{
+  guint n = 0;
+  gsize pos = 0;
+
+  while (len - pos > 1 && g_rand_boolean (rand)) {
+    pos += g_rand_int_range (rand, 1, len - pos);
+    splits[n++] = pos;
+  }
+
+  return n;
+}
+
+static void
+check_random_append (GRand *rand, const gchar *input, gsize len)
+{
+  gsize splits[MAX_INPUT];
+  guint n_splits = random_splits (rand, len, splits);
+  gboolean line_has_chars = g_rand_boolean (rand);
+  gboolean preserve = g_rand_int_range (rand, 0, 3) == 0;
+  gboolean insert_space = g_rand_int_range (rand, 0, 4) != 0;
+
+  check_append (input, len, splits, n_splits, preserve, insert_space,
+      line_has_chars, line_has_chars && g_rand_boolean (rand));
+}
+
+GST_START_TEST (test_random_pieces)
+{
+  GRand *rand = g_rand_new_with_seed (0xb0ffe7);
+  gchar input[MAX_INPUT];
+  guint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    gint n_pieces = g_rand_int_range (rand, 0, 40);
+    gsize len = 0;
+
+    while (n_pieces--) {
+      const gchar *piece =
+          pieces[g_rand_int_range (rand, 0, G_N_ELEMENTS (pieces))];
+      gsize piece_len = strlen (piece);
+
+      /* A NUL now and then */
+      if (g_rand_int_range (rand, 0, 50) == 0) {
+        piece = "";
+        piece_len = 1;
+      }
+      if (len + piece_len > sizeof (input))
+        break;
+      memcpy (input + len, piece, piece_len);
+      len += piece_len;
+    }
+    check_random_append (rand, input, len);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_random_bytes)
+{
+  GRand *rand = g_rand_new_with_seed (0xb0ffe8);
+  gchar input[MAX_INPUT];
+  guint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    gsize len = g_rand_int_range (rand, 0, 100), j;
+
+    for (j = 0; j < len; j++) {
+      /* Mostly ASCII letters and whitespace, as in captions */
+      switch (g_rand_int_range (rand, 0, 4)) {
+        case 0:
+          input[j] = g_rand_int_range (rand, 0, 256);
+          break;
+        case 1:
+          input[j] = g_rand_int_range (rand, 0, 0x21);
+          break;
+        default:
+          input[j] = g_rand_int_range (rand, 'a', 'z' + 1);
+          break;
+      }
+    }
+    check_random_append (rand, input, len);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* Every lead byte with every second byte, and the limits of the ranges of
+ * the third one, straddling the 16-byte blocks of the SIMD code, with the
+ * input split inside the sequence or not */
+GST_START_TEST (test_sequences)
+{
+  static const gsize offsets[] = { 0, 13, 14, 15 };
+  static const guchar tails[] = { 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf,
+    0xc0 };
+  gchar input[40];
+  guint lead, second, k, l, preserve;
+
+  for (lead = 0x80; lead <= 0xff; lead++) {
+    for (second = 0; second <= 0xff; second++) {
+      for (k = 0; k < G_N_ELEMENTS (offsets); k++) {
+        for (l = 0; l < G_N_ELEMENTS (tails); l++) {
+          gsize offset = offsets[k], split = offset + 1;
+
+          memset (input, 'a', sizeof (input));
+          input[offset] = lead;
+          input[offset + 1] = second;
+          input[offset + 2] = tails[l];
+          input[offset + 3] = 0x80;
+
+          for (preserve = 0; preserve < 2; preserve++) {
+            check_append (input, sizeof (input), NULL, 0, preserve, TRUE,
+                FALSE, FALSE);
+            check_append (input, sizeof (input), &split, 1, preserve, TRUE,
+                FALSE, FALSE);
+          }
+        }
+      }
+    }
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_whitespace)
+{
+  GstTTMLBuffer buffer = { 0 };
+  const gchar *long_run = "a                                  b";
+
+  buffer.insert_space = TRUE;
+
+  /* Leading whitespace is dropped, runs become one space */
+  gst_ttml_buffer_append (&buffer, " \t a  \n b ", 10);
+  fail_unless (buffer.len == 3);
+  fail_unless (memcmp (buffer.data, "a b", 3) == 0);
+  fail_unless (buffer.collapsing);
+
+  /* The pending space goes before the next chars, even after a clear */
+  gst_ttml_buffer_clear (&buffer);
+  gst_ttml_buffer_append (&buffer, "c", 1);
+  fail_unless (buffer.len == 2);
+  fail_unless (memcmp (buffer.data, " c", 2) == 0);
+
+  /* A run longer than a SIMD block, and one split across appends */
+  gst_ttml_buffer_clear (&buffer);
+  gst_ttml_buffer_append (&buffer, long_run, strlen (long_run));
+  gst_ttml_buffer_append (&buffer, "  ", 2);
+  gst_ttml_buffer_append (&buffer, " d", 2);
+  fail_unless (buffer.len == 5);
+  fail_unless (memcmp (buffer.data, "a b d", 5) == 0);
+
+  /* Without inserting spaces, runs are removed */
+  gst_ttml_buffer_clear (&buffer);
+  buffer.insert_space = FALSE;
+  gst_ttml_buffer_append (&buffer, "e f", 3);
+  fail_unless (buffer.len == 2);
+  fail_unless (memcmp (buffer.data, "ef", 2) == 0);
+
+  /* Preserved, NUL is not valid */
+  gst_ttml_buffer_clear (&buffer);
+  buffer.preserve_whitespace = TRUE;
+  gst_ttml_buffer_append (&buffer, " g\n", 3);
+  fail_unless (buffer.len == 3);
+  fail_unless (memcmp (buffer.data, " g\n", 3) == 0);
+  fail_unless (gst_ttml_buffer_is_valid (&buffer));
+  gst_ttml_buffer_append (&buffer, "", 1);
+  fail_if (gst_ttml_buffer_is_valid (&buffer));
+
+  /* The validation starts again after a clear */
+  gst_ttml_buffer_clear (&buffer);
+  fail_unless (gst_ttml_buffer_is_valid (&buffer));
+
+  g_free (buffer.data);
+}
+
+GST_END_TEST;
+
+static Suite *
+buffer_suite (void)
+{
+  Suite *s = suite_create ("ttml_buffer");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_random_pieces);
+  tcase_add_test (tc, test_random_bytes);
+  tcase_add_test (tc, test_sequences);
+  tcase_add_test (tc, test_whitespace);
+
+  return s;
+}
+
+GST_CHECK_MAIN (buffer);
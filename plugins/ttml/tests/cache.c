@@ -0,0 +1,350 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the cached timeline on randomly generated event sequences: the
+ * binary search has to find the same event as a linear scan of the times,
+ * and replaying the live events of the nearest checkpoint followed by the
+ * events after it has to reach the same state as replaying every event from
+ * the beginning. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlattribute.h"
+#include "gstttmlcache.h"
+#include "gstttmlevent.h"
+#include "gstttmlspan.h"
+#include "gstttmlstate.h"
+#include "gstttmlstyle.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define N_EVENTS 2000
+#define N_SEEKS 500
+#define N_SPANS 16
+#define N_REGIONS 4
+#define N_ATTRS 2
+
+static const GstTTMLAttributeType attr_types[N_ATTRS] = {
+  GST_TTML_ATTR_ZINDEX, GST_TTML_ATTR_DISPLAY
+};
+
+static const gchar *region_ids[N_REGIONS] = { "r0", "r1", "r2", "r3" };
+
+/* What the events leave visible: the active spans and regions, and the last
+ * value of each attribute applied to them, 0 if none */
+typedef struct
+{
+  gboolean span_active[N_SPANS];
+  gint span_attrs[N_SPANS][N_ATTRS];
+  gboolean region_active[N_REGIONS];
+  gint region_attrs[N_REGIONS][N_ATTRS];
+  guint executed;
+} Model;
+
+static gint
+attr_index (const GstTTMLAttribute *attr)
+{
+  return attr->type == attr_types[0] ? 0 : 1;
+}
+
+static gint
+region_index (const gchar *id)
+{
+  return id[1] - '0';
+}
+
+/* Executes an event the way the parser does: updates of spans and regions
+ * which are not active are ignored, and a new region replaces the old one */
+static void
+model_execute (GstTTMLEvent *event, Model *model)
+{
+  gint id;
+
+  switch (event->type) {
+    case GST_TTML_EVENT_TYPE_SPAN_BEGIN:
+      id = event->data.span_begin.span->id;
+      model->span_active[id] = TRUE;
+      memset (model->span_attrs[id], 0, sizeof (model->span_attrs[id]));
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_END:
+      id = event->data.span_end.id;
+      model->span_active[id] = FALSE;
+      memset (model->span_attrs[id], 0, sizeof (model->span_attrs[id]));
+      break;
+    case GST_TTML_EVENT_TYPE_SPAN_ATTR_UPDATE:
+      id = event->data.attr_update.id;
+      if (model->span_active[id])
+        model->span_attrs[id][attr_index (event->data.attr_update.attr)] =
+            event->data.attr_update.attr->value.i;
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_BEGIN:
+      id = region_index (event->data.region_begin.id);
+      model->region_active[id] = TRUE;
+      memset (model->region_attrs[id], 0, sizeof (model->region_attrs[id]));
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_END:
+      id = region_index (event->data.region_end.id);
+      model->region_active[id] = FALSE;
+      memset (model->region_attrs[id], 0, sizeof (model->region_attrs[id]));
+      break;
+    case GST_TTML_EVENT_TYPE_REGION_ATTR_UPDATE:
+      id = region_index (event->data.region_update.id);
+      if (model->region_active[id])
+        model->region_attrs[id][attr_index (event->data.region_update.attr)] =
+            event->data.region_update.attr->value.i;
+      break;
+    default:
+      break;
+  }
+  model->executed++;
+  gst_ttml_event_free (event);
+}
+
+static gboolean
+model_equal (const Model *a, const Model *b)
+{
+  return memcmp (a->span_active, b->span_active, sizeof (a->span_active)) ==
+             0 &&
+         memcmp (a->span_attrs, b->span_attrs, sizeof (a->span_attrs)) == 0 &&
+         memcmp (a->region_active, b->region_active,
+             sizeof (a->region_active)) == 0 &&
+         memcmp (a->region_attrs, b->region_attrs,
+             sizeof (a->region_attrs)) == 0;
+}
+
+/* A random event, mostly targeting active spans and regions, at a time which
+ * mostly grows but is sometimes late or repeated */
+static GstTTMLEvent *
+random_event (GRand *rand, const Model *model, GstClockTime *time)
+{
+  GstTTMLState state;
+  GstTTMLStyle style;
+  GstTTMLAttribute *attr;
+  GstTTMLEvent *event;
+  gint id;
+
+  switch (g_rand_int_range (rand, 0, 10)) {
+    case 0:
+      break;
+    case 1:
+      *time = *time > GST_SECOND ? *time - GST_SECOND : 0;
+      break;
+    default:
+      *time += g_rand_int_range (rand, 1, 1000) * GST_MSECOND;
+      break;
+  }
+
+  memset (&state, 0, sizeof (state));
+  state.begin = state.end = *time;
+  gst_ttml_style_init (&style);
+  attr = gst_ttml_attribute_new_int (NULL,
+      attr_types[g_rand_int_range (rand, 0, N_ATTRS)],
+      g_rand_int_range (rand, 1, 1000));
+
+  switch (g_rand_int_range (rand, 0, 6)) {
+    case 0:
+      id = g_rand_int_range (rand, 0, N_SPANS);
+      if (!model->span_active[id]) {
+        event = gst_ttml_event_new_span_begin (
+            NULL, &state, gst_ttml_span_new (NULL, id, 1, "x", &style));
+      } else {
+        event = gst_ttml_event_new_span_end (NULL, &state, id);
+      }
+      break;
+    case 1:
+    case 2:
+      id = g_rand_int_range (rand, 0, N_SPANS);
+      event = gst_ttml_event_new_attr_update (NULL, id, *time, attr);
+      break;
+    case 3:
+      id = g_rand_int_range (rand, 0, N_REGIONS);
+      event = gst_ttml_event_new_region_begin (
+          NULL, *time, region_ids[id], &style);
+      break;
+    case 4:
+      id = g_rand_int_range (rand, 0, N_REGIONS);
+      event = gst_ttml_event_new_region_end (NULL, *time, region_ids[id]);
+      break;
+    default:
+      id = g_rand_int_range (rand, 0, N_REGIONS);
+      event =
+          gst_ttml_event_new_region_update (NULL, *time, region_ids[id], attr);
+      break;
+  }
+  gst_ttml_attribute_free (attr);
+
+  return event;
+}
+
+/* Records a random sequence, returning the time at which each event takes
+ * effect */
+static GstTTMLCache *
+random_cache (GRand *rand, guint n_events, GstClockTime *times)
+{
+  GstTTMLCache *cache = gst_ttml_cache_new ();
+  Model model = { { 0 } };
+  GstClockTime time = 0;
+  guint i;
+
+  for (i = 0; i < n_events; i++) {
+    GstTTMLEvent *event = random_event (rand, &model, &time);
+
+    times[i] = i ? MAX (time, times[i - 1]) : time;
+    gst_ttml_cache_add_event (cache, event);
+    model_execute (event, &model);
+  }
+
+  return cache;
+}
+
+/* A random time around the ones in the cache, often exactly one of them */
+static GstClockTime
+random_time (GRand *rand, const GstClockTime *times, guint n_events)
+{
+  GstClockTime time = times[g_rand_int_range (rand, 0, n_events)];
+  gint end = times[n_events - 1] / GST_MSECOND + 1000;
+
+  switch (g_rand_int_range (rand, 0, 4)) {
+    case 0:
+      return time;
+    case 1:
+      return time > 0 ? time - 1 : 0;
+    case 2:
+      return time + 1;
+    default:
+      return g_rand_int_range (rand, 0, end) * GST_MSECOND;
+  }
+}
+
+GST_START_TEST (test_seek)
+{
+  GRand *rand = g_rand_new_with_seed (0xcac4e);
+  GstClockTime *times = g_new (GstClockTime, N_EVENTS);
+  GstTTMLCache *cache;
+  guint i;
+
+  cache = random_cache (rand, N_EVENTS, times);
+  fail_unless_equals_int (gst_ttml_cache_get_length (cache), N_EVENTS);
+
+  for (i = 0; i < N_SEEKS; i++) {
+    GstClockTime time = random_time (rand, times, N_EVENTS);
+    Model seeked = { { 0 } }, replayed = { { 0 } };
+    guint expected = 0, position, n;
+
+    /* First event taking effect after the time */
+    while (expected < N_EVENTS && times[expected] <= time)
+      expected++;
+
+    position = gst_ttml_cache_seek (
+        cache, time, (GstTTMLCacheEventFunc) model_execute, &seeked);
+    fail_unless_equals_int (position, expected);
+
+    for (n = 0; n < position; n++)
+      model_execute (gst_ttml_cache_get_event (cache, n), &replayed);
+    fail_unless (model_equal (&seeked, &replayed),
+        "Wrong state after seeking to event %u", position);
+
+    /* Never more than the live events plus those after the checkpoint */
+    fail_unless (seeked.executed < N_SPANS * (1 + N_ATTRS) +
+                                       N_REGIONS * (1 + N_ATTRS) +
+                                       GST_TTML_CACHE_CHECKPOINT_INTERVAL);
+  }
+
+  gst_ttml_cache_free (cache);
+  g_free (times);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_seek_boundaries)
+{
+  GRand *rand = g_rand_new_with_seed (0xb0dd);
+  GstClockTime times[3 * GST_TTML_CACHE_CHECKPOINT_INTERVAL];
+  GstTTMLCache *cache;
+  Model model = { { 0 } };
+  guint n;
+
+  /* Empty */
+  cache = gst_ttml_cache_new ();
+  fail_unless_equals_int (
+      gst_ttml_cache_seek (cache, GST_SECOND,
+          (GstTTMLCacheEventFunc) model_execute, &model),
+      0);
+  fail_unless_equals_int (model.executed, 0);
+  gst_ttml_cache_free (cache);
+
+  /* Exactly at each checkpoint, and past the end of the last one */
+  for (n = 1; n <= G_N_ELEMENTS (times); n++) {
+    guint i;
+
+    cache = random_cache (rand, n, times);
+    for (i = 0; i < n; i++) {
+      guint expected = i;
+
+      while (expected < n && times[expected] <= times[i])
+        expected++;
+      memset (&model, 0, sizeof (model));
+      fail_unless_equals_int (
+          gst_ttml_cache_seek (cache, times[i],
+              (GstTTMLCacheEventFunc) model_execute, &model),
+          expected);
+    }
+    fail_unless_equals_int (
+        gst_ttml_cache_seek (cache, GST_CLOCK_TIME_NONE - 1,
+            (GstTTMLCacheEventFunc) model_execute, &model),
+        n);
+    gst_ttml_cache_free (cache);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_valid)
+{
+  GstTTMLCache *cache;
+  GstTTMLState state;
+
+  memset (&state, 0, sizeof (state));
+  cache = gst_ttml_cache_new ();
+  fail_if (gst_ttml_cache_is_valid (NULL, "file:///a.ttml"));
+  fail_if (gst_ttml_cache_is_valid (cache, "file:///a.ttml"));
+
+  gst_ttml_cache_complete (cache, "file:///a.ttml", &state, NULL);
+  fail_unless (gst_ttml_cache_is_valid (cache, "file:///a.ttml"));
+  fail_if (gst_ttml_cache_is_valid (cache, "file:///b.ttml"));
+  fail_if (gst_ttml_cache_is_valid (cache, NULL));
+
+  gst_ttml_cache_free (cache);
+}
+
+GST_END_TEST;
+
+static Suite *
+cache_suite (void)
+{
+  Suite *s = suite_create ("ttml_cache");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_seek);
+  tcase_add_test (tc, test_seek_boundaries);
+  tcase_add_test (tc, test_valid);
+
+  return s;
+}
+
+GST_CHECK_MAIN (cache);
@@ -0,0 +1,586 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the TTML expression parsers against the sscanf-based ones they
+ * replaced, on randomly generated expressions. The generators stay away
+ * from the corners where sscanf misbehaves (dangling exponents, white space
+ * or signs inside hexadecimal colors, integer overflows, infinities and
+ * hexadecimal floats), those are covered by explicit tests instead. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlattribute.h"
+#include "gstttmlexpression.h"
+#include "gstttmlstate.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define ITERATIONS 20000
+#define MAX_EXPRESSION 64
+
+#define MAKE_COLOR(r, g, b, a) ((r) << 24 | (g) << 16 | (b) << 8 | (a))
+
+static const gchar *named_colors[] = { "transparent", "black", "silver",
+  "gray", "white", "maroon", "red", "purple", "fuchsia", "magenta", "green",
+  "lime", "olive", "yellow", "navy", "blue", "teal", "aqua", "cyan", NULL };
+
+/* Reference implementations */
+
+static GstClockTime
+reference_parse_time (const GstTTMLState *state, const gchar *expr)
+{
+  gdouble h, m, s, count;
+  int f, subf;
+  char metric[3] = "\0\0";
+  GstClockTime res = GST_CLOCK_TIME_NONE;
+
+  if (sscanf (expr, "%lf:%lf:%lf:%d.%d", &h, &m, &s, &f, &subf) == 5) {
+    res =
+        (GstClockTime) ((h * 3600 + m * 60 + s +
+                            (f + subf / (gdouble) state->sub_frame_rate) *
+                                state->frame_rate_den /
+                                (state->frame_rate * state->frame_rate_num)) *
+                        GST_SECOND);
+  } else if (sscanf (expr, "%lf:%lf:%lf:%d", &h, &m, &s, &f) == 4) {
+    res =
+        (GstClockTime) ((h * 3600 + m * 60 + s +
+                            f * state->frame_rate_den /
+                                (state->frame_rate * state->frame_rate_num)) *
+                        GST_SECOND);
+  } else if (sscanf (expr, "%lf:%lf:%lf", &h, &m, &s) == 3) {
+    res = (GstClockTime) ((h * 3600 + m * 60 + s) * GST_SECOND);
+  } else if (sscanf (expr, "%lf%2[hmstf]", &count, metric) == 2) {
+    double scale = 0;
+    switch (metric[0]) {
+      case 'h':
+        scale = 3600 * GST_SECOND;
+        break;
+      case 'm':
+        if (metric[1] == 's')
+          scale = GST_MSECOND;
+        else
+          scale = 60 * GST_SECOND;
+        break;
+      case 's':
+        scale = GST_SECOND;
+        break;
+      case 't':
+        scale = 1.0 / state->tick_rate;
+        break;
+      case 'f':
+        scale = GST_SECOND * state->frame_rate_den /
+                (state->frame_rate * state->frame_rate_num);
+        break;
+    }
+    res = (GstClockTime) (count * scale);
+  }
+
+  return res;
+}
+
+static gboolean
+reference_parse_color (const gchar *expr, guint32 *color, const gchar **end)
+{
+  guint r, g, b, a;
+  int n = 0;
+  *end = expr;
+  if (sscanf (expr, "#%02x%02x%02x%02x%n", &r, &g, &b, &a, &n) == 4) {
+    *color = MAKE_COLOR (r, g, b, a);
+  } else if (sscanf (expr, "#%02x%02x%02x%n", &r, &g, &b, &n) == 3) {
+    *color = MAKE_COLOR (r, g, b, 0xFF);
+  } else if (sscanf (expr, "rgb(%d,%d,%d)%n", &r, &g, &b, &n) == 3) {
+    *color = MAKE_COLOR (r, g, b, 0xFF);
+  } else if (sscanf (expr, "rgba(%d,%d,%d,%d)%n", &r, &g, &b, &a, &n) == 4) {
+    *color = MAKE_COLOR (r, g, b, a);
+  } else {
+    static const guint32 values[] = { 0x00000000, 0x000000ff, 0xc0c0c0ff,
+      0x808080ff, 0xffffffff, 0x800000ff, 0xff0000ff, 0x800080ff, 0xff00ffff,
+      0xff00ffff, 0x008000ff, 0x00ff00ff, 0x808000ff, 0xffff00ff, 0x000080ff,
+      0x0000ffff, 0x008080ff, 0x00ffffff, 0x00ffffff };
+    gint i;
+    for (i = 0; named_colors[i]; i++) {
+      if (!g_ascii_strncasecmp (
+              expr, named_colors[i], strlen (named_colors[i]))) {
+        *color = values[i];
+        n = strlen (named_colors[i]);
+        break;
+      }
+    }
+    if (!named_colors[i]) {
+      *color = 0xFFFFFFFF;
+      return FALSE;
+    }
+  }
+
+  while (expr[n] != '\0' && g_ascii_isspace (expr[n]))
+    n++;
+  *end = expr + n;
+
+  return TRUE;
+}
+
+/* Returns TRUE on error */
+static gboolean
+reference_parse_length (const gchar *expr, gfloat *value,
+    GstTTMLLengthUnit *unit, const gchar **end)
+{
+  int n;
+  gboolean error = FALSE;
+
+  *value = 1.f;
+  *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
+  *end = expr;
+  n = 0;
+  if (sscanf (expr, "%f%n", value, &n)) {
+    if (n > 0 && expr[n - 1] == 'e') {
+      n--;
+    }
+    *end += n;
+    if (!g_ascii_strncasecmp (expr + n, "px", 2)) {
+      *unit = GST_TTML_LENGTH_UNIT_PIXELS;
+      *end += 2;
+    } else if (!g_ascii_strncasecmp (expr + n, "em", 2)) {
+      *unit = GST_TTML_LENGTH_UNIT_EM;
+      *end += 2;
+    } else if (!g_ascii_strncasecmp (expr + n, "c", 1)) {
+      *unit = GST_TTML_LENGTH_UNIT_CELLS;
+      *end += 1;
+    } else if (!g_ascii_strncasecmp (expr + n, "%", 1)) {
+      *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
+      *value /= 100.0;
+      *end += 1;
+    } else {
+      *unit = GST_TTML_LENGTH_UNIT_RELATIVE;
+      error = TRUE;
+    }
+  } else {
+    error = TRUE;
+  }
+
+  return error;
+}
+
+static gint
+reference_parse_lengths_list (
+    const gchar *expr, GstTTMLLength *length, int max_elements)
+{
+  const gchar *next;
+  int ndx = 0, i;
+  gboolean error;
+
+  do {
+    error = reference_parse_length (
+        expr, &length[ndx].f, &length[ndx].unit, &next);
+    if (!error) {
+      expr = next;
+      ndx++;
+    }
+  } while (!error && *next != '\0' && ndx < max_elements);
+
+  for (i = ndx; i < max_elements; i++) {
+    length[i].unit = GST_TTML_LENGTH_UNIT_NOT_PRESENT;
+  }
+
+  return ndx;
+}
+
+/* Generators */
+
+static const gchar *
+pick (GRand *rand, const gchar **list)
+{
+  return list[g_rand_int_range (rand, 0, g_strv_length ((gchar **) list))];
+}
+
+static void
+append_digits (GRand *rand, GString *str, gint min, gint max)
+{
+  gint n = g_rand_int_range (rand, min, max + 1);
+
+  while (n--)
+    g_string_append_c (str, '0' + g_rand_int_range (rand, 0, 10));
+}
+
+/* A decimal number, whose exponent (if any) is always complete */
+static void
+append_number (GRand *rand, GString *str, gboolean allow_minus)
+{
+  static const gchar *signs[] = { "", "", "", "+", " ", "-", NULL };
+  const gchar *sign = pick (rand, signs);
+
+  if (allow_minus || *sign != '-')
+    g_string_append (str, sign);
+
+  switch (g_rand_int_range (rand, 0, 4)) {
+    case 0:
+      append_digits (rand, str, 1, 3);
+      break;
+    case 1:
+      append_digits (rand, str, 1, 3);
+      g_string_append_c (str, '.');
+      append_digits (rand, str, 0, 3);
+      break;
+    case 2:
+      g_string_append_c (str, '.');
+      append_digits (rand, str, 1, 6);
+      break;
+    case 3:
+      /* Too many digits for the fast path */
+      g_string_append (str, "0.");
+      append_digits (rand, str, 16, 24);
+      break;
+  }
+
+  /* Small positive exponents, so times do not overflow */
+  if (g_rand_int_range (rand, 0, 5) == 0) {
+    static const gchar *exponents[] = { "e", "E", "e+", NULL };
+    g_string_append (str, pick (rand, exponents));
+    g_string_append_c (str, '0' + g_rand_int_range (rand, 0, 4));
+  } else if (g_rand_int_range (rand, 0, 5) == 0) {
+    g_string_append (str, g_rand_boolean (rand) ? "e-" : "E-");
+    append_digits (rand, str, 1, 2);
+  }
+}
+
+static void
+generate_time (GRand *rand, GString *str)
+{
+  static const gchar *separators[] = { ":", ":", ":", ".", "", NULL };
+  static const gchar *suffixes[] = { "", "", "h", "m", "s", "t", "f", "ms",
+    "mh", "sm", " s", "z", "hz", NULL };
+  gint i, n = g_rand_int_range (rand, 1, 6);
+
+  g_string_truncate (str, 0);
+  for (i = 0; i < n; i++) {
+    if (i > 0)
+      g_string_append (str, pick (rand, separators));
+    /* Frames and sub-frames are read as integers, keep them small */
+    if (i >= 3 || g_rand_int_range (rand, 0, 4) == 0)
+      append_digits (rand, str, 1, 3);
+    else
+      append_number (rand, str, FALSE);
+  }
+  g_string_append (str, pick (rand, suffixes));
+}
+
+static void
+generate_color (GRand *rand, GString *str)
+{
+  static const gchar hex[] = "0123456789abcdefABCDEF";
+  static const gchar *hex_suffixes[] = { "", "", "px", "g", "z", NULL };
+  static const gchar *suffixes[] = { "", "", " ", "  2px", "z", " red",
+    NULL };
+  static const gchar *separators[] = { ",", ",", ",", ", ", " ,", ";",
+    NULL };
+  guint i, n;
+
+  g_string_truncate (str, 0);
+  switch (g_rand_int_range (rand, 0, 4)) {
+    case 0:
+      g_string_append_c (str, '#');
+      n = g_rand_int_range (rand, 0, 10);
+      for (i = 0; i < n; i++)
+        g_string_append_c (str, hex[g_rand_int_range (rand, 0, 22)]);
+      g_string_append (str, pick (rand, hex_suffixes));
+      return;
+    case 1:
+    case 2:
+      g_string_append (str, g_rand_boolean (rand) ? "rgb(" : "rgba(");
+      n = g_rand_int_range (rand, 1, 6);
+      for (i = 0; i < n; i++) {
+        if (i)
+          g_string_append (str, pick (rand, separators));
+        if (g_rand_int_range (rand, 0, 4) == 0)
+          g_string_append_c (str, g_rand_boolean (rand) ? '+' : '-');
+        g_string_append_printf (str, "%d", g_rand_int_range (rand, 0, 300));
+      }
+      if (g_rand_int_range (rand, 0, 4))
+        g_string_append_c (str, ')');
+      break;
+    case 3:
+      g_string_append (str, pick (rand, named_colors));
+      for (i = 0; i < str->len; i++) {
+        if (g_rand_boolean (rand))
+          str->str[i] = g_ascii_toupper (str->str[i]);
+      }
+      break;
+  }
+  g_string_append (str, pick (rand, suffixes));
+}
+
+static void
+generate_lengths (GRand *rand, GString *str)
+{
+  /* No upper case "E" units: sscanf takes it for an exponent */
+  static const gchar *units[] = { "px", "PX", "pX", "em", "eM", "c", "C",
+    "%", "%", "", "z", NULL };
+  static const gchar *separators[] = { " ", " ", "  ", "\t", "", NULL };
+  gint n = g_rand_int_range (rand, 1, 5);
+
+  g_string_truncate (str, 0);
+  while (n--) {
+    append_number (rand, str, TRUE);
+    g_string_append (str, pick (rand, units));
+    if (n)
+      g_string_append (str, pick (rand, separators));
+  }
+}
+
+static void
+generate_int_pair (GRand *rand, GString *str)
+{
+  static const gchar *separators[] = { " ", " ", "  ", "\t", "", ",",
+    " x ", NULL };
+  static const gchar *signs[] = { "", "", "+", "-", NULL };
+
+  g_string_truncate (str, 0);
+  g_string_append_printf (str, "%s%d", pick (rand, signs),
+      g_rand_int_range (rand, 0, 100000));
+  if (g_rand_int_range (rand, 0, 8)) {
+    const gchar *separator = pick (rand, separators);
+    const gchar *sign = pick (rand, signs);
+
+    /* Without separator only if the sign splits the numbers */
+    if (*separator == '\0' && *sign == '\0')
+      separator = " ";
+    g_string_append (str, separator);
+    g_string_append_printf (
+        str, "%s%d", sign, g_rand_int_range (rand, 0, 100000));
+  }
+}
+
+static void
+init_state (GstTTMLState *state)
+{
+  memset (state, 0, sizeof (GstTTMLState));
+  state->tick_rate = 10000000.0 / GST_SECOND;
+  state->frame_rate = 30.0;
+  state->frame_rate_num = 1000;
+  state->frame_rate_den = 1001;
+  state->sub_frame_rate = 2;
+}
+
+GST_START_TEST (test_time_expressions)
+{
+  GRand *rand = g_rand_new_with_seed (0x77a1);
+  GString *str = g_string_new (NULL);
+  GstTTMLState state;
+  gint i;
+
+  init_state (&state);
+  for (i = 0; i < ITERATIONS; i++) {
+    GstClockTime expected, result;
+
+    generate_time (rand, str);
+    expected = reference_parse_time (&state, str->str);
+    result = gst_ttml_expression_parse_time (&state, str->str);
+    fail_unless (result == expected, "%s: %" G_GUINT64_FORMAT " != %"
+        G_GUINT64_FORMAT, str->str, result, expected);
+  }
+
+  g_string_free (str, TRUE);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_color_expressions)
+{
+  GRand *rand = g_rand_new_with_seed (0x77a2);
+  GString *str = g_string_new (NULL);
+  gint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    guint32 expected, result;
+    const gchar *expected_end, *result_end;
+    gboolean expected_ok, result_ok;
+
+    generate_color (rand, str);
+    expected_ok = reference_parse_color (str->str, &expected, &expected_end);
+    result_ok =
+        gst_ttml_expression_parse_color (str->str, &result, &result_end);
+    fail_unless (result_ok == expected_ok && result == expected &&
+                     result_end == expected_end,
+        "%s: %d #%08x +%d != %d #%08x +%d", str->str, result_ok, result,
+        (gint) (result_end - str->str), expected_ok, expected,
+        (gint) (expected_end - str->str));
+  }
+
+  g_string_free (str, TRUE);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_length_expressions)
+{
+  GRand *rand = g_rand_new_with_seed (0x77a3);
+  GString *str = g_string_new (NULL);
+  gint i, j;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    GstTTMLLength expected[3], result[3];
+    gint expected_n, result_n;
+
+    generate_lengths (rand, str);
+    expected_n = reference_parse_lengths_list (str->str, expected, 3);
+    result_n = gst_ttml_expression_parse_lengths_list (str->str, result, 3);
+    fail_unless (result_n == expected_n, "%s: %d != %d elements", str->str,
+        result_n, expected_n);
+    for (j = 0; j < 3; j++) {
+      fail_unless (result[j].unit == expected[j].unit, "%s: unit %d != %d",
+          str->str, result[j].unit, expected[j].unit);
+      if (j < result_n)
+        fail_unless (result[j].f == expected[j].f, "%s: %.9g != %.9g",
+            str->str, result[j].f, expected[j].f);
+    }
+  }
+
+  g_string_free (str, TRUE);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_int_pairs)
+{
+  GRand *rand = g_rand_new_with_seed (0x77a4);
+  GString *str = g_string_new (NULL);
+  gint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    gint expected[2] = { -1, -1 }, result[2] = { -1, -1 };
+    gint expected_n, result_n = 0;
+    const gchar *end;
+
+    generate_int_pair (rand, str);
+    expected_n = sscanf (str->str, "%d %d", &expected[0], &expected[1]);
+    if (gst_ttml_expression_parse_int (str->str, &result[0], &end)) {
+      result_n++;
+      if (gst_ttml_expression_parse_int (end, &result[1], NULL))
+        result_n++;
+    }
+    fail_unless (result_n == expected_n && result[0] == expected[0] &&
+                     result[1] == expected[1],
+        "%s: %d (%d %d) != %d (%d %d)", str->str, result_n, result[0],
+        result[1], expected_n, expected[0], expected[1]);
+  }
+
+  g_string_free (str, TRUE);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* Inputs on which the parsers knowingly differ from sscanf */
+GST_START_TEST (test_malformed_expressions)
+{
+  GstTTMLState state;
+  GstTTMLLength length[2];
+  guint32 color;
+  const gchar *end;
+  gdouble d;
+  gint i;
+
+  init_state (&state);
+
+  /* The alpha is not taken from the next token */
+  fail_unless (gst_ttml_expression_parse_color ("#FF8040 2px", &color, &end));
+  fail_unless_equals_int_hex (color, 0xFF8040FF);
+  fail_unless_equals_string (end, "2px");
+  fail_if (gst_ttml_expression_parse_color ("# FF8040", &color, &end));
+  fail_if (gst_ttml_expression_parse_color ("#+F+F+F", &color, &end));
+
+  /* An exponent without digits is not part of the number */
+  fail_unless (gst_ttml_expression_parse_double ("5es", &d, &end));
+  fail_unless_equals_float (d, 5.0);
+  fail_unless_equals_string (end, "es");
+  fail_unless_equals_uint64 (
+      gst_ttml_expression_parse_time (&state, "5es"), GST_CLOCK_TIME_NONE);
+  fail_unless_equals_uint64 (
+      gst_ttml_expression_parse_time (&state, "5e1s"), 50 * GST_SECOND);
+  fail_unless_equals_int (
+      gst_ttml_expression_parse_lengths_list ("2Em 1e+px", length, 2), 1);
+  fail_unless_equals_int (length[0].unit, GST_TTML_LENGTH_UNIT_EM);
+  fail_unless_equals_float (length[0].f, 2.0);
+  fail_unless_equals_int (length[1].unit, GST_TTML_LENGTH_UNIT_NOT_PRESENT);
+
+  /* Integers saturate instead of wrapping around */
+  fail_unless (gst_ttml_expression_parse_int ("4294967297", &i, &end));
+  fail_unless_equals_int (i, G_MAXINT);
+  fail_unless (gst_ttml_expression_parse_int (" -4294967297 ", &i, &end));
+  fail_unless_equals_int (i, G_MININT);
+  fail_unless_equals_string (end, " ");
+
+  /* Neither infinities nor hexadecimal numbers */
+  fail_if (gst_ttml_expression_parse_double ("inf", &d, &end));
+  fail_unless (gst_ttml_expression_parse_double ("0x10", &d, &end));
+  fail_unless_equals_float (d, 0.0);
+  fail_unless_equals_string (end, "x10");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_locale)
+{
+  gchar *previous_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
+  GstTTMLState state;
+  gdouble d;
+  gfloat f;
+
+  init_state (&state);
+
+  /* Only meaningful if any locale with decimal comma is available */
+  if (!setlocale (LC_NUMERIC, "de_DE.UTF-8"))
+    setlocale (LC_NUMERIC, "fr_FR.UTF-8");
+
+  fail_unless (gst_ttml_expression_parse_double ("1.5", &d, NULL));
+  fail_unless_equals_float (d, 1.5);
+  fail_unless (gst_ttml_expression_parse_float ("0.25", &f, NULL));
+  fail_unless_equals_float (f, 0.25);
+  fail_unless (gst_ttml_expression_parse_double (
+      "1.25000000000000000000001", &d, NULL));
+  fail_unless_equals_float (d, 1.25);
+  fail_unless_equals_uint64 (gst_ttml_expression_parse_time (&state, "1.5s"),
+      1500 * GST_MSECOND);
+
+  setlocale (LC_NUMERIC, previous_locale);
+  g_free (previous_locale);
+}
+
+GST_END_TEST;
+
+static Suite *
+expression_suite (void)
+{
+  Suite *s = suite_create ("ttml_expression");
+  TCase *tc_equivalence = tcase_create ("equivalence");
+  TCase *tc_general = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc_equivalence);
+  tcase_add_test (tc_equivalence, test_time_expressions);
+  tcase_add_test (tc_equivalence, test_color_expressions);
+  tcase_add_test (tc_equivalence, test_length_expressions);
+  tcase_add_test (tc_equivalence, test_int_pairs);
+
+  suite_add_tcase (s, tc_general);
+  tcase_add_test (tc_general, test_malformed_expressions);
+  tcase_add_test (tc_general, test_locale);
+
+  return s;
+}
+
+GST_CHECK_MAIN (expression);
@@ -0,0 +1,443 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the cache of the <head> of segmented streams: which documents
+ * repeat the head of the previous one, and that a document parsed with the
+ * results of a cached head produces the same output, with the same named
+ * styles, regions and embedded data, as the same document parsed from
+ * scratch. Buffers of several documents, parsed in worker threads, must
+ * give the same output too, also when the number of threads changes. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#include "gstttmlattribute.h"
+#include "gstttmlbase.h"
+#include "gstttmlheadcache.h"
+#include "gstttmlspan.h"
+#include "gstttmlstate.h"
+#include "gstttmlstyle.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define TT_START(styling_prefix)                                              \
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"                              \
+  "<tt xmlns=\"http://www.w3.org/ns/ttml\" "                                  \
+  "xmlns:" styling_prefix "=\"http://www.w3.org/ns/ttml#styling\" "           \
+  "xmlns:smpte=\"http://www.smpte-ra.org/schemas/2052-1/2010/smpte-tt\" "     \
+  "xml:lang=\"en\">\n"
+
+/* Named styles referencing each other, regions with their own and nested
+ * styling, and an embedded image */
+#define HEAD(p, color)                                                        \
+  "<head>\n"                                                                  \
+  "<metadata><smpte:image imagetype=\"PNG\" encoding=\"Base64\" "             \
+  "xml:id=\"img0\">iVBORw0KGgoAAAANSUhEUgAAAAE=</smpte:image></metadata>\n"   \
+  "<styling>\n"                                                               \
+  "<style xml:id=\"s0\" " p ":color=\"" color "\" " p                         \
+  ":fontSize=\"120%\"/>\n"                                                    \
+  "<style xml:id=\"s1\" style=\"s0\" " p ":fontWeight=\"bold\"/>\n"           \
+  "</styling>\n"                                                              \
+  "<layout>\n"                                                                \
+  "<region xml:id=\"r0\" " p ":origin=\"10% 80%\" " p                         \
+  ":extent=\"80% 10%\"/>\n"                                                   \
+  "<region xml:id=\"r1\" style=\"s0\" " p ":backgroundColor=\"black\">"       \
+  "<style " p ":textAlign=\"center\"/></region>\n"                            \
+  "</layout>\n"                                                               \
+  "</head>\n"
+
+#define BODY(p, first)                                                        \
+  "<body><div>\n"                                                             \
+  "<p begin=\"" first "s\" end=\"" first ".5s\" region=\"r0\" "               \
+  "style=\"s1\">Bold <span style=\"s0\">and yellow</span></p>\n"              \
+  "<p begin=\"" first ".2s\" end=\"" first ".9s\" region=\"r1\" " p           \
+  ":fontStyle=\"italic\">Centered</p>\n"                                      \
+  "</div></body>\n"                                                           \
+  "</tt>\n"
+
+#define DOCUMENT(p, color, first) TT_START (p) HEAD (p, color) BODY (p, first)
+
+/* Whether each document repeats the head of the previous one */
+static const struct
+{
+  const gchar *document;
+  gboolean hit;
+} documents[] = {
+  { DOCUMENT ("tts", "yellow", "0"), FALSE },
+  { DOCUMENT ("tts", "yellow", "1"), TRUE },
+  { DOCUMENT ("tts", "yellow", "2"), TRUE },
+  /* Different head contents */
+  { DOCUMENT ("tts", "red", "3"), FALSE },
+  { DOCUMENT ("tts", "red", "4"), TRUE },
+  /* Same contents, only the prefix is different */
+  { DOCUMENT ("s", "red", "5"), FALSE },
+  { DOCUMENT ("s", "red", "6"), TRUE },
+  { DOCUMENT ("tts", "red", "7"), FALSE },
+};
+
+
+/* An element whose output is a dump of the state of the parser: the active
+ * spans, the regions, the named styles and the embedded data */
+typedef GstTTMLBase TestHead;
+typedef GstTTMLBaseClass TestHeadClass;
+
+G_DEFINE_TYPE (TestHead, test_head, GST_TYPE_TTMLBASE);
+
+static GstStaticPadTemplate test_head_src_template = GST_STATIC_PAD_TEMPLATE (
+    "src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS ("text/x-raw"));
+
+static void
+dump_style (GString *str, const GstTTMLStyle *style)
+{
+  GstTTMLAttributeType type;
+
+  for (type = 0; type < GST_TTML_ATTR_UNKNOWN; type++) {
+    GstTTMLAttribute *attr = gst_ttml_style_get_attr (style, type);
+    gchar *value;
+
+    if (!attr)
+      continue;
+    /* Not every type can be dumped */
+    value = gst_ttml_attribute_dump (attr);
+    if (value)
+      g_string_append_printf (str, " %d=%s", type, value);
+    else
+      g_string_append_printf (
+          str, " %d#%08x", type, gst_ttml_attribute_hash (attr));
+    g_free (value);
+  }
+}
+
+/* Styles of a table, sorted by ID since hash tables have no order */
+static void
+dump_styles (GString *str, const gchar *name, GHashTable *table)
+{
+  GList *ids, *l;
+
+  if (!table)
+    return;
+
+  ids = g_list_sort (g_hash_table_get_keys (table), (GCompareFunc) strcmp);
+  for (l = ids; l; l = l->next) {
+    g_string_append_printf (str, "%s %s:", name, (gchar *) l->data);
+    dump_style (str, g_hash_table_lookup (table, l->data));
+    g_string_append_c (str, '\n');
+  }
+  g_list_free (ids);
+}
+
+static void
+dump_data (GString *str, GHashTable *table)
+{
+  GList *ids, *l;
+
+  if (!table)
+    return;
+
+  ids = g_list_sort (g_hash_table_get_keys (table), (GCompareFunc) strcmp);
+  for (l = ids; l; l = l->next) {
+    GBytes *data = g_hash_table_lookup (table, l->data);
+
+    g_string_append_printf (str, "data %s: %" G_GSIZE_FORMAT " %08x\n",
+        (gchar *) l->data, g_bytes_get_size (data), g_bytes_hash (data));
+  }
+  g_list_free (ids);
+}
+
+/* Only when there is text, so the times of the output do not depend on
+ * what the element parsed before */
+static GstBuffer *
+test_head_gen_buffer (GstTTMLBase *base, GstClockTime ts, GstClockTime dur)
+{
+  GString *str;
+  GList *l;
+  gsize len;
+
+  if (!base->active_spans)
+    return NULL;
+
+  str = g_string_new (NULL);
+  g_string_append_printf (str, "%" GST_TIME_FORMAT " %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (ts), GST_TIME_ARGS (dur));
+  for (l = base->active_spans; l; l = l->next) {
+    GstTTMLSpan *span = l->data;
+
+    g_string_append_printf (
+        str, "span %u '%.*s':", span->id, (gint) span->length, span->chars);
+    dump_style (str, span->style);
+    g_string_append_c (str, '\n');
+  }
+  dump_styles (str, "region", base->state.saved_region_attr_stacks);
+  dump_styles (str, "style", base->state.saved_styling_attr_stacks);
+  dump_data (str, base->state.saved_data);
+  g_string_append_printf (str, "zindex %u\n", base->state.last_zindex_micro);
+
+  len = str->len + 1;
+  return gst_buffer_new_wrapped (g_string_free (str, FALSE), len);
+}
+
+static void
+test_head_class_init (TestHeadClass *klass)
+{
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_static_pad_template_get (&test_head_src_template));
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "TTML head test", "Codec/Parser/Subtitle",
+      "Dumps the state of the TTML parser",
+      "Fluendo S.A. <support@fluendo.com>");
+
+  klass->gen_buffer = test_head_gen_buffer;
+}
+
+static void
+test_head_init (TestHead *base)
+{
+}
+
+static GstHarness *
+test_head_harness_new (void)
+{
+  GstElement *element = g_object_new (test_head_get_type (), NULL);
+  GstHarness *h;
+
+  gst_object_ref_sink (element);
+  h = gst_harness_new_with_element (element, "sink", "src");
+  gst_object_unref (element);
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+
+  return h;
+}
+
+/* Pushes a whole document and returns the dumps it produced */
+static gchar *
+parse_document (GstHarness *h, const gchar *document)
+{
+  GString *output = g_string_new (NULL);
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_wrapped (g_strdup (document), strlen (document));
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  while ((buffer = gst_harness_try_pull (h))) {
+    GstMapInfo map;
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    g_string_append (output, (const gchar *) map.data);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+
+  return g_string_free (output, FALSE);
+}
+
+static gchar *
+replace (const gchar *str, const gchar *old, const gchar *new)
+{
+  gchar **parts = g_strsplit (str, old, -1);
+  gchar *ret = g_strjoinv (new, parts);
+
+  g_strfreev (parts);
+  return ret;
+}
+
+GST_START_TEST (test_find_head)
+{
+  const gchar *doc = documents[0].document;
+  const gchar *prefixed =
+      "<tt:tt xmlns:tt=\"http://www.w3.org/ns/ttml\"><!-- <body> -->"
+      "<tt:head><tt:styling/><head></head></tt:head><tt:body/></tt:tt>";
+  gsize start, end;
+
+  fail_unless (
+      gst_ttml_head_cache_find_head (doc, strlen (doc), &start, &end));
+  fail_unless (strncmp (doc + start, "<head>", 6) == 0);
+  fail_unless (strncmp (doc + end - 7, "</head>", 7) == 0);
+
+  /* Any prefix, comments skipped, nested elements with the same name */
+  fail_unless (gst_ttml_head_cache_find_head (
+      prefixed, strlen (prefixed), &start, &end));
+  fail_unless (strncmp (prefixed + start, "<tt:head>", 9) == 0);
+  fail_unless (strncmp (prefixed + end, "<tt:body/>", 10) == 0);
+
+  /* Truncated head */
+  fail_if (gst_ttml_head_cache_find_head (doc, end - 1, &start, &end));
+  /* No head, or an empty one */
+  fail_if (gst_ttml_head_cache_find_head (
+      "<tt><body/></tt>", 16, &start, &end));
+  fail_if (gst_ttml_head_cache_find_head (
+      "<tt><head/><body/></tt>", 23, &start, &end));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_matches)
+{
+  const gchar *doc = documents[0].document;
+  GstTTMLHeadCache *cache;
+  gchar *other_uri;
+  gsize start, end;
+  guint i;
+
+  fail_unless (
+      gst_ttml_head_cache_find_head (doc, strlen (doc), &start, &end));
+  cache = gst_ttml_head_cache_new (doc, start, end);
+  fail_unless_equals_int (g_bytes_get_size (cache->key), end);
+
+  for (i = 0; i < G_N_ELEMENTS (documents); i++) {
+    const gchar *other = documents[i].document;
+
+    /* The same up to the end of the head, whatever the body */
+    fail_unless_equals_int (
+        gst_ttml_head_cache_matches (cache, other, strlen (other)),
+        strncmp (doc, other, end) == 0);
+  }
+  fail_unless (gst_ttml_head_cache_matches (cache, documents[1].document,
+      strlen (documents[1].document)));
+  /* Not all of the head yet */
+  fail_if (gst_ttml_head_cache_matches (cache, doc, end - 1));
+
+  /* Same head bytes at the same offset, but its prefix bound to another
+   * namespace */
+  other_uri = replace (doc, "ns/ttml#styling", "ns/ttml#profile");
+  fail_if (gst_ttml_head_cache_matches (cache, other_uri, strlen (other_uri)));
+  g_free (other_uri);
+
+  gst_ttml_head_cache_free (cache);
+}
+
+GST_END_TEST;
+
+/* Every document through the same element, using the cached head when it
+ * repeats the previous one, gives the same output as a new element */
+GST_START_TEST (test_apply)
+{
+  GstHarness *h = test_head_harness_new ();
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (documents); i++) {
+    GstTTMLHeadCache *previous = GST_TTMLBASE (h->element)->head_cache;
+    GstHarness *fresh = test_head_harness_new ();
+    gchar *output, *expected;
+
+    output = parse_document (h, documents[i].document);
+    fail_unless (GST_TTMLBASE (h->element)->head_cache != NULL);
+    fail_unless_equals_int (
+        GST_TTMLBASE (h->element)->head_cache == previous, documents[i].hit);
+
+    expected = parse_document (fresh, documents[i].document);
+    fail_unless (strstr (expected, "span ") != NULL);
+    fail_unless (strstr (expected, "style s1:") != NULL);
+    fail_unless (strstr (expected, "data img0:") != NULL);
+    fail_unless_equals_string (output, expected);
+
+    g_free (output);
+    g_free (expected);
+    gst_harness_teardown (fresh);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Pushes the documents from 'first' on, in buffers of 'per_buffer' of them,
+ * and returns the dumps they produced */
+static gchar *
+parse_documents (GstHarness *h, guint first, guint per_buffer)
+{
+  GString *output = g_string_new (NULL);
+  guint i, j;
+
+  for (i = first; i < G_N_ELEMENTS (documents); i += per_buffer) {
+    GString *buffer = g_string_new (NULL);
+    gchar *dump;
+
+    for (j = i; j < MIN (i + per_buffer, G_N_ELEMENTS (documents)); j++)
+      g_string_append (buffer, documents[j].document);
+    dump = parse_document (h, buffer->str);
+    g_string_append (output, dump);
+    g_free (dump);
+    g_string_free (buffer, TRUE);
+  }
+
+  return g_string_free (output, FALSE);
+}
+
+/* The same output with parse_threads at 1 and above, whatever the number
+ * of documents per buffer, and after it changes while playing */
+GST_START_TEST (test_parse_threads)
+{
+  const guint threads[] = { 2, 4, 8 };
+  guint per_buffer, i, first;
+
+  for (per_buffer = 2; per_buffer <= G_N_ELEMENTS (documents);
+       per_buffer++) {
+    for (first = 0; first < 2; first++) {
+      GstHarness *serial = test_head_harness_new ();
+      gchar *expected[2];
+
+      expected[0] = parse_documents (serial, first, per_buffer);
+      expected[1] = parse_documents (serial, first, per_buffer);
+      fail_unless (strstr (expected[0], "span ") != NULL);
+      fail_unless (strstr (expected[0], "style s1:") != NULL);
+      fail_unless (GST_TTMLBASE (serial->element)->parse_pool == NULL);
+      gst_harness_teardown (serial);
+
+      for (i = 0; i < G_N_ELEMENTS (threads); i++) {
+        GstHarness *parallel = test_head_harness_new ();
+        GstTTMLBase *base = GST_TTMLBASE (parallel->element);
+        GThreadPool *pool;
+        gchar *output;
+
+        g_object_set (base, "parse_threads", threads[i], NULL);
+        output = parse_documents (parallel, first, per_buffer);
+        fail_unless_equals_string (output, expected[0]);
+        g_free (output);
+
+        /* The pool is resized, not recreated */
+        pool = base->parse_pool;
+        fail_unless (pool != NULL);
+        g_object_set (base, "parse_threads", 3, NULL);
+        fail_unless_equals_int (g_thread_pool_get_max_threads (pool), 3);
+        output = parse_documents (parallel, first, per_buffer);
+        fail_unless_equals_string (output, expected[1]);
+        fail_unless (base->parse_pool == pool);
+        g_free (output);
+
+        gst_harness_teardown (parallel);
+      }
+      g_free (expected[0]);
+      g_free (expected[1]);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+headcache_suite (void)
+{
+  Suite *s = suite_create ("ttml_headcache");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_find_head);
+  tcase_add_test (tc, test_matches);
+  tcase_add_test (tc, test_apply);
+  tcase_add_test (tc, test_parse_threads);
+
+  return s;
+}
+
+GST_CHECK_MAIN (headcache);
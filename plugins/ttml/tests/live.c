@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the output of ttmlparse in live mode while a document arrives in
+ * several buffers: it goes up to the timestamp of the last input buffer, or
+ * further when the content is ahead of it by more than the maximum
+ * lookahead, but never past the beginning of an open paragraph. The latency
+ * it reports is the longest time from a buffer ending inside a document to
+ * the next one, for which the output can wait, capped at the lookahead.
+ * Complete documents add nothing to it, however sparse they are. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define UPSTREAM_LATENCY (100 * GST_MSECOND)
+
+typedef struct
+{
+  GstClockTime end;
+  GString *text;
+} Output;
+
+/* Pushes a chunk of the document and collects what was output for it */
+static void
+push_chunk (GstHarness *h, GstClockTime pts, const gchar *chunk,
+    Output *output)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_wrapped (g_strdup (chunk), strlen (chunk));
+  GST_BUFFER_PTS (buffer) = pts;
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  output->end = GST_CLOCK_TIME_NONE;
+  g_string_truncate (output->text, 0);
+  while ((buffer = gst_harness_try_pull (h))) {
+    GstMapInfo map;
+
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buffer));
+    fail_unless (GST_BUFFER_DURATION_IS_VALID (buffer));
+    output->end = GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer);
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    g_string_append_len (output->text, (const gchar *) map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+}
+
+GST_START_TEST (test_watermark)
+{
+  GstHarness *h = gst_harness_new ("ttmlparse");
+  Output output = { GST_CLOCK_TIME_NONE, g_string_new (NULL) };
+
+  g_object_set (h->element, "live", TRUE, "max_lookahead",
+      (guint64) (500 * GST_MSECOND), NULL);
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+  gst_harness_set_upstream_latency (h, UPSTREAM_LATENCY);
+  fail_unless_equals_uint64 (gst_harness_query_latency (h), UPSTREAM_LATENCY);
+
+  /* More content beginning at 0 may still come */
+  push_chunk (h, 0,
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\"><body><div>\n"
+      "<p begin=\"0s\" end=\"1s\">One</p>\n",
+      &output);
+  fail_if (GST_CLOCK_TIME_IS_VALID (output.end));
+
+  /* Up to the timestamp of the input */
+  push_chunk (h, 2 * GST_SECOND, "<p begin=\"2s\" end=\"3s\">Two</p>\n",
+      &output);
+  fail_unless_equals_uint64 (output.end, 2 * GST_SECOND);
+  fail_unless (strstr (output.text->str, "One") != NULL);
+  fail_if (strstr (output.text->str, "Two") != NULL);
+  /* The 2s since the open document was pushed, capped at the lookahead */
+  fail_unless_equals_uint64 (
+      gst_harness_query_latency (h), UPSTREAM_LATENCY + 500 * GST_MSECOND);
+
+  /* Not past the beginning of the open paragraph */
+  push_chunk (h, 4 * GST_SECOND, "<p begin=\"4s\" end=\"5s\">Thr", &output);
+  fail_unless_equals_uint64 (output.end, 4 * GST_SECOND);
+  fail_unless (strstr (output.text->str, "Two") != NULL);
+
+  /* Up to the lookahead before the newest content, ahead of the input */
+  push_chunk (h, 4500 * GST_MSECOND,
+      "ee</p>\n<p begin=\"6s\" end=\"7s\">Four</p>\n", &output);
+  fail_unless_equals_uint64 (output.end, 5500 * GST_MSECOND);
+  fail_unless (strstr (output.text->str, "Three") != NULL);
+  fail_if (strstr (output.text->str, "Four") != NULL);
+  fail_unless_equals_uint64 (
+      gst_harness_query_latency (h), UPSTREAM_LATENCY + 500 * GST_MSECOND);
+
+  /* Everything at the end of the document */
+  push_chunk (h, 8 * GST_SECOND, "</div></body></tt>\n", &output);
+  fail_unless (output.end >= 7 * GST_SECOND);
+  fail_unless (strstr (output.text->str, "Four") != NULL);
+  fail_unless_equals_uint64 (
+      gst_harness_query_latency (h), UPSTREAM_LATENCY + 500 * GST_MSECOND);
+
+  g_string_free (output.text, TRUE);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Sparse complete documents hold nothing back, only the time to the buffer
+ * closing an open one counts */
+GST_START_TEST (test_latency_sparse)
+{
+  GstHarness *h = gst_harness_new ("ttmlparse");
+  Output output = { GST_CLOCK_TIME_NONE, g_string_new (NULL) };
+  const gchar *header = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<tt xmlns=\"http://www.w3.org/ns/ttml\"><body><div>";
+  guint i;
+
+  g_object_set (h->element, "live", TRUE, "max_lookahead",
+      (guint64) (5 * GST_SECOND), NULL);
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+  gst_harness_set_upstream_latency (h, UPSTREAM_LATENCY);
+
+  for (i = 0; i < 3; i++) {
+    gchar *doc = g_strdup_printf ("%s<p begin=\"%us\" end=\"%us\">Cue</p>"
+                                  "</div></body></tt>\n",
+        header, 10 * i, 10 * i + 1);
+
+    push_chunk (h, 10 * i * GST_SECOND, doc, &output);
+    fail_unless (strstr (output.text->str, "Cue") != NULL);
+    fail_unless_equals_uint64 (
+        gst_harness_query_latency (h), UPSTREAM_LATENCY);
+    g_free (doc);
+  }
+
+  push_chunk (h, 30 * GST_SECOND, header, &output);
+  fail_unless_equals_uint64 (gst_harness_query_latency (h), UPSTREAM_LATENCY);
+  push_chunk (h, 31 * GST_SECOND,
+      "<p begin=\"31s\" end=\"32s\">Late</p></div></body></tt>\n", &output);
+  fail_unless (strstr (output.text->str, "Late") != NULL);
+  fail_unless_equals_uint64 (
+      gst_harness_query_latency (h), UPSTREAM_LATENCY + GST_SECOND);
+
+  /* Whole documents after it do not make it grow */
+  push_chunk (h, 60 * GST_SECOND, header, &output);
+  push_chunk (h, 60 * GST_SECOND, "</div></body></tt>\n", &output);
+  push_chunk (h, 90 * GST_SECOND, header, &output);
+  fail_unless_equals_uint64 (
+      gst_harness_query_latency (h), UPSTREAM_LATENCY + GST_SECOND);
+
+  g_string_free (output.text, TRUE);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Without live mode, nothing is added to the upstream latency */
+GST_START_TEST (test_latency_not_live)
+{
+  GstHarness *h = gst_harness_new ("ttmlparse");
+
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+  gst_harness_set_upstream_latency (h, UPSTREAM_LATENCY);
+  fail_unless_equals_uint64 (gst_harness_query_latency (h), UPSTREAM_LATENCY);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+live_suite (void)
+{
+  Suite *s = suite_create ("ttml_live");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_watermark);
+  tcase_add_test (tc, test_latency_sparse);
+  tcase_add_test (tc, test_latency_not_live);
+
+  return s;
+}
+
+GST_CHECK_MAIN (live);
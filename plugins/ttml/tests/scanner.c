@@ -0,0 +1,303 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks that the scanner finds the same document boundaries in a stream of
+ * concatenated documents wherever the stream is split into buffers: after
+ * the end of the root element, whatever its prefix, or at the XML
+ * declaration of a document which starts before the previous one was
+ * closed, even when the declaration is split across buffers. Markup inside
+ * comments, CDATA sections, processing instructions, declarations and
+ * attribute values must be ignored. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlscanner.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define MAX_BOUNDARIES 8
+
+typedef struct
+{
+  GstTTMLScannerBoundary type;
+  /* From the start of the stream */
+  gsize offset;
+} Boundary;
+
+/* Scans the stream split at the given offsets, the way ttmlbase feeds its
+ * buffers to it, and returns the number of boundaries found */
+static guint
+scan_stream (const gchar *stream, const gsize *splits, guint n_splits,
+    Boundary *boundaries)
+{
+  GstTTMLScanner scanner;
+  gsize len = strlen (stream), start = 0;
+  guint n = 0, i;
+
+  gst_ttml_scanner_init (&scanner);
+  for (i = 0; i <= n_splits; i++) {
+    gsize end = i < n_splits ? splits[i] : len;
+    gsize pos = start;
+
+    while (pos < end) {
+      GstTTMLScannerBoundary type;
+      gsize chunk_len =
+          gst_ttml_scanner_scan (&scanner, stream + pos, end - pos, &type);
+
+      fail_unless (chunk_len <= end - pos);
+      if (type != GST_TTML_SCANNER_BOUNDARY_NONE) {
+        fail_unless (n < MAX_BOUNDARIES);
+        boundaries[n].type = type;
+        boundaries[n].offset = pos + chunk_len;
+        /* The part of the declaration in previous buffers */
+        if (type == GST_TTML_SCANNER_BOUNDARY_RESTART)
+          boundaries[n].offset -= scanner.carried;
+        n++;
+      }
+      pos += chunk_len;
+    }
+    start = end;
+  }
+
+  return n;
+}
+
+static void
+check_boundaries (const gchar *stream, const Boundary *expected,
+    guint n_expected, const gsize *splits, guint n_splits)
+{
+  Boundary boundaries[MAX_BOUNDARIES];
+  guint n, i;
+
+  n = scan_stream (stream, splits, n_splits, boundaries);
+  fail_unless_equals_int (n, n_expected);
+  for (i = 0; i < n; i++) {
+    fail_unless_equals_int (boundaries[i].type, expected[i].type);
+    fail_unless (boundaries[i].offset == expected[i].offset,
+        "Boundary %u at %" G_GSIZE_FORMAT " instead of %" G_GSIZE_FORMAT
+        " (split at %" G_GSIZE_FORMAT ")",
+        i, boundaries[i].offset, expected[i].offset,
+        n_splits ? splits[0] : 0);
+  }
+}
+
+/* In one buffer, in two buffers split at every offset, and one byte per
+ * buffer */
+static void
+check_every_split (
+    const gchar *stream, const Boundary *expected, guint n_expected)
+{
+  gsize len = strlen (stream);
+  gsize *splits = g_new (gsize, len);
+  gsize i;
+
+  check_boundaries (stream, expected, n_expected, NULL, 0);
+  for (i = 1; i < len; i++)
+    check_boundaries (stream, expected, n_expected, &i, 1);
+
+  for (i = 0; i < len - 1; i++)
+    splits[i] = i + 1;
+  check_boundaries (stream, expected, n_expected, splits, len - 1);
+
+  g_free (splits);
+}
+
+/* Offset right after the n-th occurrence of 'token' */
+static gsize
+offset_after (const gchar *stream, const gchar *token, guint n)
+{
+  const gchar *found = stream;
+
+  do {
+    found = strstr (found, token);
+    fail_unless (found != NULL);
+    found += strlen (token);
+  } while (--n);
+
+  return found - stream;
+}
+
+static gsize
+offset_of (const gchar *stream, const gchar *token, guint n)
+{
+  return offset_after (stream, token, n) - strlen (token);
+}
+
+GST_START_TEST (test_prefixed_root)
+{
+  const gchar *stream =
+      "<?xml version=\"1.0\"?>\n"
+      "<tt:tt xmlns:tt=\"http://www.w3.org/ns/ttml\"><tt:body>"
+      "<tt:p begin=\"0s\" end=\"1s\">One</tt:p></tt:body></tt:tt>\n"
+      "<?xml version=\"1.0\"?>\n"
+      "<tt:tt xmlns:tt=\"http://www.w3.org/ns/ttml\"><tt:body/></tt:tt>";
+  Boundary expected[2] = {
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+  };
+
+  expected[0].offset = offset_after (stream, "</tt:tt>", 1);
+  expected[1].offset = strlen (stream);
+  check_every_split (stream, expected, 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_empty_root)
+{
+  const gchar *stream =
+      "<tt/>"
+      "<?xml version=\"1.0\"?><tt xmlns=\"http://www.w3.org/ns/ttml\" />"
+      "<tt a=\"/\" b='x/'/>"
+      "<tt:tt xmlns:tt=\"http://www.w3.org/ns/ttml\"/>";
+  Boundary expected[4] = {
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+  };
+
+  expected[0].offset = offset_after (stream, "/>", 1);
+  expected[1].offset = offset_after (stream, "/>", 2);
+  expected[2].offset = offset_after (stream, "/>", 3);
+  expected[3].offset = strlen (stream);
+  check_every_split (stream, expected, 4);
+}
+
+GST_END_TEST;
+
+/* None of these end the document */
+GST_START_TEST (test_hidden_end_tags)
+{
+  const gchar *stream =
+      "<?xml version=\"1.0\"?>\n"
+      "<!DOCTYPE tt [ <!ENTITY end \"</tt>\"> ]>\n"
+      "<!-- </tt> --><tt xmlns=\"http://www.w3.org/ns/ttml\">"
+      "<!-- </tt> <tt/> -->"
+      "<?xml-stylesheet href=\"</tt>\"?>"
+      "<?pi </tt> ? > ?>"
+      "<body title=\"</tt> >\" alt='</tt> \"'>"
+      "<p><![CDATA[</tt> ]]</tt> ]]]></p>"
+      "<p a='\"' b=\"'\">x</p>"
+      "</body></tt>"
+      "<!-- </tt> --><tt/>";
+  Boundary expected[2] = {
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+  };
+
+  expected[0].offset = offset_after (stream, "</body></tt>", 1);
+  expected[1].offset = strlen (stream);
+  check_every_split (stream, expected, 2);
+}
+
+GST_END_TEST;
+
+/* A truncated document followed by a new one */
+GST_START_TEST (test_restart)
+{
+  const gchar *stream =
+      "<?xml version=\"1.0\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\"><body><p>Trunc"
+      "<?xml version=\"1.0\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\"><body/></tt>"
+      "<?xml\tversion=\"1.0\"?><tt><body><div>"
+      "<?xml version=\"1.0\"?><tt/>";
+  Boundary expected[4] = {
+    { GST_TTML_SCANNER_BOUNDARY_RESTART, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_RESTART, 0 },
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+  };
+
+  expected[0].offset = offset_of (stream, "<?xml", 2);
+  expected[1].offset = offset_after (stream, "</tt>", 1);
+  expected[2].offset = offset_of (stream, "<?xml", 4);
+  expected[3].offset = strlen (stream);
+  check_every_split (stream, expected, 4);
+}
+
+GST_END_TEST;
+
+/* The declaration of the new document split after each of its chars, the
+ * scanner carries the ones in the previous buffer */
+GST_START_TEST (test_restart_carried)
+{
+  const gchar *stream = "<tt><body>"
+                        "<?xml version=\"1.0\"?><tt/>";
+  gsize start = offset_of (stream, "<?xml", 1);
+  gsize i;
+
+  for (i = 1; i <= strlen (GST_TTML_SCANNER_XML_DECLARATION); i++) {
+    GstTTMLScanner scanner;
+    GstTTMLScannerBoundary type;
+    gsize split = start + i;
+
+    gst_ttml_scanner_init (&scanner);
+    fail_unless_equals_int (
+        gst_ttml_scanner_scan (&scanner, stream, split, &type), split);
+    fail_unless_equals_int (type, GST_TTML_SCANNER_BOUNDARY_NONE);
+
+    /* The scanner can only tell once it sees the char after "<?xml" */
+    fail_unless_equals_int (gst_ttml_scanner_scan (&scanner, stream + split,
+                                strlen (stream) - split, &type),
+        0);
+    fail_unless_equals_int (type, GST_TTML_SCANNER_BOUNDARY_RESTART);
+    fail_unless_equals_int (scanner.carried, i);
+    fail_unless (strncmp (GST_TTML_SCANNER_XML_DECLARATION, stream + start,
+                     scanner.carried) == 0);
+
+    /* The rest of the declaration is skipped, the new document goes on */
+    fail_unless_equals_int (gst_ttml_scanner_scan (&scanner, stream + split,
+                                strlen (stream) - split, &type),
+        strlen (stream) - split);
+    fail_unless_equals_int (type, GST_TTML_SCANNER_BOUNDARY_END);
+  }
+}
+
+GST_END_TEST;
+
+/* Only in the prolog, a new document cannot start before the root */
+GST_START_TEST (test_declaration_in_prolog)
+{
+  const gchar *stream = "<?xml version=\"1.0\"?>\n<!-- x -->"
+                        "<?xml version=\"1.0\"?>\n<tt/>";
+  Boundary expected[1] = {
+    { GST_TTML_SCANNER_BOUNDARY_END, 0 },
+  };
+
+  expected[0].offset = strlen (stream);
+  check_every_split (stream, expected, 1);
+}
+
+GST_END_TEST;
+
+static Suite *
+scanner_suite (void)
+{
+  Suite *s = suite_create ("ttml_scanner");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_prefixed_root);
+  tcase_add_test (tc, test_empty_root);
+  tcase_add_test (tc, test_hidden_end_tags);
+  tcase_add_test (tc, test_restart);
+  tcase_add_test (tc, test_restart_carried);
+  tcase_add_test (tc, test_declaration_in_prolog);
+
+  return s;
+}
+
+GST_CHECK_MAIN (scanner);
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks that ttmlparse answers flushing seeks on a document it already
+ * parsed completely from its cached timeline, without reading it again from
+ * upstream, and that the output resumes from the seek position every time,
+ * whether the output went through the queue or not. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib/gstdio.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#define N_CUES 10
+
+typedef struct
+{
+  GMutex lock;
+  guint buffers;
+  GstClockTime min_pts;
+  guint upstream_buffers;
+} Output;
+
+static void
+output_reset (Output *output)
+{
+  g_mutex_lock (&output->lock);
+  output->buffers = 0;
+  output->min_pts = GST_CLOCK_TIME_NONE;
+  output->upstream_buffers = 0;
+  g_mutex_unlock (&output->lock);
+}
+
+static void
+handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, Output *output)
+{
+  g_mutex_lock (&output->lock);
+  output->buffers++;
+  output->min_pts = MIN (output->min_pts, GST_BUFFER_PTS (buffer));
+  g_mutex_unlock (&output->lock);
+}
+
+static GstPadProbeReturn
+upstream_probe (GstPad *pad, GstPadProbeInfo *info, Output *output)
+{
+  g_mutex_lock (&output->lock);
+  output->upstream_buffers++;
+  g_mutex_unlock (&output->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* A cue starts every second and lasts 900 ms */
+static gchar *
+write_document (void)
+{
+  GString *str = g_string_new (NULL);
+  GError *err = NULL;
+  gchar *location;
+  gint fd;
+  guint i;
+
+  g_string_append (str,
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\" xml:lang=\"en\">\n"
+      "<body><div>\n");
+  for (i = 0; i < N_CUES; i++)
+    g_string_append_printf (str,
+        "<p begin=\"%u.0s\" end=\"%u.9s\">Cue number %u</p>\n", i, i, i);
+  g_string_append (str, "</div></body>\n</tt>\n");
+
+  fd = g_file_open_tmp ("ttmlseek-XXXXXX.ttml", &location, &err);
+  fail_unless (fd >= 0, "%s", err ? err->message : "");
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (location, str->str, str->len, NULL));
+  g_string_free (str, TRUE);
+
+  return location;
+}
+
+static void
+wait_eos (GstElement *pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+
+  msg = gst_bus_timed_pop_filtered (
+      bus, 10 * GST_SECOND, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL, "Timed out waiting for EOS");
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static void
+check_seek (GstElement *pipeline, Output *output, guint cue)
+{
+  GstClockTime position = cue * GST_SECOND + 500 * GST_MSECOND;
+
+  output_reset (output);
+  fail_unless (gst_element_seek_simple (
+      pipeline, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, position));
+  wait_eos (pipeline);
+
+  g_mutex_lock (&output->lock);
+  /* At least the cue active at the position and the following ones */
+  fail_unless (output->buffers >= N_CUES - cue, "Only %u buffers",
+      output->buffers);
+  fail_unless (output->min_pts >= position,
+      "Output at %" GST_TIME_FORMAT " before the seek position",
+      GST_TIME_ARGS (output->min_pts));
+  fail_unless_equals_int (output->upstream_buffers, 0);
+  g_mutex_unlock (&output->lock);
+}
+
+static void
+run_cached_seeks (guint output_queue_size)
+{
+  GstElement *pipeline, *src, *filter, *parse, *sink;
+  GstCaps *caps;
+  GstPad *pad;
+  Output output;
+  gchar *location;
+
+  g_mutex_init (&output.lock);
+  output_reset (&output);
+  location = write_document ();
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  parse = gst_element_factory_make ("ttmlparse", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (pipeline && src && filter && parse && sink);
+
+  caps = gst_caps_new_empty_simple ("application/ttml+xml");
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (src, "location", location, NULL);
+  g_object_set (parse, "output_queue_size", output_queue_size, NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), &output);
+
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) upstream_probe, &output, NULL);
+  gst_object_unref (pad);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, filter, parse, sink, NULL);
+  fail_unless (gst_element_link_many (src, filter, parse, sink, NULL));
+
+  /* Parse the whole document, which fills the cache */
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+               GST_STATE_CHANGE_FAILURE);
+  wait_eos (pipeline);
+  fail_unless (output.buffers >= N_CUES);
+  fail_unless (output.upstream_buffers > 0);
+
+  /* Forwards, backwards, and to the same place again */
+  check_seek (pipeline, &output, 5);
+  check_seek (pipeline, &output, 2);
+  check_seek (pipeline, &output, 2);
+  check_seek (pipeline, &output, N_CUES - 1);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_unlink (location);
+  g_free (location);
+  g_mutex_clear (&output.lock);
+}
+
+GST_START_TEST (test_cached_seek)
+{
+  run_cached_seeks (0);
+}
+
+GST_END_TEST;
+
+/* The first pass runs the output task, the seeks the cached timeline one */
+GST_START_TEST (test_cached_seek_output_queue)
+{
+  run_cached_seeks (4);
+}
+
+GST_END_TEST;
+
+static Suite *
+seek_suite (void)
+{
+  Suite *s = suite_create ("ttml_seek");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_cached_seek);
+  tcase_add_test (tc, test_cached_seek_output_queue);
+
+  return s;
+}
+
+GST_CHECK_MAIN (seek);
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks the timeline against the sorted list it replaced: random events of
+ * every type, many of them at the same time, are inserted in both, and what
+ * the timeline returns, while more events keep being inserted, is compared
+ * with the head of the list. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstttmlattribute.h"
+#include "gstttmlevent.h"
+#include "gstttmlspan.h"
+#include "gstttmlstate.h"
+#include "gstttmlstyle.h"
+#include "gstttmltimeline.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+#define ITERATIONS 2000
+#define MAX_EVENTS 200
+#define MAX_TIME 10
+
+/* The order the timeline had as a GList: by time, and at the same time
+ * regions enclosing spans */
+static gint
+gst_ttml_event_compare (GstTTMLEvent *a, GstTTMLEvent *b)
+{
+  if (a->timestamp != b->timestamp)
+    return a->timestamp > b->timestamp ? 1 : -1;
+  if (a->type == GST_TTML_EVENT_TYPE_REGION_BEGIN)
+    return -1;
+  if (a->type == GST_TTML_EVENT_TYPE_REGION_END)
+    return 1;
+  if (b->type == GST_TTML_EVENT_TYPE_REGION_BEGIN)
+    return 1;
+  if (b->type == GST_TTML_EVENT_TYPE_REGION_END)
+    return -1;
+  return 0;
+}
+
+/* An event of any type, at one of a few times so many of them are equal */
+static GstTTMLEvent *
+random_event (GRand *rand)
+{
+  GstClockTime time = g_rand_int_range (rand, 0, MAX_TIME) * GST_SECOND;
+  GstTTMLState state;
+  GstTTMLStyle style;
+  GstTTMLAttribute *attr;
+  GstTTMLEvent *event;
+
+  memset (&state, 0, sizeof (state));
+  state.begin = state.end = time;
+  gst_ttml_style_init (&style);
+
+  switch (g_rand_int_range (rand, 0, 6)) {
+    case 0:
+      event = gst_ttml_event_new_span_begin (
+          NULL, &state, gst_ttml_span_new (NULL, 1, 1, "x", &style));
+      break;
+    case 1:
+      event = gst_ttml_event_new_span_end (NULL, &state, 1);
+      break;
+    case 2:
+      attr = gst_ttml_attribute_new_int (
+          NULL, GST_TTML_ATTR_ZINDEX, g_rand_int (rand));
+      event = gst_ttml_event_new_attr_update (NULL, 1, time, attr);
+      gst_ttml_attribute_free (attr);
+      break;
+    case 3:
+      event = gst_ttml_event_new_region_begin (NULL, time, "r", &style);
+      break;
+    case 4:
+      event = gst_ttml_event_new_region_end (NULL, time, "r");
+      break;
+    default:
+      attr = gst_ttml_attribute_new_int (
+          NULL, GST_TTML_ATTR_ZINDEX, g_rand_int (rand));
+      event = gst_ttml_event_new_region_update (NULL, time, "r", attr);
+      gst_ttml_attribute_free (attr);
+      break;
+  }
+
+  return event;
+}
+
+/* Takes the next event from both and checks it is the same one */
+static GList *
+check_pop (GstTTMLTimeline *timeline, GList *reference)
+{
+  GstTTMLEvent *event;
+
+  fail_if (gst_ttml_timeline_is_empty (timeline));
+  event = gst_ttml_timeline_peek (timeline);
+  fail_unless (event == reference->data,
+      "Got event of type %d at %" GST_TIME_FORMAT ", expected type %d at %"
+      GST_TIME_FORMAT, event->type, GST_TIME_ARGS (event->timestamp),
+      ((GstTTMLEvent *) reference->data)->type,
+      GST_TIME_ARGS (((GstTTMLEvent *) reference->data)->timestamp));
+  fail_unless (gst_ttml_timeline_pop (timeline) == event);
+
+  gst_ttml_event_free (event);
+  return g_list_delete_link (reference, reference);
+}
+
+GST_START_TEST (test_random_order)
+{
+  GRand *rand = g_rand_new_with_seed (0x7e11e);
+  guint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    GstTTMLTimeline timeline;
+    GList *reference = NULL;
+    guint n_events = g_rand_int_range (rand, 1, MAX_EVENTS + 1), n;
+
+    gst_ttml_timeline_init (&timeline);
+    fail_unless (gst_ttml_timeline_is_empty (&timeline));
+    fail_unless (gst_ttml_timeline_peek (&timeline) == NULL);
+
+    /* Inserting, and sometimes taking the next one, as the parser and the
+     * buffer generation do */
+    for (n = 0; n < n_events; n++) {
+      GstTTMLEvent *event = random_event (rand);
+
+      gst_ttml_timeline_insert (&timeline, event);
+      reference = g_list_insert_sorted (
+          reference, event, (GCompareFunc) gst_ttml_event_compare);
+
+      while (reference && g_rand_int_range (rand, 0, 4) == 0)
+        reference = check_pop (&timeline, reference);
+      fail_unless_equals_int (
+          gst_ttml_timeline_get_length (&timeline), g_list_length (reference));
+    }
+
+    while (reference)
+      reference = check_pop (&timeline, reference);
+    fail_unless (gst_ttml_timeline_is_empty (&timeline));
+    fail_unless_equals_int (gst_ttml_timeline_get_length (&timeline), 0);
+    fail_unless (gst_ttml_timeline_pop (&timeline) == NULL);
+
+    gst_ttml_timeline_clear (&timeline);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* Clearing frees the events left, and the timeline can be used again */
+GST_START_TEST (test_clear)
+{
+  GRand *rand = g_rand_new_with_seed (0x7e11f);
+  GstTTMLTimeline timeline;
+  GList *reference = NULL;
+  guint n;
+
+  gst_ttml_timeline_init (&timeline);
+  for (n = 0; n < MAX_EVENTS; n++)
+    gst_ttml_timeline_insert (&timeline, random_event (rand));
+  fail_unless_equals_int (
+      gst_ttml_timeline_get_length (&timeline), MAX_EVENTS);
+
+  gst_ttml_timeline_clear (&timeline);
+  fail_unless (gst_ttml_timeline_is_empty (&timeline));
+  fail_unless_equals_int (gst_ttml_timeline_get_length (&timeline), 0);
+
+  for (n = 0; n < MAX_EVENTS; n++) {
+    GstTTMLEvent *event = random_event (rand);
+
+    gst_ttml_timeline_insert (&timeline, event);
+    reference = g_list_insert_sorted (
+        reference, event, (GCompareFunc) gst_ttml_event_compare);
+  }
+  while (reference)
+    reference = check_pop (&timeline, reference);
+
+  gst_ttml_timeline_clear (&timeline);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static Suite *
+timeline_suite (void)
+{
+  Suite *s = suite_create ("ttml_timeline");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_random_order);
+  tcase_add_test (tc, test_clear);
+
+  return s;
+}
+
+GST_CHECK_MAIN (timeline);
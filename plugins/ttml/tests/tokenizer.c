@@ -0,0 +1,341 @@
+/*
+ * Copyright 2026 FLUENDO S.A.
+ * SPDX-License-Identifier: LGPL-2.1-only
+ */
+
+/* Checks that the built-in tokenizer calls the SAX2 callbacks the same way
+ * libxml2's push parser does, for documents split at every byte offset and
+ * fed in chunks of every size: the same elements, namespaces, attribute
+ * values, text and comments, and an error for the same malformed input.
+ * Only the first error is recorded, and the end of the document is not
+ * after it: libxml2 reports it after some errors and not after others. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <libxml/parser.h>
+
+#include "gstttmltokenizer.h"
+
+GST_DEBUG_CATEGORY (ttmlbase_debug);
+
+/* Calls of the callbacks, consecutive text coalesced */
+static GString *record;
+static gboolean in_text;
+static gboolean error;
+
+static void
+record_text_end (void)
+{
+  if (in_text)
+    g_string_append (record, "]\n");
+  in_text = FALSE;
+}
+
+static void
+record_start_document (void *ctx)
+{
+  record_text_end ();
+  g_string_append (record, "start document\n");
+}
+
+static void
+record_end_document (void *ctx)
+{
+  if (error)
+    return;
+  record_text_end ();
+  g_string_append (record, "end document\n");
+}
+
+static void
+record_start_element (void *ctx, const xmlChar *name, const xmlChar *prefix,
+    const xmlChar *uri, int nb_namespaces, const xmlChar **namespaces,
+    int nb_attributes, int nb_defaulted, const xmlChar **attrs)
+{
+  gint i;
+
+  record_text_end ();
+  g_string_append_printf (record, "<%s prefix=%s uri=%s", name,
+      prefix ? (const gchar *) prefix : "-", uri ? (const gchar *) uri : "-");
+  for (i = 0; i < nb_namespaces; i++)
+    g_string_append_printf (record, " xmlns:%s=%s",
+        namespaces[2 * i] ? (const gchar *) namespaces[2 * i] : "-",
+        namespaces[2 * i + 1]);
+  for (i = 0; i < nb_attributes; i++, attrs += 5)
+    g_string_append_printf (record, " %s prefix=%s uri=%s value='%.*s'",
+        attrs[0], attrs[1] ? (const gchar *) attrs[1] : "-",
+        attrs[2] ? (const gchar *) attrs[2] : "-",
+        (gint) (attrs[4] - attrs[3]), attrs[3]);
+  g_string_append (record, ">\n");
+}
+
+static void
+record_end_element (void *ctx, const xmlChar *name, const xmlChar *prefix,
+    const xmlChar *uri)
+{
+  record_text_end ();
+  g_string_append_printf (record, "</%s prefix=%s uri=%s>\n", name,
+      prefix ? (const gchar *) prefix : "-", uri ? (const gchar *) uri : "-");
+}
+
+static void
+record_characters (void *ctx, const xmlChar *ch, int len)
+{
+  if (!in_text)
+    g_string_append (record, "text [");
+  in_text = TRUE;
+  g_string_append_len (record, (const gchar *) ch, len);
+}
+
+static void
+record_comment (void *ctx, const xmlChar *value)
+{
+  record_text_end ();
+  g_string_append_printf (record, "comment '%s'\n", value);
+}
+
+static void
+record_error (void *ctx, const char *msg, ...)
+{
+  if (error)
+    return;
+  record_text_end ();
+  g_string_append (record, "error\n");
+  error = TRUE;
+}
+
+static xmlEntityPtr
+record_get_entity (void *ctx, const xmlChar *name)
+{
+  return xmlGetPredefinedEntity (name);
+}
+
+static xmlSAXHandler handler;
+
+static void
+handler_init (void)
+{
+  memset (&handler, 0, sizeof (handler));
+  handler.initialized = XML_SAX2_MAGIC;
+  handler.getEntity = record_get_entity;
+  handler.startDocument = record_start_document;
+  handler.endDocument = record_end_document;
+  handler.startElementNs = record_start_element;
+  handler.endElementNs = record_end_element;
+  handler.characters = record_characters;
+  handler.comment = record_comment;
+  handler.error = record_error;
+  handler.fatalError = record_error;
+}
+
+static gchar *
+record_finish (void)
+{
+  gchar *ret;
+
+  record_text_end ();
+  ret = g_strdup (record->str);
+  g_string_truncate (record, 0);
+  error = FALSE;
+
+  return ret;
+}
+
+static gchar *
+parse_libxml (const gchar *doc)
+{
+  xmlParserCtxtPtr parser;
+
+  parser = xmlCreatePushParserCtxt (&handler, NULL, doc, strlen (doc), NULL);
+  xmlParseChunk (parser, NULL, 0, 1);
+  xmlFreeParserCtxt (parser);
+
+  return record_finish ();
+}
+
+/* Fed in chunks of 'step' bytes, the first one 'first' bytes long */
+static gchar *
+parse_tokenizer (
+    GstTTMLTokenizer *tokenizer, const gchar *doc, gsize first, gsize step)
+{
+  gsize len = strlen (doc), pos = 0, size = first;
+
+  gst_ttml_tokenizer_reset (tokenizer);
+  while (pos < len) {
+    size = MIN (size, len - pos);
+    gst_ttml_tokenizer_feed (tokenizer, doc + pos, size);
+    pos += size;
+    size = step;
+  }
+  gst_ttml_tokenizer_finish (tokenizer);
+
+  return record_finish ();
+}
+
+static void
+check_documents (const gchar **docs, guint n_docs)
+{
+  GstTTMLTokenizer *tokenizer;
+  guint i;
+
+  handler_init ();
+  record = g_string_new (NULL);
+  tokenizer = gst_ttml_tokenizer_new (&handler, NULL);
+
+  for (i = 0; i < n_docs; i++) {
+    gchar *expected = parse_libxml (docs[i]);
+    gsize len = strlen (docs[i]), n;
+
+    for (n = 1; n <= len; n++) {
+      gchar *split = parse_tokenizer (tokenizer, docs[i], n, len);
+      gchar *chunks = parse_tokenizer (tokenizer, docs[i], n, n);
+
+      fail_unless (strcmp (split, expected) == 0,
+          "Document %u split at %" G_GSIZE_FORMAT ":\n%s\nlibxml2:\n%s", i,
+          n, split, expected);
+      fail_unless (strcmp (chunks, expected) == 0,
+          "Document %u in chunks of %" G_GSIZE_FORMAT ":\n%s\nlibxml2:\n%s",
+          i, n, chunks, expected);
+      g_free (split);
+      g_free (chunks);
+    }
+    g_free (expected);
+  }
+
+  gst_ttml_tokenizer_free (tokenizer);
+  g_string_free (record, TRUE);
+}
+
+GST_START_TEST (test_document)
+{
+  const gchar *docs[] = {
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<tt xmlns=\"http://www.w3.org/ns/ttml\" "
+    "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">\n"
+    "<head><styling><style xml:id=\"s1\" tts:color=\"white\"\n"
+    " tts:fontSize='100%'/></styling></head>\n"
+    "<body><div><p begin=\"00:00:01.000\" end='2s' style=\"s1\">"
+    "Hello<br/>world <span tts:color=\"red\">red</span></p></div></body>"
+    "</tt>\n",
+    "<tt/>",
+    "<tt/>  \n",
+  };
+
+  check_documents (docs, G_N_ELEMENTS (docs));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_references)
+{
+  const gchar *docs[] = {
+    "<tt>&amp; &lt;&gt; &quot;&apos; &#65;&#x42;&#x10FFFF; &#38;</tt>",
+    "<tt a=\"x &amp; y &#38; z &#x26;\" b='&lt;&gt;&quot;&apos;'/>",
+    "<tt a=\"&#65;&#x42;\tc&#10;d&#9;e\">&#xe9;\xc3\xa9</tt>",
+    /* Malformed */
+    "<tt>&unknown;</tt>",
+    "<tt>&amp</tt>",
+    "<tt>&#0;</tt>",
+    "<tt>&#xZ;</tt>",
+    "<tt a=\"&foo;\"/>",
+    "<tt a=\"&amp\"/>",
+    "<tt>&am",
+    "<tt>&amp;&lt",
+  };
+
+  check_documents (docs, G_N_ELEMENTS (docs));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_markup)
+{
+  const gchar *docs[] = {
+    "<tt><![CDATA[<raw> & ]]></tt>",
+    "<tt>a<![CDATA[]]b]]]>c<![CDATA[]]></tt>",
+    "<?xml version=\"1.0\"?><!-- before --><?pi data?>"
+    "<tt><!--inside--><?target x y?>t<!-- - --></tt>"
+    "<!-- after --><?pi?>",
+    "<?xml version=\"1.0\"?><!DOCTYPE tt [ <!ELEMENT tt ANY> ]><tt>x</tt>",
+    /* Malformed */
+    "<tt><p>truncated",
+    "<tt><p>mismatch</q></tt>",
+    "<tt></tt>junk",
+    "<tt></tt><tt/>",
+    "<tt><p a=\"1\"b=\"2\"/></tt>",
+    "<tt><p a=1/></tt>",
+    "<tt><p a=\"<\"/></tt>",
+    "<tt><!-- unterminated </tt>",
+    /* Truncated inside markup */
+    "<tt><p a=\"1",
+    "<tt></t",
+    "<tt><![CDATA[x",
+    "<tt><?pi x",
+    "<tt><!-",
+    "<tt></tt><!-- x",
+    "<!DOCTYPE tt [",
+  };
+
+  check_documents (docs, G_N_ELEMENTS (docs));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_namespaces)
+{
+  const gchar *docs[] = {
+    "<tt:tt xmlns:tt=\"urn:x\" a=\"v\"><tt:p xmlns=\"urn:d\"><q/>"
+    "<r xmlns=\"\"/></tt:p></tt:tt>",
+    "<a:tt xmlns:a=\"u\" xmlns:b=\"v\" b:x=\"1\" y=\"2\" "
+    "xml:space=\"preserve\"><b:p/><a:p xmlns:a=\"w\"/><a:p/></a:tt>",
+    /* Undeclared prefixes */
+    "<tt><p:q/></tt>",
+    "<tt q:a=\"1\"/>",
+  };
+
+  check_documents (docs, G_N_ELEMENTS (docs));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_encoding)
+{
+  const gchar *docs[] = {
+    /* Byte order mark */
+    "\xef\xbb\xbf<tt>bom</tt>",
+    "\xef\xbb\xbf<?xml version=\"1.0\" encoding=\"UTF-8\"?><tt/>",
+    /* Line ends */
+    "<tt a=\"x\r\ny\rz\">l1\r\nl2\rl3\r\n\r</tt>",
+    "<tt>\r\n<p>\r</p>\r\n</tt>\r\n",
+  };
+
+  check_documents (docs, G_N_ELEMENTS (docs));
+}
+
+GST_END_TEST;
+
+static Suite *
+tokenizer_suite (void)
+{
+  Suite *s = suite_create ("ttml_tokenizer");
+  TCase *tc = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (ttmlbase_debug, "ttmlbase", 0, "TTML base");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_document);
+  tcase_add_test (tc, test_references);
+  tcase_add_test (tc, test_markup);
+  tcase_add_test (tc, test_namespaces);
+  tcase_add_test (tc, test_encoding);
+
+  return s;
+}
+
+GST_CHECK_MAIN (tokenizer);